@@ -231,6 +231,38 @@ static inline block_t *block_Duplicate( const block_t *p_block )
     return p_dup;
 }
 
+/**
+ * Shares a block.
+ *
+ * Creates a new block referencing the same payload as the given block,
+ * without copying it. Both blocks must be released with block_Release(); the
+ * payload is freed with the last of them.
+ *
+ * While a payload is shared, it must not be modified in place:
+ * block_TryRealloc() and block_Realloc() copy it as needed, and
+ * block_MakeWritable() should be used before any other modification.
+ *
+ * @return the new block on success, NULL on error.
+ */
+VLC_API block_t *block_Share(block_t *) VLC_USED;
+
+/**
+ * Checks if the payload of a block is shared with other blocks.
+ *
+ * @see block_Share()
+ */
+VLC_API bool block_IsShared(const block_t *) VLC_USED;
+
+/**
+ * Makes a block writable.
+ *
+ * If the payload of the block is shared, replaces the block with a private
+ * copy. Otherwise the block is returned as is.
+ *
+ * @return the writable block, or NULL on error (the block is then released).
+ */
+VLC_API block_t *block_MakeWritable(block_t *) VLC_USED;
+
 /**
  * Wraps heap in a block.
  *
@@ -306,6 +338,19 @@ VLC_API block_t *block_File(int fd, bool write) VLC_USED VLC_MALLOC;
  */
 VLC_API block_t *block_FilePath(const char *, bool write) VLC_USED VLC_MALLOC;
 
+/**
+ * Gets the statistics of the pool of blocks (see the block-pool option).
+ *
+ * The pool is shared by the whole process: the counters cover the blocks of
+ * all the inputs and outputs, not of any one of them.
+ *
+ * @param hits number of allocations served from the pool [OUT]
+ * @param misses number of pooled allocations made from the system [OUT]
+ * @param bytes size of the pooled blocks currently in use [OUT]
+ */
+VLC_API void block_PoolStats(uintmax_t *hits, uintmax_t *misses,
+                             uintmax_t *bytes);
+
 static inline void block_Cleanup (void *block)
 {
     block_Release ((block_t *)block);
@@ -364,6 +409,36 @@ static inline void block_ChainRelease( block_t *p_block )
     }
 }
 
+/**
+ * Makes all the blocks of a chain writable.
+ *
+ * @see block_MakeWritable()
+ *
+ * @return the writable chain, or NULL on error (the whole chain is then
+ * released).
+ */
+static inline block_t *block_ChainMakeWritable( block_t *p_list )
+{
+    block_t **pp_block = &p_list;
+
+    while( *pp_block != NULL )
+    {
+        block_t *p_next = (*pp_block)->p_next;
+        block_t *p_block = block_MakeWritable( *pp_block );
+
+        if( p_block == NULL )
+        {
+            *pp_block = NULL;
+            block_ChainRelease( p_list );
+            block_ChainRelease( p_next );
+            return NULL;
+        }
+        *pp_block = p_block;
+        pp_block = &p_block->p_next;
+    }
+    return p_list;
+}
+
 static size_t block_ChainExtract( block_t *p_list, void *p_data, size_t i_max )
 {
     size_t  i_total = 0;
@@ -637,6 +712,98 @@ static inline void vlc_fifo_Cleanup(void *fifo)
 }
 #define vlc_fifo_CleanupPush(fifo) vlc_cleanup_push(vlc_fifo_Cleanup, fifo)
 
+/**
+ * @}
+ * \defgroup spsc_fifo Single producer, single consumer block FIFO
+ * Lock-free block queue between two threads
+ *
+ * Unlike the block FIFO, this queue has a fixed capacity and no lock.
+ * Queuing and dequeuing only use atomic operations, and a thread only enters
+ * the kernel when it has to sleep, because the queue is full or empty.
+ *
+ * At any given time, at most one thread may queue blocks (the producer) and
+ * at most one thread may dequeue blocks (the consumer).
+ * @{
+ */
+
+typedef struct vlc_spsc_fifo vlc_spsc_fifo_t;
+
+/**
+ * Creates a single producer, single consumer queue of blocks.
+ *
+ * @param capacity maximum number of queued blocks
+ * (rounded up to a power of two)
+ * @return the FIFO or NULL on memory error
+ */
+VLC_API vlc_spsc_fifo_t *vlc_spsc_fifo_New(size_t capacity)
+VLC_USED VLC_MALLOC;
+
+/**
+ * Destroys a FIFO created by vlc_spsc_fifo_New().
+ *
+ * @note Any queued blocks are also destroyed.
+ * @warning Neither the producer nor the consumer may be using the FIFO
+ * anymore when this function is called.
+ */
+VLC_API void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *);
+
+/**
+ * Queues one block, unless the FIFO is full.
+ *
+ * This function never sleeps. It can only be called by the producer.
+ *
+ * @param block a single block (block->p_next must be NULL)
+ * @retval true if the block was queued
+ * @retval false if the FIFO is full (the block remains owned by the caller)
+ */
+VLC_API bool vlc_spsc_fifo_TryQueue(vlc_spsc_fifo_t *, block_t *block)
+VLC_USED;
+
+/**
+ * Queues a list of blocks, waiting for room in the FIFO as needed.
+ *
+ * This function can only be called by the producer. It is not a
+ * cancellation point.
+ *
+ * @param block head of a block list to queue (may be NULL)
+ */
+VLC_API void vlc_spsc_fifo_Queue(vlc_spsc_fifo_t *, block_t *block);
+
+/**
+ * Dequeues the first block, if any.
+ *
+ * This function never sleeps. It can only be called by the consumer.
+ *
+ * @return the first block, or NULL if the FIFO is empty
+ */
+VLC_API block_t *vlc_spsc_fifo_TryDequeue(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Dequeues the first block, waiting for one if the FIFO is empty.
+ *
+ * This function can only be called by the consumer. Cancellation is only
+ * tested on entry, not while sleeping.
+ *
+ * @return a valid block
+ */
+VLC_API block_t *vlc_spsc_fifo_Dequeue(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Counts blocks in a FIFO.
+ *
+ * @note The value may be stale by the time it is used, unless called from
+ * the producer (it can only grow) or the consumer (it can only shrink).
+ */
+VLC_API size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Counts bytes in a FIFO.
+ *
+ * This is the total size of the queued blocks, like vlc_fifo_GetBytes().
+ * The same remark as vlc_spsc_fifo_GetCount() applies.
+ */
+VLC_API size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *) VLC_USED;
+
 /** @} */
 
 /** @} */
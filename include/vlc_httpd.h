@@ -111,6 +111,9 @@ typedef int    (*httpd_callback_t)( httpd_callback_sys_t *, httpd_client_t *, ht
 VLC_API httpd_url_t * httpd_UrlNew( httpd_host_t *, const char *psz_url, const char *psz_user, const char *psz_password ) VLC_USED;
 /* register callback on a url */
 VLC_API int httpd_UrlCatch( httpd_url_t *, int i_msg, httpd_callback_t, httpd_callback_sys_t * );
+/* let the callbacks of a url run from several host threads at once
+ * (they are otherwise called one at a time per host) */
+VLC_API void httpd_UrlSetConcurrent( httpd_url_t * );
 /* delete a url */
 VLC_API void httpd_UrlDelete( httpd_url_t * );
 
@@ -140,7 +143,7 @@ typedef struct httpd_stream_t httpd_stream_t;
 VLC_API httpd_stream_t * httpd_StreamNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password ) VLC_USED;
 VLC_API void httpd_StreamDelete( httpd_stream_t * );
 VLC_API int httpd_StreamHeader( httpd_stream_t *, uint8_t *p_data, int i_data );
-VLC_API int httpd_StreamSend( httpd_stream_t *, const block_t *p_block );
+VLC_API int httpd_StreamSend( httpd_stream_t *, block_t *p_block );
 VLC_API int httpd_StreamSetHTTPHeaders(httpd_stream_t *, const httpd_header *, size_t);
 
 /* Msg functions facilities */
@@ -159,6 +159,8 @@ vlc_media_tree_Unlock(vlc_media_tree_t *);
 /**
  * Find the node containing the requested input item (and its parent).
  *
+ * If several nodes contain the item, the first one added is returned.
+ *
  * \param tree the media tree, locked
  * \param result point to the matching node if the function returns true [OUT]
  * \param result_parent if not NULL, point to the matching node parent
@@ -112,6 +112,54 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
                               input_item_t *input_item, vlc_tick_t timeout,
                               vlc_thumbnailer_cb cb, void* user_data );
 
+/**
+ * \brief vlc_thumbnailer_batch_cb defines a callback invoked for each
+ * thumbnail of a batch request
+ *
+ * This callback is called once for each requested time, in order, provided
+ * vlc_thumbnailer_RequestBatch returned a non NULL request, and provided the
+ * request is not cancelled before its completion.
+ * The picture follows the same rules as with \ref vlc_thumbnailer_cb.
+ *
+ * The next seek is already requested when this callback is invoked: to
+ * process the thumbnails in parallel with their extraction, hold the picture
+ * and process it from another thread.
+ *
+ * \param data Is the opaque pointer passed as vlc_thumbnailer_RequestBatch last parameter
+ * \param index The index of the time in the requested array
+ * \param thumbnail The generated thumbnail, or NULL in case of failure or timeout
+ */
+typedef void(*vlc_thumbnailer_batch_cb)( void* data, size_t index,
+                                         picture_t* thumbnail );
+
+/**
+ * \brief vlc_thumbnailer_RequestBatch Requests thumbnails at several times
+ * \param thumbnailer A thumbnailer object
+ * \param times The times at which the thumbnails should be taken
+ * \param count The number of times, must not be 0
+ * \param speed The seeking speed \sa{enum vlc_thumbnailer_seek_speed}
+ * \param input_item The input item to generate the thumbnails for
+ * \param timeout A timeout value for the whole batch, or VLC_TICK_INVALID to
+ * disable timeout
+ * \param cb A user callback to be called for each thumbnail (success & error)
+ * \param user_data An opaque value, provided as pf_cb's first parameter
+ * \return An opaque request object, or NULL in case of failure
+ *
+ * The input is opened once, and seeks to each time in the given order:
+ * increasing times avoid seeking backward. The thumbnail is the first picture
+ * decoded after each seek, which is a key frame when seeking fast.
+ *
+ * The times are copied by the thumbnailer. The request object and the
+ * input_item follow the same rules as with vlc_thumbnailer_RequestByTime,
+ * the request completing after the last callback.
+ */
+VLC_API vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data );
+
 /**
  * \brief vlc_thumbnailer_Cancel Cancel a thumbnail request
  * \param thumbnailer A thumbnailer object
@@ -100,6 +100,231 @@ static int rtp_timeout (vlc_tick_t deadline)
     return t;
 }
 
+/* Maximum number of released receive buffers kept for reuse */
+#define RTP_RING_SIZE 64
+
+/**
+ * Ring of receive buffers of MRU bytes, to which the blocks go back once
+ * released by the RTP session or its payload handlers, so that datagrams are
+ * received without allocations. It outlives the receiving thread while
+ * blocks are still in use.
+ */
+struct rtp_ring
+{
+    vlc_mutex_t lock;
+    unsigned refs; /* the thread and the blocks out of the ring */
+    bool alive; /* whether the thread still uses the ring */
+    size_t mru;
+    unsigned count;
+    block_t *blocks[RTP_RING_SIZE];
+};
+
+struct rtp_ring_block
+{
+    block_t self;
+    struct rtp_ring *ring;
+    size_t size;
+};
+
+static void rtp_ring_destroy (struct rtp_ring *ring)
+{
+    vlc_mutex_destroy (&ring->lock);
+    free (ring);
+}
+
+/* Frees the cached buffers, must be called with the lock held */
+static void rtp_ring_flush (struct rtp_ring *ring)
+{
+    while (ring->count > 0)
+        free (container_of (ring->blocks[--ring->count],
+                            struct rtp_ring_block, self));
+}
+
+static void rtp_ring_block_release (block_t *block)
+{
+    struct rtp_ring_block *rb = container_of (block, struct rtp_ring_block,
+                                              self);
+    struct rtp_ring *ring = rb->ring;
+
+    vlc_mutex_lock (&ring->lock);
+    if (ring->alive && rb->size == ring->mru && ring->count < RTP_RING_SIZE)
+    {
+        ring->blocks[ring->count++] = block;
+        rb = NULL;
+    }
+    bool last = --ring->refs == 0;
+    vlc_mutex_unlock (&ring->lock);
+
+    free (rb);
+    if (last)
+        rtp_ring_destroy (ring);
+}
+
+static const struct vlc_block_callbacks rtp_ring_block_cbs =
+{
+    rtp_ring_block_release,
+};
+
+static struct rtp_ring *rtp_ring_create (void)
+{
+    struct rtp_ring *ring = malloc (sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    vlc_mutex_init (&ring->lock);
+    ring->refs = 1;
+    ring->alive = true;
+    ring->mru = 0;
+    ring->count = 0;
+    return ring;
+}
+
+static void rtp_ring_close (void *data)
+{
+    struct rtp_ring *ring = data;
+
+    vlc_mutex_lock (&ring->lock);
+    ring->alive = false;
+    rtp_ring_flush (ring);
+    bool last = --ring->refs == 0;
+    vlc_mutex_unlock (&ring->lock);
+
+    if (last)
+        rtp_ring_destroy (ring);
+}
+
+/**
+ * Gets a receive buffer of mru bytes, from the ring if possible.
+ */
+static block_t *rtp_ring_get (struct rtp_ring *ring, size_t mru)
+{
+    struct rtp_ring_block *rb = NULL;
+
+    vlc_mutex_lock (&ring->lock);
+    if (ring->mru != mru)
+    {   /* the cached buffers have the wrong size */
+        rtp_ring_flush (ring);
+        ring->mru = mru;
+    }
+    if (ring->count > 0)
+        rb = container_of (ring->blocks[--ring->count],
+                           struct rtp_ring_block, self);
+    ring->refs++;
+    vlc_mutex_unlock (&ring->lock);
+
+    if (rb == NULL)
+    {
+        rb = malloc (sizeof (*rb) + mru);
+        if (unlikely(rb == NULL))
+        {
+            vlc_mutex_lock (&ring->lock);
+            ring->refs--; /* the thread holds a reference */
+            vlc_mutex_unlock (&ring->lock);
+            return NULL;
+        }
+        rb->ring = ring;
+        rb->size = mru;
+    }
+    return block_Init (&rb->self, &rtp_ring_block_cbs, rb + 1, mru);
+}
+
+#ifdef HAVE_RECVMMSG
+/* Maximum number of datagrams received per system call */
+# define RTP_VLEN 32
+
+/**
+ * Receive buffers for batched datagram reception. They are kept across
+ * calls, and only those passed on to the RTP session get replaced, from the
+ * ring.
+ */
+struct rtp_dgram_batch
+{
+    size_t mru;
+    struct rtp_ring *ring;
+    block_t *blocks[RTP_VLEN];
+    struct iovec iovecs[RTP_VLEN];
+    struct mmsghdr msgs[RTP_VLEN];
+};
+
+static void rtp_dgram_batch_cleanup (void *data)
+{
+    struct rtp_dgram_batch *batch = data;
+
+    for (size_t i = 0; i < RTP_VLEN; i++)
+        if (batch->blocks[i] != NULL)
+            block_Release (batch->blocks[i]);
+    rtp_ring_close (batch->ring);
+}
+
+/**
+ * Receives and processes all pending datagrams (up to RTP_VLEN) at once.
+ * @return -1 if no buffer could be allocated at all, 0 otherwise.
+ */
+static int rtp_dgram_batch_recv (demux_t *demux, int fd,
+                                 struct rtp_dgram_batch *batch, int trunc_flag)
+{
+    unsigned vlen;
+
+    for (vlen = 0; vlen < RTP_VLEN; vlen++)
+    {
+        block_t *block = batch->blocks[vlen];
+
+        if (block != NULL && block->i_buffer < batch->mru)
+        {   /* MRU was grown since allocation */
+            block_Release (block);
+            block = NULL;
+        }
+
+        if (block == NULL)
+        {
+            block = rtp_ring_get (batch->ring, batch->mru);
+            batch->blocks[vlen] = block;
+            if (unlikely(block == NULL))
+                break;
+        }
+
+        batch->iovecs[vlen].iov_base = block->p_buffer;
+        batch->iovecs[vlen].iov_len = batch->mru;
+        batch->msgs[vlen].msg_hdr.msg_iov = &batch->iovecs[vlen];
+        batch->msgs[vlen].msg_hdr.msg_iovlen = 1;
+    }
+
+    if (unlikely(vlen == 0))
+    {
+        if (batch->mru == DEFAULT_MRU)
+            return -1; /* we are totallly screwed */
+        batch->mru = DEFAULT_MRU; /* retry with shrunk MRU */
+        return 0;
+    }
+
+    int count = recvmmsg (fd, batch->msgs, vlen, MSG_DONTWAIT | trunc_flag,
+                          NULL);
+    if (count == -1)
+        msg_Warn (demux, "RTP network error: %s", vlc_strerror_c(errno));
+
+    for (int i = 0; i < count; i++)
+    {
+        block_t *block = batch->blocks[i];
+        size_t len = batch->msgs[i].msg_len;
+
+        batch->blocks[i] = NULL;
+        if (batch->msgs[i].msg_hdr.msg_flags & trunc_flag)
+        {
+            msg_Err(demux, "%zu bytes packet truncated (MRU was %zu)",
+                    len, batch->mru);
+            block->i_buffer = batch->mru;
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            batch->mru = len;
+        }
+        else
+            block->i_buffer = len;
+
+        rtp_process (demux, block);
+    }
+    return 0;
+}
+#endif
+
 /**
  * RTP/RTCP session thread for datagram sockets
  */
@@ -115,6 +340,17 @@ void *rtp_dgram_thread (void *opaque)
     const int trunc_flag = 0;
 #endif
 
+    struct rtp_ring *ring = rtp_ring_create ();
+    if (unlikely(ring == NULL))
+        return NULL;
+
+#ifdef HAVE_RECVMMSG
+    struct rtp_dgram_batch batch;
+
+    memset (&batch, 0, sizeof (batch));
+    batch.mru = DEFAULT_MRU;
+    batch.ring = ring;
+#else
     struct iovec iov =
     {
         .iov_len = DEFAULT_MRU,
@@ -124,11 +360,17 @@ void *rtp_dgram_thread (void *opaque)
         .msg_iov = &iov,
         .msg_iovlen = 1,
     };
+#endif
 
     struct pollfd ufd[1];
     ufd[0].fd = rtp_fd;
     ufd[0].events = POLLIN;
 
+#ifdef HAVE_RECVMMSG
+    vlc_cleanup_push (rtp_dgram_batch_cleanup, &batch);
+#else
+    vlc_cleanup_push (rtp_ring_close, ring);
+#endif
     for (;;)
     {
         int n = poll (ufd, 1, rtp_timeout (deadline));
@@ -145,7 +387,11 @@ void *rtp_dgram_thread (void *opaque)
             if (unlikely(ufd[0].revents & POLLHUP))
                 break; /* RTP socket dead (DCCP only) */
 
-            block_t *block = block_Alloc (iov.iov_len);
+#ifdef HAVE_RECVMMSG
+            if (rtp_dgram_batch_recv (demux, rtp_fd, &batch, trunc_flag))
+                break;
+#else
+            block_t *block = rtp_ring_get (ring, iov.iov_len);
             if (unlikely(block == NULL))
             {
                 if (iov.iov_len == DEFAULT_MRU)
@@ -178,6 +424,7 @@ void *rtp_dgram_thread (void *opaque)
                           vlc_strerror_c(errno));
                 block_Release (block);
             }
+#endif
         }
 
     dequeue:
@@ -185,6 +432,12 @@ void *rtp_dgram_thread (void *opaque)
             deadline = VLC_TICK_INVALID;
         vlc_restorecancel (canc);
     }
+    vlc_cleanup_pop ();
+#ifdef HAVE_RECVMMSG
+    rtp_dgram_batch_cleanup (&batch);
+#else
+    rtp_ring_close (ring);
+#endif
     return NULL;
 }
 
@@ -53,15 +53,126 @@
  */
 #define MRU 65507u
 
+#ifdef HAVE_RECVMMSG
+/* Maximum number of datagrams received per system call */
+# define VLEN 32
+#else
+# define VLEN 1
+#endif
+/* Maximum number of released blocks kept for reuse */
+#define RING_SIZE (2 * VLEN)
+
+/* Blocks of MRU bytes, which go back to the ring when released, so that
+ * datagrams are received without allocation nor copy. The ring outlives the
+ * access while the demuxer still holds blocks. */
+typedef struct
+{
+    vlc_mutex_t lock;
+    unsigned refs; /* the access and the blocks out of the ring */
+    bool alive; /* whether the access is still open */
+    unsigned count;
+    block_t *blocks[RING_SIZE];
+} udp_ring_t;
+
+struct udp_block
+{
+    block_t self;
+    udp_ring_t *ring;
+};
+
 typedef struct {
     int fd;
     int timeout;
 
-    size_t length;
-    char *offset;
-    char buf[MRU];
+    udp_ring_t *ring;
+    block_t *posted[VLEN]; /* receive buffers, NULL once handed out */
+#ifdef HAVE_RECVMMSG
+    unsigned count; /* datagrams received in posted */
+    unsigned next; /* next datagram to hand out */
+    struct mmsghdr msgs[VLEN];
+    struct iovec iovecs[VLEN];
+#endif
 } access_sys_t;
 
+static void RingDestroy(udp_ring_t *ring)
+{
+    vlc_mutex_destroy(&ring->lock);
+    free(ring);
+}
+
+static void RingBlockRelease(block_t *block)
+{
+    struct udp_block *ub = container_of(block, struct udp_block, self);
+    udp_ring_t *ring = ub->ring;
+
+    vlc_mutex_lock(&ring->lock);
+    if (ring->alive && ring->count < RING_SIZE) {
+        ring->blocks[ring->count++] = block;
+        ub = NULL;
+    }
+    bool last = --ring->refs == 0;
+    vlc_mutex_unlock(&ring->lock);
+
+    free(ub);
+    if (last)
+        RingDestroy(ring);
+}
+
+static const struct vlc_block_callbacks ring_block_cbs =
+{
+    RingBlockRelease,
+};
+
+static block_t *RingBlockGet(udp_ring_t *ring)
+{
+    struct udp_block *ub = NULL;
+
+    vlc_mutex_lock(&ring->lock);
+    if (ring->count > 0)
+        ub = container_of(ring->blocks[--ring->count], struct udp_block, self);
+    ring->refs++;
+    vlc_mutex_unlock(&ring->lock);
+
+    if (ub == NULL) {
+        ub = malloc(sizeof (*ub) + MRU);
+        if (unlikely(ub == NULL)) {
+            vlc_mutex_lock(&ring->lock);
+            ring->refs--; /* the access holds a reference */
+            vlc_mutex_unlock(&ring->lock);
+            return NULL;
+        }
+        ub->ring = ring;
+    }
+    return block_Init(&ub->self, &ring_block_cbs, ub + 1, MRU);
+}
+
+static udp_ring_t *RingCreate(void)
+{
+    udp_ring_t *ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    vlc_mutex_init(&ring->lock);
+    ring->refs = 1;
+    ring->alive = true;
+    ring->count = 0;
+    return ring;
+}
+
+static void RingClose(udp_ring_t *ring)
+{
+    vlc_mutex_lock(&ring->lock);
+    ring->alive = false;
+    while (ring->count > 0)
+        free(container_of(ring->blocks[--ring->count], struct udp_block,
+                          self));
+    bool last = --ring->refs == 0;
+    vlc_mutex_unlock(&ring->lock);
+
+    if (last)
+        RingDestroy(ring);
+}
+
 static int Control(stream_t *access, int query, va_list args)
 {
     switch (query) {
@@ -83,20 +194,82 @@ static int Control(stream_t *access, int query, va_list args)
     return VLC_SUCCESS;
 }
 
-static ssize_t Read(stream_t *access, void *buf, size_t len)
+/* Gives receive buffers to the slots which handed theirs out */
+static unsigned PostBuffers(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    unsigned n;
+
+    for (n = 0; n < VLEN; n++)
+        if (sys->posted[n] == NULL
+         && (sys->posted[n] = RingBlockGet(sys->ring)) == NULL)
+            break;
+    return n;
+}
+
+#ifdef HAVE_RECVMMSG
+/**
+ * Receives as many datagrams as are pending (up to VLEN) in one call.
+ */
+static ssize_t ReadBatch(stream_t *access)
 {
     access_sys_t *sys = access->p_sys;
+    unsigned vlen = PostBuffers(access);
 
-    if (sys->length > 0) {
-        if (len > sys->length)
-            len = sys->length;
+    if (unlikely(vlen == 0))
+        return -1;
 
-        memcpy(buf, sys->offset, len);
-        sys->offset += len;
-        sys->length -= len;
-        return len;
+    for (unsigned i = 0; i < vlen; i++) {
+        sys->iovecs[i].iov_base = sys->posted[i]->p_buffer;
+        sys->iovecs[i].iov_len = MRU;
+        sys->msgs[i].msg_hdr.msg_flags = 0;
     }
 
+    int val = recvmmsg(sys->fd, sys->msgs, vlen, MSG_DONTWAIT, NULL);
+    if (val <= 0)
+        return -1;
+
+    sys->count = val;
+    sys->next = 0;
+    return val;
+}
+
+static block_t *NextDatagram(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    while (sys->next < sys->count) {
+        unsigned i = sys->next++;
+        const struct mmsghdr *msg = &sys->msgs[i];
+
+        /* Only IPv6 jumbograms can exceed the MRU */
+        if (unlikely(msg->msg_hdr.msg_flags & MSG_TRUNC)) {
+            msg_Err(access, "dropped truncated datagram");
+            continue;
+        }
+        /* Empty (0 bytes) datagrams are skipped */
+        if (msg->msg_len == 0)
+            continue;
+
+        block_t *block = sys->posted[i];
+        sys->posted[i] = NULL;
+        block->i_buffer = msg->msg_len;
+        return block;
+    }
+    return NULL;
+}
+#endif
+
+static block_t *BlockUDP(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+#ifdef HAVE_RECVMMSG
+    block_t *block = NextDatagram(access);
+    if (block != NULL)
+        return block;
+#endif
+
     struct pollfd ufd[1];
 
     ufd[0].fd = sys->fd;
@@ -105,31 +278,32 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
         case 0:
             msg_Err(access, "receive time-out");
-            return 0;
+            *eof = true;
+            /* fall through */
         case -1:
-            return -1;
+            return NULL;
     }
 
-    struct iovec iov[] = {
-        { .iov_base = buf,      .iov_len = len, },
-        { .iov_base = sys->buf, .iov_len = MRU, },
-    };
-    struct msghdr msg = {
-        .msg_iov = iov,
-        .msg_iovlen = ARRAY_SIZE(iov),
-    };
-    ssize_t val = recvmsg(sys->fd, &msg, 0);
+#ifdef HAVE_RECVMMSG
+    if (ReadBatch(access) <= 0)
+        return NULL;
 
-    if (val <= 0) /* empty (0 bytes) payload does *not* mean EOF here */
-        return -1;
+    /* empty (0 bytes) payload does *not* mean EOF here */
+    return NextDatagram(access);
+#else
+    if (PostBuffers(access) == 0)
+        return NULL;
 
-    if (unlikely((size_t)val > len)) {
-        sys->offset = sys->buf;
-        sys->length = val - len;
-        val = len;
-    }
+    block_t *block = sys->posted[0];
+    ssize_t val = recv(sys->fd, block->p_buffer, MRU, 0);
 
-    return val;
+    if (val <= 0) /* empty (0 bytes) payload does *not* mean EOF here */
+        return NULL;
+
+    sys->posted[0] = NULL;
+    block->i_buffer = val;
+    return block;
+#endif
 }
 
 /*****************************************************************************
@@ -147,10 +321,22 @@ static int Open( vlc_object_t *p_this )
     if( unlikely( sys == NULL ) )
         return VLC_ENOMEM;
 
-    sys->length = 0;
+    for (unsigned i = 0; i < VLEN; i++)
+        sys->posted[i] = NULL;
+#ifdef HAVE_RECVMMSG
+    sys->count = 0;
+    sys->next = 0;
+    /* Each datagram gets a full MRU buffer so that none can be truncated.
+     * Only the pages that actually receive data are ever touched. */
+    memset(sys->msgs, 0, sizeof (sys->msgs));
+    for (unsigned i = 0; i < VLEN; i++) {
+        sys->msgs[i].msg_hdr.msg_iov = &sys->iovecs[i];
+        sys->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
     p_access->p_sys = sys;
-    p_access->pf_read = Read;
-    p_access->pf_block = NULL;
+    p_access->pf_read = NULL;
+    p_access->pf_block = BlockUDP;
     p_access->pf_control = Control;
     p_access->pf_seek = NULL;
 
@@ -217,6 +403,14 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+    sys->ring = RingCreate();
+    if( unlikely(sys->ring == NULL) )
+    {
+        net_Close( sys->fd );
+        return VLC_ENOMEM;
+    }
+    PostBuffers( p_access );
+
     return VLC_SUCCESS;
 }
 
@@ -229,6 +423,10 @@ static void Close( vlc_object_t *p_this )
     access_sys_t *sys = p_access->p_sys;
 
     net_Close( sys->fd );
+    for( unsigned i = 0; i < VLEN; i++ )
+        if( sys->posted[i] != NULL )
+            block_Release( sys->posted[i] );
+    RingClose( sys->ring );
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
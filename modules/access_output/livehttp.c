@@ -961,6 +961,10 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
     {
         if( p_sys->key_uri && !crypted )
         {
+            /* Encrypted in place, while the payload may be shared */
+            output = block_MakeWritable( output );
+            if( unlikely(!output ) )
+                return VLC_ENOMEM;
             if( p_sys->stuffing_size )
             {
                 output = block_Realloc( output, p_sys->stuffing_size, output->i_buffer );
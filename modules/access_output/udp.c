@@ -45,11 +45,20 @@
 #elif defined (HAVE_SYS_SOCKET_H)
 #   include <sys/socket.h>
 #endif
+#ifdef __linux__
+#   include <netinet/udp.h>
+#endif
 
 #include <vlc_network.h>
 
 #define MAX_EMPTY_BLOCKS 200
 
+/* Maximum number of packets sent per system call */
+#define MAX_BATCH 64
+
+/* Maximum number of packets waiting for their date */
+#define MAX_QUEUED 16384
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -114,8 +123,11 @@ typedef struct
     bool          b_mtu_warning;
     size_t        i_mtu;
 
-    block_fifo_t *p_fifo;
+    vlc_spsc_fifo_t *p_fifo; /* from Write() to ThreadWrite() */
     block_t      *p_buffer;
+#ifdef UDP_SEGMENT
+    bool          b_gso; /* kernel UDP segmentation offload */
+#endif
 
     vlc_thread_t  thread;
 } sout_access_out_sys_t;
@@ -206,14 +218,26 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_handle = i_handle;
     p_sys->i_mtu = var_CreateGetInteger( p_this, "mtu" );
     p_sys->b_mtu_warning = false;
-    p_sys->p_fifo = block_FifoNew();
+    p_sys->p_fifo = vlc_spsc_fifo_New( MAX_QUEUED );
+    if( unlikely(p_sys->p_fifo == NULL) )
+    {
+        net_Close( i_handle );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
     p_sys->p_buffer = NULL;
+#ifdef UDP_SEGMENT
+    p_sys->b_gso = getsockopt( i_handle, SOL_UDP, UDP_SEGMENT, &(int){ 0 },
+                               &(socklen_t){ sizeof (int) } ) == 0;
+    if( p_sys->b_gso )
+        msg_Dbg( p_access, "using UDP segmentation offload" );
+#endif
 
     if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
     {
         msg_Err( p_access, "cannot spawn sout access thread" );
-        block_FifoRelease( p_sys->p_fifo );
+        vlc_spsc_fifo_Delete( p_sys->p_fifo );
         net_Close (i_handle);
         free (p_sys);
         return VLC_EGENERIC;
@@ -234,8 +258,14 @@ static void Close( vlc_object_t * p_this )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
 
     vlc_cancel( p_sys->thread );
+    /* Sleeping on an empty queue is not a cancellation point: wake the
+     * thread up with an empty block. If the queue is full, the thread
+     * is not sleeping on it. */
+    block_t *p_wakeup = block_Alloc( 0 );
+    if( p_wakeup && !vlc_spsc_fifo_TryQueue( p_sys->p_fifo, p_wakeup ) )
+        block_Release( p_wakeup );
     vlc_join( p_sys->thread, NULL );
-    block_FifoRelease( p_sys->p_fifo );
+    vlc_spsc_fifo_Delete( p_sys->p_fifo );
 
     if( p_sys->p_buffer ) block_Release( p_sys->p_buffer );
 
@@ -290,7 +320,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                          now - p_sys->p_buffer->i_dts
                           - p_sys->i_caching );
             }
-            block_FifoPut( p_sys->p_fifo, p_sys->p_buffer );
+            vlc_spsc_fifo_Queue( p_sys->p_fifo, p_sys->p_buffer );
             p_sys->p_buffer = NULL;
         }
 
@@ -332,7 +362,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                              vlc_tick_now() - p_sys->p_buffer->i_dts
                               - p_sys->i_caching );
                 }
-                block_FifoPut( p_sys->p_fifo, p_sys->p_buffer );
+                vlc_spsc_fifo_Queue( p_sys->p_fifo, p_sys->p_buffer );
                 p_sys->p_buffer = NULL;
             }
         }
@@ -345,6 +375,115 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
     return i_len;
 }
 
+#ifdef UDP_SEGMENT
+/*****************************************************************************
+ * SendSegmented: send a batch as a single super-datagram that the kernel
+ * splits into packets of the same size (only the last one may be shorter).
+ *****************************************************************************/
+static int SendSegmented( sout_access_out_t *p_access,
+                          block_t *const *pp_pk, unsigned i_count )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    const size_t i_segment = pp_pk[0]->i_buffer;
+    struct iovec iov[MAX_BATCH];
+    size_t i_total = 0;
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        if( pp_pk[i]->i_buffer > i_segment ||
+            (pp_pk[i]->i_buffer < i_segment && i + 1 < i_count) )
+            return VLC_EGENERIC;
+        iov[i].iov_base = pp_pk[i]->p_buffer;
+        iov[i].iov_len = pp_pk[i]->i_buffer;
+        i_total += pp_pk[i]->i_buffer;
+    }
+    if( i_total > 65507 )
+        return VLC_EGENERIC;
+
+    union
+    {
+        char buf[CMSG_SPACE(sizeof (uint16_t))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = i_count,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof (control.buf),
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR( &msg );
+
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof (uint16_t));
+    memcpy( CMSG_DATA(cmsg), &(uint16_t){ i_segment }, sizeof (uint16_t) );
+
+    if( sendmsg( p_sys->i_handle, &msg, 0 ) == -1 )
+    {
+        if( errno == EIO || errno == EINVAL || errno == ENOPROTOOPT )
+        {   /* Not supported for this route or device */
+            msg_Dbg( p_access, "UDP segmentation offload disabled: %s",
+                     vlc_strerror_c(errno) );
+            p_sys->b_gso = false;
+            return VLC_EGENERIC;
+        }
+        msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+    }
+    return VLC_SUCCESS;
+}
+#endif
+
+/*****************************************************************************
+ * SendBatch: send packets with as few system calls as possible.
+ *****************************************************************************/
+static void SendBatch( sout_access_out_t *p_access,
+                       block_t *const *pp_pk, unsigned i_count )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+#ifdef UDP_SEGMENT
+    if( p_sys->b_gso && i_count > 1 &&
+        SendSegmented( p_access, pp_pk, i_count ) == VLC_SUCCESS )
+        return;
+#endif
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[MAX_BATCH];
+    struct iovec iov[MAX_BATCH];
+
+    memset( msgs, 0, i_count * sizeof (*msgs) );
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        iov[i].iov_base = pp_pk[i]->p_buffer;
+        iov[i].iov_len = pp_pk[i]->i_buffer;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for( unsigned i = 0; i < i_count; )
+    {
+        int val = sendmmsg( p_sys->i_handle, &msgs[i], i_count - i, 0 );
+        if( val == -1 )
+        {   /* Skip the failing packet */
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            val = 1;
+        }
+        i += val;
+    }
+#else
+    for( unsigned i = 0; i < i_count; i++ )
+        if( send( p_sys->i_handle, pp_pk[i]->p_buffer, pp_pk[i]->i_buffer,
+                  0 ) == -1 )
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+#endif
+}
+
+static void WaitPacket( block_t *p_pk, vlc_tick_t i_date )
+{
+    block_cleanup_push( p_pk );
+    vlc_tick_wait( i_date );
+    vlc_cleanup_pop();
+}
+
 /*****************************************************************************
  * ThreadWrite: Write a packet on the network at the good time.
  *****************************************************************************/
@@ -357,45 +496,99 @@ static void* ThreadWrite( void *data )
                                              SOUT_CFG_PREFIX "group" );
     int i_to_send = i_group;
     unsigned i_dropped_packets = 0;
+    block_t *p_next = NULL; /* dequeued packet waiting for its own date */
+    bool b_next_wait = false;
 
     for (;;)
     {
-        block_t *p_pk = block_FifoGet( p_sys->p_fifo );
-        vlc_tick_t    i_date;
+        block_t *pp_batch[MAX_BATCH];
+        unsigned i_batch = 0;
+        vlc_tick_t i_date_first = VLC_TICK_INVALID;
 
-        i_date = p_sys->i_caching + p_pk->i_dts;
-        if( i_date_last > 0 )
+        /* Packets that need not be waited for, or whose date was reached
+         * already, are sent together with the previous ones. */
+        while( i_batch < MAX_BATCH )
         {
-            if( i_date - i_date_last > VLC_TICK_FROM_SEC(2) )
+            block_t *p_pk;
+            bool b_wait;
+
+            if( p_next != NULL )
             {
-                if( !i_dropped_packets )
-                    msg_Dbg( p_access, "mmh, hole (%"PRId64" > 2s) -> drop",
-                             i_date - i_date_last );
+                p_pk = p_next;
+                b_wait = b_next_wait;
+                p_next = NULL;
+            }
+            else
+            {
+                if( i_batch == 0 )
+                    p_pk = vlc_spsc_fifo_Dequeue( p_sys->p_fifo );
+                else
+                {
+                    p_pk = vlc_spsc_fifo_TryDequeue( p_sys->p_fifo );
+                    if( p_pk == NULL )
+                        break;
+                }
 
-                block_Release( p_pk );
+                if( p_pk->i_buffer == 0 )
+                {   /* Wake-up from Close() */
+                    block_Release( p_pk );
+                    if( i_batch > 0 )
+                        break;
+                    continue; /* cancelled when dequeuing again */
+                }
 
+                vlc_tick_t i_date = p_sys->i_caching + p_pk->i_dts;
+                if( i_date_last > 0 )
+                {
+                    if( i_date - i_date_last > VLC_TICK_FROM_SEC(2) )
+                    {
+                        if( !i_dropped_packets )
+                            msg_Dbg( p_access, "mmh, hole (%"PRId64" > 2s) -> drop",
+                                     i_date - i_date_last );
+
+                        block_Release( p_pk );
+
+                        i_date_last = i_date;
+                        i_dropped_packets++;
+                        continue;
+                    }
+                    else if( i_date - i_date_last < VLC_TICK_FROM_MS(-1) )
+                    {
+                        if( !i_dropped_packets )
+                            msg_Dbg( p_access, "mmh, packets in the past (%"PRId64")",
+                                     i_date_last - i_date );
+                    }
+                }
                 i_date_last = i_date;
-                i_dropped_packets++;
-                continue;
+
+                i_to_send--;
+                b_wait = !i_to_send || (p_pk->i_flags & BLOCK_FLAG_CLOCK);
+                if( b_wait )
+                    i_to_send = i_group;
             }
-            else if( i_date - i_date_last < VLC_TICK_FROM_MS(-1) )
+
+            vlc_tick_t i_date = p_sys->i_caching + p_pk->i_dts;
+            if( b_wait )
             {
-                if( !i_dropped_packets )
-                    msg_Dbg( p_access, "mmh, packets in the past (%"PRId64")",
-                             i_date_last - i_date );
+                if( i_batch > 0 && i_date > vlc_tick_now() )
+                {   /* Send what we have, then wait for this one */
+                    p_next = p_pk;
+                    b_next_wait = true;
+                    break;
+                }
+
+                if( i_batch == 0 )
+                    WaitPacket( p_pk, i_date );
             }
-        }
 
-        block_cleanup_push( p_pk );
-        i_to_send--;
-        if( !i_to_send || (p_pk->i_flags & BLOCK_FLAG_CLOCK) )
-        {
-            vlc_tick_wait( i_date );
-            i_to_send = i_group;
+            if( i_batch == 0 )
+                i_date_first = i_date;
+            pp_batch[i_batch++] = p_pk;
         }
-        if ( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
-            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
-        vlc_cleanup_pop();
+
+        int canc = vlc_savecancel();
+        SendBatch( p_access, pp_batch, i_batch );
+        vlc_restorecancel( canc );
 
         if( i_dropped_packets )
         {
@@ -403,19 +596,17 @@ static void* ThreadWrite( void *data )
             i_dropped_packets = 0;
         }
 
-        i_date_last = i_date;
-
 #if 1
-        i_date = vlc_tick_now() - i_date;
-        if ( i_date > VLC_TICK_FROM_MS(20) )
+        vlc_tick_t i_late = vlc_tick_now() - i_date_first;
+        if ( i_late > VLC_TICK_FROM_MS(20) )
         {
             msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
-                     i_date );
+                     i_late );
         }
 #endif
 
-        block_Release( p_pk );
-
+        for( unsigned i = 0; i < i_batch; i++ )
+            block_Release( pp_batch[i] );
     }
     return NULL;
 }
@@ -36,6 +36,7 @@
 
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
+#include <math.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -88,12 +89,18 @@ vlc_module_end ()
  * Scaletempo smooths the overlap further by searching within the input buffer
  * for the best overlap position.  Scaletempo uses a statistical cross correlation
  * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here.
+ * For long searches, the correlation is computed for all offsets at once in
+ * the frequency domain, summing the spectra of all channels.
  *
  * NOTE:
  * sample: a single audio sample for one channel
  * frame: a single set of samples, one for each channel
  * VLC uses these terms differently
  */
+/* Cost of the transforms, per point and per pass, relative to a multiply-add
+ * of the direct search (measured with test/modules/audio_filter/scaletempo_bench.c) */
+#define FFT_COST_FACTOR 4.0
+
 typedef struct
 {
     /* Filter static config */
@@ -129,6 +136,10 @@ typedef struct
     void     *buf_pre_corr;
     void     *table_window;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    /* FFT cross correlation */
+    unsigned  fft_size;
+    float    *fft_buf;
+    unsigned *fft_rev;
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -136,9 +147,122 @@ typedef struct
 #endif
 } filter_sys_t;
 
+/*****************************************************************************
+ * dot_product_float: inner product of two vectors
+ *****************************************************************************/
+static float dot_product_float( const float *restrict a, const float *restrict b,
+                                unsigned n )
+{
+    /* Independent sums, so that the compiler can vectorize the loop */
+    float sum[4] = { 0, 0, 0, 0 };
+    unsigned i;
+    for( i = 0; i + 4 <= n; i += 4 ) {
+        sum[0] += a[i + 0] * b[i + 0];
+        sum[1] += a[i + 1] * b[i + 1];
+        sum[2] += a[i + 2] * b[i + 2];
+        sum[3] += a[i + 3] * b[i + 3];
+    }
+    for( ; i < n; i++ )
+        sum[0] += a[i] * b[i];
+    return ( sum[0] + sum[1] ) + ( sum[2] + sum[3] );
+}
+
+/*****************************************************************************
+ * fft_float: in-place radix-2 complex FFT of p_sys->fft_size values
+ *****************************************************************************/
+static void fft_float( const filter_sys_t *p, float *re, float *im )
+{
+    const unsigned n = p->fft_size;
+    const float *cos_table = p->fft_buf + 4 * n;
+    const float *sin_table = cos_table + n / 2;
+
+    for( unsigned i = 0; i < n; i++ ) {
+        unsigned j = p->fft_rev[i];
+        if( j > i ) {
+            float t;
+            t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for( unsigned half = 1, step = n / 2; half < n; half *= 2, step /= 2 ) {
+        for( unsigned k = 0; k < half; k++ ) {
+            const float wr = cos_table[k * step];
+            const float wi = sin_table[k * step];
+            for( unsigned a = k; a < n; a += 2 * half ) {
+                unsigned b = a + half;
+                float tr = wr * re[b] - wi * im[b];
+                float ti = wr * im[b] + wi * re[b];
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
+static unsigned best_overlap_offset_fft( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned channels = p->samples_per_frame;
+    const unsigned n = p->fft_size;
+    const unsigned frames_corr = p->samples_overlap / channels - 1;
+    const unsigned frames_in = p->frames_search + frames_corr - 1;
+    const float *pw = p->table_window;
+    const float *po = (float *)p->buf_overlap + channels;
+    const float *ps = (float *)p->buf_queue + channels;
+    float *re = p->fft_buf, *im = re + n;
+    float *acc_re = im + n, *acc_im = acc_re + n;
+    unsigned i, k;
+
+    memset( acc_re, 0, 2 * n * sizeof (float) );
+    for( unsigned c = 0; c < channels; c++ ) {
+        /* Transform the searched input and the windowed overlap at once, as
+         * the real and imaginary parts of the same signal. The transform
+         * size leaves room enough for the correlation not to wrap around. */
+        for( i = 0; i < frames_in; i++ )
+            re[i] = ps[i * channels + c];
+        for( ; i < n; i++ )
+            re[i] = 0;
+        for( i = 0; i < frames_corr; i++ )
+            im[i] = pw[i * channels + c] * po[i * channels + c];
+        for( ; i < n; i++ )
+            im[i] = 0;
+
+        fft_float( p, re, im );
+
+        /* Split both spectra and accumulate their cross-spectrum */
+        for( k = 0; k < n; k++ ) {
+            unsigned nk = ( n - k ) & ( n - 1 );
+            float sr = re[k] + re[nk], si = im[k] - im[nk];
+            float wr = im[k] + im[nk], wi = re[nk] - re[k];
+            acc_re[k] += wr * sr + wi * si;
+            acc_im[k] += wr * si - wi * sr;
+        }
+    }
+
+    /* The correlation is real: take the real part of the forward transform
+     * of the conjugate, rather than an inverse transform */
+    for( k = 0; k < n; k++ )
+        acc_im[k] = -acc_im[k];
+    fft_float( p, acc_re, acc_im );
+
+    float best_corr = acc_re[0];
+    unsigned best_off = 0;
+    for( k = 1; k < p->frames_search; k++ ) {
+        if( acc_re[k] > best_corr ) {
+            best_corr = acc_re[k];
+            best_off  = k;
+        }
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
 static unsigned best_overlap_offset_float( filter_t *p_filter )
 {
     filter_sys_t *p = p_filter->p_sys;
@@ -157,12 +281,8 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
+      float corr = dot_product_float( p->buf_pre_corr, search_start,
+                                      p->samples_overlap - p->samples_per_frame );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
@@ -352,6 +472,42 @@ static int reinit_buffers( filter_t *p_filter )
                 *pw++ = v;
         }
         p->best_overlap_offset = best_overlap_offset_float;
+
+        /* The transforms cost O(n log n) per channel, plus one for the
+         * inverse, against O(search * overlap) for the direct search */
+        unsigned frames_in = p->frames_search + frames_overlap - 2;
+        unsigned log2_size = 1;
+        while( ( 1u << log2_size ) < frames_in )
+            log2_size++;
+        unsigned n = 1u << log2_size;
+        double cost_direct = (double)p->frames_search * ( frames_overlap - 1 )
+                           * p->samples_per_frame;
+        double cost_fft = ( p->samples_per_frame + 1. ) * n * log2_size
+                        * FFT_COST_FACTOR;
+        if( cost_fft < cost_direct )
+        {
+            p->fft_size = n;
+            p->fft_buf  = vlc_alloc( 5 * n, sizeof (float) );
+            p->fft_rev  = vlc_alloc( n, sizeof (unsigned) );
+            if( ! p->fft_buf || ! p->fft_rev )
+                return VLC_ENOMEM;
+
+            float *cos_table = p->fft_buf + 4 * n;
+            float *sin_table = cos_table + n / 2;
+            for( i = 0; i < n / 2; i++ )
+            {
+                cos_table[i] =  cos( 2 * M_PI * i / n );
+                sin_table[i] = -sin( 2 * M_PI * i / n );
+            }
+            for( i = 0; i < n; i++ )
+            {
+                unsigned rev = 0;
+                for( j = 0; j < log2_size; j++ )
+                    rev |= ( ( i >> j ) & 1 ) << ( log2_size - 1 - j );
+                p->fft_rev[i] = rev;
+            }
+            p->best_overlap_offset = best_overlap_offset_fft;
+        }
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -381,13 +537,14 @@ static int reinit_buffers( filter_t *p_filter )
     p->frames_stride_scaled = p->bytes_stride_scaled / p->bytes_per_frame;
 
     msg_Dbg( VLC_OBJECT(p_filter),
-             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode",
+             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search%s, %i queue, %s mode",
              p->scale,
              p->frames_stride_scaled,
              (int)( p->bytes_stride / p->bytes_per_frame ),
              (int)( p->bytes_standing / p->bytes_per_frame ),
              (int)( p->bytes_overlap / p->bytes_per_frame ),
              p->frames_search,
+             p->best_overlap_offset == best_overlap_offset_fft ? " (fft)" : "",
              (int)( p->bytes_queue_max / p->bytes_per_frame ),
              "fl32");
 
@@ -430,6 +587,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->fft_size       = 0;
+    p_sys->fft_buf        = NULL;
+    p_sys->fft_rev        = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
@@ -527,6 +687,8 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->fft_buf );
+    free( p_sys->fft_rev );
     free( p_sys );
 }
 
@@ -617,3 +779,107 @@ static block_t *DoPitchWork( filter_t * p_filter, block_t * p_in_buf )
     return DoWork( p_filter, p_in_buf );
 }
 #endif
+
+#ifdef SCALETEMPO_TEST
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdlib.h>
+
+static float correlation_at( const filter_sys_t *p, unsigned bytes_off )
+{
+    /* buf_pre_corr is filled by the direct search */
+    return dot_product_float( p->buf_pre_corr,
+                              (float *)( p->buf_queue + bytes_off ) + p->samples_per_frame,
+                              p->samples_overlap - p->samples_per_frame );
+}
+
+static void fill_random( float *buf, size_t count )
+{
+    for( size_t i = 0; i < count; i++ )
+        buf[i] = 2.f * rand() / RAND_MAX - 1.f;
+}
+
+static void fill_periodic( float *buf, size_t count, unsigned channels,
+                           unsigned period )
+{
+    for( size_t i = 0; i < count; i++ )
+    {
+        double t = (double)( i / channels ) / period;
+        unsigned c = i % channels;
+        buf[i] = .6f * sin( 2 * M_PI * t + c ) + .4f * sin( 6 * M_PI * t );
+    }
+}
+
+/**
+ * Checks that the FFT search finds the offset of the direct search, or one
+ * whose correlation is as high within rounding errors (periodic input has
+ * several equal maxima).
+ */
+static void check_offsets( filter_t *p_filter, unsigned channels, bool periodic )
+{
+    filter_sys_t *p;
+
+    p_filter->fmt_in.audio.i_rate = 48000;
+    p_filter->fmt_in.audio.i_physical_channels = channels == 2
+        ? AOUT_CHANS_STEREO : AOUT_CHANS_5_1;
+    assert( aout_FormatNbChannels( &p_filter->fmt_in.audio ) == channels );
+
+    assert( Open( VLC_OBJECT(p_filter) ) == VLC_SUCCESS );
+    p = p_filter->p_sys;
+    assert( p->best_overlap_offset == best_overlap_offset_fft );
+
+    for( unsigned round = 0; round < 20; round++ )
+    {
+        size_t queue = p->bytes_queue_max / sizeof (float);
+        size_t overlap = p->bytes_overlap / sizeof (float);
+        if( periodic )
+        {
+            fill_periodic( (float *)p->buf_queue, queue, channels, 50 + 37 * round );
+            fill_periodic( p->buf_overlap, overlap, channels, 50 + 37 * round );
+        }
+        else
+        {
+            fill_random( (float *)p->buf_queue, queue );
+            fill_random( p->buf_overlap, overlap );
+        }
+
+        unsigned off_fft = best_overlap_offset_fft( p_filter );
+        unsigned off_direct = best_overlap_offset_float( p_filter );
+        assert( off_fft % p->bytes_per_frame == 0 );
+        assert( off_fft / p->bytes_per_frame < p->frames_search );
+        if( off_fft != off_direct )
+        {
+            float best = correlation_at( p, off_direct );
+            float found = correlation_at( p, off_fft );
+            assert( best - found <= 1e-4f * fabsf( best ) );
+        }
+    }
+
+    Close( VLC_OBJECT(p_filter) );
+}
+
+int main( void )
+{
+    vlc_object_t *root = NULL;
+    filter_t *p_filter = vlc_object_create( root, sizeof (*p_filter) );
+    assert( p_filter != NULL );
+
+    /* Default parameters, for which the FFT search is used */
+    var_Create( p_filter, "scaletempo-stride", VLC_VAR_INTEGER );
+    var_SetInteger( p_filter, "scaletempo-stride", 30 );
+    var_Create( p_filter, "scaletempo-overlap", VLC_VAR_FLOAT );
+    var_SetFloat( p_filter, "scaletempo-overlap", .2f );
+    var_Create( p_filter, "scaletempo-search", VLC_VAR_INTEGER );
+    var_SetInteger( p_filter, "scaletempo-search", 14 );
+
+    srand( 0 );
+    check_offsets( p_filter, 2, false );
+    check_offsets( p_filter, 2, true );
+    check_offsets( p_filter, 6, false );
+    check_offsets( p_filter, 6, true );
+
+    vlc_object_delete( p_filter );
+    return 0;
+}
+#endif
@@ -39,6 +39,7 @@
 #include <vlc_plugin.h>
 #include <vlc_interface.h>
 #include <vlc_input_item.h>
+#include <vlc_block.h>
 #include <vlc_aout.h>
 #include <vlc_vout.h>
 #include <vlc_player.h>
@@ -1206,8 +1207,22 @@ static void Statistics(intf_thread_t *intf)
         msg_print(intf, _("| buffers lost     :    %5"PRIi64),
                   item->p_stats->i_lost_abuffers);
         msg_print(intf, "|");
-
         vlc_mutex_unlock(&item->lock);
+
+        /* Blocks pool, shared by the whole process */
+        uintmax_t hits, misses, bytes;
+
+        block_PoolStats(&hits, &misses, &bytes);
+        if (hits + misses > 0)
+        {
+            msg_print(intf, "%s", _("+-[Data Blocks Pool (all inputs)]"));
+            msg_print(intf, _("| pool hits        : %8ju"), hits);
+            msg_print(intf, _("| pool misses      : %8ju"), misses);
+            msg_print(intf, _("| bytes in use     : %8.0f KiB"),
+                      (float)bytes / 1024.f);
+            msg_print(intf, "|");
+        }
+
         msg_print(intf,  "+----[ end of statistical info ]" );
     }
     vlc_player_Unlock(player);
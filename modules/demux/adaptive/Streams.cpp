@@ -52,6 +52,7 @@ AbstractStream::AbstractStream(demux_t * demux_)
     needrestart = false;
     inrestart = false;
     segmentTracker = NULL;
+    connManager = NULL;
     demuxersource = NULL;
     demuxer = NULL;
     fakeesout = NULL;
@@ -670,6 +671,19 @@ void AbstractStream::trackerEvent(const SegmentTrackerEvent &event)
             }
             break;
 
+        /* Let the downloader serve first the streams about to run dry */
+        case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+            if(connManager)
+                connManager->updateBufferingLevel(*event.u.buffering_level.id,
+                                                  event.u.buffering_level.current);
+            break;
+
+        case SegmentTrackerEvent::BUFFERING_STATE:
+            if(!event.u.buffering.enabled && connManager)
+                connManager->updateBufferingLevel(*event.u.buffering.id,
+                                                  VLC_TICK_INVALID);
+            break;
+
         default:
             break;
     }
@@ -76,6 +76,21 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_PARALLEL_TEXT N_("Maximum parallel downloads")
+#define ADAPT_PARALLEL_LONGTEXT N_("Maximum number of segments downloaded at " \
+                                   "the same time, from different streams")
+
+#define ADAPT_CACHE_MEMORY_TEXT N_("Segments cache size in MiB")
+#define ADAPT_CACHE_MEMORY_LONGTEXT N_("Memory used to keep downloaded segments " \
+                                       "for seeking back or switching back (0 disables it)")
+#define ADAPT_CACHE_DISK_TEXT N_("Segments disk cache size in MiB")
+#define ADAPT_CACHE_DISK_LONGTEXT N_("Disk space used to keep the segments " \
+                                     "which do not fit in memory anymore")
+
+#define ADAPT_LOWLATENCY_TEXT N_("Low latency")
+#define ADAPT_LOWLATENCY_LONGTEXT N_("Play live streams close to the live edge, " \
+                                     "using partial segments when available")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
@@ -122,6 +137,13 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_integer( "adaptive-maxparallel", 3, ADAPT_PARALLEL_TEXT, ADAPT_PARALLEL_LONGTEXT, true )
+            change_integer_range( 1, 16 )
+        add_integer( "adaptive-cache-memory", 0, ADAPT_CACHE_MEMORY_TEXT, ADAPT_CACHE_MEMORY_LONGTEXT, true )
+            change_integer_range( 0, 4096 )
+        add_integer( "adaptive-cache-disk", 0, ADAPT_CACHE_DISK_TEXT, ADAPT_CACHE_DISK_LONGTEXT, true )
+            change_integer_range( 0, 65536 )
+        add_bool   ( "adaptive-lowlatency", false, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT, false )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -29,14 +29,19 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
 
 #include <algorithm>
+#include <cassert>
 
 using namespace adaptive::http;
 
+#define PARTIAL_HEAD_SIZE 1024
+#define PARTIAL_ALIGN     16
+
 AbstractChunkSource::AbstractChunkSource()
 {
     contentLength = 0;
@@ -116,7 +121,8 @@ block_t * AbstractChunk::doRead(size_t size, bool b_block)
             block->i_flags |= BLOCK_FLAG_HEADER;
         bytesRead += block->i_buffer;
         onDownload(&block);
-        block->i_flags &= ~BLOCK_FLAG_HEADER;
+        if(block)
+            block->i_flags &= ~BLOCK_FLAG_HEADER;
     }
 
     return block;
@@ -232,6 +238,11 @@ block_t * HTTPChunkSource::read(size_t readsize)
     return p_block;
 }
 
+const std::string & HTTPChunkSource::getUrl() const
+{
+    return params.getUrl();
+}
+
 std::string HTTPChunkSource::getContentType() const
 {
     vlc_mutex_locker locker(&lock);
@@ -304,6 +315,12 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     eof = false;
     held = false;
     downloadstart = 0;
+    cache = NULL;
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
+    cachesize = 0;
+    cached = false;
+    partial = false;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -313,7 +330,7 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
 
     vlc_mutex_lock(&lock);
     done = true;
-    if(held) /* wait release if not in queue but currently downloaded */
+    while(held) /* wait release if not in queue but currently downloaded */
         vlc_cond_wait(&avail, &lock);
 
     if(p_head)
@@ -323,6 +340,7 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         pp_tail = &p_head;
     }
     buffered = 0;
+    block_ChainRelease(p_cachehead);
     vlc_mutex_unlock(&lock);
 
     vlc_cond_destroy(&avail);
@@ -334,6 +352,41 @@ bool HTTPChunkBufferedSource::isDone() const
     return done;
 }
 
+void HTTPChunkBufferedSource::setCache(SegmentCache *cache_)
+{
+    vlc_mutex_locker locker( &lock );
+    cache = cache_;
+}
+
+void HTTPChunkBufferedSource::setPartialReads(bool b)
+{
+    vlc_mutex_locker locker( &lock );
+    partial = b;
+}
+
+void HTTPChunkBufferedSource::setCachedData(block_t *p_chain, const std::string &type)
+{
+    vlc_mutex_locker locker( &lock );
+    assert(p_head == NULL);
+    block_ChainProperties(p_chain, NULL, &buffered, NULL);
+    block_ChainLastAppend(&pp_tail, p_chain);
+    contentLength = buffered;
+    cachedType = type;
+    cached = true;
+    prepared = true;
+    done = true;
+}
+
+std::string HTTPChunkBufferedSource::getContentType() const
+{
+    {
+        vlc_mutex_locker locker( &lock );
+        if(cached)
+            return cachedType;
+    }
+    return HTTPChunkSource::getContentType();
+}
+
 void HTTPChunkBufferedSource::hold()
 {
     vlc_mutex_locker locker( &lock );
@@ -379,14 +432,57 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         size_t size;
         vlc_tick_t time;
     } rate = {0,0};
+    bool finished = false;
+    SegmentCache *store = NULL;
+    block_t *p_complete = NULL;
 
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    ssize_t ret = 0;
+    if(!partial)
+    {
+        ret = connection->read(p_block->p_buffer, readsize);
+    }
+    else
+    {
+        /* Don't wait for the whole block: data is handed over as it arrives.
+         * The segment head still needs to be large enough for probing, and
+         * blocks are kept aligned to the cipher block size for decryption. */
+        size_t minsize = (buffered + consumed) ? 1 : PARTIAL_HEAD_SIZE;
+        if(minsize > readsize)
+            minsize = readsize;
+        for(;;)
+        {
+            ssize_t val = connection->readPartial(&p_block->p_buffer[ret], readsize - ret);
+            if(val <= 0)
+            {
+                if(ret == 0)
+                    ret = val;
+                break;
+            }
+            ret += val;
+            if((size_t) ret == readsize ||
+               ((size_t) ret >= minsize && (ret % PARTIAL_ALIGN) == 0))
+                break;
+        }
+
+        /* Don't keep a whole block allocated for a few network packets */
+        if(ret > 0 && (size_t) ret < readsize / 2)
+        {
+            block_t *p_short = block_Alloc(ret);
+            if(p_short)
+            {
+                memcpy(p_short->p_buffer, p_block->p_buffer, ret);
+                block_Release(p_block);
+                p_block = p_short;
+            }
+        }
+    }
     if(ret <= 0)
     {
         block_Release(p_block);
         p_block = NULL;
         vlc_mutex_locker locker( &lock );
         done = true;
+        finished = (ret == 0);
         rate.size = buffered + consumed;
         rate.time = vlc_tick_now() - downloadstart;
         downloadstart = 0;
@@ -395,17 +491,51 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     {
         p_block->i_buffer = (size_t) ret;
         vlc_mutex_locker locker( &lock );
+        if(cache)
+        {
+            /* Keep a reference to the whole data, as long as it can be cached */
+            block_t *p_share = NULL;
+            cachesize += p_block->i_buffer;
+            if(cachesize <= cache->getMaxSize())
+                p_share = block_Share(p_block);
+            if(p_share)
+                block_ChainLastAppend(&pp_cachetail, p_share);
+            else
+                cache = NULL;
+        }
         buffered += p_block->i_buffer;
         block_ChainLastAppend(&pp_tail, p_block);
-        if((size_t) ret < readsize)
+        /* A short read means the end of the reply, unless reading partially */
+        if((!partial && (size_t) ret < readsize) ||
+           (contentLength && buffered + consumed >= contentLength))
         {
             done = true;
+            finished = true;
             rate.size = buffered + consumed;
             rate.time = vlc_tick_now() - downloadstart;
             downloadstart = 0;
         }
     }
 
+    if(finished)
+    {
+        vlc_mutex_locker locker( &lock );
+        /* Only store complete downloads */
+        if(cache && requeststatus == RequestStatus::Success &&
+           (!contentLength || cachesize == contentLength))
+        {
+            store = cache;
+            p_complete = p_cachehead;
+        }
+        else
+            block_ChainRelease(p_cachehead);
+        p_cachehead = NULL;
+        pp_cachetail = &p_cachehead;
+    }
+
+    if(p_complete)
+        store->put(getUrl(), bytesRange, connection->getContentType(), p_complete);
+
     if(rate.size && rate.time)
     {
         connManager->updateDownloadRate(sourceid, rate.size, rate.time);
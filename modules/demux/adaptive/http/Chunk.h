@@ -39,6 +39,7 @@ namespace adaptive
     namespace http
     {
         class AbstractConnection;
+        class SegmentCache;
         class AbstractConnectionManager;
         class AbstractChunk;
 
@@ -97,6 +98,7 @@ namespace adaptive
                 virtual block_t *   read            (size_t); /* impl */
                 virtual bool        hasMoreData     () const; /* impl */
                 virtual std::string getContentType  () const; /* reimpl */
+                const std::string & getUrl          () const;
 
                 static const size_t CHUNK_SIZE = 32768;
 
@@ -126,8 +128,12 @@ namespace adaptive
                 virtual block_t *  readBlock       (); /* reimpl */
                 virtual block_t *  read            (size_t); /* reimpl */
                 virtual bool       hasMoreData     () const; /* impl */
+                virtual std::string getContentType () const; /* reimpl */
                 void               hold();
                 void               release();
+                void               setCache(SegmentCache *);
+                void               setCachedData(block_t *, const std::string &);
+                void               setPartialReads(bool);
 
             protected:
                 virtual bool       prepare(); /* reimpl */
@@ -138,6 +144,13 @@ namespace adaptive
                 block_t            *p_head; /* read cache buffer */
                 block_t           **pp_tail;
                 size_t              buffered; /* read cache size */
+                SegmentCache       *cache; /* where to store the whole data */
+                block_t            *p_cachehead; /* copy of the data */
+                block_t           **pp_cachetail;
+                size_t              cachesize;
+                std::string         cachedType; /* set if read from the cache */
+                bool                cached;
+                bool                partial; /* hand over data as it arrives */
                 bool                done;
                 bool                eof;
                 vlc_tick_t          downloadstart;
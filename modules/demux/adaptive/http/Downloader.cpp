@@ -25,39 +25,31 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
-
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Lane::Lane()
 {
-    vlc_mutex_init(&lock);
-    vlc_cond_init(&waitcond);
-    killed = false;
-    thread_handle_valid = false;
+    current = NULL;
+    canceled = false;
 }
 
-bool Downloader::start()
+Downloader::Downloader(unsigned maxThreads_)
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
-    {
-        return false;
-    }
-    thread_handle_valid = true;
-    return true;
+    vlc_mutex_init(&lock);
+    vlc_cond_init(&waitcond);
+    killed = false;
+    maxThreads = maxThreads_ ? maxThreads_ : 1;
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, NULL);
+    for(size_t i = 0; i < threads.size(); i++)
+        vlc_join(threads[i], NULL);
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
 }
@@ -65,7 +57,15 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
     source->hold();
-    chunks.push_back(source);
+    lanes[source->sourceid].chunks.push_back(source);
+    /* Threads are started as lanes get used, up to maxThreads */
+    if(threads.size() < maxThreads && threads.size() < lanes.size())
+    {
+        vlc_thread_t thread_handle;
+        if(!vlc_clone(&thread_handle, downloaderThread,
+                      static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            threads.push_back(thread_handle);
+    }
     vlc_cond_signal(&waitcond);
     vlc_mutex_unlock(&lock);
 }
@@ -73,8 +73,34 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
-    source->release();
-    chunks.remove(source);
+    std::map<ID, Lane>::iterator it = lanes.find(source->sourceid);
+    if(it != lanes.end())
+    {
+        Lane &lane = (*it).second;
+        if(lane.current == source)
+        {
+            /* The downloading thread will release it once done with it */
+            lane.canceled = true;
+        }
+        else
+        {
+            lane.chunks.remove(source);
+            source->release();
+            /* Streams come and go with representation switches */
+            if(lane.chunks.empty())
+                lanes.erase(it);
+        }
+    }
+    vlc_mutex_unlock(&lock);
+}
+
+void Downloader::updateBufferingLevel(const ID &id, vlc_tick_t level)
+{
+    vlc_mutex_lock(&lock);
+    if(level == VLC_TICK_INVALID)
+        levels.erase(id); /* the stream is gone */
+    else
+        levels[id] = level;
     vlc_mutex_unlock(&lock);
 }
 
@@ -93,27 +119,62 @@ void Downloader::DownloadSource(HTTPChunkBufferedSource *source)
         source->bufferize(HTTPChunkSource::CHUNK_SIZE);
 }
 
+/* Picks the idle lane of the stream with the least demuxed data, i.e. the
+ * stream which is the closest to run dry. Streams which did not report
+ * their level yet come first. */
+Downloader::Lane * Downloader::getNextLane()
+{
+    Lane *next = NULL;
+    vlc_tick_t nextBuffered = 0;
+
+    for(std::map<ID, Lane>::iterator it = lanes.begin(); it != lanes.end(); ++it)
+    {
+        Lane &lane = (*it).second;
+        if(lane.current || lane.chunks.empty())
+            continue;
+
+        std::map<ID, vlc_tick_t>::const_iterator level = levels.find((*it).first);
+        vlc_tick_t buffered = (level != levels.end()) ? (*level).second : 0;
+        if(next == NULL || buffered < nextBuffered)
+        {
+            next = &lane;
+            nextBuffered = buffered;
+        }
+    }
+    return next;
+}
+
 void Downloader::Run()
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        Lane *lane;
+
+        while(!killed && (lane = getNextLane()) == NULL)
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        if(!chunks.empty())
+        HTTPChunkBufferedSource *source = lane->chunks.front();
+        lane->current = source;
+        vlc_mutex_unlock(&lock);
+
+        DownloadSource(source);
+
+        vlc_mutex_lock(&lock);
+        lane->current = NULL;
+        if(lane->canceled || source->isDone())
         {
-            HTTPChunkBufferedSource *source = chunks.front();
-            DownloadSource(source);
-            if(source->isDone())
-            {
-                chunks.pop_front();
-                source->release();
-            }
+            lane->canceled = false;
+            lane->chunks.remove(source);
+            if(lane->chunks.empty())
+                lanes.erase(source->sourceid); /* the lane is idle */
+            source->release();
         }
+        /* The lane can be picked up again, possibly by another thread */
+        vlc_cond_signal(&waitcond);
     }
     vlc_mutex_unlock(&lock);
 }
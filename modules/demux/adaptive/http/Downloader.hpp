@@ -24,6 +24,8 @@
 
 #include <vlc_common.h>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace adaptive
 {
@@ -31,25 +33,38 @@ namespace adaptive
     namespace http
     {
 
+        /* Sources are queued in one lane per stream: each lane is
+         * downloaded in order, while up to maxThreads lanes are downloaded
+         * in parallel. Threads are only started once lanes are used. */
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1);
                 ~Downloader();
-                bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
+                void updateBufferingLevel(const ID &, vlc_tick_t);
 
             private:
+                class Lane
+                {
+                    public:
+                        Lane();
+                        std::list<HTTPChunkBufferedSource *> chunks;
+                        HTTPChunkBufferedSource *current; /* being downloaded */
+                        bool canceled;
+                };
                 static void * downloaderThread(void *);
                 void Run();
                 void DownloadSource(HTTPChunkBufferedSource *);
-                vlc_thread_t thread_handle;
+                Lane * getNextLane();
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
-                bool         thread_handle_valid;
+                unsigned     maxThreads;
+                std::vector<vlc_thread_t> threads;
                 bool         killed;
-                std::list<HTTPChunkBufferedSource *> chunks;
+                std::map<ID, Lane> lanes;
+                std::map<ID, vlc_tick_t> levels; /* demuxed amount per stream */
         };
 
     }
@@ -55,6 +55,11 @@ bool AbstractConnection::prepare(const ConnectionParams &params_)
     return true;
 }
 
+ssize_t AbstractConnection::readPartial(void *p_buffer, size_t len)
+{
+    return read(p_buffer, len);
+}
+
 size_t AbstractConnection::getContentLength() const
 {
     return contentLength;
@@ -207,6 +212,16 @@ enum RequestStatus
 }
 
 ssize_t HTTPConnection::read(void *p_buffer, size_t len)
+{
+    return receive(p_buffer, len, true);
+}
+
+ssize_t HTTPConnection::readPartial(void *p_buffer, size_t len)
+{
+    return receive(p_buffer, len, false);
+}
+
+ssize_t HTTPConnection::receive(void *p_buffer, size_t len, bool waitall)
 {
     if( !connected() ||
        (!queryOk && bytesRead == 0) )
@@ -224,12 +239,12 @@ ssize_t HTTPConnection::read(void *p_buffer, size_t len)
     if(len > toRead)
         len = toRead;
 
-    ssize_t ret = ( chunked ) ? readChunk(p_buffer, len)
-                              : transport->read(p_buffer, len);
+    ssize_t ret = ( chunked ) ? readChunk(p_buffer, len, waitall)
+                              : transport->read(p_buffer, len, waitall);
     if(ret >= 0)
         bytesRead += ret;
 
-    if(ret < 0 || (size_t)ret < len || /* set EOF */
+    if(ret < 0 || (waitall ? (size_t)ret < len : ret == 0) || /* set EOF */
        (contentLength == bytesRead && connectionClose))
     {
         transport->disconnect();
@@ -304,7 +319,7 @@ enum RequestStatus
     return RequestStatus::Success;
 }
 
-ssize_t HTTPConnection::readChunk(void *p_buffer, size_t len)
+ssize_t HTTPConnection::readChunk(void *p_buffer, size_t len, bool waitall)
 {
     size_t copied = 0;
 
@@ -326,17 +341,15 @@ ssize_t HTTPConnection::readChunk(void *p_buffer, size_t len)
             if(toread > chunkLength)
                 toread = chunkLength;
 
-            ssize_t in = transport->read(&((uint8_t*)p_buffer)[copied], toread);
+            ssize_t in = transport->read(&((uint8_t*)p_buffer)[copied], toread, waitall);
             if(in < 0)
             {
                 return (copied == 0) ? in : copied;
             }
-            else if((size_t)in < toread)
-            {
-               return copied + in;
-            }
             copied += in;
             chunkLength -= in;
+            if((size_t)in < toread)
+                return copied;
         }
         else chunked_eof = true;
 
@@ -346,6 +359,10 @@ ssize_t HTTPConnection::readChunk(void *p_buffer, size_t len)
             ssize_t in = transport->read(&crlf, 2);
             if(in < 2 || memcmp(crlf, "\r\n", 2))
                 return (copied == 0) ? -1 : copied;
+            /* Low latency servers send media as it is produced: hand
+             * over each complete chunk instead of waiting for more */
+            if(!waitall)
+                break;
         }
     }
 
@@ -539,6 +556,16 @@ enum RequestStatus
 }
 
 ssize_t StreamUrlConnection::read(void *p_buffer, size_t len)
+{
+    return receive(p_buffer, len, true);
+}
+
+ssize_t StreamUrlConnection::readPartial(void *p_buffer, size_t len)
+{
+    return receive(p_buffer, len, false);
+}
+
+ssize_t StreamUrlConnection::receive(void *p_buffer, size_t len, bool waitall)
 {
     if( !p_streamurl )
         return VLC_EGENERIC;
@@ -553,11 +580,12 @@ ssize_t StreamUrlConnection::read(void *p_buffer, size_t len)
     if(len > toRead)
         len = toRead;
 
-    ssize_t ret = vlc_stream_Read(p_streamurl, p_buffer, len);
+    ssize_t ret = (waitall) ? vlc_stream_Read(p_streamurl, p_buffer, len)
+                            : vlc_stream_ReadPartial(p_streamurl, p_buffer, len);
     if(ret >= 0)
         bytesRead += ret;
 
-    if(ret < 0 || (size_t)ret < len || /* set EOF */
+    if(ret < 0 || (waitall ? (size_t)ret < len : ret == 0) || /* set EOF */
        contentLength == bytesRead )
     {
         reset();
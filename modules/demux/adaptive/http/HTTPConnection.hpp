@@ -49,6 +49,8 @@ namespace adaptive
                 virtual enum RequestStatus
                                 request     (const std::string& path, const BytesRange & = BytesRange()) = 0;
                 virtual ssize_t read        (void *p_buffer, size_t len) = 0;
+                /* Returns as soon as some data arrived, 0 at end of reply */
+                virtual ssize_t readPartial (void *p_buffer, size_t len);
 
                 virtual size_t  getContentLength() const;
                 virtual const std::string & getContentType() const;
@@ -75,6 +77,7 @@ namespace adaptive
                 virtual enum RequestStatus
                                 request     (const std::string& path, const BytesRange & = BytesRange());
                 virtual ssize_t read        (void *p_buffer, size_t len);
+                virtual ssize_t readPartial (void *p_buffer, size_t len);
 
                 void setUsed( bool );
                 const ConnectionParams &getRedirection() const;
@@ -92,7 +95,8 @@ namespace adaptive
                 virtual std::string extraRequestHeaders() const;
                 virtual std::string buildRequestHeader(const std::string &path) const;
 
-                ssize_t         readChunk   (void *p_buffer, size_t len);
+                ssize_t         receive     (void *p_buffer, size_t len, bool waitall);
+                ssize_t         readChunk   (void *p_buffer, size_t len, bool waitall);
                 enum RequestStatus parseReply();
                 std::string readLine();
                 std::string useragent;
@@ -123,10 +127,12 @@ namespace adaptive
                 virtual enum RequestStatus
                                 request     (const std::string& path, const BytesRange & = BytesRange());
                 virtual ssize_t read        (void *p_buffer, size_t len);
+                virtual ssize_t readPartial (void *p_buffer, size_t len);
 
                 virtual void    setUsed( bool );
 
             protected:
+                ssize_t receive(void *p_buffer, size_t len, bool waitall);
                 void reset();
                 stream_t *p_streamurl;
        };
@@ -30,6 +30,7 @@
 #include "ConnectionParams.hpp"
 #include "Transport.hpp"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
 
@@ -58,19 +59,28 @@ void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *o
     rateObserver = obs;
 }
 
+void AbstractConnectionManager::updateBufferingLevel(const adaptive::ID &, vlc_tick_t)
+{
+
+}
+
 
 HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthStorage *storage)
     : AbstractConnectionManager( p_object_ )
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    downloader = new (std::nothrow) Downloader(
+                var_InheritInteger(p_object, "adaptive-maxparallel"));
     factory = new ConnectionFactory(storage);
+    cache = SegmentCache::hold(p_object);
+    lowlatency = var_InheritBool(p_object, "adaptive-lowlatency");
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
 {
     delete downloader;
+    if(cache)
+        SegmentCache::release(cache);
     delete factory;
     this->closeAllConnections();
     vlc_mutex_destroy(&lock);
@@ -136,8 +146,22 @@ AbstractConnection * HTTPConnectionManager::getConnection(ConnectionParams &para
 void HTTPConnectionManager::start(AbstractChunkSource *source)
 {
     HTTPChunkBufferedSource *src = dynamic_cast<HTTPChunkBufferedSource *>(source);
-    if(src)
-        downloader->schedule(src);
+    if(!src)
+        return;
+
+    if(cache)
+    {
+        std::string type;
+        block_t *p_block = cache->get(src->getUrl(), src->getBytesRange(), &type);
+        if(p_block)
+        {
+            src->setCachedData(p_block, type);
+            return;
+        }
+        src->setCache(cache);
+    }
+    src->setPartialReads(lowlatency);
+    downloader->schedule(src);
 }
 
 void HTTPConnectionManager::cancel(AbstractChunkSource *source)
@@ -146,3 +170,9 @@ void HTTPConnectionManager::cancel(AbstractChunkSource *source)
     if(src)
         downloader->cancel(src);
 }
+
+void HTTPConnectionManager::updateBufferingLevel(const adaptive::ID &id, vlc_tick_t level)
+{
+    if(downloader)
+        downloader->updateBufferingLevel(id, level);
+}
@@ -41,6 +41,7 @@ namespace adaptive
         class AbstractConnection;
         class AuthStorage;
         class Downloader;
+        class SegmentCache;
         class AbstractChunkSource;
 
         class AbstractConnectionManager : public IDownloadRateObserver
@@ -55,6 +56,8 @@ namespace adaptive
 
                 virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t); /* impl */
                 void setDownloadRateObserver(IDownloadRateObserver *);
+                /* demuxed amount of a stream, VLC_TICK_INVALID once gone */
+                virtual void updateBufferingLevel(const ID &, vlc_tick_t);
 
             protected:
                 vlc_object_t                                       *p_object;
@@ -74,10 +77,13 @@ namespace adaptive
 
                 virtual void start(AbstractChunkSource *) /* impl */;
                 virtual void cancel(AbstractChunkSource *) /* impl */;
+                virtual void updateBufferingLevel(const ID &, vlc_tick_t) /* reimpl */;
 
             private:
                 void    releaseAllConnections ();
                 Downloader                                         *downloader;
+                SegmentCache                                       *cache;
+                bool                                                lowlatency;
                 vlc_mutex_t                                         lock;
                 std::vector<AbstractConnection *>                   connectionPool;
                 AbstractConnectionFactory                          *factory;
@@ -0,0 +1,374 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <new>
+#include <unistd.h>
+
+using namespace adaptive::http;
+
+#define CACHE_VAR "adaptive-segment-cache"
+
+static vlc_mutex_t cachelock = VLC_STATIC_MUTEX;
+
+SegmentCache::Entry::Entry()
+{
+    p_chain = NULL;
+    size = 0;
+    serial = 0;
+    spilling = false;
+}
+
+SegmentCache::SegmentCache(vlc_object_t *obj_, size_t ramMax_, size_t diskMax_)
+{
+    obj = obj_;
+    vlc_mutex_init(&lock);
+    refs = 0;
+    ramSize = diskSize = 0;
+    ramSpilling = 0;
+    serial = 0;
+    ramMax = ramMax_;
+    diskMax = diskMax_;
+    dir = NULL;
+
+    if(diskMax)
+    {
+        char *cachedir = config_GetUserDir(VLC_CACHE_DIR);
+        if(cachedir)
+        {
+            /* The user cache directory may not have been created yet */
+            vlc_mkdir(cachedir, 0700);
+            if(asprintf(&dir, "%s" DIR_SEP "adaptive", cachedir) == -1)
+                dir = NULL;
+            free(cachedir);
+        }
+        if(dir == NULL || (vlc_mkdir(dir, 0700) && errno != EEXIST))
+        {
+            msg_Warn(obj, "cannot use segments cache directory");
+            diskMax = 0;
+        }
+    }
+}
+
+SegmentCache::~SegmentCache()
+{
+    while(!entries.empty())
+        evict(entries.begin());
+    free(dir);
+    vlc_mutex_destroy(&lock);
+}
+
+SegmentCache * SegmentCache::hold(vlc_object_t *p_obj)
+{
+    const int64_t ramMax = var_InheritInteger(p_obj, "adaptive-cache-memory");
+    const int64_t diskMax = var_InheritInteger(p_obj, "adaptive-cache-disk");
+    if(ramMax <= 0 && diskMax <= 0)
+        return NULL;
+
+    vlc_object_t *libvlc = VLC_OBJECT(vlc_object_instance(p_obj));
+
+    vlc_mutex_lock(&cachelock);
+    var_Create(libvlc, CACHE_VAR, VLC_VAR_ADDRESS);
+    SegmentCache *cache = static_cast<SegmentCache *>(var_GetAddress(libvlc, CACHE_VAR));
+    if(cache == NULL)
+    {
+        cache = new (std::nothrow) SegmentCache(libvlc,
+                                                std::max(ramMax, INT64_C(0)) << 20,
+                                                std::max(diskMax, INT64_C(0)) << 20);
+        if(cache == NULL)
+        {
+            var_Destroy(libvlc, CACHE_VAR);
+            vlc_mutex_unlock(&cachelock);
+            return NULL;
+        }
+        var_SetAddress(libvlc, CACHE_VAR, cache);
+    }
+    cache->refs++;
+    vlc_mutex_unlock(&cachelock);
+    return cache;
+}
+
+void SegmentCache::release(SegmentCache *cache)
+{
+    vlc_object_t *libvlc = cache->obj;
+
+    vlc_mutex_lock(&cachelock);
+    if(--cache->refs == 0)
+    {
+        var_SetAddress(libvlc, CACHE_VAR, NULL);
+        delete cache;
+    }
+    var_Destroy(libvlc, CACHE_VAR);
+    vlc_mutex_unlock(&cachelock);
+}
+
+SegmentCache::Key SegmentCache::makeKey(const std::string &url, const BytesRange &range)
+{
+    Range r(0, 0);
+    if(range.isValid())
+        r = Range(range.getStartByte(), range.getEndByte());
+    return Key(url, r);
+}
+
+block_t * SegmentCache::shareChain(block_t *p_chain)
+{
+    block_t *p_block = NULL;
+    block_t **pp_last = &p_block;
+
+    for(block_t *b = p_chain; b; b = b->p_next)
+    {
+        block_t *p_share = block_Share(b);
+        if(p_share == NULL)
+        {
+            block_ChainRelease(p_block);
+            return NULL;
+        }
+        block_ChainLastAppend(&pp_last, p_share);
+    }
+    return p_block;
+}
+
+size_t SegmentCache::getMaxSize() const
+{
+    return std::max(ramMax, diskMax);
+}
+
+block_t * SegmentCache::get(const std::string &url, const BytesRange &range,
+                            std::string *contentType)
+{
+    block_t *p_block = NULL;
+
+    vlc_mutex_lock(&lock);
+    std::map<Key, Entry>::iterator it = entries.find(makeKey(url, range));
+    if(it != entries.end())
+    {
+        Entry &entry = (*it).second;
+
+        /* Hand over references to the data, which the caller makes
+         * writable before any modification (decryption) */
+        if(entry.p_chain)
+            p_block = shareChain(entry.p_chain);
+        else
+            p_block = block_FilePath(entry.file.c_str(), true);
+
+        if(p_block)
+        {
+            lru.splice(lru.begin(), lru, entry.lru);
+            *contentType = entry.contentType;
+        }
+        else if(entry.p_chain == NULL)
+            evict(it);
+    }
+    vlc_mutex_unlock(&lock);
+
+    return p_block;
+}
+
+void SegmentCache::put(const std::string &url, const BytesRange &range,
+                       const std::string &contentType, block_t *p_chain)
+{
+    size_t size;
+    block_ChainProperties(p_chain, NULL, &size, NULL);
+    if(size == 0 || size > getMaxSize())
+    {
+        block_ChainRelease(p_chain);
+        return;
+    }
+
+    const Key key = makeKey(url, range);
+    std::list<Spill> spills;
+
+    vlc_mutex_lock(&lock);
+    std::map<Key, Entry>::iterator it = entries.find(key);
+    if(it != entries.end())
+        evict(it);
+
+    lru.push_front(key);
+    Entry &entry = entries[key];
+    entry.p_chain = p_chain;
+    entry.size = size;
+    entry.serial = ++serial;
+    entry.contentType = contentType;
+    entry.lru = lru.begin();
+    ramSize += entry.size;
+
+    trim(&spills);
+    vlc_mutex_unlock(&lock);
+
+    spill(spills);
+}
+
+/* Writes data to a new temporary file, without locking */
+bool SegmentCache::writeFile(const block_t *p_chain, size_t size,
+                             std::string *file) const
+{
+    char *psz_file;
+    if(asprintf(&psz_file, "%s" DIR_SEP "segment.XXXXXX", dir) == -1)
+        return false;
+
+    int fd = vlc_mkstemp(psz_file);
+    if(fd == -1)
+    {
+        free(psz_file);
+        return false;
+    }
+
+    size_t written = 0;
+    for(const block_t *b = p_chain; b; b = b->p_next)
+    {
+        size_t offset = 0;
+        while(offset < b->i_buffer)
+        {
+            ssize_t val = write(fd, &b->p_buffer[offset], b->i_buffer - offset);
+            if(val <= 0)
+                break;
+            offset += val;
+        }
+        written += offset;
+        if(offset < b->i_buffer)
+            break;
+    }
+    vlc_close(fd);
+
+    if(written < size)
+    {
+        vlc_unlink(psz_file);
+        free(psz_file);
+        return false;
+    }
+
+    *file = psz_file;
+    free(psz_file);
+    return true;
+}
+
+/* Moves entries from memory to temporary files, as scheduled by trim() */
+void SegmentCache::spill(std::list<Spill> &spills)
+{
+    while(!spills.empty())
+    {
+        Spill &job = spills.front();
+        std::string file;
+        bool b_written = writeFile(job.p_chain, job.size, &file);
+        block_ChainRelease(job.p_chain);
+
+        vlc_mutex_lock(&lock);
+        std::map<Key, Entry>::iterator it = entries.find(job.key);
+        if(it != entries.end() && (*it).second.serial == job.serial)
+        {
+            Entry &entry = (*it).second;
+            entry.spilling = false;
+            ramSpilling -= entry.size;
+            if(b_written)
+            {
+                entry.file = file;
+                block_ChainRelease(entry.p_chain);
+                entry.p_chain = NULL;
+                ramSize -= entry.size;
+                diskSize += entry.size;
+            }
+            else
+                evict(it);
+        }
+        else if(b_written) /* evicted meanwhile */
+            vlc_unlink(file.c_str());
+        spills.pop_front();
+
+        trim(&spills);
+        vlc_mutex_unlock(&lock);
+    }
+}
+
+void SegmentCache::evict(std::map<Key, Entry>::iterator it)
+{
+    Entry &entry = (*it).second;
+
+    if(entry.p_chain)
+    {
+        block_ChainRelease(entry.p_chain);
+        ramSize -= entry.size;
+        if(entry.spilling)
+            ramSpilling -= entry.size;
+    }
+    else
+    {
+        vlc_unlink(entry.file.c_str());
+        diskSize -= entry.size;
+    }
+    lru.erase(entry.lru);
+    entries.erase(it);
+}
+
+/* Enforces both budgets, starting from the least recently used entries.
+ * The entries to move to files are added to the spills list, to be written
+ * once the lock is released. */
+void SegmentCache::trim(std::list<Spill> *spills)
+{
+    std::list<Key>::iterator it = lru.end();
+    while(ramSize - ramSpilling > ramMax && it != lru.begin())
+    {
+        std::list<Key>::iterator prev = it;
+        Entry &entry = entries[*--prev];
+
+        if(entry.p_chain == NULL || entry.spilling)
+        {
+            it = prev;
+            continue;
+        }
+
+        block_t *p_chain = (entry.size <= diskMax) ? shareChain(entry.p_chain)
+                                                   : NULL;
+        if(p_chain)
+        {
+            Spill job;
+            job.key = *prev;
+            job.serial = entry.serial;
+            job.p_chain = p_chain;
+            job.size = entry.size;
+            spills->push_back(job);
+            entry.spilling = true;
+            ramSpilling += entry.size;
+            it = prev;
+        }
+        else
+            evict(entries.find(*prev));
+    }
+
+    it = lru.end();
+    while(diskSize > diskMax && it != lru.begin())
+    {
+        std::list<Key>::iterator prev = it;
+        Entry &entry = entries[*--prev];
+
+        if(entry.p_chain)
+            it = prev;
+        else
+            evict(entries.find(*prev));
+    }
+}
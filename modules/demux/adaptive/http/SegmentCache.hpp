@@ -0,0 +1,104 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include "BytesRange.hpp"
+
+#include <vlc_common.h>
+
+#include <map>
+#include <list>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        /* Least recently used cache of downloaded segments, keyed by URL and
+         * byte range. Entries are kept in memory up to a size budget, then
+         * optionally moved to temporary files up to a second budget.
+         * Entries in memory reference the downloaded blocks, without copies.
+         * Files are written without holding the lock, the entries staying
+         * available from memory meanwhile.
+         * A single cache is shared by all the demuxers of a LibVLC instance. */
+        class SegmentCache
+        {
+            public:
+                static SegmentCache * hold(vlc_object_t *);
+                static void release(SegmentCache *);
+
+                block_t * get(const std::string &, const BytesRange &,
+                              std::string *);
+                void put(const std::string &, const BytesRange &,
+                         const std::string &, block_t *);
+                size_t getMaxSize() const;
+
+            private:
+                SegmentCache(vlc_object_t *, size_t, size_t);
+                ~SegmentCache();
+
+                typedef std::pair<size_t, size_t> Range;
+                typedef std::pair<std::string, Range> Key;
+
+                class Entry
+                {
+                    public:
+                        Entry();
+                        block_t *p_chain; /* NULL if stored in a file */
+                        std::string file;
+                        std::string contentType;
+                        size_t size;
+                        uint64_t serial; /* tells apart entries of a key */
+                        bool spilling; /* being written to a file */
+                        std::list<Key>::iterator lru;
+                };
+
+                class Spill
+                {
+                    public:
+                        Key key;
+                        uint64_t serial;
+                        block_t *p_chain; /* shared with the entry */
+                        size_t size;
+                };
+
+                static Key makeKey(const std::string &, const BytesRange &);
+                static block_t * shareChain(block_t *);
+                bool writeFile(const block_t *, size_t, std::string *) const;
+                void spill(std::list<Spill> &);
+                void evict(std::map<Key, Entry>::iterator);
+                void trim(std::list<Spill> *);
+
+                vlc_object_t *obj;
+                vlc_mutex_t lock;
+                unsigned refs;
+                std::map<Key, Entry> entries;
+                std::list<Key> lru; /* most recently used first */
+                size_t ramSize, ramMax;
+                size_t ramSpilling; /* part of ramSize being written */
+                size_t diskSize, diskMax;
+                uint64_t serial;
+                char *dir;
+        };
+    }
+}
+
+#endif // SEGMENTCACHE_HPP
@@ -84,9 +84,9 @@ void Transport::disconnect()
     }
 }
 
-ssize_t Transport::read(void *p_buffer, size_t len)
+ssize_t Transport::read(void *p_buffer, size_t len, bool waitall)
 {
-    return vlc_tls_Read(tls, p_buffer, len, true);
+    return vlc_tls_Read(tls, p_buffer, len, waitall);
 }
 
 std::string Transport::readline()
@@ -36,7 +36,7 @@ namespace adaptive
                 bool    connect     (vlc_object_t *, const std::string&, int port = 80);
                 bool    connected   () const;
                 bool    send        (const void *buf, size_t size);
-                ssize_t read        (void *p_buffer, size_t len);
+                ssize_t read        (void *p_buffer, size_t len, bool waitall = true);
                 std::string readline();
                 void    disconnect  ();
 
@@ -47,6 +47,7 @@ AbstractPlaylist::AbstractPlaylist (vlc_object_t *p_object_) :
     timeShiftBufferDepth.Set( 0 );
     suggestedPresentationDelay.Set( 0 );
     b_needsUpdates = true;
+    b_lowlatency = var_InheritBool(p_object, "adaptive-lowlatency");
 }
 
 AbstractPlaylist::~AbstractPlaylist()
@@ -87,6 +88,9 @@ void AbstractPlaylist::setMinBuffering( vlc_tick_t min )
 
 vlc_tick_t AbstractPlaylist::getMinBuffering() const
 {
+    /* Can't buffer more than our distance to the live edge */
+    if(b_lowlatency)
+        return minBufferTime;
     return std::max(minBufferTime, VLC_TICK_FROM_SEC(6));
 }
 
@@ -96,6 +100,11 @@ vlc_tick_t AbstractPlaylist::getMaxBuffering() const
     return std::max(minbuf, VLC_TICK_FROM_SEC(60));
 }
 
+bool AbstractPlaylist::isLowLatency() const
+{
+    return b_lowlatency;
+}
+
 Url AbstractPlaylist::getUrlSegment() const
 {
     Url ret;
@@ -52,6 +52,11 @@ bool SegmentChunk::decrypt(block_t **pp_block)
 
     if(encryptionSession)
     {
+        /* The data may be shared with the segments cache */
+        p_block = *pp_block = block_MakeWritable(p_block);
+        if(p_block == NULL)
+            return false;
+
         bool b_last = isEmpty();
         p_block->i_buffer = encryptionSession->decrypt(p_block->p_buffer,
                                                        p_block->i_buffer, b_last);
@@ -180,11 +180,14 @@ uint64_t SegmentInformation::getLiveSegmentNumberByTime(uint64_t def, vlc_tick_t
 
 uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
 {
-    const vlc_tick_t i_max_buffering = getPlaylist()->getMaxBuffering() +
+    /* In low latency mode, only keep the presentation delay from the end */
+    const bool b_lowlatency = getPlaylist()->isLowLatency();
+    const vlc_tick_t i_max_buffering = (b_lowlatency) ? 0 :
+                                    getPlaylist()->getMaxBuffering() +
                                     /* FIXME: add dynamic pts-delay */ VLC_TICK_FROM_SEC(1);
 
     /* Try to never buffer up to really end */
-    const uint64_t OFFSET_FROM_END = 3;
+    const uint64_t OFFSET_FROM_END = (b_lowlatency) ? 0 : 3;
 
     if( mediaSegmentTemplate )
     {
@@ -229,7 +232,8 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
                 i_delay = getPlaylist()->getMinBuffering();
 
             const uint64_t startnumber = mediaSegmentTemplate->inheritStartNumber();
-            end = mediaSegmentTemplate->getLiveTemplateNumber(vlc_tick_from_sec(time(NULL)));
+            const vlc_tick_t now = vlc_tick_from_sec(time(NULL));
+            end = mediaSegmentTemplate->getLiveTemplateNumber(now);
 
             const uint64_t count = timescale.ToScaled( i_delay ) / mediaSegmentTemplate->duration.Get();
             if( startnumber + count >= end )
@@ -239,6 +243,20 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
 
             uint64_t bufcount = ( OFFSET_FROM_END + timescale.ToScaled(i_max_buffering) /
                                   mediaSegmentTemplate->duration.Get() );
+            if( b_lowlatency )
+            {
+                /* Segments can be requested availabilityTimeOffset before
+                 * they are complete, when the server delivers them while they
+                 * are written (chunked CMAF), but not before they started */
+                const vlc_tick_t segmentDuration = timescale.ToTime( mediaSegmentTemplate->duration.Get() );
+                const vlc_tick_t availabilityOffset =
+                        std::min( mediaSegmentTemplate->inheritAvailabilityTimeOffset(), segmentDuration );
+                const uint64_t available = mediaSegmentTemplate->getLiveTemplateNumber( now + availabilityOffset );
+                /* Number of the last available segment, counted from the end */
+                bufcount = (available > end) ? 0 : end - available + 1;
+                bufcount += timescale.ToScaled( getPlaylist()->suggestedPresentationDelay.Get() ) /
+                            mediaSegmentTemplate->duration.Get();
+            }
             /* Ensure we always pick > start # of availability window as this segment might no longer be avail */
             if( end - start <= bufcount )
                 bufcount = end - start - 1;
@@ -392,7 +410,11 @@ ISegment * SegmentInformation::getNextSegment(SegmentInfoType type, uint64_t i_p
             else if(seg->getSequenceNumber() >= i_pos)
             {
                 *pi_newpos = seg->getSequenceNumber();
-                *pb_gap = (*pi_newpos != i_pos);
+                /* Numbering can skip values (HLS parts): only a gap
+                 * if we did not just play the previous segment */
+                *pb_gap = (*pi_newpos != i_pos) &&
+                          (it == retSegments.begin() ||
+                           (*(it - 1))->getSequenceNumber() + 1 != i_pos);
                 return seg;
             }
         }
@@ -57,6 +57,7 @@ MediaSegmentTemplate::MediaSegmentTemplate( SegmentInformation *parent ) :
     initialisationSegment.Set( NULL );
     templated = true;
     parentSegmentInformation = parent;
+    availabilityTimeOffset = 0;
 }
 
 MediaSegmentTemplate::~MediaSegmentTemplate()
@@ -107,6 +108,19 @@ uint64_t MediaSegmentTemplate::inheritStartNumber() const
     return 1;
 }
 
+vlc_tick_t MediaSegmentTemplate::inheritAvailabilityTimeOffset() const
+{
+    const SegmentInformation *ulevel = parentSegmentInformation ? parentSegmentInformation
+                                                                : NULL;
+    for( ; ulevel ; ulevel = ulevel->parent )
+    {
+        if( ulevel->mediaSegmentTemplate &&
+            ulevel->mediaSegmentTemplate->availabilityTimeOffset )
+            return ulevel->mediaSegmentTemplate->availabilityTimeOffset;
+    }
+    return 0;
+}
+
 Timescale MediaSegmentTemplate::inheritTimescale() const
 {
     const SegmentInformation *ulevel = parentSegmentInformation ? parentSegmentInformation
@@ -185,6 +199,11 @@ void MediaSegmentTemplate::setStartNumber( uint64_t v )
     startNumber = v;
 }
 
+void MediaSegmentTemplate::setAvailabilityTimeOffset( vlc_tick_t v )
+{
+    availabilityTimeOffset = v;
+}
+
 void MediaSegmentTemplate::setSegmentTimeline( SegmentTimeline *v )
 {
     delete segmentTimeline;
@@ -0,0 +1,195 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright © 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/SegmentCache.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+using namespace adaptive::http;
+
+#define SEGMENT_SIZE (400 * 1024)
+
+/* Segment data, split in a few blocks as downloaded */
+static block_t * MakeSegment(unsigned id)
+{
+    block_t *p_chain = nullptr;
+    block_t **pp_last = &p_chain;
+    for(size_t offset = 0; offset < SEGMENT_SIZE; offset += SEGMENT_SIZE / 4)
+    {
+        block_t *p_block = block_Alloc(SEGMENT_SIZE / 4);
+        if(!p_block)
+            break;
+        for(size_t i = 0; i < p_block->i_buffer; i++)
+            p_block->p_buffer[i] = (id + offset + i) % 251;
+        block_ChainLastAppend(&pp_last, p_block);
+    }
+    return p_chain;
+}
+
+static bool CheckSegment(block_t *p_chain, unsigned id)
+{
+    size_t offset = 0;
+    for(const block_t *b = p_chain; b; b = b->p_next)
+        for(size_t i = 0; i < b->i_buffer; i++, offset++)
+            if(b->p_buffer[i] != (id + offset) % 251)
+                return false;
+    return offset == SEGMENT_SIZE;
+}
+
+static std::string SegmentUrl(unsigned id)
+{
+    return "http://example.com/seg" + std::to_string(id) + ".ts";
+}
+
+static unsigned CountFiles(const char *dir)
+{
+    unsigned count = 0;
+    DIR *p_dir = vlc_opendir(dir);
+    if(p_dir)
+    {
+        const char *psz;
+        while((psz = vlc_readdir(p_dir)))
+            if(strcmp(psz, ".") && strcmp(psz, ".."))
+                count++;
+        closedir(p_dir);
+    }
+    return count;
+}
+
+static int Cache_test(vlc_object_t *obj, const char *dir)
+{
+    /* 1 MiB in memory, 1 MiB on disk: two segments each */
+    var_SetInteger(obj, "adaptive-cache-memory", 1);
+    var_SetInteger(obj, "adaptive-cache-disk", 1);
+
+    SegmentCache *cache = SegmentCache::hold(obj);
+    if(!cache)
+        return 1;
+
+    const BytesRange range;
+    std::string type;
+    block_t *p_block = nullptr;
+
+    try
+    {
+        /* Stored segments are handed over without copies */
+        block_t *p_seg = MakeSegment(0);
+        Expect(p_seg);
+        const uint8_t *p_data = p_seg->p_buffer;
+        cache->put(SegmentUrl(0), range, "video/mp2t", p_seg);
+        p_block = cache->get(SegmentUrl(0), range, &type);
+        Expect(p_block);
+        Expect(p_block->p_buffer == p_data);
+        Expect(block_IsShared(p_block));
+        Expect(CheckSegment(p_block, 0));
+        Expect(type == "video/mp2t");
+        block_ChainRelease(p_block);
+        p_block = nullptr;
+
+        /* Lookups match the byte range */
+        Expect(cache->get(SegmentUrl(0), BytesRange(0, 1000), &type) == nullptr);
+
+        /* Least recently used segments spill to disk, and read back */
+        cache->put(SegmentUrl(1), range, "video/mp2t", MakeSegment(1));
+        Expect(CountFiles(dir) == 0);
+        p_block = cache->get(SegmentUrl(0), range, &type);
+        Expect(p_block);
+        block_ChainRelease(p_block);
+        p_block = nullptr;
+        cache->put(SegmentUrl(2), range, "video/mp2t", MakeSegment(2));
+        Expect(CountFiles(dir) == 1);
+        p_block = cache->get(SegmentUrl(1), range, &type);
+        Expect(p_block);
+        Expect(CheckSegment(p_block, 1));
+        block_ChainRelease(p_block);
+        p_block = nullptr;
+
+        /* Then they are evicted, once the disk budget is used up */
+        for(unsigned id = 3; id < 8; id++)
+            cache->put(SegmentUrl(id), range, "video/mp2t", MakeSegment(id));
+        Expect(CountFiles(dir) == 2);
+        for(unsigned id = 0; id < 4; id++)
+            Expect(cache->get(SegmentUrl(id), range, &type) == nullptr);
+        for(unsigned id = 4; id < 8; id++)
+        {
+            p_block = cache->get(SegmentUrl(id), range, &type);
+            Expect(p_block);
+            Expect(CheckSegment(p_block, id));
+            block_ChainRelease(p_block);
+            p_block = nullptr;
+        }
+
+        /* Segments larger than the cache are not stored */
+        block_t *p_large = block_Alloc(3 * 1024 * 1024);
+        Expect(p_large);
+        cache->put(SegmentUrl(8), range, "video/mp2t", p_large);
+        Expect(cache->get(SegmentUrl(8), range, &type) == nullptr);
+    }
+    catch(...)
+    {
+        block_ChainRelease(p_block);
+        SegmentCache::release(cache);
+        return 1;
+    }
+
+    SegmentCache::release(cache);
+    /* Temporary files go away with the cache */
+    return CountFiles(dir) == 0 ? 0 : 1;
+}
+
+int SegmentCache_test()
+{
+    char tmpdir[] = "/tmp/adaptive_test_XXXXXX";
+    if(mkdtemp(tmpdir) == nullptr)
+        return 1;
+    /* Keep the temporary files out of the user cache directory */
+    setenv("XDG_CACHE_HOME", tmpdir, 1);
+
+    const std::string vlcdir = std::string(tmpdir) + DIR_SEP "vlc";
+    const std::string dir = vlcdir + DIR_SEP "adaptive";
+
+    int ret = 1;
+    vlc_object_t *root = nullptr;
+    vlc_object_t *obj = static_cast<vlc_object_t *>(vlc_object_create(root, sizeof(*obj)));
+    if(obj)
+    {
+        var_Create(obj, "adaptive-cache-memory", VLC_VAR_INTEGER);
+        var_Create(obj, "adaptive-cache-disk", VLC_VAR_INTEGER);
+        ret = Cache_test(obj, dir.c_str());
+        vlc_object_delete(obj);
+    }
+
+    rmdir(dir.c_str());
+    rmdir(vlcdir.c_str());
+    rmdir(tmpdir);
+    return ret;
+}
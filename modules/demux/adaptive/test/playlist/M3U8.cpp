@@ -0,0 +1,206 @@
+/*
+ * M3U8.cpp
+ *****************************************************************************
+ * Copyright © 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../playlist/BasePeriod.h"
+#include "../../playlist/BaseAdaptationSet.h"
+#include "../../playlist/Segment.h"
+#include "../../../hls/playlist/M3U8.hpp"
+#include "../../../hls/playlist/Parser.hpp"
+#include "../../../hls/playlist/Representation.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+
+#include <cstring>
+
+using namespace adaptive::playlist;
+using namespace hls::playlist;
+
+#define PART(sequence, part) (((uint64_t)(sequence) << 8) | (part))
+
+static const char lowlatency_playlist[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-VERSION:6\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0,HOLD-BACK=12.0\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4.0,\n"
+    "seg10.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.part0.ts\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.part1.ts\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.part2.ts\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.part3.ts\"\n"
+    "#EXTINF:4.0,\n"
+    "seg11.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg12.part0.ts\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg12.part1.ts\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg12.part2.ts\"\n";
+
+static M3U8 * ParseM3U8(vlc_object_t *obj, const char *psz, size_t isz)
+{
+    stream_t *substream = vlc_stream_MemoryNew(obj, (uint8_t *)psz, isz, true);
+    if(!substream)
+        return nullptr;
+    M3U8Parser parser(nullptr);
+    M3U8 *m3u = parser.parse(obj, substream,
+                             std::string("http://example.com/live/media.m3u8"));
+    vlc_stream_Delete(substream);
+    return m3u;
+}
+
+static Representation * GetRepresentation(M3U8 *m3u)
+{
+    BasePeriod *period = m3u->getFirstPeriod();
+    if(!period || period->getAdaptationSets().empty())
+        return nullptr;
+    BaseAdaptationSet *set = period->getAdaptationSets().front();
+    if(set->getRepresentations().empty())
+        return nullptr;
+    return dynamic_cast<Representation *>(set->getRepresentations().front());
+}
+
+/* Media segments, in order, through the public lookup */
+static std::vector<ISegment *> GetSegments(const Representation *rep)
+{
+    std::vector<ISegment *> segments;
+    uint64_t number = 0;
+    bool gap;
+    ISegment *segment;
+    while((segment = rep->getNextSegment(SegmentInformation::INFOTYPE_MEDIA,
+                                         number, &number, &gap)))
+    {
+        segments.push_back(segment);
+        number++;
+    }
+    return segments;
+}
+
+static bool EndsWith(const std::string &str, const char *suffix)
+{
+    const size_t len = strlen(suffix);
+    return str.size() >= len && str.compare(str.size() - len, len, suffix) == 0;
+}
+
+static int LowLatency_test(vlc_object_t *obj)
+{
+    var_SetBool(obj, "adaptive-lowlatency", true);
+
+    M3U8 *m3u = ParseM3U8(obj, lowlatency_playlist, sizeof(lowlatency_playlist) - 1);
+    if(!m3u)
+        return 1;
+
+    try
+    {
+        Expect(m3u->isLowLatency());
+        Expect(m3u->isLive());
+        /* PART-HOLD-BACK, and not HOLD-BACK, when playing parts */
+        Expect(m3u->suggestedPresentationDelay.Get() == VLC_TICK_FROM_SEC(3));
+
+        Representation *rep = GetRepresentation(m3u);
+        Expect(rep);
+
+        const std::vector<ISegment *> segments = GetSegments(rep);
+
+        /* Full segment, then the parts replacing the next one, and the
+         * parts of the segment being produced, up to the preload hint */
+        static const uint64_t numbers[] = {
+            PART(10, 0),
+            PART(11, 0), PART(11, 1), PART(11, 2), PART(11, 3),
+            PART(12, 0), PART(12, 1), PART(12, 2),
+        };
+        Expect(segments.size() == ARRAY_SIZE(numbers));
+        /* Segment numbers carry an internal offset: compare the spacing */
+        const uint64_t first = segments[0]->getSequenceNumber();
+        for(size_t i = 1; i < ARRAY_SIZE(numbers); i++)
+            Expect(segments[i]->getSequenceNumber() - first == numbers[i] - numbers[0]);
+
+        Expect(EndsWith(segments[0]->getUrlSegment().toString(), "/seg10.ts"));
+        Expect(EndsWith(segments[1]->getUrlSegment().toString(), "/seg11.part0.ts"));
+        Expect(EndsWith(segments[7]->getUrlSegment().toString(), "/seg12.part2.ts"));
+
+        /* Server control: next reload waits for the part after the listed ones */
+        Expect(rep->canBlockReload());
+        Expect(EndsWith(rep->getBlockingReloadUrl(),
+                        "/media.m3u8?_HLS_msn=12&_HLS_part=2"));
+    }
+    catch(...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    delete m3u;
+    return 0;
+}
+
+static int Regular_test(vlc_object_t *obj)
+{
+    var_SetBool(obj, "adaptive-lowlatency", false);
+
+    M3U8 *m3u = ParseM3U8(obj, lowlatency_playlist, sizeof(lowlatency_playlist) - 1);
+    if(!m3u)
+        return 1;
+
+    try
+    {
+        Expect(!m3u->isLowLatency());
+
+        Representation *rep = GetRepresentation(m3u);
+        Expect(rep);
+
+        /* Parts and hints are ignored outside of low latency mode */
+        const std::vector<ISegment *> segments = GetSegments(rep);
+        Expect(segments.size() == 2);
+        Expect(segments[1]->getSequenceNumber() - segments[0]->getSequenceNumber() == 1);
+        Expect(EndsWith(segments[1]->getUrlSegment().toString(), "/seg11.ts"));
+
+        Expect(!rep->canBlockReload());
+    }
+    catch(...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    delete m3u;
+    return 0;
+}
+
+int M3U8_test()
+{
+    vlc_object_t *root = nullptr;
+    vlc_object_t *obj = static_cast<vlc_object_t *>(vlc_object_create(root, sizeof(*obj)));
+    if(!obj)
+        return 1;
+
+    var_Create(obj, "adaptive-lowlatency", VLC_VAR_BOOL);
+
+    int ret = LowLatency_test(obj);
+    ret |= Regular_test(obj);
+
+    vlc_object_delete(obj);
+    return ret;
+}
@@ -0,0 +1,32 @@
+/*
+ * test.hpp
+ *****************************************************************************
+ * Copyright © 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef ADAPTIVE_TEST_H
+#define ADAPTIVE_TEST_H
+
+#include <cstdio>
+
+#define Expect(testcond) do { if(!(testcond)) { \
+    fprintf(stderr, "failed: %s (%s:%d)\n", #testcond, __FILE__, __LINE__); \
+    throw 1; } } while(0)
+
+int M3U8_test();
+int SegmentCache_test();
+
+#endif
@@ -30,6 +30,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <limits.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -37,6 +38,7 @@
 #include <vlc_input.h>
 
 #include <vlc_dialog.h>
+#include <vlc_interrupt.h>
 
 #include <vlc_meta.h>
 #include <vlc_codecs.h>
@@ -126,6 +128,9 @@ typedef struct
 
 } avi_entry_t;
 
+/* invented; entry of an OpenDML sub index not loaded yet */
+#define AVIIF_PENDING       0x80000000L
+
 typedef struct
 {
     uint32_t        i_size;
@@ -158,6 +163,13 @@ typedef struct
     /* Avi Index */
     avi_index_t     idx;
 
+    /* OpenDML super index, and the sub indexes not appended yet (the super
+     * index and its next entry) */
+    const avi_chunk_indx_t *p_indx;
+    const avi_chunk_indx_t *p_indx_pending;
+    unsigned int    i_indx_next;
+    bool            b_index_nokeyframe;
+
     unsigned int    i_idxposc;  /* numero of chunk */
     unsigned int    i_idxposb;  /* byte in the current chunk */
 
@@ -167,6 +179,31 @@ typedef struct
 
 } avi_track_t;
 
+/* Index creation, done in the background with its own stream when possible */
+typedef struct
+{
+    demux_t         *p_demux;
+    stream_t        *s;
+    vlc_thread_t    thread;
+    vlc_interrupt_t *interrupt;     /* of the thread, NULL if synchronous */
+    atomic_bool     b_done;
+    atomic_bool     b_abort;
+
+    bool            b_odml;
+    uint64_t        i_movi_pos;
+    uint64_t        i_movi_end;
+    uint64_t        i_avix_pos;     /* second RIFF, 0 if none */
+
+    unsigned int    i_track;
+    struct
+    {
+        enum es_format_category_e i_cat;
+        vlc_fourcc_t    i_codec;
+        avi_index_t     idx;
+    } *track;
+    uint64_t        i_movi_lastchunk_pos;
+} avi_indexer_t;
+
 typedef struct
 {
     vlc_tick_t i_time;
@@ -185,6 +222,8 @@ typedef struct
     uint64_t i_movi_begin;
     uint64_t i_movi_lastchunk_pos;   /* XXX position of last valid chunk */
 
+    avi_indexer_t *p_indexer; /* index being created, NULL if none */
+
     /* number of streams and information */
     unsigned int i_track;
     avi_track_t  **track;
@@ -213,12 +252,18 @@ static int AVI_StreamBytesSet ( demux_t *,
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( vlc_fourcc_t , uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
-static int AVI_PacketSearch   ( demux_t * );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketNext     ( stream_t * );
+static int AVI_PacketSearch   ( stream_t *, unsigned int i_track );
 
 static void AVI_IndexLoad    ( demux_t * );
+static int  AVI_IndexLoadNext( demux_t *, avi_track_t * );
+static int  AVI_IndexLoadChunk( demux_t *, avi_track_t *, unsigned int i_ck );
+static void AVI_IndexLoadCurrent( demux_t *, avi_track_t * );
+static uint64_t AVI_IndexPendingCount( const avi_track_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static void AVI_IndexCreateWait( demux_t *, bool b_abort );
+static void AVI_IndexCreatePoll( demux_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -251,6 +296,8 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    AVI_IndexCreateWait( p_demux, true );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -692,9 +739,11 @@ aviindex:
     {
         const avi_track_t *tk = p_sys->track[i];
         if( tk->fmt.i_cat == VIDEO_ES && tk->idx.p_entry )
-            i_idx_totalframes = __MAX(i_idx_totalframes, tk->idx.i_size);
+            i_idx_totalframes = __MAX(i_idx_totalframes,
+                                      tk->idx.i_size + AVI_IndexPendingCount( tk ));
     }
-    if( i_idx_totalframes != p_avih->i_totalframes &&
+    if( !p_sys->p_indexer &&
+        i_idx_totalframes != p_avih->i_totalframes &&
         p_sys->i_length < VLC_TICK_FROM_US( p_avih->i_totalframes *
                                             p_avih->i_microsecperframe ) )
     {
@@ -909,6 +958,7 @@ static int Demux_Seekable( demux_t *p_demux )
     /* cannot be more than 100 stream (dcXX or wbXX) */
     avi_track_toread_t toread[100];
 
+    AVI_IndexCreatePoll( p_demux );
 
     /* detect new selected/unselected streams */
     for( i_track = 0; i_track < p_sys->i_track; i_track++ )
@@ -964,6 +1014,8 @@ static int Demux_Seekable( demux_t *p_demux )
         avi_track_t *tk = p_sys->track[i_track];
 
         toread[i_track].b_ok = tk->b_activated && !tk->b_eof;
+        if( toread[i_track].b_ok )
+            AVI_IndexLoadCurrent( p_demux, tk );
         if( tk->i_idxposc < tk->idx.i_size )
         {
             toread[i_track].i_posf = tk->idx.p_entry[tk->i_idxposc].i_pos;
@@ -1054,7 +1106,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if (vlc_stream_Seek(p_demux->s, p_sys->i_movi_lastchunk_pos))
                     return VLC_DEMUXER_EGENERIC;
 
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1069,16 +1121,18 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
+                /* skip chunks that the pending sub indexes will provide */
                 if( avi_pk.i_stream >= p_sys->i_track ||
-                    ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
+                    ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) ||
+                    p_sys->track[avi_pk.i_stream]->p_indx_pending )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1110,7 +1164,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1208,6 +1262,7 @@ static int Demux_Seekable( demux_t *p_demux )
             toread[i_track].i_toread--;
         }
 
+        AVI_IndexLoadCurrent( p_demux, tk );
         if( tk->i_idxposc < tk->idx.i_size)
         {
             toread[i_track].i_posf =
@@ -1310,7 +1365,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
     {
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1327,18 +1382,18 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
                     msg_Warn( p_demux,
                               "seems to have lost position @%"PRIu64", resync",
                               vlc_stream_Tell(p_demux->s) );
-                    if( AVI_PacketSearch( p_demux ) )
+                    if( AVI_PacketSearch( p_demux->s, p_sys->i_track ) )
                     {
                         msg_Err( p_demux, "resync failed" );
                         return VLC_DEMUXER_EGENERIC;
@@ -1379,7 +1434,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1416,10 +1471,13 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, double f_ratio, bool b_acc
 
     if( p_sys->b_seekable )
     {
+        AVI_IndexCreatePoll( p_demux );
+
         uint64_t i_pos_backup = vlc_stream_Tell( p_demux->s );
 
         /* Check and lazy load indexes if it was not done (not fastseekable) */
-        if ( !p_sys->b_indexloaded && ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
+        if ( !p_sys->b_indexloaded && !p_sys->p_indexer &&
+             ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
         {
             avi_chunk_t *p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
             if (unlikely( !p_riff ))
@@ -1547,8 +1605,9 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, double f_ratio, bool b_acc
 
 failandresetpos:
         /* Go back to position before index failure */
-        if ( vlc_stream_Tell( p_demux->s ) - i_pos_backup )
-            vlc_stream_Seek( p_demux->s, i_pos_backup );
+        if ( vlc_stream_Tell( p_demux->s ) != i_pos_backup &&
+             vlc_stream_Seek( p_demux->s, i_pos_backup ) )
+            msg_Warn( p_demux, "cannot restore the stream position" );
 
         return VLC_EGENERIC;
     }
@@ -1785,7 +1844,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
     {
         if (vlc_stream_Seek(p_demux->s, p_sys->i_movi_lastchunk_pos))
             return VLC_EGENERIC;
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -1798,15 +1857,17 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
         }
+        /* skip chunks that the pending sub indexes will provide */
         if( avi_pk.i_stream >= p_sys->i_track ||
-            ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
+            ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) ||
+            p_sys->track[avi_pk.i_stream]->p_indx_pending )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -1832,7 +1893,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -1850,6 +1911,14 @@ static int AVI_StreamChunkSet( demux_t *p_demux, unsigned int i_stream,
     p_stream->i_idxposc = i_ck;
     p_stream->i_idxposb = 0;
 
+    if( AVI_IndexLoadChunk( p_demux, p_stream, i_ck ) )
+    {
+        if( i_ck < p_stream->idx.i_size )
+            return VLC_EGENERIC; /* unreadable sub index */
+        while( i_ck >= p_stream->idx.i_size &&
+               AVI_IndexLoadNext( p_demux, p_stream ) == VLC_SUCCESS );
+    }
+
     if(  i_ck >= p_stream->idx.i_size )
     {
         p_stream->i_idxposc = p_stream->idx.i_size - 1;
@@ -1875,6 +1944,11 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
     demux_sys_t *p_sys = p_demux->p_sys;
     avi_track_t *p_stream = p_sys->track[i_stream];
 
+    while( ( p_stream->idx.i_size == 0 ||
+             i_byte >= p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_lengthtotal +
+                       p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_length ) &&
+           AVI_IndexLoadNext( p_demux, p_stream ) == VLC_SUCCESS );
+
     if( ( p_stream->idx.i_size > 0 )
         &&( i_byte < p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_lengthtotal +
                 p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_length ) )
@@ -2129,17 +2203,17 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = vlc_stream_Tell( s );
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2156,12 +2230,12 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketNext( stream_t *s )
 {
     avi_packet_t    avi_ck;
     size_t          i_skip = 0;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( AVI_PacketGetHeader( s, &avi_ck ) )
     {
         return VLC_EGENERIC;
     }
@@ -2186,7 +2260,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     if( i_skip > SSIZE_MAX )
         return VLC_EGENERIC;
 
-    ssize_t i_ret = vlc_stream_Read( p_demux->s, NULL, i_skip );
+    ssize_t i_ret = vlc_stream_Read( s, NULL, i_skip );
     if( i_ret < 0 || (size_t) i_ret != i_skip )
     {
         return VLC_EGENERIC;
@@ -2194,20 +2268,19 @@ static int AVI_PacketNext( demux_t *p_demux )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketSearch( demux_t *p_demux )
+static int AVI_PacketSearch( stream_t *s, unsigned int i_track )
 {
-    demux_sys_t     *p_sys = p_demux->p_sys;
     avi_packet_t    avi_pk;
     unsigned short  i_count = 0;
 
     for( ;; )
     {
-        if( vlc_stream_Read( p_demux->s, NULL, 1 ) != 1 )
+        if( vlc_stream_Read( s, NULL, 1 ) != 1 )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
-        if( avi_pk.i_stream < p_sys->i_track &&
+        AVI_PacketGetHeader( s, &avi_pk );
+        if( avi_pk.i_stream < i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
             return VLC_SUCCESS;
@@ -2222,7 +2295,7 @@ static int AVI_PacketSearch( demux_t *p_demux )
         }
 
         if( !++i_count )
-            msg_Warn( p_demux, "trying to resync..." );
+            msg_Warn( s, "trying to resync..." );
     }
 }
 
@@ -2469,6 +2542,15 @@ static void AVI_IndexLoad_indx( demux_t *p_demux,
         {
             if ( !p_sys->b_seekable )
                 return;
+            if( p_sys->b_odml )
+            {
+                /* The sub indexes are spread over the whole file: only
+                 * load them when needed, see AVI_IndexLoadNext() */
+                p_stream->p_indx = p_indx;
+                p_stream->p_indx_pending = p_indx;
+                p_stream->i_indx_next = 0;
+                continue;
+            }
             avi_chunk_t    ck_sub;
             for( unsigned i = 0; i < p_indx->i_entriesinuse; i++ )
             {
@@ -2507,6 +2589,13 @@ static void AVI_IndexLoad( demux_t *p_demux )
     uint64_t i_indx_last_pos = p_sys->i_movi_lastchunk_pos;
     uint64_t i_idx1_last_pos = p_sys->i_movi_lastchunk_pos;
 
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        p_sys->track[i]->p_indx = NULL;
+        p_sys->track[i]->p_indx_pending = NULL;
+        p_sys->track[i]->b_index_nokeyframe = false;
+    }
+
     AVI_IndexLoad_indx( p_demux, p_idx_indx, &i_indx_last_pos );
     if( !p_sys->b_odml )
         AVI_IndexLoad_idx1( p_demux, p_idx_idx1, &i_idx1_last_pos );
@@ -2533,6 +2622,10 @@ static void AVI_IndexLoad( demux_t *p_demux )
     {
         avi_index_t *p_index = &p_sys->track[i]->idx;
 
+        /* Load the first sub index, if delayed */
+        if( p_index->i_size == 0 )
+            AVI_IndexLoadNext( p_demux, p_sys->track[i] );
+
         /* Fix key flag */
         bool b_key = false;
         for( unsigned j = 0; !b_key && j < p_index->i_size; j++ )
@@ -2542,6 +2635,7 @@ static void AVI_IndexLoad( demux_t *p_demux )
             msg_Err( p_demux, "no key frame set for track %u", i );
             for( unsigned j = 0; j < p_index->i_size; j++ )
                 p_index->p_entry[j].i_flags |= AVIIF_KEYFRAME;
+            p_sys->track[i]->b_index_nokeyframe = true;
         }
 
         /* */
@@ -2550,100 +2644,232 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
-static void AVI_IndexCreate( demux_t *p_demux )
+/* Load the next OpenDML sub index of a track, if any is left */
+static int AVI_IndexLoadNext( demux_t *p_demux, avi_track_t *tk )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
+    const avi_chunk_indx_t *p_indx = tk->p_indx_pending;
 
-    avi_chunk_list_t *p_riff;
-    avi_chunk_list_t *p_movi;
+    while( p_indx && tk->i_indx_next < p_indx->i_entriesinuse )
+    {
+        const unsigned i = tk->i_indx_next++;
+        const uint32_t i_size = tk->idx.i_size;
+        avi_chunk_t    ck_sub;
 
-    unsigned int i_stream;
-    uint32_t i_movi_end;
+        if( vlc_stream_Seek( p_demux->s, p_indx->idx.super[i].i_offset ) ||
+            AVI_ChunkRead( p_demux->s, &ck_sub, NULL ) )
+        {
+            msg_Warn( p_demux, "cannot read sub index %u, skipping it", i );
+            continue;
+        }
+        if( ck_sub.indx.i_indextype == AVI_INDEX_OF_CHUNKS )
+            __Parse_indx( p_demux, &tk->idx, &p_sys->i_movi_lastchunk_pos,
+                          &ck_sub.indx );
+        AVI_ChunkClean( p_demux->s, &ck_sub );
 
-    vlc_tick_t i_dialog_update;
-    vlc_dialog_id *p_dialog_id = NULL;
+        if( tk->b_index_nokeyframe )
+        {
+            for( uint32_t j = i_size; j < tk->idx.i_size; j++ )
+                tk->idx.p_entry[j].i_flags |= AVIIF_KEYFRAME;
+        }
+        if( tk->idx.i_size > i_size )
+            return VLC_SUCCESS;
+    }
 
-    p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
-    p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
+    tk->p_indx_pending = NULL;
+    return VLC_EGENERIC;
+}
 
-    if( !p_movi )
+/* Load the OpenDML sub index covering a chunk, but not the ones before it.
+ * Their chunks are kept as pending entries, so that the entries remain
+ * numbered by chunk, until a seek or the playback reaches them.
+ * Only for tracks positioned by chunk number, where the super index tells
+ * how many chunks each sub index has. */
+static int AVI_IndexLoadChunk( demux_t *p_demux, avi_track_t *tk,
+                               unsigned int i_ck )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const avi_chunk_indx_t *p_indx = tk->p_indx;
+
+    if( i_ck < tk->idx.i_size &&
+        !( tk->idx.p_entry[i_ck].i_flags & AVIIF_PENDING ) )
+        return VLC_SUCCESS;
+    if( !p_indx || tk->i_samplesize || tk->i_blocksize )
+        return VLC_EGENERIC;
+
+    /* Find the sub index */
+    uint64_t i_first = 0;
+    unsigned i = 0;
+    for( ; i < p_indx->i_entriesinuse; i++ )
     {
-        msg_Err( p_demux, "cannot find p_movi" );
-        return;
+        if( i_ck < i_first + p_indx->idx.super[i].i_duration )
+            break;
+        i_first += p_indx->idx.super[i].i_duration;
+    }
+    if( i >= p_indx->i_entriesinuse )
+        return VLC_EGENERIC;
+
+    if( i_ck >= tk->idx.i_size )
+    {
+        /* Past the loaded entries: skip the sub indexes in between */
+        if( !tk->p_indx_pending || i < tk->i_indx_next ||
+            i_first < tk->idx.i_size || i_first > UINT32_MAX )
+            return VLC_EGENERIC; /* the durations do not match the index */
+
+        avi_entry_t pending = {
+            .i_id = p_indx->i_id, .i_flags = AVIIF_PENDING,
+        };
+        while( tk->idx.i_size < i_first )
+        {
+            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos,
+                              &pending );
+            if( !tk->idx.p_entry )
+            {
+                tk->idx.i_size = tk->idx.i_max = 0;
+                return VLC_EGENERIC;
+            }
+        }
+        tk->i_indx_next = i;
+        if( AVI_IndexLoadNext( p_demux, tk ) )
+            return VLC_EGENERIC;
     }
+    else
+    {
+        /* Pending entries: fill them with the sub index */
+        uint32_t i_count = p_indx->idx.super[i].i_duration;
+        avi_index_t sub;
+        avi_chunk_t ck_sub;
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
-        avi_index_Init( &p_sys->track[i_stream]->idx );
+        if( i_first + i_count > tk->idx.i_size )
+            return VLC_EGENERIC;
+        if( vlc_stream_Seek( p_demux->s, p_indx->idx.super[i].i_offset ) ||
+            AVI_ChunkRead( p_demux->s, &ck_sub, NULL ) )
+        {
+            msg_Warn( p_demux, "cannot read sub index %u", i );
+            return VLC_EGENERIC;
+        }
+        avi_index_Init( &sub );
+        if( ck_sub.indx.i_indextype == AVI_INDEX_OF_CHUNKS )
+            __Parse_indx( p_demux, &sub, &p_sys->i_movi_lastchunk_pos,
+                          &ck_sub.indx );
+        AVI_ChunkClean( p_demux->s, &ck_sub );
 
-    i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
-                        stream_Size( p_demux->s ) );
+        if( sub.i_size != i_count )
+            msg_Warn( p_demux, "sub index %u has %"PRIu32" entries instead "
+                      "of %"PRIu32, i, sub.i_size, i_count );
+        i_count = __MIN( i_count, sub.i_size );
+        for( uint32_t j = 0; j < i_count; j++ )
+        {
+            avi_entry_t *p_entry = &tk->idx.p_entry[i_first + j];
 
-    vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 );
-    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
+            *p_entry = sub.p_entry[j];
+            if( tk->b_index_nokeyframe )
+                p_entry->i_flags |= AVIIF_KEYFRAME;
+        }
+        avi_index_Clean( &sub );
 
+        for( uint32_t j = i_first; j < tk->idx.i_size; j++ )
+            tk->idx.p_entry[j].i_lengthtotal = j == 0 ? 0 :
+                tk->idx.p_entry[j - 1].i_lengthtotal +
+                tk->idx.p_entry[j - 1].i_length;
+    }
 
-    /* Only show dialog if AVI is > 10MB */
-    i_dialog_update = vlc_tick_now();
-    if( stream_Size( p_demux->s ) > 10000000 )
+    if( i_ck >= tk->idx.i_size ||
+        ( tk->idx.p_entry[i_ck].i_flags & AVIIF_PENDING ) )
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+/* Make sure the entry at the position of a track is loaded */
+static void AVI_IndexLoadCurrent( demux_t *p_demux, avi_track_t *tk )
+{
+    if( tk->i_idxposc < tk->idx.i_size &&
+        AVI_IndexLoadChunk( p_demux, tk, tk->i_idxposc ) )
     {
-        p_dialog_id =
-            vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
-                                         _("Broken or missing AVI Index"),
-                                         _("Fixing AVI Index...") );
+        /* skip the chunks of a sub index that cannot be read */
+        while( tk->i_idxposc < tk->idx.i_size &&
+               ( tk->idx.p_entry[tk->i_idxposc].i_flags & AVIIF_PENDING ) )
+            tk->i_idxposc++;
+        tk->i_idxposb = 0;
     }
+    if( tk->i_idxposc >= tk->idx.i_size )
+        AVI_IndexLoadNext( p_demux, tk );
+}
+
+/* Number of chunks (or samples) covered by the sub indexes not loaded yet */
+static uint64_t AVI_IndexPendingCount( const avi_track_t *tk )
+{
+    const avi_chunk_indx_t *p_indx = tk->p_indx_pending;
+    uint64_t i_count = 0;
+
+    if( p_indx )
+    {
+        for( unsigned i = tk->i_indx_next; i < p_indx->i_entriesinuse; i++ )
+            i_count += p_indx->idx.super[i].i_duration;
+    }
+    return i_count;
+}
+
+/* Scan the movi content, as the index is missing or broken */
+static void AVI_IndexScan( avi_indexer_t *p_ix, vlc_dialog_id *p_dialog_id )
+{
+    demux_t *p_demux = p_ix->p_demux;
+    stream_t *s = p_ix->s;
+    vlc_tick_t i_dialog_update = vlc_tick_now();
+
+    if( vlc_stream_Seek( s, p_ix->i_movi_pos + 12 ) )
+        return;
 
     for( ;; )
     {
         avi_packet_t pk;
 
+        if( atomic_load_explicit( &p_ix->b_abort, memory_order_relaxed ) )
+            break;
+
         /* Don't update/check dialog too often */
         if( p_dialog_id != NULL && vlc_tick_now() - i_dialog_update > VLC_TICK_FROM_MS(100) )
         {
             if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
                 break;
 
-            double f_current = vlc_stream_Tell( p_demux->s );
-            double f_size    = stream_Size( p_demux->s );
+            double f_current = vlc_stream_Tell( s );
+            double f_size    = stream_Size( s );
             double f_pos     = f_current / f_size;
             vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
 
             i_dialog_update = vlc_tick_now();
         }
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
+        if( AVI_PacketGetHeader( s, &pk ) )
             break;
 
-        if( pk.i_stream < p_sys->i_track &&
-            pk.i_cat == p_sys->track[pk.i_stream]->fmt.i_cat )
+        if( pk.i_stream < p_ix->i_track &&
+            pk.i_cat == p_ix->track[pk.i_stream].i_cat )
         {
-            avi_track_t *tk = p_sys->track[pk.i_stream];
-
             avi_entry_t index;
             index.i_id      = pk.i_fourcc;
-            index.i_flags   = AVI_GetKeyFlag(tk->fmt.i_codec, pk.i_peek);
+            index.i_flags   = AVI_GetKeyFlag(p_ix->track[pk.i_stream].i_codec, pk.i_peek);
             index.i_pos     = pk.i_pos;
             index.i_length  = pk.i_size;
             index.i_lengthtotal = pk.i_size;
-            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+            avi_index_Append( &p_ix->track[pk.i_stream].idx,
+                              &p_ix->i_movi_lastchunk_pos, &index );
         }
         else
         {
             switch( pk.i_fourcc )
             {
             case AVIFOURCC_idx1:
-                if( p_sys->b_odml )
+                if( p_ix->b_odml )
                 {
-                    avi_chunk_list_t *p_sysx;
-                    p_sysx = AVI_ChunkFind( &p_sys->ck_root,
-                                            AVIFOURCC_RIFF, 1, true );
-
                     msg_Dbg( p_demux, "looking for new RIFF chunk" );
-                    if( !p_sysx || vlc_stream_Seek( p_demux->s,
-                                         p_sysx->i_chunk_pos + 24 ) )
-                        goto print_stat;
-                    break;
+                    if( !p_ix->i_avix_pos ||
+                        vlc_stream_Seek( s, p_ix->i_avix_pos + 24 ) )
+                        return;
+                    continue; /* already at the first chunk */
                 }
-                goto print_stat;
+                return;
 
             case AVIFOURCC_RIFF:
                     msg_Dbg( p_demux, "new RIFF chunk found" );
@@ -2654,31 +2880,264 @@ static void AVI_IndexCreate( demux_t *p_demux )
                 break;
 
             default:
+                /* OpenDML standard index chunk (ix##) */
+                if( ( pk.i_fourcc & 0xffff ) == VLC_TWOCC( 'i', 'x' ) )
+                    break;
                 msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
+                if( AVI_PacketSearch( s, p_ix->i_track ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
-                    goto print_stat;
+                    return;
                 }
             }
         }
 
-        if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+        if( ( !p_ix->b_odml && pk.i_pos + pk.i_size >= p_ix->i_movi_end ) ||
+            AVI_PacketNext( s ) )
         {
             break;
         }
     }
+}
+
+static void *AVI_IndexCreateThread( void *data )
+{
+    avi_indexer_t *p_ix = data;
+
+    vlc_interrupt_set( p_ix->interrupt );
+    AVI_IndexScan( p_ix, NULL );
+    atomic_store_explicit( &p_ix->b_done, true, memory_order_release );
+    return NULL;
+}
+
+static avi_indexer_t *AVI_IndexerNew( demux_t *p_demux, stream_t *s )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    avi_chunk_list_t *p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
+    avi_chunk_list_t *p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
+    if( !p_movi )
+    {
+        msg_Err( p_demux, "cannot find p_movi" );
+        return NULL;
+    }
+
+    avi_indexer_t *p_ix = malloc( sizeof( *p_ix ) );
+    if( !p_ix )
+        return NULL;
+    p_ix->track = calloc( p_sys->i_track, sizeof( *p_ix->track ) );
+    if( !p_ix->track )
+    {
+        free( p_ix );
+        return NULL;
+    }
+
+    p_ix->p_demux = p_demux;
+    p_ix->s = s;
+    p_ix->interrupt = NULL;
+    atomic_init( &p_ix->b_done, false );
+    atomic_init( &p_ix->b_abort, false );
+    p_ix->b_odml = p_sys->b_odml;
+    p_ix->i_movi_pos = p_movi->i_chunk_pos;
+    p_ix->i_movi_end = __MIN( p_movi->i_chunk_pos + p_movi->i_chunk_size,
+                              (uint64_t)stream_Size( s ) );
+    /* the chunk tree may be modified meanwhile: store what we need */
+    avi_chunk_list_t *p_sysx = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 1, true );
+    p_ix->i_avix_pos = p_sysx ? p_sysx->i_chunk_pos : 0;
+    p_ix->i_track = p_sys->i_track;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        p_ix->track[i].i_cat = p_sys->track[i]->fmt.i_cat;
+        p_ix->track[i].i_codec = p_sys->track[i]->fmt.i_codec;
+        avi_index_Init( &p_ix->track[i].idx );
+    }
+    p_ix->i_movi_lastchunk_pos = p_sys->i_movi_lastchunk_pos;
+    return p_ix;
+}
+
+static void AVI_IndexerDelete( avi_indexer_t *p_ix )
+{
+    if( p_ix->interrupt )
+        vlc_interrupt_destroy( p_ix->interrupt );
+    for( unsigned i = 0; i < p_ix->i_track; i++ )
+        avi_index_Clean( &p_ix->track[i].idx );
+    free( p_ix->track );
+    free( p_ix );
+}
+
+/* Find where a track is in a new index, given its old index */
+static unsigned int AVI_IndexRemap( const avi_index_t *p_old, unsigned int i_old,
+                                    const avi_index_t *p_new )
+{
+    uint64_t i_pos;
+    bool b_after;
+
+    if( i_old < p_old->i_size )
+    {
+        i_pos = p_old->p_entry[i_old].i_pos;
+        b_after = false;
+    }
+    else
+    {
+        i_pos = p_old->p_entry[p_old->i_size - 1].i_pos;
+        b_after = true;
+    }
+
+    /* entries are sorted by position */
+    uint32_t i_low = 0, i_high = p_new->i_size;
+    while( i_low < i_high )
+    {
+        uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if( p_new->p_entry[i_mid].i_pos < i_pos ||
+            ( b_after && p_new->p_entry[i_mid].i_pos == i_pos ) )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/* Replace the tracks index by the created one, keeping their positions */
+static void AVI_IndexCreateAdopt( demux_t *p_demux, avi_indexer_t *p_ix )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_track_t *tk = p_sys->track[i];
+        avi_index_t *p_new = &p_ix->track[i].idx;
+        bool b_seek = false;
+
+        if( tk->idx.i_size > 0 )
+        {
+            unsigned int i_idxposc = AVI_IndexRemap( &tk->idx, tk->i_idxposc, p_new );
+            if( tk->i_idxposc >= tk->idx.i_size || i_idxposc >= p_new->i_size ||
+                p_new->p_entry[i_idxposc].i_pos != tk->idx.p_entry[tk->i_idxposc].i_pos )
+                tk->i_idxposb = 0;
+            tk->i_idxposc = i_idxposc;
+        }
+        else
+            b_seek = tk->b_activated && p_new->i_size > 0;
+
+        avi_index_Clean( &tk->idx );
+        tk->idx = *p_new;
+        avi_index_Init( p_new );
+        tk->p_indx = NULL;
+        tk->p_indx_pending = NULL;
+
+        if( b_seek )
+            tk->b_eof = AVI_TrackSeek( p_demux, i, p_sys->i_time ) != 0;
+        else if( tk->i_idxposc < tk->idx.i_size )
+            tk->b_eof = false;
+
+        msg_Dbg( p_demux, "stream[%d] created %d index entries",
+                i, tk->idx.i_size );
+    }
+    p_sys->i_movi_lastchunk_pos = __MAX( p_sys->i_movi_lastchunk_pos,
+                                         p_ix->i_movi_lastchunk_pos );
+    p_sys->b_indexloaded = true;
+}
+
+static void AVI_IndexCreate( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    /* Build the index in the background using another stream, so that
+     * playback can start meanwhile */
+    if( !EMPTY_STR( p_demux->psz_url ) )
+    {
+        stream_t *s = vlc_stream_NewURL( p_demux, p_demux->psz_url );
+        if( s != NULL )
+        {
+            p_sys->p_indexer = AVI_IndexerNew( p_demux, s );
+            if( p_sys->p_indexer &&
+                ( p_sys->p_indexer->interrupt = vlc_interrupt_create() ) &&
+                !vlc_clone( &p_sys->p_indexer->thread, AVI_IndexCreateThread,
+                            p_sys->p_indexer, VLC_THREAD_PRIORITY_LOW ) )
+            {
+                msg_Warn( p_demux, "creating index from LIST-movi in the background" );
+                return;
+            }
+            if( p_sys->p_indexer )
+                AVI_IndexerDelete( p_sys->p_indexer );
+            p_sys->p_indexer = NULL;
+            vlc_stream_Delete( s );
+        }
+    }
+
+    avi_indexer_t *p_ix = AVI_IndexerNew( p_demux, p_demux->s );
+    if( !p_ix )
+        return;
+
+    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
+
+    /* Only show dialog if AVI is > 10MB */
+    vlc_dialog_id *p_dialog_id = NULL;
+    if( stream_Size( p_demux->s ) > 10000000 )
+    {
+        p_dialog_id =
+            vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
+                                         _("Broken or missing AVI Index"),
+                                         _("Fixing AVI Index...") );
+    }
+
+    AVI_IndexScan( p_ix, p_dialog_id );
 
-print_stat:
     if( p_dialog_id != NULL )
         vlc_dialog_release( p_demux, p_dialog_id );
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
     {
+        avi_track_t *tk = p_sys->track[i];
+        avi_index_Clean( &tk->idx );
+        tk->idx = p_ix->track[i].idx;
+        avi_index_Init( &p_ix->track[i].idx );
+        tk->p_indx = NULL;
+        tk->p_indx_pending = NULL;
+
         msg_Dbg( p_demux, "stream[%d] creating %d index entries",
-                i_stream, p_sys->track[i_stream]->idx.i_size );
+                i, tk->idx.i_size );
     }
+    p_sys->i_movi_lastchunk_pos = __MAX( p_sys->i_movi_lastchunk_pos,
+                                         p_ix->i_movi_lastchunk_pos );
+    AVI_IndexerDelete( p_ix );
+}
+
+/* Wait for the index being created, and use it */
+static void AVI_IndexCreateWait( demux_t *p_demux, bool b_abort )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_indexer_t *p_ix = p_sys->p_indexer;
+
+    if( !p_ix )
+        return;
+
+    if( b_abort )
+    {
+        /* Also wake the thread up if it is blocked reading its stream */
+        atomic_store_explicit( &p_ix->b_abort, true, memory_order_relaxed );
+        vlc_interrupt_kill( p_ix->interrupt );
+    }
+    vlc_join( p_ix->thread, NULL );
+    p_sys->p_indexer = NULL;
+
+    if( !b_abort )
+    {
+        AVI_IndexCreateAdopt( p_demux, p_ix );
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
+    }
+    vlc_stream_Delete( p_ix->s );
+    AVI_IndexerDelete( p_ix );
+}
+
+/* Use the index being created, if it is ready */
+static void AVI_IndexCreatePoll( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->p_indexer &&
+        atomic_load_explicit( &p_sys->p_indexer->b_done, memory_order_acquire ) )
+        AVI_IndexCreateWait( p_demux, false );
 }
 
 /* */
@@ -2983,6 +3442,9 @@ static vlc_tick_t  AVI_MovieGetLength( demux_t *p_demux )
         {
             i_length = AVI_GetDPTS( tk, tk->idx.i_size );
         }
+        /* add what the sub indexes not loaded yet will cover */
+        i_length += AVI_GetDPTS( tk, AVI_IndexPendingCount( tk ) *
+                                     __MAX( tk->i_samplesize, 1 ) );
 
         msg_Dbg( p_demux,
                  "stream[%d] length:%"PRId64" (based on index)",
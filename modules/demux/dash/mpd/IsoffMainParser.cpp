@@ -182,6 +182,14 @@ size_t IsoffMainParser::parseSegmentTemplate(Node *templateNode, SegmentInformat
     if(templateNode->hasAttribute("duration"))
         mediaTemplate->duration.Set(Integer<stime_t>(templateNode->getAttributeValue("duration")));
 
+    /* Segments can be requested that long before they are complete */
+    if(templateNode->hasAttribute("availabilityTimeOffset"))
+    {
+        const std::string &offset = templateNode->getAttributeValue("availabilityTimeOffset");
+        mediaTemplate->setAvailabilityTimeOffset((offset == "INF") ? INT64_MAX :
+                                                 vlc_tick_from_sec((double) Integer<double>(offset)));
+    }
+
     InitSegmentTemplate *initTemplate = NULL;
 
     if(templateNode->hasAttribute("initialization"))
@@ -43,6 +43,7 @@ namespace hls
 
             protected:
                 vlc_tick_t utcTime;
+                uint64_t mediaSequence; /* differs from sequence for parts */
                 virtual bool prepareChunk(SharedResources *, SegmentChunk *,
                                           BaseRepresentation *); /* reimpl */
         };
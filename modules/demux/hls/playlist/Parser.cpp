@@ -68,7 +68,7 @@ static std::list<Tag *> getTagsFromList(std::list<Tag *> &list, int tag)
     return ret;
 }
 
-static Tag * getTagFromList(std::list<Tag *> &list, int tag)
+static Tag * getTagFromList(const std::list<Tag *> &list, int tag)
 {
     std::list<Tag *>::const_iterator it;
     for(it = list.begin(); it != list.end(); ++it)
@@ -161,22 +161,29 @@ bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representati
                                       rep->getPlaylistUrl().toString());
     if(p_block)
     {
-        stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
-        if(substream)
-        {
-            std::list<Tag *> tagslist = parseEntries(substream);
-            vlc_stream_Delete(substream);
-
-            parseSegments(p_obj, rep, tagslist);
-
-            releaseTagsList(tagslist);
-        }
+        appendSegmentsFromPlaylistData(p_obj, rep, p_block);
         block_Release(p_block);
         return true;
     }
     return false;
 }
 
+bool M3U8Parser::appendSegmentsFromPlaylistData(vlc_object_t *p_obj, Representation *rep,
+                                                const block_t *p_block)
+{
+    stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
+    if(!substream)
+        return false;
+
+    std::list<Tag *> tagslist = parseEntries(substream);
+    vlc_stream_Delete(substream);
+
+    parseSegments(p_obj, rep, tagslist);
+
+    releaseTagsList(tagslist);
+    return true;
+}
+
 static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
                             CommonEncryption &encryption)
 {
@@ -212,6 +219,120 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
+HLSSegment * M3U8Parser::createSegment(Representation *rep, uint64_t number, uint64_t sequence,
+                                       const std::string &uri, double duration,
+                                       vlc_tick_t *nzStartTime, vlc_tick_t *absReferenceTime)
+{
+    HLSSegment *segment = new (std::nothrow) HLSSegment(rep, number);
+    if(!segment)
+        return NULL;
+
+    segment->mediaSequence = sequence;
+    segment->setSourceUrl(uri);
+
+    const vlc_tick_t nzDuration = vlc_tick_from_sec( duration );
+    segment->duration.Set(duration * (uint64_t) rep->getTimescale());
+    segment->startTime.Set(rep->getTimescale().ToScaled(*nzStartTime));
+    *nzStartTime += nzDuration;
+    if(*absReferenceTime != VLC_TICK_INVALID)
+    {
+        segment->utcTime = *absReferenceTime;
+        *absReferenceTime += nzDuration;
+    }
+    return segment;
+}
+
+/* Parts are numbered after their segment media sequence, so that numbers
+ * remain the same when a reload lists more parts of the same segment */
+#define PART_BITS 8
+#define PART_NUMBER(sequence, part) (((sequence) << PART_BITS) | (part))
+
+void M3U8Parser::createPartialSegments(Representation *rep, SegmentList *segmentList,
+                                       uint64_t sequence,
+                                       const std::list<const AttributesTag *> &parts,
+                                       const AttributesTag *hint, bool discontinuity,
+                                       CommonEncryption &encryption,
+                                       vlc_tick_t *nzStartTime, vlc_tick_t *absReferenceTime)
+{
+    std::size_t prevbyterangeoffset = 0;
+    uint64_t index = 0;
+
+    std::list<const AttributesTag *>::const_iterator it;
+    for(it = parts.begin(); it != parts.end(); ++it, ++index)
+    {
+        const AttributesTag *tag = *it;
+        const Attribute *uriAttr = tag->getAttributeByName("URI");
+        const Attribute *durAttr = tag->getAttributeByName("DURATION");
+        const Attribute *gapAttr = tag->getAttributeByName("GAP");
+        if(!uriAttr || !durAttr)
+            continue;
+
+        /* Missing parts are skipped, which will be seen as a gap */
+        if(gapAttr && gapAttr->value == "YES")
+        {
+            const vlc_tick_t nzDuration = vlc_tick_from_sec( durAttr->floatingPoint() );
+            *nzStartTime += nzDuration;
+            if(*absReferenceTime != VLC_TICK_INVALID)
+                *absReferenceTime += nzDuration;
+            continue;
+        }
+
+        HLSSegment *segment = createSegment(rep, PART_NUMBER(sequence, index), sequence,
+                                            uriAttr->quotedString(), durAttr->floatingPoint(),
+                                            nzStartTime, absReferenceTime);
+        if(!segment)
+            continue;
+
+        const Attribute *rangeAttr = tag->getAttributeByName("BYTERANGE");
+        if(rangeAttr)
+        {
+            std::pair<std::size_t,std::size_t> range = rangeAttr->unescapeQuotes().getByteRange();
+            if(range.first == 0) /* first == offset, second = size */
+                range.first = prevbyterangeoffset;
+            prevbyterangeoffset = range.first + range.second;
+            segment->setByteRange(range.first, prevbyterangeoffset - 1);
+        }
+
+        if(discontinuity)
+        {
+            segment->discontinuity = true;
+            discontinuity = false;
+        }
+
+        if(encryption.method != CommonEncryption::Method::NONE)
+            segment->setEncryption(encryption);
+
+        segmentList->addSegment(segment);
+    }
+
+    /* Request the hinted part right away: the server sends it while it is
+     * being produced. Hints up to the end of a resource, which would
+     * overlap the next parts, are left to the next reload. */
+    if(hint && hint->getAttributeByName("URI") &&
+       hint->getAttributeByName("TYPE") && hint->getAttributeByName("TYPE")->value == "PART" &&
+       (!hint->getAttributeByName("BYTERANGE-START") || hint->getAttributeByName("BYTERANGE-LENGTH")))
+    {
+        HLSSegment *segment = createSegment(rep, PART_NUMBER(sequence, index), sequence,
+                                            hint->getAttributeByName("URI")->quotedString(),
+                                            secf_from_vlc_tick(rep->partTarget),
+                                            nzStartTime, absReferenceTime);
+        if(segment)
+        {
+            if(hint->getAttributeByName("BYTERANGE-START"))
+            {
+                const std::size_t start = hint->getAttributeByName("BYTERANGE-START")->decimal();
+                const std::size_t length = hint->getAttributeByName("BYTERANGE-LENGTH")->decimal();
+                segment->setByteRange(start, start + length - 1);
+            }
+            if(discontinuity)
+                segment->discontinuity = true;
+            if(encryption.method != CommonEncryption::Method::NONE)
+                segment->setEncryption(encryption);
+            segmentList->addSegment(segment);
+        }
+    }
+}
+
 void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::list<Tag *> &tagslist)
 {
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
@@ -219,7 +340,6 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
     rep->setTimescale(100);
     rep->b_loaded = true;
 
-    vlc_tick_t totalduration = 0;
     vlc_tick_t nzStartTime = 0;
     vlc_tick_t absReferenceTime = VLC_TICK_INVALID;
     uint64_t sequenceNumber = 0;
@@ -229,6 +349,13 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = NULL;
 
+    /* In low latency mode, recent segments are played through their parts */
+    const bool b_parts = rep->getPlaylist()->isLowLatency() &&
+                         getTagFromList(tagslist, AttributesTag::EXTXPARTINF);
+    std::list<const AttributesTag *> ctx_parts;
+    const AttributesTag *ctx_hint = NULL;
+    vlc_tick_t holdBack = 0;
+
     std::list<Tag *>::const_iterator it;
     for(it = tagslist.begin(); it != tagslist.end(); ++it)
     {
@@ -258,12 +385,6 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                     break;
                 }
 
-                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
-                if(!segment)
-                    break;
-
-                segment->setSourceUrl(uritag->getValue().value);
-
                 /* Need to use EXTXTARGETDURATION as default as some can't properly set segment one */
                 double duration = rep->targetDuration;
                 if(ctx_extinf)
@@ -273,16 +394,25 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                         duration = durAttribute->floatingPoint();
                     ctx_extinf = NULL;
                 }
-                const vlc_tick_t nzDuration = vlc_tick_from_sec( duration );
-                segment->duration.Set(duration * (uint64_t) rep->getTimescale());
-                segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
-                nzStartTime += nzDuration;
-                totalduration += nzDuration;
-                if(absReferenceTime != VLC_TICK_INVALID)
+
+                const uint64_t sequence = sequenceNumber++;
+                if(!ctx_parts.empty() && ctx_parts.size() < (1 << PART_BITS))
                 {
-                    segment->utcTime = absReferenceTime;
-                    absReferenceTime += nzDuration;
+                    createPartialSegments(rep, segmentList, sequence, ctx_parts, NULL,
+                                          discontinuity, encryption,
+                                          &nzStartTime, &absReferenceTime);
+                    ctx_parts.clear();
+                    ctx_byterange = NULL;
+                    discontinuity = false;
+                    break;
                 }
+                ctx_parts.clear();
+
+                HLSSegment *segment = createSegment(rep, b_parts ? PART_NUMBER(sequence, 0) : sequence,
+                                                    sequence, uritag->getValue().value, duration,
+                                                    &nzStartTime, &absReferenceTime);
+                if(!segment)
+                    break;
 
                 segmentList->addSegment(segment);
 
@@ -360,16 +490,67 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
             case Tag::EXTXENDLIST:
                 rep->b_live = false;
                 break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *controltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *attr = controltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_canblockreload = (attr && attr->value == "YES");
+                attr = controltag->getAttributeByName(b_parts ? "PART-HOLD-BACK" : "HOLD-BACK");
+                if(attr)
+                    holdBack = vlc_tick_from_sec(attr->floatingPoint());
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *attr =
+                        static_cast<const AttributesTag *>(tag)->getAttributeByName("PART-TARGET");
+                if(attr)
+                    rep->partTarget = vlc_tick_from_sec(attr->floatingPoint());
+            }
+            break;
+
+            case AttributesTag::EXTXPART:
+                if(b_parts)
+                    ctx_parts.push_back(static_cast<const AttributesTag *>(tag));
+                break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+                if(b_parts)
+                    ctx_hint = static_cast<const AttributesTag *>(tag);
+                break;
         }
     }
 
+    /* Parts of the segment being produced */
+    if(b_parts && rep->isLive() &&
+       (!ctx_parts.empty() || ctx_hint) && ctx_parts.size() < (1 << PART_BITS))
+    {
+        createPartialSegments(rep, segmentList, sequenceNumber, ctx_parts, ctx_hint,
+                              discontinuity, encryption, &nzStartTime, &absReferenceTime);
+    }
+
+    /* What to wait for on the next blocking reload */
+    rep->nextMediaSequence = sequenceNumber;
+    rep->nextPart = (b_parts) ? ctx_parts.size() : -1;
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
+
+        /* Default distance from the live edge, in low latency mode */
+        if(rep->getPlaylist()->isLowLatency())
+        {
+            if(holdBack == 0)
+                holdBack = (b_parts) ? 3 * rep->partTarget
+                                     : vlc_tick_from_sec(3 * rep->targetDuration);
+            rep->getPlaylist()->suggestedPresentationDelay.Set(holdBack);
+        }
     }
-    else if(totalduration > rep->getPlaylist()->duration.Get())
+    else if(nzStartTime > rep->getPlaylist()->duration.Get())
     {
-        rep->getPlaylist()->duration.Set(totalduration);
+        rep->getPlaylist()->duration.Set(nzStartTime);
     }
 
     rep->updateSegmentList(segmentList, true);
@@ -37,6 +37,12 @@ namespace adaptive
         class MediaSegmentTemplate;
         class BasePeriod;
         class BaseAdaptationSet;
+        class SegmentList;
+    }
+
+    namespace encryption
+    {
+        class CommonEncryption;
     }
 }
 
@@ -50,6 +56,7 @@ namespace hls
         class AttributesTag;
         class Tag;
         class Representation;
+        class HLSSegment;
 
         class M3U8Parser
         {
@@ -59,12 +66,22 @@ namespace hls
 
                 M3U8 *             parse  (vlc_object_t *p_obj, stream_t *p_stream, const std::string &);
                 bool appendSegmentsFromPlaylistURI(vlc_object_t *, Representation *);
+                bool appendSegmentsFromPlaylistData(vlc_object_t *, Representation *,
+                                                    const block_t *);
 
             private:
                 Representation * createRepresentation(BaseAdaptationSet *, const AttributesTag *);
                 void createAndFillRepresentation(vlc_object_t *, BaseAdaptationSet *,
                                                  const AttributesTag *, const std::list<Tag *>&);
                 void parseSegments(vlc_object_t *, Representation *, const std::list<Tag *>&);
+                HLSSegment * createSegment(Representation *, uint64_t, uint64_t,
+                                           const std::string &, double,
+                                           vlc_tick_t *, vlc_tick_t *);
+                void createPartialSegments(Representation *, SegmentList *, uint64_t,
+                                           const std::list<const AttributesTag *> &,
+                                           const AttributesTag *, bool,
+                                           adaptive::encryption::CommonEncryption &,
+                                           vlc_tick_t *, vlc_tick_t *);
                 std::list<Tag *> parseEntries(stream_t *);
                 adaptive::SharedResources *resources;
         };
@@ -31,8 +31,12 @@
 #include "../adaptive/playlist/BasePeriod.h"
 #include "../adaptive/playlist/BaseAdaptationSet.h"
 #include "../adaptive/playlist/SegmentList.h"
+#include "../adaptive/tools/Retrieve.hpp"
+#include "../adaptive/SharedResources.hpp"
 
-#include <ctime>
+#include <vlc_block.h>
+
+#include <sstream>
 
 using namespace hls;
 using namespace hls::playlist;
@@ -44,11 +48,31 @@ Representation::Representation  ( BaseAdaptationSet *set ) :
     b_loaded = false;
     nextUpdateTime = 0;
     targetDuration = 0;
+    partTarget = 0;
+    b_canblockreload = false;
+    nextMediaSequence = 0;
+    nextPart = -1;
     streamFormat = StreamFormat::UNKNOWN;
+    vlc_mutex_init(&reload.lock);
+    reload.intr = NULL;
+    reload.state = RELOAD_IDLE;
+    reload.p_block = NULL;
+    reload.obj = NULL;
+    reload.auth = NULL;
 }
 
 Representation::~Representation ()
 {
+    if(reload.intr)
+    {
+        vlc_interrupt_kill(reload.intr);
+        if(reload.state != RELOAD_IDLE)
+            vlc_join(reload.thread, NULL);
+        vlc_interrupt_destroy(reload.intr);
+    }
+    if(reload.p_block)
+        block_Release(reload.p_block);
+    vlc_mutex_destroy(&reload.lock);
 }
 
 StreamFormat Representation::getStreamFormat() const
@@ -101,14 +125,20 @@ void Representation::debug(vlc_object_t *obj, int indent) const
 void Representation::scheduleNextUpdate(uint64_t number)
 {
     const AbstractPlaylist *playlist = getPlaylist();
-    const time_t now = time(NULL);
+    const vlc_tick_t now = vlc_tick_now();
 
     /* Compute new update time */
     vlc_tick_t minbuffer = getMinAheadTime(number);
 
+    if(playlist->isLowLatency() && (b_canblockreload || partTarget))
+    {
+        /* A blocking reload is held by the server until the next part
+         * is out. Otherwise, poll as often as parts are produced. */
+        minbuffer = (b_canblockreload) ? 0 : partTarget;
+    }
     /* Update frequency must always be at least targetDuration (if any)
      * but we need to update before reaching that last segment, thus -1 */
-    if(targetDuration)
+    else if(targetDuration)
     {
         if(minbuffer > vlc_tick_from_sec( 2 * targetDuration + 1 ))
             minbuffer -= vlc_tick_from_sec( targetDuration + 1 );
@@ -123,28 +153,50 @@ void Representation::scheduleNextUpdate(uint64_t number)
             minbuffer /= 2;
     }
 
-    nextUpdateTime = now + SEC_FROM_VLC_TICK(minbuffer);
+    nextUpdateTime = now + minbuffer;
 
-    msg_Dbg(playlist->getVLCObject(), "Updated playlist ID %s, next update in %" PRId64 "s",
-            getID().str().c_str(), (int64_t) nextUpdateTime - now);
+    msg_Dbg(playlist->getVLCObject(), "Updated playlist ID %s, next update in %" PRId64 "ms",
+            getID().str().c_str(), MS_FROM_VLC_TICK(minbuffer));
 
     debug(playlist->getVLCObject(), 0);
 }
 
 bool Representation::needsUpdate() const
 {
-    return !b_loaded || (isLive() && nextUpdateTime < time(NULL));
+    if(!b_loaded)
+        return true;
+    if(!isLive())
+        return false;
+
+    vlc_mutex_locker locker(&reload.lock);
+    if(reload.state != RELOAD_IDLE)
+        return reload.state == RELOAD_DONE;
+    return nextUpdateTime < vlc_tick_now();
 }
 
 bool Representation::runLocalUpdates(SharedResources *res,
                                      vlc_tick_t, uint64_t, bool)
 {
-    const time_t now = time(NULL);
     AbstractPlaylist *playlist = getPlaylist();
-    if(!b_loaded || (isLive() && nextUpdateTime < now))
+    M3U8Parser parser(res);
+    block_t *p_block;
+
+    if(endBlockingReload(&p_block))
     {
-        M3U8Parser parser(res);
-        parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this);
+        if(p_block)
+        {
+            parser.appendSegmentsFromPlaylistData(playlist->getVLCObject(), this, p_block);
+            block_Release(p_block);
+        }
+        else /* Retry without blocking */
+            parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this);
+        return true;
+    }
+
+    if(!b_loaded || (isLive() && nextUpdateTime < vlc_tick_now() && !isReloading()))
+    {
+        if(!canBlockReload() || !startBlockingReload(res))
+            parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this);
         b_loaded = true;
 
         return true;
@@ -153,6 +205,87 @@ bool Representation::runLocalUpdates(SharedResources *res,
     return true;
 }
 
+bool Representation::canBlockReload() const
+{
+    return b_loaded && b_canblockreload && isLive() &&
+           getPlaylist()->isLowLatency();
+}
+
+/* The server holds the reply until the next segment, or part, we are
+ * missing is available */
+std::string Representation::getBlockingReloadUrl() const
+{
+    std::string url = getPlaylistUrl().toString();
+    std::ostringstream directives;
+    directives.imbue(std::locale("C"));
+    directives << ((url.find('?') == std::string::npos) ? '?' : '&')
+               << "_HLS_msn=" << nextMediaSequence;
+    if(nextPart >= 0)
+        directives << "&_HLS_part=" << nextPart;
+    return url.append(directives.str());
+}
+
+bool Representation::startBlockingReload(SharedResources *res)
+{
+    if(!reload.intr)
+    {
+        reload.intr = vlc_interrupt_create();
+        if(!reload.intr)
+            return false;
+    }
+
+    reload.url = getBlockingReloadUrl();
+    reload.obj = getPlaylist()->getVLCObject();
+    reload.auth = res->getAuthStorage();
+    reload.state = RELOAD_PENDING;
+    if(vlc_clone(&reload.thread, blockingReloadThread, this,
+                 VLC_THREAD_PRIORITY_INPUT))
+    {
+        reload.state = RELOAD_IDLE;
+        return false;
+    }
+    return true;
+}
+
+bool Representation::isReloading() const
+{
+    vlc_mutex_locker locker(&reload.lock);
+    return reload.state == RELOAD_PENDING;
+}
+
+/* Returns whether a blocking reload completed, and its result */
+bool Representation::endBlockingReload(block_t **pp_block)
+{
+    vlc_mutex_lock(&reload.lock);
+    if(reload.state != RELOAD_DONE)
+    {
+        vlc_mutex_unlock(&reload.lock);
+        return false;
+    }
+    *pp_block = reload.p_block;
+    reload.p_block = NULL;
+    reload.state = RELOAD_IDLE;
+    vlc_mutex_unlock(&reload.lock);
+
+    vlc_join(reload.thread, NULL);
+    return true;
+}
+
+void * Representation::blockingReloadThread(void *opaque)
+{
+    Representation *rep = static_cast<Representation *>(opaque);
+
+    vlc_interrupt_set(rep->reload.intr);
+    block_t *p_block = Retrieve::HTTP(rep->reload.obj, rep->reload.auth,
+                                      rep->reload.url);
+
+    vlc_mutex_lock(&rep->reload.lock);
+    rep->reload.p_block = p_block;
+    rep->reload.state = RELOAD_DONE;
+    vlc_mutex_unlock(&rep->reload.lock);
+    return NULL;
+}
+
 uint64_t Representation::translateSegmentNumber(uint64_t num, const SegmentInformation *from) const
 {
     if(consistentSegmentNumber())
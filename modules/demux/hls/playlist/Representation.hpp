@@ -25,6 +25,16 @@
 #include "../adaptive/tools/Properties.hpp"
 #include "../adaptive/StreamFormat.hpp"
 
+#include <vlc_interrupt.h>
+
+namespace adaptive
+{
+    namespace http
+    {
+        class AuthStorage;
+    }
+}
+
 namespace hls
 {
     namespace playlist
@@ -53,14 +63,44 @@ namespace hls
                 virtual bool runLocalUpdates(SharedResources *,
                                              vlc_tick_t, uint64_t, bool); /* reimpl */
                 virtual uint64_t translateSegmentNumber(uint64_t, const SegmentInformation *) const; /* reimpl */
+                bool canBlockReload() const;
+                std::string getBlockingReloadUrl() const;
 
             private:
+                bool startBlockingReload(SharedResources *);
+                bool isReloading() const;
+                bool endBlockingReload(block_t **);
+                static void * blockingReloadThread(void *);
                 StreamFormat streamFormat;
                 bool b_live;
                 bool b_loaded;
-                time_t nextUpdateTime;
+                vlc_tick_t nextUpdateTime;
                 time_t targetDuration;
+                vlc_tick_t partTarget;
+                bool b_canblockreload;
+                uint64_t nextMediaSequence; /* first one not yet listed */
+                int nextPart; /* or -1 when not playing parts */
                 Url playlistUrl;
+
+                /* Blocking reloads run on their own thread and connection, as
+                 * the server holds them until new media is available */
+                enum ReloadState
+                {
+                    RELOAD_IDLE,
+                    RELOAD_PENDING,
+                    RELOAD_DONE,
+                };
+                struct
+                {
+                    mutable vlc_mutex_t lock;
+                    vlc_thread_t thread;
+                    vlc_interrupt_t *intr;
+                    enum ReloadState state;
+                    block_t *p_block; /* result, NULL on failure */
+                    std::string url;
+                    vlc_object_t *obj;
+                    adaptive::http::AuthStorage *auth;
+                } reload;
         };
     }
 }
@@ -98,6 +98,10 @@ namespace hls
                     EXTXMEDIA,
                     EXTXSTREAMINF,
                     EXTXSESSIONKEY,
+                    EXTXSERVERCONTROL,
+                    EXTXPARTINF,
+                    EXTXPART,
+                    EXTXPRELOADHINT,
                 };
                 AttributesTag(int, const std::string &);
                 virtual ~AttributesTag();
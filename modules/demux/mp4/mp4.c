@@ -329,32 +329,61 @@ static es_out_id_t * MP4_AddTrackES( es_out_t *out, mp4_track_t *p_track )
     return p_es;
 }
 
-/* Return time in microsecond of a track */
-static inline vlc_tick_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
+/* Return the number of samples of a chunk described by a stts/ctts entry,
+ * i_skip being the samples of the entry used by previous chunks */
+static inline uint32_t MP4_ChunkEntrySamples( const uint32_t *pi_sample_count,
+                                              uint32_t i_entry, uint32_t i_skip,
+                                              uint32_t i_left )
 {
-    demux_sys_t *p_sys = p_demux->p_sys;
-    const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
+    uint32_t i_count = pi_sample_count[i_entry] - i_skip;
+    return __MIN( i_count, i_left );
+}
 
-    unsigned int i_index = 0;
-    unsigned int i_sample = p_track->i_sample - p_chunk->i_sample_first;
-    int64_t sdts = p_chunk->i_first_dts;
+/* Return the total duration of i_count samples of a chunk, starting at
+ * sample i_from of this chunk (in track time scale) */
+static stime_t MP4_ChunkGetSamplesDuration( const mp4_track_t *p_track,
+                                            const mp4_chunk_t *p_chunk,
+                                            uint32_t i_from, uint32_t i_count )
+{
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_entry = p_chunk->i_dts_entry;
+    uint32_t i_skip = p_chunk->i_dts_entry_skip;
+    uint32_t i_left = p_chunk->i_sample_count;
+    stime_t i_duration = 0;
 
-    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
+    while( i_count > 0 && i_left > 0 && i_entry < stts->i_entry_count )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        uint32_t i_run = MP4_ChunkEntrySamples( stts->pi_sample_count,
+                                                i_entry, i_skip, i_left );
+        if( i_from >= i_run )
         {
-            sdts += p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index];
-            i_index++;
+            i_from -= i_run;
         }
         else
         {
-            sdts += i_sample * p_chunk->p_sample_delta_dts[i_index];
-            break;
+            uint32_t i_used = __MIN( i_run - i_from, i_count );
+            i_duration += (uint64_t) i_used * (uint32_t) stts->pi_sample_delta[i_entry];
+            i_count -= i_used;
+            i_from = 0;
         }
+        i_left -= i_run;
+        i_entry++;
+        i_skip = 0;
     }
 
+    return i_duration;
+}
+
+/* Return time in microsecond of a track */
+static inline vlc_tick_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
+
+    int64_t sdts = p_chunk->i_first_dts +
+        MP4_ChunkGetSamplesDuration( p_track, p_chunk, 0,
+                                     p_track->i_sample - p_chunk->i_sample_first );
+
     vlc_tick_t i_dts = MP4_rescale_mtime( sdts, p_track->i_timescale );
 
     /* now handle elst */
@@ -383,24 +412,32 @@ static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
                                          vlc_tick_t *pi_delta )
 {
     VLC_UNUSED( p_demux );
-    mp4_chunk_t *ck = &p_track->chunk[p_track->i_chunk];
+    const mp4_chunk_t *ck = &p_track->chunk[p_track->i_chunk];
+    const MP4_Box_data_ctts_t *ctts = p_track->p_ctts;
 
-    unsigned int i_index = 0;
-    unsigned int i_sample = p_track->i_sample - ck->i_sample_first;
+    uint32_t i_sample = p_track->i_sample - ck->i_sample_first;
+    uint32_t i_entry = ck->i_pts_entry;
+    uint32_t i_skip = ck->i_pts_entry_skip;
+    uint32_t i_left = ck->i_sample_count;
 
-    if( ck->p_sample_count_pts == NULL || ck->p_sample_offset_pts == NULL )
+    if( ctts == NULL )
         return false;
 
-    for( i_index = 0; i_index < ck->i_entries_pts ; i_index++ )
+    for( ; i_left > 0 && i_entry < ctts->i_entry_count; i_entry++ )
     {
-        if( i_sample < ck->p_sample_count_pts[i_index] )
+        uint32_t i_run = MP4_ChunkEntrySamples( ctts->pi_sample_count,
+                                                i_entry, i_skip, i_left );
+        if( i_sample < i_run )
         {
-            *pi_delta = MP4_rescale_mtime( ck->p_sample_offset_pts[i_index],
+            *pi_delta = MP4_rescale_mtime( ctts->pi_sample_offset[i_entry] +
+                                           p_track->i_cts_shift,
                                            p_track->i_timescale );
             return true;
         }
 
-        i_sample -= ck->p_sample_count_pts[i_index];
+        i_sample -= i_run;
+        i_left -= i_run;
+        i_skip = 0;
     }
     return false;
 }
@@ -411,43 +448,10 @@ static inline vlc_tick_t MP4_GetSamplesDuration( demux_t *p_demux, mp4_track_t *
     VLC_UNUSED( p_demux );
 
     const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
-    stime_t i_duration = 0;
-
-    /* Forward to right index, and set remaining count in that index */
-    unsigned i_index = 0;
-    unsigned i_remain = 0;
-    for( unsigned i = p_chunk->i_sample_first;
-         i<p_track->i_sample && i_index < p_chunk->i_entries_dts; )
-    {
-        if( p_track->i_sample - i >= p_chunk->p_sample_count_dts[i_index] )
-        {
-            i += p_chunk->p_sample_count_dts[i_index];
-            i_index++;
-        }
-        else
-        {
-            i_remain = p_track->i_sample - i;
-            break;
-        }
-    }
-
-    /* Compute total duration from all samples from index */
-    while( i_nb_samples > 0 && i_index < p_chunk->i_entries_dts )
-    {
-        if( i_nb_samples >= p_chunk->p_sample_count_dts[i_index] - i_remain )
-        {
-            i_duration += (p_chunk->p_sample_count_dts[i_index] - i_remain) *
-                          (int64_t) p_chunk->p_sample_delta_dts[i_index];
-            i_nb_samples -= (p_chunk->p_sample_count_dts[i_index] - i_remain);
-            i_index++;
-            i_remain = 0;
-        }
-        else
-        {
-            i_duration += i_nb_samples * p_chunk->p_sample_delta_dts[i_index];
-            break;
-        }
-    }
+    stime_t i_duration =
+        MP4_ChunkGetSamplesDuration( p_track, p_chunk,
+                                     p_track->i_sample - p_chunk->i_sample_first,
+                                     i_nb_samples );
 
     return MP4_rescale_mtime( i_duration, p_track->i_timescale );
 }
@@ -2464,12 +2468,6 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
         ck->i_offset = BOXDATA(p_co64)->i_chunk_offset[i_chunk];
 
         ck->i_first_dts = 0;
-        ck->i_entries_dts = 0;
-        ck->p_sample_count_dts = NULL;
-        ck->p_sample_delta_dts = NULL;
-        ck->i_entries_pts = 0;
-        ck->p_sample_count_pts = NULL;
-        ck->p_sample_offset_pts = NULL;
     }
 
     /* now we read index for SampleEntry( soun vide mp4a mp4v ...)
@@ -2531,54 +2529,6 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
-{
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
-    {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
-
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_EBADVAR;
-        }
-
-        if ( i_index_samples_left )
-        {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
-        }
-        else
-        {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
-        }
-    }
-
-    return VLC_SUCCESS;
-}
-
 static int TrackCreateSamplesIndex( demux_t *p_demux,
                                     mp4_track_t *p_demux_track )
 {
@@ -2618,16 +2568,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     {
         /* 2: each sample can have a different size */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -2642,120 +2583,62 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
     /* Use stts table to create a sample number -> dts table.
      * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+     *  the box! so each chunk only records where its samples start in the
+     *  table, which is then read in place */
 
     int64_t i_next_dts = 0;
     /* Find stts
      *  Gives mapping between sample and decoding time
      */
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "stts" );
-    if( !p_box )
+    if( !p_box || !p_box->data.p_stts )
     {
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
     else
     {
-        MP4_Box_data_stts_t *stts = p_box->data.p_stts;
+        const MP4_Box_data_stts_t *stts = p_box->data.p_stts;
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
+        p_demux_track->p_stts = stts;
+
+        /* Locate each chunk in the table, and compute its dts */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_index_samples_used = 0;
+        bool b_truncated = false;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
+            uint32_t i_sample_count = ck->i_sample_count;
 
-            /* save first dts */
             ck->i_first_dts = i_next_dts;
+            ck->i_dts_entry = i_index;
+            ck->i_dts_entry_skip = i_index_samples_used;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
-            {
-                free( ck->p_sample_count_dts );
-                free( ck->p_sample_delta_dts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return VLC_ENOMEM;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
+            while( i_sample_count > 0 && i_index < stts->i_entry_count )
             {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
+                uint32_t i_run = MP4_ChunkEntrySamples( stts->pi_sample_count,
+                                                        i_index, i_index_samples_used,
+                                                        i_sample_count );
+                i_next_dts += (uint64_t) i_run * (uint32_t) stts->pi_sample_delta[i_index];
+                i_sample_count -= i_run;
+                i_index_samples_used += i_run;
+                if( i_index_samples_used == stts->pi_sample_count[i_index] )
                 {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
+                    i_index++;
+                    i_index_samples_used = 0;
                 }
-
             }
+            b_truncated |= i_sample_count > 0;
+
+            ck->i_duration = i_next_dts - ck->i_first_dts;
         }
+
+        if( b_truncated )
+            msg_Err( p_demux, "invalid STTS table: too few samples" );
     }
 
 
@@ -2765,95 +2648,47 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
     if( p_box && p_box->data.p_ctts )
     {
-        MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
+        const MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-        int64_t i_cts_shift = 0;
+        p_demux_track->p_ctts = ctts;
+        p_demux_track->i_cts_shift = 0;
         const MP4_Box_t *p_cslg = MP4_BoxGet( p_demux_track->p_stbl, "cslg" );
         if( p_cslg && BOXDATA(p_cslg) )
-            i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
+            p_demux_track->i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
 
-        /* Create pts-dts table per chunk */
+        /* Locate each chunk in the table */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_index_samples_used = 0;
+        bool b_truncated = false;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
-            {
-                free( ck->p_sample_count_pts );
-                free( ck->p_sample_offset_pts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return VLC_ENOMEM;
-            }
+            uint32_t i_sample_count = ck->i_sample_count;
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->i_pts_entry = i_index;
+            ck->i_pts_entry_skip = i_index_samples_used;
 
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
+            while( i_sample_count > 0 && i_index < ctts->i_entry_count )
             {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
+                uint32_t i_run = MP4_ChunkEntrySamples( ctts->pi_sample_count,
+                                                        i_index, i_index_samples_used,
+                                                        i_sample_count );
+                i_sample_count -= i_run;
+                i_index_samples_used += i_run;
+                if( i_index_samples_used == ctts->pi_sample_count[i_index] )
                 {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
+                    i_index++;
+                    i_index_samples_used = 0;
                 }
-
-
             }
+            b_truncated |= i_sample_count > 0;
         }
+
+        if( b_truncated )
+            msg_Err( p_demux, "invalid CTTS table: too few samples" );
     }
 
     msg_Dbg( p_demux, "track[Id 0x%x] read %"PRIu32" samples length:%"PRId64"s",
@@ -3042,17 +2877,23 @@ static int TrackGetNearestSeekPoint( demux_t *p_demux, mp4_track_t *p_track,
         const MP4_Box_data_stss_t *p_stss_data = BOXDATA(p_stss);
         msg_Dbg( p_demux, "track[Id 0x%x] using Sync Sample Box (stss)",
                  p_track->i_track_ID );
-        for( unsigned i_index = 0; i_index < p_stss_data->i_entry_count; i_index++ )
+        if( p_stss_data->i_entry_count > 0 )
         {
-            if( i_index >= p_stss_data->i_entry_count - 1 ||
-                i_sample < p_stss_data->i_sample_number[i_index+1] )
+            /* sync samples are increasing: look for the last one
+               up to i_sample, or use the first one */
+            uint32_t i_low = 1, i_high = p_stss_data->i_entry_count;
+            while( i_low < i_high )
             {
-                *pi_sync_sample = p_stss_data->i_sample_number[i_index];
-                msg_Dbg( p_demux, "stss gives %d --> %" PRIu32 " (sample number)",
-                         i_sample, *pi_sync_sample );
-                i_ret = VLC_SUCCESS;
-                break;
+                uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+                if( i_sample >= p_stss_data->i_sample_number[i_mid] )
+                    i_low = i_mid + 1;
+                else
+                    i_high = i_mid;
             }
+            *pi_sync_sample = p_stss_data->i_sample_number[i_low - 1];
+            msg_Dbg( p_demux, "stss gives %d --> %" PRIu32 " (sample number)",
+                     i_sample, *pi_sync_sample );
+            i_ret = VLC_SUCCESS;
         }
     }
 
@@ -3110,7 +2951,6 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
     uint64_t     i_dts;
     unsigned int i_sample;
     unsigned int i_chunk;
-    int          i_index;
     stime_t      i_start;
 
     /* FIXME see if it's needed to check p_track->i_chunk_count */
@@ -3154,50 +2994,52 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = MP4_rescale_qtime( start, p_track->i_timescale );
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
     /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
-    {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
-        {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
-        }
+    /* chunks dts are increasing: look for the last one starting before
+       i_start. If it is the last chunk, i_start will be checked while
+       searching i_sample */
+    uint32_t i_low = 1, i_high = p_track->i_chunk_count;
+    while( i_low < i_high )
+    {
+        uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if( (uint64_t)i_start >= p_track->chunk[i_mid].i_first_dts )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
+    i_chunk = i_low - 1;
 
     /* *** find sample in the chunk *** */
-    i_sample = p_track->chunk[i_chunk].i_sample_first;
-    i_dts    = p_track->chunk[i_chunk].i_first_dts;
-    for( i_index = 0;  i_index < p_track->chunk[i_chunk].i_entries_dts &&
-                       i_sample < p_track->chunk[i_chunk].i_sample_count; )
-    {
-        if( i_dts +
-            p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-            p_track->chunk[i_chunk].p_sample_delta_dts[i_index] < (uint64_t)i_start )
-        {
-            i_dts    +=
-                p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
-
-            i_sample += p_track->chunk[i_chunk].p_sample_count_dts[i_index];
+    const mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_index = ck->i_dts_entry;
+    uint32_t i_skip = ck->i_dts_entry_skip;
+    uint32_t i_left = ck->i_sample_count;
+
+    i_sample = ck->i_sample_first;
+    i_dts    = ck->i_first_dts;
+    while( i_left > 0 && i_index < stts->i_entry_count &&
+           i_sample < ck->i_sample_count )
+    {
+        uint32_t i_run = MP4_ChunkEntrySamples( stts->pi_sample_count,
+                                                i_index, i_skip, i_left );
+        uint32_t i_delta = stts->pi_sample_delta[i_index];
+
+        if( i_dts + (uint64_t) i_run * i_delta < (uint64_t)i_start )
+        {
+            i_dts    += (uint64_t) i_run * i_delta;
+            i_sample += i_run;
+            i_left   -= i_run;
             i_index++;
+            i_skip = 0;
         }
         else
         {
-            if( p_track->chunk[i_chunk].p_sample_delta_dts[i_index] <= 0 )
+            if( i_delta == 0 )
             {
                 break;
             }
-            i_sample += ( i_start - i_dts ) /
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+            i_sample += ( i_start - i_dts ) / i_delta;
             break;
         }
     }
@@ -3618,15 +3460,6 @@ static void MP4_TrackSetup( demux_t *p_demux, mp4_track_t *p_track,
     p_track->b_ok = true;
 }
 
-static void DestroyChunk( mp4_chunk_t *ck )
-{
-    free( ck->p_sample_count_dts );
-    free( ck->p_sample_delta_dts );
-    free( ck->p_sample_count_pts );
-    free( ck->p_sample_offset_pts );
-    free( ck->p_sample_size );
-}
-
 /****************************************************************************
  * MP4_TrackClean:
  ****************************************************************************
@@ -3639,16 +3472,8 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     if( p_track->p_es )
         es_out_Del( out, p_track->p_es );
 
-    if( p_track->chunk )
-    {
-        for( unsigned int i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
-            DestroyChunk( &p_track->chunk[i_chunk] );
-    }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
 
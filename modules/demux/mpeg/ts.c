@@ -192,6 +192,9 @@ static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static uint64_t TSStreamTell( demux_t *p_demux );
+static int TSStreamSeek( demux_t *p_demux, uint64_t i_pos );
+static void TSStreamFlushBuffer( demux_sys_t *p_sys );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
@@ -400,6 +403,15 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->readbuf.i_size = p_sys->i_ts_read * i_packet_size;
+    p_sys->readbuf.p_block = block_Alloc( p_sys->readbuf.i_size );
+    if( !p_sys->readbuf.p_block )
+    {
+        vlc_mutex_destroy( &p_sys->csa_lock );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    p_sys->readbuf.p_buffer = p_sys->readbuf.p_block->p_buffer;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
 
@@ -414,6 +426,7 @@ static int Open( vlc_object_t *p_this )
     if ( !PIDSetup( p_demux, TYPE_PAT, patpid, NULL ) )
     {
         vlc_mutex_destroy( &p_sys->csa_lock );
+        block_Release( p_sys->readbuf.p_block );
         free( p_sys );
         return VLC_ENOMEM;
     }
@@ -421,6 +434,7 @@ static int Open( vlc_object_t *p_this )
     {
         PIDRelease( p_demux, patpid );
         vlc_mutex_destroy( &p_sys->csa_lock );
+        block_Release( p_sys->readbuf.p_block );
         free( p_sys );
         return VLC_EGENERIC;
     }
@@ -588,6 +602,7 @@ static void Close( vlc_object_t *p_this )
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
+    block_Release( p_sys->readbuf.p_block );
     free( p_sys );
 }
 
@@ -950,7 +965,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TSStreamTell( p_demux );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -997,7 +1012,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            TSStreamSeek( p_demux, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1129,11 +1144,16 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
-        return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
+        if( vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args ) )
+            return VLC_EGENERIC;
+        TSStreamFlushBuffer( p_sys );
+        return VLC_SUCCESS;
 
     case DEMUX_SET_SEEKPOINT:
-        return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
-                                     args );
+        if( vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT, args ) )
+            return VLC_EGENERIC;
+        TSStreamFlushBuffer( p_sys );
+        return VLC_SUCCESS;
 
     case DEMUX_TEST_AND_CLEAR_FLAGS:
     {
@@ -1730,29 +1750,221 @@ static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool
     return b_ret;
 }
 
-static block_t* ReadTSPacket( demux_t *p_demux )
+/*
+ * Packets are read from the stream in batches of up to i_ts_read packets
+ * into a single block, which is sync checked once per refill. Each packet is
+ * then handed out through a block header embedded in the demuxer, pointing
+ * into the batch: it is parsed in place, without any allocation nor copy,
+ * and is only valid until the next packet is read. The payloads gathered
+ * into PES are kept as views sharing the batch block (see TSPacketKeep()),
+ * and the next refill moves to a new block while such views are in use.
+ */
+static uint64_t TSStreamTell( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint64_t i_pos = vlc_stream_Tell( p_sys->stream );
+    size_t i_buffered = p_sys->readbuf.i_filled - p_sys->readbuf.i_offset;
+
+    assert( i_pos >= i_buffered );
+    return i_pos - i_buffered;
+}
+
+static int TSStreamSeek( demux_t *p_demux, uint64_t i_pos )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    block_t     *p_pkt;
+    TSStreamFlushBuffer( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+static void TSStreamFlushBuffer( demux_sys_t *p_sys )
+{
+    p_sys->readbuf.i_offset = 0;
+    p_sys->readbuf.i_filled = 0;
+    p_sys->readbuf.i_synced = 0;
+}
+
+/* Gives the packets buffered but not demuxed yet back to the stream, so that
+ * they are read again, ie. through a filter inserted on top of it. The
+ * buffer is kept if the stream can't seek back. */
+int TSStreamRewindBuffer( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->readbuf.i_filled == p_sys->readbuf.i_offset )
+        return VLC_SUCCESS;
+    if( vlc_stream_Seek( p_sys->stream, TSStreamTell( p_demux ) ) )
+        return VLC_EGENERIC;
+    TSStreamFlushBuffer( p_sys );
+    return VLC_SUCCESS;
+}
+
+/* Returns the number of buffered bytes, reading more if less than i_min are
+ * available */
+static size_t FillTSPacketBuffer( demux_t *p_demux, size_t i_min )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    size_t i_avail = p_sys->readbuf.i_filled - p_sys->readbuf.i_offset;
+
+    if( i_avail >= i_min )
+        return i_avail;
+
+    if( block_IsShared( p_sys->readbuf.p_block ) )
+    {
+        /* Packets handed out still use the buffer, continue in a new one */
+        block_t *p_block = block_Alloc( p_sys->readbuf.i_size );
+        if( unlikely(p_block == NULL) )
+            return i_avail;
+
+        memcpy( p_block->p_buffer,
+                &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset], i_avail );
+        block_Release( p_sys->readbuf.p_block );
+        p_sys->readbuf.p_block = p_block;
+        p_sys->readbuf.p_buffer = p_block->p_buffer;
+        p_sys->readbuf.i_synced -= p_sys->readbuf.i_offset;
+        p_sys->readbuf.i_offset = 0;
+        p_sys->readbuf.i_filled = i_avail;
+    }
+    /* Move the partial packet tail to the front */
+    else if( p_sys->readbuf.i_offset > 0 )
+    {
+        memmove( p_sys->readbuf.p_buffer,
+                 &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset], i_avail );
+        p_sys->readbuf.i_synced -= p_sys->readbuf.i_offset;
+        p_sys->readbuf.i_offset = 0;
+        p_sys->readbuf.i_filled = i_avail;
+    }
+
+    while( i_avail < i_min )
+    {
+        /* Partial reads, so that live inputs don't wait for a full batch */
+        ssize_t i_read = vlc_stream_ReadPartial( p_sys->stream,
+                                &p_sys->readbuf.p_buffer[i_avail],
+                                p_sys->readbuf.i_size - i_avail );
+        if( i_read <= 0 )
+            break;
+        i_avail += i_read;
+    }
+    p_sys->readbuf.i_filled = i_avail;
+
+    return i_avail;
+}
+
+/* Checks sync bytes of all complete packets that were not checked yet */
+static void SyncCheckTSPacketBuffer( demux_sys_t *p_sys )
+{
+    const uint8_t *p_buf = p_sys->readbuf.p_buffer;
+    size_t i_pos = p_sys->readbuf.i_synced;
+
+    while( i_pos + p_sys->i_packet_size <= p_sys->readbuf.i_filled &&
+           p_buf[i_pos + p_sys->i_packet_header_size] == 0x47 )
+        i_pos += p_sys->i_packet_size;
+
+    p_sys->readbuf.i_synced = i_pos;
+}
+
+static bool ResyncTSPacketBuffer( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const unsigned i_hdr = p_sys->i_packet_header_size;
+    unsigned i_skip = 0;
+
+    for( ;; )
+    {
+        size_t i_avail = FillTSPacketBuffer( p_demux, p_sys->i_packet_size + i_hdr + 1 );
+        if( i_avail < p_sys->i_packet_size + i_hdr + 1 )
+        {
+            msg_Dbg( p_demux, "eof ?" );
+            return false;
+        }
+
+        const uint8_t *p_start = &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset];
+        const uint8_t *p_end = p_start + i_avail - p_sys->i_packet_size;
+        const uint8_t *p = p_start + i_hdr;
+
+        while( (p = memchr( p, 0x47, p_end - p )) )
+        {
+            if( p[p_sys->i_packet_size] == 0x47 )
+                break;
+            p++;
+        }
+
+        size_t i_garbage = p ? (size_t)(p - p_start) - i_hdr
+                             : (size_t)(p_end - p_start) - i_hdr;
+        i_skip += i_garbage;
+        p_sys->readbuf.i_offset += i_garbage;
+        p_sys->readbuf.i_synced = p_sys->readbuf.i_offset;
+        if( p )
+            break;
+    }
+
+    msg_Dbg( p_demux, "skipping %u bytes of garbage", i_skip );
+    return true;
+}
+
+/* The current packet belongs to the read buffer */
+static void TSPacketRelease( block_t *p_pkt )
+{
+    VLC_UNUSED(p_pkt);
+}
+
+static const struct vlc_block_callbacks ts_packet_cbs =
+{
+    TSPacketRelease,
+};
+
+/* Turns the current packet into a block that can be kept past the next
+ * read */
+static block_t *TSPacketKeep( demux_sys_t *p_sys, block_t *p_pkt )
+{
+    if( p_pkt != &p_sys->readbuf.packet )
+        return p_pkt; /* a private copy already */
+
+    block_t *p_view = block_Share( p_sys->readbuf.p_block );
+    if( unlikely(p_view == NULL) )
+        return NULL;
+    p_view->p_buffer = p_pkt->p_buffer;
+    p_view->i_buffer = p_pkt->i_buffer;
+    p_view->i_flags = p_pkt->i_flags;
+    return p_view;
+}
+
+static block_t* ReadTSPacket( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
 
     /* Get a new TS packet */
-    if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+    if( FillTSPacketBuffer( p_demux, p_sys->i_packet_size ) < p_sys->i_packet_size )
     {
         int64_t size = stream_Size( p_sys->stream );
-        if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
-            msg_Dbg( p_demux, "EOF at %"PRIu64, vlc_stream_Tell( p_sys->stream ) );
+        if( size >= 0 && (uint64_t)size == TSStreamTell( p_demux ) )
+            msg_Dbg( p_demux, "EOF at %"PRIu64, TSStreamTell( p_demux ) );
         else
-            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, TSStreamTell( p_demux ) );
         return NULL;
     }
 
-    if( p_pkt->i_buffer < TS_HEADER_SIZE + p_sys->i_packet_header_size )
+    if( p_sys->readbuf.i_offset >= p_sys->readbuf.i_synced )
+        SyncCheckTSPacketBuffer( p_sys );
+
+    /* Check sync byte and re-sync if needed */
+    if( p_sys->readbuf.i_offset >= p_sys->readbuf.i_synced )
     {
-        block_Release( p_pkt );
-        return NULL;
+        msg_Warn( p_demux, "lost synchro" );
+        /* Drop the current packet, then look for two consecutive sync bytes */
+        p_sys->readbuf.i_offset += p_sys->i_packet_size;
+        p_sys->readbuf.i_synced = p_sys->readbuf.i_offset;
+        if( !ResyncTSPacketBuffer( p_demux ) ||
+            FillTSPacketBuffer( p_demux, p_sys->i_packet_size ) < p_sys->i_packet_size )
+            return NULL;
+        SyncCheckTSPacketBuffer( p_sys );
     }
 
+    block_t *p_pkt = block_Init( &p_sys->readbuf.packet, &ts_packet_cbs,
+                                 &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset],
+                                 p_sys->i_packet_size );
+    p_sys->readbuf.i_offset += p_sys->i_packet_size;
+
     /* Skip header (BluRay streams).
      * re-sync logic would do this (by adjusting packet start), but this would result in losing first and last ts packets.
      * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
@@ -1760,49 +1972,6 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     p_pkt->p_buffer += p_sys->i_packet_header_size;
     p_pkt->i_buffer -= p_sys->i_packet_header_size;
 
-    /* Check sync byte and re-sync if needed */
-    if( p_pkt->p_buffer[0] != 0x47 )
-    {
-        msg_Warn( p_demux, "lost synchro" );
-        block_Release( p_pkt );
-        for( ;; )
-        {
-            const uint8_t *p_peek;
-            int i_peek = 0;
-            unsigned i_skip = 0;
-
-            i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
-                    p_sys->i_packet_size * 10 );
-            if( i_peek < 0 || (unsigned)i_peek < p_sys->i_packet_size + 1 )
-            {
-                msg_Dbg( p_demux, "eof ?" );
-                return NULL;
-            }
-
-            while( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
-                {
-                    break;
-                }
-                i_skip++;
-            }
-            msg_Dbg( p_demux, "skipping %d bytes of garbage", i_skip );
-            if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
-                return NULL;
-
-            if( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                break;
-            }
-        }
-        if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
-        {
-            msg_Dbg( p_demux, "eof ?" );
-            return NULL;
-        }
-    }
     return p_pkt;
 }
 
@@ -1913,13 +2082,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return TSStreamSeek( p_demux, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSStreamTell( p_demux );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1935,7 +2104,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( TSStreamSeek( p_demux, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1949,7 +2118,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TSStreamTell( p_demux );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -2006,7 +2175,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
+        if( TSStreamSeek( p_demux, i_initial_pos ) != VLC_SUCCESS )
             msg_Err( p_demux, "Can't seek back to %" PRIu64, i_initial_pos );
         return VLC_EGENERIC;
     }
@@ -2088,7 +2257,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_
                         if( b_end )
                         {
                             p_pmt->i_last_dts = *pi_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TSStreamTell( p_demux );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2116,7 +2285,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSStreamTell( p_demux );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2129,7 +2298,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TSStreamSeek( p_demux, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, false, &i_pcr, &b_found );
@@ -2139,7 +2308,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TSStreamSeek( p_demux, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2148,7 +2317,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSStreamTell( p_demux );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2161,7 +2330,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TSStreamSeek( p_demux, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, true, &i_pcr, &b_found );
@@ -2171,7 +2340,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TSStreamSeek( p_demux, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2222,14 +2391,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TSStreamTell( p_demux ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TSStreamTell( p_demux );
             }
         }
     }
@@ -2470,6 +2639,8 @@ static block_t * ProcessTSPacket( demux_t *p_demux, ts_pid_t *pid, block_t *p_pk
     {
         if( p_sys->csa )
         {
+            /* Descrambled in place: the views kept of the read buffer do
+             * not cover the current packet */
             vlc_mutex_lock( &p_sys->csa_lock );
             csa_Decrypt( p_sys->csa, p_pkt->p_buffer, p_sys->i_csa_pkt_size );
             vlc_mutex_unlock( &p_sys->csa_lock );
@@ -2687,6 +2858,10 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, size
             p_pes->p_es->i_next_block_flags |= BLOCK_FLAG_DISCONTINUITY;
     }
 
+    p_pkt = TSPacketKeep( p_sys, p_pkt );
+    if( unlikely(p_pkt == NULL) )
+        return b_ret;
+
     if ( unlikely(p_pes->gather.i_saved > 0) )
     {
         /* Saved from previous packet end */
@@ -70,6 +70,18 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Batched reads of up to i_ts_read packets */
+    struct
+    {
+        block_t    *p_block; /* gathered payloads are shared views of it */
+        block_t     packet; /* current packet, pointing into the buffer */
+        uint8_t    *p_buffer;
+        size_t      i_size;
+        size_t      i_offset; /* next packet to hand out */
+        size_t      i_filled;
+        size_t      i_synced; /* sync byte checked up to there */
+    } readbuf;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -144,6 +156,8 @@ struct demux_sys_t
 
 void TsChangeStandard( demux_sys_t *, ts_standards_e );
 
+int TSStreamRewindBuffer( demux_t * );
+
 bool ProgramIsSelected( demux_sys_t *, uint16_t i_pgrm );
 
 void UpdatePESFilters( demux_t *p_demux, bool b_all );
@@ -2044,6 +2044,10 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
                 en50221_capmt_Delete( p_en );
                 if ( p_sys->standard == TS_STANDARD_ARIB && !p_sys->arib.b25stream )
                 {
+                    /* Packets following the PMT were already buffered:
+                     * have them read again, descrambled */
+                    if( TSStreamRewindBuffer( p_demux ) != VLC_SUCCESS )
+                        msg_Warn( p_demux, "cannot descramble buffered packets" );
                     p_sys->arib.b25stream = vlc_stream_FilterNew( p_demux->s, "aribcam" );
                     p_sys->stream = ( p_sys->arib.b25stream ) ? p_sys->arib.b25stream : p_demux->s;
                 }
@@ -38,6 +38,7 @@
 #include <vlc_demux.h>
 #include <vlc_meta.h>
 #include <vlc_input.h>
+#include <vlc_vector.h>
 
 #include <ogg/ogg.h>
 
@@ -56,6 +57,11 @@
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
+#define INDEX_CACHE_TEXT N_("Cache seek index")
+#define INDEX_CACHE_LONGTEXT N_( \
+    "Store the seek points found in a file in the cache directory, and " \
+    "reuse them to seek faster when the same file is opened again." )
+
 vlc_module_begin ()
     set_shortname ( "OGG" )
     set_description( N_("OGG demuxer" ) )
@@ -64,6 +70,8 @@ vlc_module_begin ()
     set_capability( "demux", 50 )
     set_callbacks( Open, Close )
     add_shortcut( "ogg" )
+    add_bool( "ogg-seek-index-cache", false, INDEX_CACHE_TEXT,
+              INDEX_CACHE_LONGTEXT, true )
 vlc_module_end ()
 
 
@@ -2193,7 +2201,7 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
         p_stream->p_es = NULL;
 
         /* initialise kframe index */
-        p_stream->idx=NULL;
+        vlc_vector_init( &p_stream->idx );
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2209,6 +2217,8 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
     /* get total frame count for video stream; we will need this for seeking */
     p_ogg->i_total_frames = 0;
 
+    Oggseek_IndexLoad( p_demux );
+
     return VLC_SUCCESS;
 }
 
@@ -2220,6 +2230,8 @@ static void Ogg_EndOfStream( demux_t *p_demux )
     demux_sys_t *p_ogg = p_demux->p_sys  ;
     int i_stream;
 
+    Oggseek_IndexSave( p_demux );
+
     for( i_stream = 0 ; i_stream < p_ogg->i_streams; i_stream++ )
         Ogg_LogicalStreamDelete( p_demux, p_ogg->pp_stream[i_stream] );
     free( p_ogg->pp_stream );
@@ -2299,10 +2311,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    oggseek_index_entries_free( &p_stream->idx );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
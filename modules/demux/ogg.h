@@ -43,6 +43,7 @@
 #define OGGDS_RESOLUTION     10000000
 
 typedef struct oggseek_index_entry demux_index_entry_t;
+typedef struct VLC_VECTOR(demux_index_entry_t) demux_index_t;
 typedef struct ogg_skeleton_t ogg_skeleton_t;
 
 typedef struct backup_queue
@@ -93,7 +94,7 @@ typedef struct logical_stream_s
     int8_t i_first_frame_index;
 
     /* keyframe index for seeking, created as we discover keyframes */
-    demux_index_entry_t *idx;
+    demux_index_t idx;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -224,6 +225,9 @@ typedef struct
 
     bool b_slave;
 
+    /* seek index changed since it was loaded from the cache */
+    bool b_index_changed;
+
 } demux_sys_t;
 
 
@@ -36,9 +36,14 @@
 
 #include <vlc_common.h>
 #include <vlc_demux.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_vector.h>
 
 #include <ogg/ogg.h>
 #include <limits.h>
+#include <errno.h>
 
 #include <assert.h>
 
@@ -60,115 +65,274 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
+/* free all entries in index */
 
-void oggseek_index_entries_free ( demux_index_entry_t *idx )
+void oggseek_index_entries_free ( demux_index_t *idx )
 {
-    demux_index_entry_t *idx_next;
-
-    while ( idx != NULL )
-    {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
-    }
-}
-
-
-/* internal function to create a new list member */
-
-static demux_index_entry_t *index_entry_new( void )
-{
-    demux_index_entry_t *idx = xmalloc( sizeof( demux_index_entry_t ) );
-    if ( !idx ) return NULL;
-    idx->p_next = idx->p_prev = NULL;
-    idx->i_pagepos_end = -1;
-    return idx;
+    vlc_vector_clear( idx );
 }
 
 /* We insert into index, sorting by pagepos (as a page can match multiple
-   time stamps) */
+   time stamps). An entry already in the index is returned instead of being
+   added again. The returned entry is valid until the next insertion. */
 const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
                                              vlc_tick_t i_timestamp,
                                              int64_t i_pagepos )
 {
-    demux_index_entry_t *idx;
-    demux_index_entry_t *last_idx = NULL;
-
     if ( p_stream == NULL ) return NULL;
 
-    idx = p_stream->idx;
-
     if ( i_timestamp == VLC_TICK_INVALID || i_pagepos < 1 ) return NULL;
 
-    if ( idx == NULL )
+    demux_index_t *idx = &p_stream->idx;
+
+    /* insert after the last entry with a lower or equal pagepos, entries
+     * of the same page being ordered by timestamp */
+    size_t i_low = 0, i_high = idx->size;
+    while ( i_low < i_high )
     {
-        demux_index_entry_t *ie = index_entry_new();
-        if ( !ie ) return NULL;
-        ie->i_value = i_timestamp;
-        ie->i_pagepos = i_pagepos;
-        p_stream->idx = ie;
-        return ie;
+        size_t i_mid = i_low + ( i_high - i_low ) / 2;
+        const demux_index_entry_t *p_mid = &idx->data[i_mid];
+        if ( p_mid->i_pagepos > i_pagepos ||
+             ( p_mid->i_pagepos == i_pagepos && p_mid->i_value > i_timestamp ) )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
     }
 
-    while ( idx != NULL )
+    if ( i_low > 0 && idx->data[i_low - 1].i_pagepos == i_pagepos &&
+         idx->data[i_low - 1].i_value == i_timestamp )
+        return &idx->data[i_low - 1];
+
+    demux_index_entry_t entry = {
+        .i_value = i_timestamp,
+        .i_pagepos = i_pagepos,
+        .i_pagepos_end = -1,
+    };
+    if ( !vlc_vector_insert( idx, i_low, entry ) )
+        return NULL;
+
+    return &idx->data[i_low];
+}
+
+static bool OggSeekIndexFind ( logical_stream_t *p_stream, vlc_tick_t i_timestamp,
+                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+{
+    const demux_index_t *idx = &p_stream->idx;
+
+    /* first entry past the timestamp */
+    size_t i_low = 0, i_high = idx->size;
+    while ( i_low < i_high )
     {
-        if ( idx->i_pagepos > i_pagepos ) break;
-        last_idx = idx;
-        idx = idx->p_next;
+        size_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( idx->data[i_mid].i_value > i_timestamp )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
     }
 
-    /* new entry; insert after last_idx */
-    idx = index_entry_new();
-    if ( !idx ) return NULL;
-    if ( last_idx != NULL )
+    if ( i_low == 0 )
+        return false;
+
+    *pi_pos_lower = idx->data[i_low - 1].i_pagepos;
+    if ( i_low < idx->size ) /* otherwise found on last index */
+        *pi_pos_upper = idx->data[i_low].i_pagepos;
+    return true;
+}
+
+/************************************************************
+* persistent index cache
+*************************************************************/
+
+/* Cache files start with this header, followed for each logical stream by
+ * its serial number, its entries count and its entries. */
+#define OGGSEEK_CACHE_MAGIC   "VLCOGGIX"
+#define OGGSEEK_CACHE_VERSION 1
+
+typedef struct
+{
+    char     magic[8];
+    uint32_t i_version;
+    uint32_t i_streams;
+    uint64_t i_size;
+} oggseek_cache_header_t;
+
+typedef struct
+{
+    int64_t i_value;
+    int64_t i_pagepos;
+} oggseek_cache_entry_t;
+
+static void OggSeekCacheCreateDir( const char *psz_dir )
+{
+    char newdir[strlen( psz_dir ) + 1];
+    strcpy( newdir, psz_dir );
+    char *psz = newdir;
+
+    while( *psz )
     {
-        idx->p_next = last_idx->p_next;
-        last_idx->p_next = idx;
-        idx->p_prev = last_idx;
+        while( *psz && *psz != DIR_SEP_CHAR ) psz++;
+        if( !*psz ) break;
+        *psz = 0;
+        if( newdir[0] )
+            vlc_mkdir( newdir, 0700 );
+        *psz = DIR_SEP_CHAR;
+        psz++;
     }
-    else
+    vlc_mkdir( psz_dir, 0700 );
+}
+
+/* The cache is keyed by the file location and size */
+static char *OggSeekCachePath( demux_t *p_demux, bool b_create )
+{
+    if ( !var_InheritBool( p_demux, "ogg-seek-index-cache" )
+      || p_demux->psz_url == NULL )
+        return NULL;
+
+    uint64_t i_size;
+    if ( vlc_stream_GetSize( p_demux->s, &i_size ) || i_size == 0 )
+        return NULL;
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if ( psz_cachedir == NULL )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, p_demux->psz_url, strlen( p_demux->psz_url ) );
+    AddMD5( &md5, &i_size, sizeof( i_size ) );
+    EndMD5( &md5 );
+    char *psz_hash = psz_md5_hash( &md5 );
+
+    char *psz_dir = NULL, *psz_path = NULL;
+    if ( psz_hash != NULL
+      && asprintf( &psz_dir, "%s" DIR_SEP "ogg", psz_cachedir ) != -1 )
     {
-        idx->p_next = p_stream->idx;
-        p_stream->idx = idx;
+        if ( b_create )
+            OggSeekCacheCreateDir( psz_dir );
+        if ( asprintf( &psz_path, "%s" DIR_SEP "%s", psz_dir, psz_hash ) == -1 )
+            psz_path = NULL;
+        free( psz_dir );
     }
+    free( psz_hash );
+    free( psz_cachedir );
+    return psz_path;
+}
+
+static logical_stream_t *OggSeekCacheFindStream( demux_sys_t *p_sys,
+                                                 uint32_t i_serial_no )
+{
+    for ( int i = 0; i < p_sys->i_streams; i++ )
+        if ( (uint32_t) p_sys->pp_stream[i]->i_serial_no == i_serial_no )
+            return p_sys->pp_stream[i];
+    return NULL;
+}
+
+void Oggseek_IndexLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    p_sys->b_index_changed = false;
+
+    char *psz_path = OggSeekCachePath( p_demux, false );
+    if ( psz_path == NULL )
+        return;
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    free( psz_path );
+    if ( p_file == NULL )
+        return;
+
+    uint64_t i_size;
+    oggseek_cache_header_t hdr;
+    if ( fread( &hdr, sizeof( hdr ), 1, p_file ) != 1
+      || memcmp( hdr.magic, OGGSEEK_CACHE_MAGIC, sizeof( hdr.magic ) )
+      || hdr.i_version != OGGSEEK_CACHE_VERSION
+      || vlc_stream_GetSize( p_demux->s, &i_size ) || hdr.i_size != i_size )
+        goto end;
 
-    if ( idx->p_next != NULL )
+    for ( uint32_t i = 0; i < hdr.i_streams; i++ )
     {
-        idx->p_next->p_prev = idx;
-    }
+        uint32_t i_serial_no, i_count;
+        if ( fread( &i_serial_no, sizeof( i_serial_no ), 1, p_file ) != 1
+          || fread( &i_count, sizeof( i_count ), 1, p_file ) != 1 )
+            break;
 
-    idx->i_value = i_timestamp;
-    idx->i_pagepos = i_pagepos;
+        /* Serial numbers are random: a mismatch means another file */
+        logical_stream_t *p_stream = OggSeekCacheFindStream( p_sys, i_serial_no );
+        if ( p_stream == NULL )
+            break;
 
-    return idx;
+        for ( uint32_t j = 0; j < i_count; j++ )
+        {
+            oggseek_cache_entry_t entry;
+            if ( fread( &entry, sizeof( entry ), 1, p_file ) != 1 )
+                goto end;
+            if ( (uint64_t) entry.i_pagepos < i_size )
+                OggSeek_IndexAdd( p_stream, entry.i_value, entry.i_pagepos );
+        }
+        msg_Dbg( p_demux, "loaded %zu seek index entries for stream %"PRIu32,
+                 p_stream->idx.size, i_serial_no );
+    }
+end:
+    fclose( p_file );
 }
 
-static bool OggSeekIndexFind ( logical_stream_t *p_stream, vlc_tick_t i_timestamp,
-                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+void Oggseek_IndexSave( demux_t *p_demux )
 {
-    demux_index_entry_t *idx = p_stream->idx;
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if ( !p_sys->b_index_changed )
+        return;
+    p_sys->b_index_changed = false;
+
+    char *psz_path = OggSeekCachePath( p_demux, true );
+    if ( psz_path == NULL )
+        return;
+    FILE *p_file = vlc_fopen( psz_path, "wb" );
+    if ( p_file == NULL )
+    {
+        msg_Warn( p_demux, "cannot write seek index cache %s: %s",
+                  psz_path, vlc_strerror_c( errno ) );
+        free( psz_path );
+        return;
+    }
+
+    uint64_t i_size;
+    if ( vlc_stream_GetSize( p_demux->s, &i_size ) )
+        i_size = 0;
 
-    while ( idx != NULL )
+    oggseek_cache_header_t hdr;
+    memset( &hdr, 0, sizeof( hdr ) );
+    memcpy( hdr.magic, OGGSEEK_CACHE_MAGIC, sizeof( hdr.magic ) );
+    hdr.i_version = OGGSEEK_CACHE_VERSION;
+    hdr.i_streams = p_sys->i_streams;
+    hdr.i_size = i_size;
+    bool b_error = fwrite( &hdr, sizeof( hdr ), 1, p_file ) != 1;
+
+    for ( int i = 0; i < p_sys->i_streams && !b_error; i++ )
     {
-        if ( idx->i_value <= i_timestamp )
+        const logical_stream_t *p_stream = p_sys->pp_stream[i];
+        uint32_t i_serial_no = p_stream->i_serial_no;
+        uint32_t i_count = p_stream->idx.size;
+
+        b_error = fwrite( &i_serial_no, sizeof( i_serial_no ), 1, p_file ) != 1
+               || fwrite( &i_count, sizeof( i_count ), 1, p_file ) != 1;
+
+        for ( uint32_t j = 0; j < i_count && !b_error; j++ )
         {
-            if ( !idx->p_next ) /* found on last index */
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                return true;
-            }
-            if ( idx->p_next->i_value > i_timestamp )
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
-            }
+            const oggseek_cache_entry_t entry = {
+                .i_value = p_stream->idx.data[j].i_value,
+                .i_pagepos = p_stream->idx.data[j].i_pagepos,
+            };
+            b_error = fwrite( &entry, sizeof( entry ), 1, p_file ) != 1;
         }
-        idx = idx->p_next;
     }
 
-    return false;
+    if ( fclose( p_file ) || b_error )
+    {
+        msg_Warn( p_demux, "cannot write seek index cache %s", psz_path );
+        vlc_unlink( psz_path );
+    }
+    free( psz_path );
 }
 
 /*********************************************************************
@@ -906,10 +1070,13 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
         seek_byte( p_demux, p_sys->i_input_position );
     }
     /* Insert keyframe position into index */
+    const size_t i_index_size = p_stream->idx.size;
     OggNoDebug(
     if ( i_pagepos >= p_stream->i_data_start )
         OggSeek_IndexAdd( p_stream, i_time, i_pagepos )
     );
+    if ( p_stream->idx.size != i_index_size )
+        p_sys->b_index_changed = true;
 
     OggDebug( msg_Dbg( p_demux, "=================== Seeked To %"PRId64" time %"PRId64, i_pagepos, i_time ) );
     return i_pagepos;
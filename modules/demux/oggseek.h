@@ -42,14 +42,13 @@
 /* index entries are structured as follows:
  *   - for theora, highest granulepos -> pagepos (bytes) where keyframe begins
  *  - for dirac, kframe (sync point) -> pagepos of sequence start (?)
+ *
+ * They are kept sorted by pagepos, which also sorts them by value.
  */
 
 /* this is typedefed to demux_index_entry_t in ogg.h */
 struct oggseek_index_entry
 {
-    demux_index_entry_t *p_next;
-    demux_index_entry_t *p_prev;
-
     /* value is highest granulepos for theora, sync frame for dirac */
     vlc_tick_t i_value;
     int64_t i_pagepos;
@@ -64,6 +63,10 @@ int     Oggseek_SeektoAbsolutetime ( demux_t *, logical_stream_t *, vlc_tick_t )
 const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *, vlc_tick_t, int64_t );
 void    Oggseek_ProbeEnd( demux_t * );
 
-void oggseek_index_entries_free ( demux_index_entry_t * );
+void oggseek_index_entries_free ( demux_index_t * );
+
+/* Persistent index cache, see "ogg-seek-index-cache" */
+void Oggseek_IndexLoad ( demux_t * );
+void Oggseek_IndexSave ( demux_t * );
 
 int64_t oggseek_read_page ( demux_t * );
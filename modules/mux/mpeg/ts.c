@@ -1148,6 +1148,14 @@ static block_t *Encap_J2K( block_t *p_data, const es_format_t *p_fmt )
         return NULL;
     }
 
+    /* The header overwrites the boxes preceding the codestream */
+    if( i_offset > 0 )
+    {
+        p_data = block_MakeWritable( p_data );
+        if( unlikely(!p_data) )
+            return NULL;
+    }
+
     if( i_offset < 38 )
     {
         block_t *p_realloc = block_Realloc( p_data, 38 - i_offset, p_data->i_buffer );
@@ -25,6 +25,8 @@
 
 static bool block_WillRealloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
 {
+    if( block_IsShared( p_block ) )
+        return false;
     if( i_prebody <= 0 && i_body <= (size_t)(-i_prebody) )
         return false;
     else
@@ -120,7 +122,8 @@ block_t *hxxx_AnnexB_to_xVC( block_t *p_block, uint8_t i_nal_length_size )
     uint8_t *p_dest = NULL;
     const size_t i_dest = p_block->i_buffer + p_list[i_nalcount - 1].move;
 
-    if( p_list[i_nalcount - 1].move != 0 || i_nal_length_size != 4 )  /* We'll need to grow or shrink */
+    if( p_list[i_nalcount - 1].move != 0 || i_nal_length_size != 4 ||  /* We'll need to grow or shrink */
+        block_IsShared( p_block ) ) /* or to not write in place */
     {
         /* If we grow in size, try using realloc to avoid memcpy */
         if( p_list[i_nalcount - 1].move > 0 && block_WillRealloc( p_block, 0, i_dest ) )
@@ -36,66 +36,71 @@
 // #define STREAM_DEBUG 1
 
 /*
- * Complex scheme using mutliple track to avoid seeking
+ * Byte range cache
+ *
+ * Method:
+ *  - Data read from the source is kept in fixed size chunks, each caching a
+ *    contiguous byte range. Chunks are sorted by offset and never overlap, so
+ *    that any position can be looked up with a binary search. Seeking back
+ *    to any range that was already read does not touch the source.
+ *  - The source is only seeked when missing data is read. Small forward gaps
+ *    are read through (and cached) instead.
+ *  - Reads are sized from the measured source throughput.
+ *  - The least recently used chunk is dropped when the cache is full.
+ *  - For slow seekable sources, the end of the stream, where many formats
+ *    store their index, is fetched in the background at start.
  */
 
-/* How many tracks we have, currently only used for stream mode */
+/* Default maximum size of our cache (KiB) */
 #ifdef OPTIMIZE_MEMORY
-#   define STREAM_CACHE_TRACK 1
-    /* Max size of our cache 128Ko per track */
-#   define STREAM_CACHE_SIZE  (STREAM_CACHE_TRACK*1024*128)
+#   define STREAM_CACHE_SIZE  (128)
 #else
-#   define STREAM_CACHE_TRACK 3
-    /* Max size of our cache 4Mo per track */
-#   define STREAM_CACHE_SIZE  (4*STREAM_CACHE_TRACK*1024*1024)
+#   define STREAM_CACHE_SIZE  (12*1024)
 #endif
+#define STREAM_CHUNK_SIZE (32*1024)
 
 /* How many data we try to prebuffer
  * XXX it should be small to avoid useless latency but big enough for
  * efficient demux probing */
 #define STREAM_CACHE_PREBUFFER_SIZE (128)
 
-/* Method:
- *  - We use ring buffers, only one if unseekable, all if seekable
- *  - Upon seek date current ring, then search if one ring match the pos,
- *      yes: switch to it, seek the access to match the end of the ring
- *      no: search the ring with i_end the closer to i_pos,
- *          if close enough, read data and use this ring
- *          else use the oldest ring, seek and use it.
- *
- *  TODO: - with access non seekable: use all space available for only one ring, but
- *          we have to support seekable/non-seekable switch on the fly.
- *        - compute a good value for i_read_size
- *        - ?
- */
+/* Reads are sized to take about STREAM_READ_AHEAD at the measured rate */
 #define STREAM_READ_ATONCE 1024
-#define STREAM_CACHE_TRACK_SIZE (STREAM_CACHE_SIZE/STREAM_CACHE_TRACK)
+#define STREAM_READ_MAX (1024*1024)
+/* The operating system already caches local files */
+#define STREAM_READ_MAX_FASTSEEK (64*1024)
+#define STREAM_READ_AHEAD VLC_TICK_FROM_MS(50)
+/* Only the last seconds of reads are accounted for */
+#define STREAM_STAT_WINDOW VLC_TICK_FROM_SEC(2)
 
 typedef struct
 {
-    vlc_tick_t date;
-
     uint64_t i_start;
-    uint64_t i_end;
-
-    uint8_t *p_buffer;
-
-} stream_track_t;
+    size_t   i_length;  /* Cached bytes from i_start */
+    uint64_t i_used;    /* Last use date, in cache accesses */
+    uint8_t  p_buffer[STREAM_CHUNK_SIZE];
+} stream_chunk_t;
 
 typedef struct
 {
     uint64_t     i_pos;      /* Current reading offset */
 
-    unsigned     i_offset;   /* Buffer offset in the current track */
-    int          i_tk;       /* Current track */
-    stream_track_t tk[STREAM_CACHE_TRACK];
-
-    /* Global buffer */
-    uint8_t     *p_buffer;
-
-    /* */
-    unsigned     i_used; /* Used since last read */
-    unsigned     i_read_size;
+    /* Cached ranges, sorted by offset */
+    vlc_mutex_t  lock;
+    stream_chunk_t **pp_chunks;
+    size_t       i_chunks;
+    size_t       i_max_chunks;
+    uint64_t     i_clock;
+    uint64_t     i_eof;      /* Source size, once its end was reached */
+
+    /* Source access, serialized with the tail prefetch */
+    vlc_mutex_t  source_lock;
+    uint64_t     i_source_pos;
+    bool         b_can_seek;
+    bool         b_can_fastseek;
+    uint8_t     *p_read;
+    size_t       i_read_size;
+    size_t       i_read_max;
 
     struct
     {
@@ -104,343 +109,407 @@ typedef struct
         uint64_t i_bytes;
         vlc_tick_t i_read_time;
     } stat;
+
+    /* Tail prefetch */
+    bool         b_tail;
+    uint64_t     i_tail_start;
+    uint64_t     i_tail_end;
+    vlc_thread_t thread;
+    vlc_interrupt_t *interrupt;
 } stream_sys_t;
 
-static int AStreamRefillStream(stream_t *s)
+/* Returns the index of the first chunk starting after i_pos */
+static size_t ChunkUpperBound(const stream_sys_t *sys, uint64_t i_pos)
 {
-    stream_sys_t *sys = s->p_sys;
-    stream_track_t *tk = &sys->tk[sys->i_tk];
+    size_t lo = 0, hi = sys->i_chunks;
 
-    /* We read but won't increase i_start after initial start + offset */
-    int i_toread =
-        __MIN(sys->i_used, STREAM_CACHE_TRACK_SIZE -
-               (tk->i_end - tk->i_start - sys->i_offset));
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
 
-    if (i_toread <= 0) return VLC_SUCCESS; /* EOF */
+        if (sys->pp_chunks[mid]->i_start <= i_pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
 
-#ifdef STREAM_DEBUG
-    msg_Dbg(s, "AStreamRefillStream: used=%d toread=%d",
-                 sys->i_used, i_toread);
-#endif
+static stream_chunk_t *ChunkLookup(const stream_sys_t *sys, uint64_t i_pos)
+{
+    size_t i = ChunkUpperBound(sys, i_pos);
+    if (i == 0)
+        return NULL;
 
-    vlc_tick_t start = vlc_tick_now();
-    while (i_toread > 0)
-    {
-        int i_off = tk->i_end % STREAM_CACHE_TRACK_SIZE;
-        int i_read;
+    stream_chunk_t *chunk = sys->pp_chunks[i - 1];
+    return (i_pos - chunk->i_start < chunk->i_length) ? chunk : NULL;
+}
 
-        if (vlc_killed())
-            return VLC_EGENERIC;
+static void ChunkEvict(stream_sys_t *sys)
+{
+    size_t i_oldest = 0;
 
-        i_read = __MIN(i_toread, STREAM_CACHE_TRACK_SIZE - i_off);
-        i_read = vlc_stream_Read(s->s, &tk->p_buffer[i_off], i_read);
+    assert(sys->i_chunks > 0);
+    for (size_t i = 1; i < sys->i_chunks; i++)
+        if (sys->pp_chunks[i]->i_used < sys->pp_chunks[i_oldest]->i_used)
+            i_oldest = i;
 
-        /* msg_Dbg(s, "AStreamRefillStream: read=%d", i_read); */
-        if (i_read <  0)
-        {
-            continue;
-        }
-        else if (i_read == 0)
-            return VLC_SUCCESS;
+    free(sys->pp_chunks[i_oldest]);
+    sys->i_chunks--;
+    memmove(&sys->pp_chunks[i_oldest], &sys->pp_chunks[i_oldest + 1],
+            (sys->i_chunks - i_oldest) * sizeof (*sys->pp_chunks));
+}
 
-        /* Update end */
-        tk->i_end += i_read;
+static void CacheFlush(stream_sys_t *sys)
+{
+    for (size_t i = 0; i < sys->i_chunks; i++)
+        free(sys->pp_chunks[i]);
+    sys->i_chunks = 0;
+    sys->i_eof = UINT64_MAX;
+}
 
-        /* Windows of STREAM_CACHE_TRACK_SIZE */
-        if (tk->i_start + STREAM_CACHE_TRACK_SIZE < tk->i_end)
-        {
-            unsigned i_invalid = tk->i_end - tk->i_start - STREAM_CACHE_TRACK_SIZE;
+/* Caches data read at i_pos, skipping the ranges that are already cached.
+ * Must be called with the lock held. */
+static void CacheInsert(stream_sys_t *sys, uint64_t i_pos,
+                        const uint8_t *p_data, size_t i_len)
+{
+    while (i_len > 0)
+    {
+        size_t i = ChunkUpperBound(sys, i_pos);
+        stream_chunk_t *chunk = (i > 0) ? sys->pp_chunks[i - 1] : NULL;
+        size_t i_copy;
 
-            tk->i_start += i_invalid;
-            sys->i_offset -= i_invalid;
+        if (chunk != NULL && i_pos - chunk->i_start < chunk->i_length)
+        {   /* Already cached */
+            i_copy = __MIN(i_len, chunk->i_start + chunk->i_length - i_pos);
         }
+        else
+        {
+            if (chunk == NULL || chunk->i_length == STREAM_CHUNK_SIZE
+             || chunk->i_start + chunk->i_length != i_pos)
+            {   /* Cannot extend the previous chunk, start a new one */
+                if (sys->i_chunks == sys->i_max_chunks)
+                {
+                    ChunkEvict(sys);
+                    continue;
+                }
+
+                chunk = malloc(sizeof (*chunk));
+                if (unlikely(chunk == NULL))
+                    return;
+
+                chunk->i_start = i_pos;
+                chunk->i_length = 0;
+                memmove(&sys->pp_chunks[i + 1], &sys->pp_chunks[i],
+                        (sys->i_chunks - i) * sizeof (*sys->pp_chunks));
+                sys->pp_chunks[i] = chunk;
+                sys->i_chunks++;
+                i++;
+            }
 
-        i_toread -= i_read;
-        sys->i_used -= i_read;
+            i_copy = __MIN(i_len, STREAM_CHUNK_SIZE - chunk->i_length);
+            /* Do not overlap the next chunk */
+            if (i < sys->i_chunks)
+                i_copy = __MIN(i_copy, sys->pp_chunks[i]->i_start - i_pos);
 
-        sys->stat.i_bytes += i_read;
-        sys->stat.i_read_count++;
-    }
+            memcpy(&chunk->p_buffer[chunk->i_length], p_data, i_copy);
+            chunk->i_length += i_copy;
+            chunk->i_used = ++sys->i_clock;
+        }
 
-    sys->stat.i_read_time += vlc_tick_now() - start;
-    return VLC_SUCCESS;
+        i_pos += i_copy;
+        p_data += i_copy;
+        i_len -= i_copy;
+    }
 }
 
-static void AStreamPrebufferStream(stream_t *s)
+/* Must be called with the source lock held */
+static void UpdateStat(stream_sys_t *sys, size_t i_read, vlc_tick_t i_time)
 {
-    stream_sys_t *sys = s->p_sys;
-    vlc_tick_t start = vlc_tick_now();
-    bool first = true;
+    if (sys->stat.i_read_time > STREAM_STAT_WINDOW)
+    {
+        sys->stat.i_bytes /= 2;
+        sys->stat.i_read_time /= 2;
+    }
+    sys->stat.i_bytes += i_read;
+    sys->stat.i_read_time += i_time;
+    sys->stat.i_read_count++;
+
+    uint64_t i_byterate = (CLOCK_FREQ * sys->stat.i_bytes) /
+                          (sys->stat.i_read_time + 1);
+    sys->i_read_size = VLC_CLIP(i_byterate * STREAM_READ_AHEAD / CLOCK_FREQ,
+                                STREAM_READ_ATONCE, sys->i_read_max);
+}
 
-    msg_Dbg(s, "starting pre-buffering");
-    for (;;)
+/* Locks the source for the reading thread. The tail prefetch holds it while
+ * it reads, so an interruption of the reader is forwarded to it: a stalled
+ * tail read must not block the input from stopping. */
+static void SourceLock(stream_sys_t *sys)
+{
+    if (sys->b_tail)
     {
-        stream_track_t *tk = &sys->tk[sys->i_tk];
-        vlc_tick_t now = vlc_tick_now();
+        void *data[2];
+
+        vlc_interrupt_forward_start(sys->interrupt, data);
+        vlc_mutex_lock(&sys->source_lock);
+        vlc_interrupt_forward_stop(data);
+    }
+    else
+        vlc_mutex_lock(&sys->source_lock);
+}
 
-        int i_read;
-        int i_buffered = tk->i_end - tk->i_start;
+/* Reads missing data at i_pos from the source into the cache.
+ *
+ * Returns 0 at the end of the stream or on error, a negative value if no
+ * data is available yet, and a positive value otherwise. */
+static ssize_t AStreamFill(stream_t *s, uint64_t i_pos, size_t i_len)
+{
+    stream_sys_t *sys = s->p_sys;
+    ssize_t ret = 1;
 
-        if (vlc_killed() || i_buffered >= STREAM_CACHE_PREBUFFER_SIZE)
-        {
-            int64_t i_byterate;
+    SourceLock(sys);
 
-            /* Update stat */
-            sys->stat.i_bytes = i_buffered;
-            sys->stat.i_read_time = now - start;
-            i_byterate = (CLOCK_FREQ * sys->stat.i_bytes) /
-                         (sys->stat.i_read_time+1);
+    /* The tail prefetch may have read it meanwhile */
+    vlc_mutex_lock(&sys->lock);
+    if (i_pos >= sys->i_eof)
+        ret = 0;
+    else if (ChunkLookup(sys, i_pos) != NULL)
+        i_len = 0;
+    vlc_mutex_unlock(&sys->lock);
 
-            msg_Dbg(s, "pre-buffering done %"PRId64" bytes in %"PRId64"s - "
-                    "%"PRId64" KiB/s", sys->stat.i_bytes,
-                    SEC_FROM_VLC_TICK(sys->stat.i_read_time), i_byterate / 1024);
-            break;
-        }
+    uint64_t i_from = sys->i_source_pos;
+    uint64_t i_end = i_pos + __MIN(__MAX(i_len, sys->i_read_size),
+                                   sys->i_read_max);
 
-        i_read = STREAM_CACHE_TRACK_SIZE - i_buffered;
-        i_read = __MIN((int)sys->i_read_size, i_read);
-        i_read = vlc_stream_Read(s->s, &tk->p_buffer[i_buffered], i_read);
-        if (i_read <  0)
-            continue;
-        else if (i_read == 0)
-            break;  /* EOF */
+    /* FIXME compute seek cost (instead of static 'stupid' value) */
+    uint64_t i_skip_threshold;
+    if (sys->b_can_seek)
+        i_skip_threshold = sys->b_can_fastseek ? 128 : 3 * sys->i_read_size;
+    else
+        i_skip_threshold = UINT64_MAX;
 
-        if (first)
+    if (ret > 0 && i_len > 0
+     && (i_from > i_pos || i_pos - i_from > i_skip_threshold))
+    {
+#ifdef STREAM_DEBUG
+        msg_Dbg(s, "AStreamFill: seek from %"PRIu64" to %"PRIu64,
+                i_from, i_pos);
+#endif
+        if (!sys->b_can_seek || vlc_stream_Seek(s->s, i_pos))
         {
-            msg_Dbg(s, "received first data after %"PRId64" ms",
-                    MS_FROM_VLC_TICK(vlc_tick_now() - start));
-            first = false;
+            msg_Err(s, "AStreamFill: seek to %"PRIu64" failed", i_pos);
+            ret = 0;
         }
-
-        tk->i_end += i_read;
-        sys->stat.i_read_count++;
+        else
+            sys->i_source_pos = i_from = i_pos;
     }
-}
 
-/****************************************************************************
- * AStreamControlReset:
- ****************************************************************************/
-static void AStreamControlReset(stream_t *s)
-{
-    stream_sys_t *sys = s->p_sys;
+    /* Read from the source position, through any small gap, until some of
+     * the requested data is available */
+    while (ret > 0 && i_len > 0 && i_from <= i_pos)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        ssize_t i_read = vlc_stream_ReadPartial(s->s, sys->p_read,
+                                                __MIN(i_end - i_from,
+                                                      sys->i_read_max));
+        if (i_read < 0)
+        {
+            ret = -1;
+            break;
+        }
 
-    sys->i_pos = 0;
+        vlc_mutex_lock(&sys->lock);
+        if (i_read == 0 && !vlc_killed())
+            sys->i_eof = i_from;
+        CacheInsert(sys, i_from, sys->p_read, i_read);
+        vlc_mutex_unlock(&sys->lock);
 
-    /* Setup our tracks */
-    sys->i_offset = 0;
-    sys->i_tk     = 0;
-    sys->i_used   = 0;
+        if (i_read == 0)
+            ret = 0;
+        else
+            UpdateStat(sys, i_read, vlc_tick_now() - start);
 
-    for (unsigned i = 0; i < STREAM_CACHE_TRACK; i++)
-    {
-        sys->tk[i].date  = 0;
-        sys->tk[i].i_start = sys->i_pos;
-        sys->tk[i].i_end   = sys->i_pos;
+        i_from += i_read;
+        sys->i_source_pos = i_from;
     }
 
-    /* Do the prebuffering */
-    AStreamPrebufferStream(s);
+    vlc_mutex_unlock(&sys->source_lock);
+    return ret;
 }
 
 static ssize_t AStreamReadStream(stream_t *s, void *buf, size_t len)
 {
     stream_sys_t *sys = s->p_sys;
-    stream_track_t *tk = &sys->tk[sys->i_tk];
-
-    if (tk->i_start >= tk->i_end)
-        return 0; /* EOF */
+    stream_chunk_t *chunk;
 
 #ifdef STREAM_DEBUG
-    msg_Dbg(s, "AStreamReadStream: %zd pos=%"PRId64" tk=%d start=%"PRId64
-            " offset=%d end=%"PRId64, len, sys->i_pos, sys->i_tk,
-            tk->i_start, sys->i_offset, tk->i_end);
+    msg_Dbg(s, "AStreamReadStream: %zu pos=%"PRIu64, len, sys->i_pos);
 #endif
 
-    unsigned i_off = (tk->i_start + sys->i_offset) % STREAM_CACHE_TRACK_SIZE;
-    size_t i_current = __MIN(tk->i_end - tk->i_start - sys->i_offset,
-                             STREAM_CACHE_TRACK_SIZE - i_off);
-    ssize_t i_copy = __MIN(i_current, len);
-    if (i_copy <= 0)
-        return 0; /* EOF */
+    vlc_mutex_lock(&sys->lock);
+    while ((chunk = ChunkLookup(sys, sys->i_pos)) == NULL)
+    {
+        if (sys->i_pos >= sys->i_eof)
+        {
+            vlc_mutex_unlock(&sys->lock);
+            return 0; /* EOF */
+        }
+        vlc_mutex_unlock(&sys->lock);
 
-    /* Copy data */
-    /* msg_Dbg(s, "AStreamReadStream: copy %zd", i_copy); */
-    if (buf != NULL)
-        memcpy(buf, &tk->p_buffer[i_off], i_copy);
-    sys->i_offset += i_copy;
+        ssize_t ret = AStreamFill(s, sys->i_pos, len);
+        if (ret <= 0)
+            return ret;
 
-    /* Update pos now */
-    sys->i_pos += i_copy;
+        vlc_mutex_lock(&sys->lock);
+    }
 
-    /* */
-    sys->i_used += i_copy;
+    size_t i_offset = sys->i_pos - chunk->i_start;
+    size_t i_copy = __MIN(len, chunk->i_length - i_offset);
 
-    if (tk->i_end + i_copy <= tk->i_start + sys->i_offset + len)
-    {
-        const size_t i_read_requested = VLC_CLIP(len - i_copy,
-                                                 STREAM_READ_ATONCE / 2,
-                                                 STREAM_READ_ATONCE * 10);
-        if (sys->i_used < i_read_requested)
-            sys->i_used = i_read_requested;
-
-        AStreamRefillStream(s);
-    }
+    memcpy(buf, &chunk->p_buffer[i_offset], i_copy);
+    chunk->i_used = ++sys->i_clock;
+    vlc_mutex_unlock(&sys->lock);
 
+    sys->i_pos += i_copy;
     return i_copy;
 }
 
 static int AStreamSeekStream(stream_t *s, uint64_t i_pos)
 {
     stream_sys_t *sys = s->p_sys;
-    stream_track_t *p_current = &sys->tk[sys->i_tk];
-
-    if (p_current->i_start >= p_current->i_end  && i_pos >= p_current->i_end)
-        return 0; /* EOF */
 
 #ifdef STREAM_DEBUG
-    msg_Dbg(s, "AStreamSeekStream: to %"PRId64" pos=%"PRId64
-             " tk=%d start=%"PRId64" offset=%d end=%"PRId64,
-             i_pos, sys->i_pos, sys->i_tk, p_current->i_start,
-             sys->i_offset, p_current->i_end);
+    msg_Dbg(s, "AStreamSeekStream: to %"PRIu64" pos=%"PRIu64,
+            i_pos, sys->i_pos);
 #endif
 
-    bool   b_aseek;
-    vlc_stream_Control(s->s, STREAM_CAN_SEEK, &b_aseek);
-    if (!b_aseek && i_pos < p_current->i_start)
+    if (!sys->b_can_seek)
     {
-        msg_Warn(s, "AStreamSeekStream: can't seek");
-        return VLC_EGENERIC;
+        vlc_mutex_lock(&sys->source_lock);
+        vlc_mutex_lock(&sys->lock);
+        bool b_ok = i_pos >= sys->i_source_pos
+                 || ChunkLookup(sys, i_pos) != NULL;
+        vlc_mutex_unlock(&sys->lock);
+        vlc_mutex_unlock(&sys->source_lock);
+
+        if (!b_ok)
+        {
+            msg_Warn(s, "AStreamSeekStream: can't seek");
+            return VLC_EGENERIC;
+        }
     }
 
-    bool   b_afastseek;
-    vlc_stream_Control(s->s, STREAM_CAN_FASTSEEK, &b_afastseek);
+    /* The source is seeked when the data is actually read */
+    sys->i_pos = i_pos;
+    return VLC_SUCCESS;
+}
 
-    /* FIXME compute seek cost (instead of static 'stupid' value) */
-    uint64_t i_skip_threshold;
-    if (b_aseek)
-        i_skip_threshold = b_afastseek ? 128 : 3 * sys->i_read_size;
-    else
-        i_skip_threshold = INT64_MAX;
+static void *AStreamTailThread(void *data)
+{
+    stream_t *s = data;
+    stream_sys_t *sys = s->p_sys;
+    uint64_t i_pos = sys->i_tail_start;
+    vlc_tick_t start = vlc_tick_now();
 
-    /* Date the current track */
-    p_current->date = vlc_tick_now();
+    vlc_interrupt_set(sys->interrupt);
 
-    /* Search a new track slot */
-    stream_track_t *tk = NULL;
-    int i_tk_idx = -1;
+    /* Fetch the whole tail at once, in reads as large as possible: sharing
+     * the source with the reads of the demuxer would cost two seeks, ie.
+     * two round trips on network sources, each time they interleave. The
+     * demuxer waits for the tail at most, which it would read soon anyway,
+     * unless it gets interrupted (see SourceLock()). */
+    vlc_mutex_lock(&sys->source_lock);
+    if (sys->i_source_pos != i_pos && vlc_stream_Seek(s->s, i_pos))
+        i_pos = UINT64_MAX; /* unknown */
 
-    /* Prefer the current track */
-    if (p_current->i_start <= i_pos && i_pos <= p_current->i_end + i_skip_threshold)
+    while (i_pos < sys->i_tail_end && !vlc_killed())
     {
-        tk = p_current;
-        i_tk_idx = sys->i_tk;
-    }
-    if (!tk)
-    {
-        /* Try to maximize already read data */
-        for (int i = 0; i < STREAM_CACHE_TRACK; i++)
+        vlc_tick_t read_start = vlc_tick_now();
+        ssize_t i_read = vlc_stream_ReadPartial(s->s, sys->p_read,
+                                                __MIN(sys->i_tail_end - i_pos,
+                                                      sys->i_read_max));
+        if (i_read < 0)
         {
-            stream_track_t *t = &sys->tk[i];
+            i_pos = UINT64_MAX; /* unknown */
+            break;
+        }
 
-            if (t->i_start > i_pos || i_pos > t->i_end)
-                continue;
+        vlc_mutex_lock(&sys->lock);
+        if (i_read == 0 && !vlc_killed())
+            sys->i_eof = i_pos;
+        CacheInsert(sys, i_pos, sys->p_read, i_read);
+        vlc_mutex_unlock(&sys->lock);
 
-            if (!tk || tk->i_end < t->i_end)
-            {
-                tk = t;
-                i_tk_idx = i;
-            }
-        }
+        if (i_read == 0)
+            break;
+        UpdateStat(sys, i_read, vlc_tick_now() - read_start);
+        i_pos += i_read;
     }
-    if (!tk)
-    {
-        /* Use the oldest unused */
-        for (int i = 0; i < STREAM_CACHE_TRACK; i++)
-        {
-            stream_track_t *t = &sys->tk[i];
+    sys->i_source_pos = i_pos;
+    vlc_mutex_unlock(&sys->source_lock);
+
+    if (i_pos != UINT64_MAX)
+        msg_Dbg(s, "prefetched %"PRIu64" bytes at the end in %"PRId64" ms",
+                i_pos - sys->i_tail_start,
+                MS_FROM_VLC_TICK(vlc_tick_now() - start));
+    return NULL;
+}
 
-            if (!tk || tk->date > t->date)
-            {
-                tk = t;
-                i_tk_idx = i;
-            }
-        }
+static void AStreamTailStart(stream_t *s)
+{
+    stream_sys_t *sys = s->p_sys;
+    uint64_t i_tail = var_InheritInteger(s, "cache-read-tail") << 10;
+    uint64_t i_size;
+
+    /* Fast seeking sources do not benefit from it */
+    if (i_tail == 0 || !sys->b_can_seek || sys->b_can_fastseek
+     || vlc_stream_GetSize(s->s, &i_size) || i_size == 0)
+        return;
+
+    /* Keep room for the data around the reading position */
+    i_tail = __MIN(i_tail, sys->i_max_chunks * STREAM_CHUNK_SIZE / 2);
+    if (i_size <= i_tail + sys->i_source_pos)
+        return; /* The whole stream will be read anyway */
+
+    sys->i_tail_start = i_size - i_tail;
+    sys->i_tail_end = i_size;
+    sys->interrupt = vlc_interrupt_create();
+    if (unlikely(sys->interrupt == NULL))
+        return;
+
+    if (vlc_clone(&sys->thread, AStreamTailThread, s,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_interrupt_destroy(sys->interrupt);
+        return;
     }
-    assert(i_tk_idx >= 0 && i_tk_idx < STREAM_CACHE_TRACK);
+    sys->b_tail = true;
+}
 
-    if (tk != p_current)
-        i_skip_threshold = 0;
-    if (tk->i_start <= i_pos && i_pos <= tk->i_end + i_skip_threshold)
-    {
-#ifdef STREAM_DEBUG
-        msg_Err(s, "AStreamSeekStream: reusing %d start=%"PRId64
-                 " end=%"PRId64"(%s)",
-                 i_tk_idx, tk->i_start, tk->i_end,
-                 tk != p_current ? "seek" : i_pos > tk->i_end ? "skip" : "noseek");
-#endif
-        if (tk != p_current)
-        {
-            assert(b_aseek);
+static void AStreamTailStop(stream_t *s)
+{
+    stream_sys_t *sys = s->p_sys;
 
-            /* Seek at the end of the buffer
-             * TODO it is stupid to seek now, it would be better to delay it
-             */
-            if (vlc_stream_Seek(s->s, tk->i_end))
-            {
-                msg_Err(s, "AStreamSeekStream: hard seek failed");
-                return VLC_EGENERIC;
-            }
-        }
-        else if (i_pos > tk->i_end)
-        {
-            uint64_t i_skip = i_pos - tk->i_end;
-            while (i_skip > 0)
-            {
-                const int i_read_max = __MIN(10 * STREAM_READ_ATONCE, i_skip);
-                int i_read = 0;
-                if ((i_read = AStreamReadStream(s, NULL, i_read_max)) < 0)
-                {
-                    msg_Err(s, "AStreamSeekStream: skip failed");
-                    return VLC_EGENERIC;
-                } else if (i_read == 0)
-                    return VLC_SUCCESS; /* EOF */
-                i_skip -= i_read_max;
-            }
-        }
-    }
-    else
-    {
-#ifdef STREAM_DEBUG
-        msg_Err(s, "AStreamSeekStream: hard seek");
-#endif
-        /* Nothing good, seek and choose oldest segment */
-        if (vlc_stream_Seek(s->s, i_pos))
-        {
-            msg_Err(s, "AStreamSeekStream: hard seek failed");
-            return VLC_EGENERIC;
-        }
+    if (!sys->b_tail)
+        return;
 
-        tk->i_start = i_pos;
-        tk->i_end   = i_pos;
-    }
-    sys->i_offset = i_pos - tk->i_start;
-    sys->i_tk = i_tk_idx;
-    sys->i_pos = i_pos;
+    vlc_interrupt_kill(sys->interrupt);
+    vlc_join(sys->thread, NULL);
+    vlc_interrupt_destroy(sys->interrupt);
+    sys->b_tail = false;
+}
 
-    /* If there is not enough data left in the track, refill  */
-    /* TODO How to get a correct value for
-     *    - refilling threshold
-     *    - how much to refill
-     */
-    if (tk->i_end < tk->i_start + sys->i_offset + sys->i_read_size)
-    {
-        if (sys->i_used < STREAM_READ_ATONCE / 2)
-            sys->i_used = STREAM_READ_ATONCE / 2;
+static void AStreamPrebufferStream(stream_t *s)
+{
+    stream_sys_t *sys = s->p_sys;
+    vlc_tick_t start = vlc_tick_now();
 
-        if (AStreamRefillStream(s))
-            return VLC_EGENERIC;
-    }
-    return VLC_SUCCESS;
+    msg_Dbg(s, "starting pre-buffering");
+    if (AStreamFill(s, sys->i_pos, STREAM_CACHE_PREBUFFER_SIZE) <= 0)
+        return;
+
+    msg_Dbg(s, "received first data after %"PRId64" ms",
+            MS_FROM_VLC_TICK(vlc_tick_now() - start));
 }
 
 /****************************************************************************
@@ -448,6 +517,9 @@ static int AStreamSeekStream(stream_t *s, uint64_t i_pos)
  ****************************************************************************/
 static int AStreamControl(stream_t *s, int i_query, va_list args)
 {
+    stream_sys_t *sys = s->p_sys;
+    int ret;
+
     switch(i_query)
     {
         case STREAM_CAN_SEEK:
@@ -467,16 +539,22 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
         case STREAM_SET_PRIVATE_ID_STATE:
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
-            return vlc_stream_vaControl(s->s, i_query, args);
+            SourceLock(sys);
+            ret = vlc_stream_vaControl(s->s, i_query, args);
+            vlc_mutex_unlock(&sys->source_lock);
+            return ret;
 
         case STREAM_SET_TITLE:
         case STREAM_SET_SEEKPOINT:
-        {
-            int ret = vlc_stream_vaControl(s->s, i_query, args);
+            AStreamTailStop(s);
+            ret = vlc_stream_vaControl(s->s, i_query, args);
             if (ret == VLC_SUCCESS)
-                AStreamControlReset(s);
+            {
+                CacheFlush(sys);
+                sys->i_pos = sys->i_source_pos = 0;
+                AStreamPrebufferStream(s);
+            }
             return ret;
-        }
 
         case STREAM_SET_RECORD_STATE:
         default:
@@ -486,6 +564,14 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
     return VLC_SUCCESS;
 }
 
+static void AStreamDestroy(stream_sys_t *sys)
+{
+    CacheFlush(sys);
+    free(sys->pp_chunks);
+    free(sys->p_read);
+    free(sys);
+}
+
 static int Open(vlc_object_t *obj)
 {
     stream_t *s = (stream_t *)obj;
@@ -497,53 +583,57 @@ static int Open(vlc_object_t *obj)
     if (unlikely(sys == NULL))
         return VLC_ENOMEM;
 
-    /* Common field */
-    sys->i_pos = 0;
+    size_t i_cache_size = var_InheritInteger(s, "cache-read-size") << 10;
+
+    vlc_mutex_init(&sys->lock);
+    sys->i_chunks = 0;
+    sys->i_max_chunks = i_cache_size / STREAM_CHUNK_SIZE;
+    sys->i_clock = 0;
+    sys->i_eof = UINT64_MAX;
+    sys->pp_chunks = vlc_alloc(sys->i_max_chunks, sizeof (*sys->pp_chunks));
+
+    vlc_mutex_init(&sys->source_lock);
+    vlc_stream_Control(s->s, STREAM_CAN_SEEK, &sys->b_can_seek);
+    vlc_stream_Control(s->s, STREAM_CAN_FASTSEEK, &sys->b_can_fastseek);
+    sys->i_read_size = STREAM_READ_ATONCE;
+    sys->i_read_max = __MIN(sys->b_can_fastseek ? STREAM_READ_MAX_FASTSEEK
+                                                : STREAM_READ_MAX,
+                            i_cache_size / 4);
+    sys->p_read = malloc(sys->i_read_max);
+#if STREAM_READ_ATONCE < 256
+#   error "Invalid STREAM_READ_ATONCE value"
+#endif
 
     /* Stats */
     sys->stat.i_bytes = 0;
     sys->stat.i_read_time = 0;
     sys->stat.i_read_count = 0;
 
-    msg_Dbg(s, "Using stream method for AStream*");
+    sys->b_tail = false;
 
-    /* Allocate/Setup our tracks */
-    sys->i_offset = 0;
-    sys->i_tk     = 0;
-    sys->p_buffer = malloc(STREAM_CACHE_SIZE);
-    if (sys->p_buffer == NULL)
+    if (unlikely(sys->pp_chunks == NULL || sys->p_read == NULL))
     {
-        free(sys);
+        AStreamDestroy(sys);
         return VLC_ENOMEM;
     }
 
-    sys->i_used   = 0;
-    sys->i_read_size = STREAM_READ_ATONCE;
-#if STREAM_READ_ATONCE < 256
-#   error "Invalid STREAM_READ_ATONCE value"
-#endif
-
-    for (unsigned i = 0; i < STREAM_CACHE_TRACK; i++)
-    {
-        sys->tk[i].date  = 0;
-        sys->tk[i].i_start = sys->i_pos;
-        sys->tk[i].i_end   = sys->i_pos;
-        sys->tk[i].p_buffer = &sys->p_buffer[i * STREAM_CACHE_TRACK_SIZE];
-    }
-
+    sys->i_pos = sys->i_source_pos = vlc_stream_Tell(s->s);
     s->p_sys = sys;
 
+    msg_Dbg(s, "Using stream method for AStream*");
+
     /* Do the prebuffering */
     AStreamPrebufferStream(s);
 
-    if (sys->tk[sys->i_tk].i_end <= 0)
+    if (sys->i_chunks == 0)
     {
         msg_Err(s, "cannot pre fill buffer");
-        free(sys->p_buffer);
-        free(sys);
+        AStreamDestroy(sys);
         return VLC_EGENERIC;
     }
 
+    AStreamTailStart(s);
+
     s->pf_read = AStreamReadStream;
     s->pf_seek = AStreamSeekStream;
     s->pf_control = AStreamControl;
@@ -558,10 +648,18 @@ static void Close(vlc_object_t *obj)
     stream_t *s = (stream_t *)obj;
     stream_sys_t *sys = s->p_sys;
 
-    free(sys->p_buffer);
-    free(sys);
+    AStreamTailStop(s);
+    AStreamDestroy(sys);
 }
 
+#define CACHE_SIZE_TEXT N_("Cache size")
+#define CACHE_SIZE_LONGTEXT N_("Maximum amount of data kept by the byte " \
+    "stream cache (KiB).")
+#define CACHE_TAIL_TEXT N_("Tail prefetch size")
+#define CACHE_TAIL_LONGTEXT N_("Amount of data fetched in the background " \
+    "from the end of slow seekable streams, where many file formats store " \
+    "their index (KiB). 0 disables the prefetch.")
+
 vlc_module_begin()
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_STREAM_FILTER)
@@ -570,4 +668,11 @@ vlc_module_begin()
 
     set_description(N_("Byte stream cache"))
     set_callbacks(Open, Close)
+
+    add_integer("cache-read-size", STREAM_CACHE_SIZE, CACHE_SIZE_TEXT,
+                CACHE_SIZE_LONGTEXT, true)
+        change_integer_range(4 * STREAM_CHUNK_SIZE / 1024, 1 << 20)
+    add_integer("cache-read-tail", 256, CACHE_TAIL_TEXT,
+                CACHE_TAIL_LONGTEXT, true)
+        change_integer_range(0, 1 << 19)
 vlc_module_end()
@@ -176,6 +176,14 @@ static int Send( sout_stream_t *p_stream, void *id, block_t *p_buffer )
 
         if( id != NULL && p_buffer->i_buffer > 0 )
         {
+            /* The decoder may modify its input, which could be shared */
+            p_buffer = block_MakeWritable( p_buffer );
+            if( p_buffer == NULL )
+            {
+                p_buffer = p_next;
+                continue;
+            }
+
             if( p_buffer->i_dts == VLC_TICK_INVALID )
                 p_buffer->i_dts = 0;
             else
@@ -1389,52 +1389,169 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/* Maximum number of packets sent at once */
+#define RTP_MAX_BATCH 32
+
+/**
+ * Handles a send error on a sink.
+ * @return true if the sink connection is broken.
+ */
+static bool rtp_send_failed( int fd, const block_t *out )
+{
+    switch( net_errno )
+    {
+        case EAGAIN:
+#if (EAGAIN != EWOULDBLOCK)
+        case EWOULDBLOCK:
+#endif
+        case ENOBUFS:
+        case ENOMEM:
+            return false;
+    }
+
+    int type;
+    getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &(socklen_t){ sizeof(type) });
+    if( type == SOCK_DGRAM )
+    {   /* ICMP soft error: ignore and retry */
+        send( fd, out->p_buffer, out->i_buffer, 0 );
+        return false;
+    }
+    return true; /* Broken connection */
+}
+
+/**
+ * Sends a batch of packets to one sink.
+ * @return -1 if the sink connection is broken, 0 otherwise.
+ */
+static int rtp_send_batch( int fd, block_t *const *outv, unsigned outc )
+{
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[RTP_MAX_BATCH];
+    struct iovec iov[RTP_MAX_BATCH];
+
+    memset( msgs, 0, outc * sizeof (*msgs) );
+    for( unsigned i = 0; i < outc; i++ )
+    {
+        iov[i].iov_base = outv[i]->p_buffer;
+        iov[i].iov_len = outv[i]->i_buffer;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for( unsigned i = 0; i < outc; )
+    {
+        int val = sendmmsg( fd, &msgs[i], outc - i, 0 );
+        if( val == -1 )
+        {   /* Skip the failing packet */
+            if( rtp_send_failed( fd, outv[i] ) )
+                return -1;
+            val = 1;
+        }
+        i += val;
+    }
+#else
+    for( unsigned i = 0; i < outc; i++ )
+        if( send( fd, outv[i]->p_buffer, outv[i]->i_buffer, 0 ) == -1
+         && rtp_send_failed( fd, outv[i] ) )
+            return -1;
+#endif
+    return 0;
+}
+
+#ifdef HAVE_SRTP
+static block_t *rtp_srtp_protect( sout_stream_id_sys_t *id, block_t *out )
+{   /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    /* Encrypted in place, while the payload may be shared */
+    out = block_MakeWritable( out );
+    if( out == NULL )
+        return NULL;
+    out = block_Realloc( out, 0, len + 10 );
+    if( out == NULL )
+        return NULL;
+    out->i_buffer = len;
+
+    int canc = vlc_savecancel ();
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    vlc_restorecancel (canc);
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+/**
+ * Protects a packet if needed, and waits until it is due.
+ */
+static block_t *rtp_wait_packet( sout_stream_id_sys_t *id, block_t *out,
+                                 vlc_tick_t i_caching )
+{
+    block_cleanup_push (out);
+
+#ifdef HAVE_SRTP
+    if( id->srtp )
+        out = rtp_srtp_protect( id, out );
+    if (out)
+        vlc_tick_wait (out->i_dts + i_caching);
+#else
+    VLC_UNUSED(id);
+    vlc_tick_wait (out->i_dts + i_caching);
+#endif
+    vlc_cleanup_pop ();
+    return out;
+}
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     vlc_tick_t i_caching = id->i_caching;
+    block_t *next = NULL; /* dequeued packet that is not due yet */
 
     for (;;)
     {
-        block_t *out = block_FifoGet( id->p_fifo );
-        block_cleanup_push (out);
+        block_t *outv[RTP_MAX_BATCH];
+        unsigned outc = 0;
 
-#ifdef HAVE_SRTP
-        if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
-            {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
-            }
-            else
-                out->i_buffer = len;
-        }
-        if (out)
-            vlc_tick_wait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
+        block_t *out = (next != NULL) ? next : block_FifoGet( id->p_fifo );
+        next = NULL;
+        out = rtp_wait_packet( id, out, i_caching );
         if (out == NULL)
             continue;
-#else
-        vlc_tick_wait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
+        outv[outc++] = out;
+
+        /* Send the packets that are due already along with this one */
+        vlc_tick_t now = vlc_tick_now();
+        while( outc < RTP_MAX_BATCH )
+        {
+            vlc_fifo_Lock( id->p_fifo );
+            out = vlc_fifo_DequeueUnlocked( id->p_fifo );
+            vlc_fifo_Unlock( id->p_fifo );
+            if( out == NULL )
+                break;
+            if( out->i_dts + i_caching > now )
+            {
+                next = out;
+                break;
+            }
+#ifdef HAVE_SRTP
+            if( id->srtp && (out = rtp_srtp_protect( id, out )) == NULL )
+                continue;
 #endif
+            outv[outc++] = out;
+        }
 
-        ssize_t len = out->i_buffer;
         int canc = vlc_savecancel ();
 
         vlc_mutex_lock( &id->lock_sink );
@@ -1446,26 +1563,17 @@ static void* ThreadSend( void *data )
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = 0; j < outc; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, outv[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
-            {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
-            }
+            if( rtp_send_batch( id->sinkv[i].rtp_fd, outv, outc ) )
+                deadv[deadc++] = id->sinkv[i].rtp_fd;
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        id->i_seq_sent_next = ntohs(((uint16_t *) outv[outc - 1]->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+
+        for( unsigned j = 0; j < outc; j++ )
+            block_Release( outv[j] );
 
         for( unsigned i = 0; i < deadc; i++ )
         {
@@ -713,6 +713,14 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
             goto error;
     }
 
+    /* The decoders may modify their input, which could be shared */
+    if( p_buffer != NULL )
+    {
+        p_buffer = block_ChainMakeWritable( p_buffer );
+        if( p_buffer == NULL )
+            return VLC_ENOMEM;
+    }
+
     int i_ret;
     switch( id->p_decoder->fmt_in.i_cat )
     {
@@ -46,6 +46,8 @@
 #include FT_GLYPH_H
 #include FT_STROKER_H
 
+#include "text_cache.h"
+
 /* Consistency between Freetype versions and platforms */
 #define FT_FLOOR(X)     ((X & -64) >> 6)
 #define FT_CEIL(X)      (((X + 63) & -64) >> 6)
@@ -110,6 +112,10 @@ typedef struct
     /** Font face cache */
     vlc_dictionary_t  face_map;
 
+    /** Rendered glyphs and shaped runs caches, see LayoutCachesInit() */
+    text_cache_t     *p_glyph_cache;
+    text_cache_t     *p_shaping_cache;
+
     int               i_fallback_counter;
 
     /* Current scaling of the text, default is 100 (%) */
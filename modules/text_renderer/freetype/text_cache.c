@@ -0,0 +1,305 @@
+/*****************************************************************************
+ * text_cache.c : Bounded caches for the text renderer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef TEXT_CACHE_TEST
+# undef NDEBUG
+#endif
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+
+#include <assert.h>
+
+#include "text_cache.h"
+
+typedef struct text_cache_entry_t text_cache_entry_t;
+struct text_cache_entry_t
+{
+    struct vlc_list     lru;        /**< Most recently used first */
+    text_cache_entry_t *p_next;     /**< Next entry in the same bucket */
+    uint32_t            i_hash;
+    size_t              i_size;
+    void               *p_value;
+    size_t              i_key_size;
+    unsigned char       p_key[];
+};
+
+struct text_cache_t
+{
+    text_cache_entry_t **pp_buckets;
+    size_t               i_buckets;     /**< Power of 2 */
+    struct vlc_list      lru;
+    void               (*pf_release)( void * );
+    size_t               i_max_size;
+    text_cache_stats_t   stats;
+};
+
+#define TEXT_CACHE_MIN_BUCKETS 64
+
+/* FNV-1a */
+static uint32_t Hash( const void *p_key, size_t i_key_size )
+{
+    const unsigned char *p = p_key;
+    uint32_t i_hash = 2166136261u;
+
+    for( size_t i = 0; i < i_key_size; i++ )
+        i_hash = ( i_hash ^ p[i] ) * 16777619u;
+    return i_hash;
+}
+
+text_cache_t *TextCache_New( size_t i_max_size, void (*pf_release)( void * ) )
+{
+    text_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( !p_cache )
+        return NULL;
+
+    p_cache->i_buckets = TEXT_CACHE_MIN_BUCKETS;
+    p_cache->pp_buckets = calloc( p_cache->i_buckets,
+                                  sizeof( *p_cache->pp_buckets ) );
+    if( !p_cache->pp_buckets )
+    {
+        free( p_cache );
+        return NULL;
+    }
+    vlc_list_init( &p_cache->lru );
+    p_cache->pf_release = pf_release;
+    p_cache->i_max_size = i_max_size;
+    return p_cache;
+}
+
+static text_cache_entry_t **FindEntry( text_cache_t *p_cache, uint32_t i_hash,
+                                       const void *p_key, size_t i_key_size )
+{
+    text_cache_entry_t **pp_entry =
+        &p_cache->pp_buckets[ i_hash & ( p_cache->i_buckets - 1 ) ];
+
+    for( ; *pp_entry; pp_entry = &(*pp_entry)->p_next )
+    {
+        const text_cache_entry_t *p_entry = *pp_entry;
+        if( p_entry->i_hash == i_hash && p_entry->i_key_size == i_key_size
+         && !memcmp( p_entry->p_key, p_key, i_key_size ) )
+            break;
+    }
+    return pp_entry;
+}
+
+static void Evict( text_cache_t *p_cache, text_cache_entry_t *p_entry )
+{
+    text_cache_entry_t **pp_entry =
+        FindEntry( p_cache, p_entry->i_hash, p_entry->p_key,
+                   p_entry->i_key_size );
+    assert( *pp_entry == p_entry );
+    *pp_entry = p_entry->p_next;
+
+    vlc_list_remove( &p_entry->lru );
+    p_cache->stats.i_size -= p_entry->i_size;
+    p_cache->stats.i_entries--;
+    p_cache->pf_release( p_entry->p_value );
+    free( p_entry );
+}
+
+void TextCache_Delete( text_cache_t *p_cache )
+{
+    text_cache_entry_t *p_entry;
+    vlc_list_foreach( p_entry, &p_cache->lru, lru )
+    {
+        p_cache->pf_release( p_entry->p_value );
+        free( p_entry );
+    }
+    free( p_cache->pp_buckets );
+    free( p_cache );
+}
+
+void *TextCache_Get( text_cache_t *p_cache,
+                     const void *p_key, size_t i_key_size )
+{
+    text_cache_entry_t *p_entry =
+        *FindEntry( p_cache, Hash( p_key, i_key_size ), p_key, i_key_size );
+
+    if( !p_entry )
+    {
+        p_cache->stats.i_misses++;
+        return NULL;
+    }
+
+    p_cache->stats.i_hits++;
+    vlc_list_remove( &p_entry->lru );
+    vlc_list_prepend( &p_entry->lru, &p_cache->lru );
+    return p_entry->p_value;
+}
+
+/* Keeps chains short as the number of entries grows */
+static void Grow( text_cache_t *p_cache )
+{
+    size_t i_buckets = p_cache->i_buckets * 2;
+    text_cache_entry_t **pp_buckets = calloc( i_buckets, sizeof( *pp_buckets ) );
+    if( !pp_buckets )
+        return;
+
+    for( size_t i = 0; i < p_cache->i_buckets; i++ )
+    {
+        text_cache_entry_t *p_entry = p_cache->pp_buckets[i];
+        while( p_entry )
+        {
+            text_cache_entry_t *p_next = p_entry->p_next;
+            text_cache_entry_t **pp_bucket =
+                &pp_buckets[ p_entry->i_hash & ( i_buckets - 1 ) ];
+            p_entry->p_next = *pp_bucket;
+            *pp_bucket = p_entry;
+            p_entry = p_next;
+        }
+    }
+    free( p_cache->pp_buckets );
+    p_cache->pp_buckets = pp_buckets;
+    p_cache->i_buckets = i_buckets;
+}
+
+void TextCache_Put( text_cache_t *p_cache,
+                    const void *p_key, size_t i_key_size,
+                    void *p_value, size_t i_size )
+{
+    if( i_size > p_cache->i_max_size )
+    {
+        p_cache->pf_release( p_value );
+        return;
+    }
+
+    text_cache_entry_t *p_entry = malloc( sizeof( *p_entry ) + i_key_size );
+    if( !p_entry )
+    {
+        p_cache->pf_release( p_value );
+        return;
+    }
+
+    /* Make room first: the new entry must not be evicted */
+    while( p_cache->stats.i_size + i_size > p_cache->i_max_size )
+        Evict( p_cache, vlc_list_last_entry_or_null( &p_cache->lru,
+                                                     text_cache_entry_t, lru ) );
+
+    if( p_cache->stats.i_entries >= p_cache->i_buckets )
+        Grow( p_cache );
+
+    p_entry->i_hash = Hash( p_key, i_key_size );
+    p_entry->i_size = i_size;
+    p_entry->p_value = p_value;
+    p_entry->i_key_size = i_key_size;
+    memcpy( p_entry->p_key, p_key, i_key_size );
+
+    text_cache_entry_t **pp_entry =
+        FindEntry( p_cache, p_entry->i_hash, p_key, i_key_size );
+    assert( *pp_entry == NULL );
+    p_entry->p_next = NULL;
+    *pp_entry = p_entry;
+
+    vlc_list_prepend( &p_entry->lru, &p_cache->lru );
+    p_cache->stats.i_size += i_size;
+    p_cache->stats.i_entries++;
+}
+
+void TextCache_GetStats( const text_cache_t *p_cache,
+                         text_cache_stats_t *p_stats )
+{
+    *p_stats = p_cache->stats;
+}
+
+#ifdef TEXT_CACHE_TEST
+static unsigned i_released;
+
+static void Release( void *p_value )
+{
+    VLC_UNUSED( p_value );
+    i_released++;
+}
+
+static void CheckStats( const text_cache_t *p_cache, unsigned long i_hits,
+                        unsigned long i_misses, size_t i_size, size_t i_entries )
+{
+    text_cache_stats_t stats;
+    TextCache_GetStats( p_cache, &stats );
+    assert( stats.i_hits == i_hits );
+    assert( stats.i_misses == i_misses );
+    assert( stats.i_size == i_size );
+    assert( stats.i_entries == i_entries );
+}
+
+int main( void )
+{
+    static int values[1000];
+    text_cache_t *p_cache = TextCache_New( 100, Release );
+    assert( p_cache );
+
+    /* Hits and misses */
+    for( int i = 0; i < 3; i++ )
+        TextCache_Put( p_cache, &i, sizeof( i ), &values[i], 30 );
+    for( int i = 0; i < 3; i++ )
+        assert( TextCache_Get( p_cache, &i, sizeof( i ) ) == &values[i] );
+    const int i_unknown = 3;
+    assert( TextCache_Get( p_cache, &i_unknown, sizeof( i_unknown ) ) == NULL );
+    /* Keys of different sizes never match */
+    const char key[] = { 0, 0, 0, 0, 0 };
+    assert( TextCache_Get( p_cache, key, sizeof( key ) ) == NULL );
+    CheckStats( p_cache, 3, 2, 90, 3 );
+
+    /* The least recently used entry is evicted to make room */
+    const int i_first = 0;
+    assert( TextCache_Get( p_cache, &i_first, sizeof( i_first ) ) );
+    TextCache_Put( p_cache, &i_unknown, sizeof( i_unknown ), &values[3], 30 );
+    assert( i_released == 1 );
+    for( int i = 0; i < 4; i++ )
+    {
+        void *p_value = TextCache_Get( p_cache, &i, sizeof( i ) );
+        assert( p_value == ( i == 1 ? NULL : &values[i] ) );
+    }
+    CheckStats( p_cache, 7, 3, 90, 3 );
+
+    /* Values larger than the cache are released at once */
+    const int i_large = 4;
+    TextCache_Put( p_cache, &i_large, sizeof( i_large ), &values[4], 101 );
+    assert( i_released == 2 );
+    assert( TextCache_Get( p_cache, &i_large, sizeof( i_large ) ) == NULL );
+    CheckStats( p_cache, 7, 4, 90, 3 );
+
+    /* Several entries are evicted for a large value */
+    TextCache_Put( p_cache, &i_large, sizeof( i_large ), &values[4], 80 );
+    assert( i_released == 5 );
+    CheckStats( p_cache, 7, 4, 80, 1 );
+    TextCache_Delete( p_cache );
+    assert( i_released == 6 );
+
+    /* Many entries, through the growth of the hash table */
+    i_released = 0;
+    p_cache = TextCache_New( 1000, Release );
+    assert( p_cache );
+    for( int i = 0; i < 1000; i++ )
+        TextCache_Put( p_cache, &i, sizeof( i ), &values[i], 1 );
+    for( int i = 0; i < 1000; i++ )
+        assert( TextCache_Get( p_cache, &i, sizeof( i ) ) == &values[i] );
+    CheckStats( p_cache, 1000, 0, 1000, 1000 );
+    assert( i_released == 0 );
+    TextCache_Delete( p_cache );
+    assert( i_released == 1000 );
+
+    return 0;
+}
+#endif
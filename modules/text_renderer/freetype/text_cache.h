@@ -0,0 +1,83 @@
+/*****************************************************************************
+ * text_cache.h : Bounded caches for the text renderer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+/** \defgroup freetype_cache Freetype caches
+ * \ingroup freetype
+ * Least recently used caches, keyed by binary keys and bounded by the
+ * total size of their values.
+ * @{
+ * \file
+ * Text renderer caches
+ */
+
+typedef struct text_cache_t text_cache_t;
+
+/**
+ * Creates a cache.
+ *
+ * \param i_max_size maximum total size of the cached values [IN]
+ * \param pf_release releases a value when it is evicted [IN]
+ */
+text_cache_t *TextCache_New( size_t i_max_size, void (*pf_release)( void * ) );
+
+/**
+ * Releases a cache and all its values.
+ */
+void TextCache_Delete( text_cache_t *p_cache );
+
+/**
+ * Looks up a value, and counts a hit or a miss.
+ *
+ * Keys are compared bytewise: any padding must be zeroed.
+ *
+ * \return the value, valid until the next TextCache_Put(), or NULL
+ */
+void *TextCache_Get( text_cache_t *p_cache,
+                     const void *p_key, size_t i_key_size );
+
+/**
+ * Inserts a value, evicting the least recently used ones as needed.
+ *
+ * The cache takes ownership of the value, even on failure. The key must not
+ * already be in the cache.
+ *
+ * \param i_size size accounted for the value [IN]
+ */
+void TextCache_Put( text_cache_t *p_cache,
+                    const void *p_key, size_t i_key_size,
+                    void *p_value, size_t i_size );
+
+typedef struct
+{
+    unsigned long i_hits;
+    unsigned long i_misses;
+    size_t        i_size;     /**< Current total size of the values */
+    size_t        i_entries;
+} text_cache_stats_t;
+
+void TextCache_GetStats( const text_cache_t *p_cache,
+                         text_cache_stats_t *p_stats );
+
+/** @} */
+
+#endif
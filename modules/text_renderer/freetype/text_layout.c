@@ -64,6 +64,7 @@
 #include "freetype.h"
 #include "text_layout.h"
 #include "platform_fonts.h"
+#include "text_cache.h"
 
 #include <stdlib.h>
 
@@ -92,6 +93,22 @@
 # warning YOU ARE MISSING FONTS FALLBACK. TEXT WILL BE INCORRECT
 #endif
 
+/* Maximum memory used by the caches */
+#define GLYPH_CACHE_SIZE   (4 << 20)
+#define SHAPING_CACHE_SIZE (1 << 20)
+
+#ifdef HAVE_HARFBUZZ
+/**
+ * Glyphs of a shaped run, as a single allocation
+ */
+typedef struct shaped_run_t
+{
+    unsigned int                i_glyph_count;
+    hb_glyph_info_t            *p_infos;
+    hb_glyph_position_t        *p_positions;
+} shaped_run_t;
+#endif
+
 /**
  * Within a paragraph, run_desc_t represents a run of characters
  * having the same font face, size, and style, Unicode script
@@ -112,15 +129,50 @@ typedef struct run_desc_t
     hb_glyph_info_t            *p_glyph_infos;
     hb_glyph_position_t        *p_glyph_positions;
     unsigned int                i_glyph_count;
+    shaped_run_t               *p_shaped;   /**< Shaping cache copy */
 #endif
 
 } run_desc_t;
 
+#define GLYPH_FLAG_EMBOLDEN     0x01
+#define GLYPH_FLAG_OBLIQUE      0x02
+#define GLYPH_FLAG_OUTLINE      0x04
+
+enum
+{
+    GLYPH_KIND_OUTLINES,        /**< Loaded glyph and stroked outline */
+    GLYPH_KIND_GLYPH_BITMAP,
+    GLYPH_KIND_OUTLINE_BITMAP,
+};
+
+/**
+ * Glyph cache key. Faces are loaded for a given size, so it is part of the
+ * face. Bitmaps are cached for each subpixel pen position.
+ */
+typedef struct
+{
+    FT_Face  p_face;
+    FT_UInt  i_glyph_index;
+    FT_Fixed i_stroke_radius;
+    uint8_t  i_flags;
+    uint8_t  i_kind;
+    uint8_t  i_x_frac;
+    uint8_t  i_y_frac;
+} glyph_key_t;
+
+typedef struct
+{
+    FT_Glyph  p_glyph;      /**< Outline, or bitmap */
+    FT_Glyph  p_outline;    /**< Stroked outline, for GLYPH_KIND_OUTLINES */
+    FT_Vector advance;
+} cached_glyph_t;
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
 typedef struct glyph_bitmaps_t
 {
+    glyph_key_t key;
     FT_Glyph p_glyph;
     FT_Glyph p_outline;
     FT_Glyph p_shadow;
@@ -299,6 +351,120 @@ static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox,
     }
 }
 
+static void ReleaseCachedGlyph( void *p_value )
+{
+    cached_glyph_t *p_cached = p_value;
+    FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+static size_t GlyphSize( FT_Glyph p_glyph )
+{
+    if( p_glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph) p_glyph)->bitmap;
+        return sizeof( FT_BitmapGlyphRec )
+             + p_bitmap->rows * (size_t) abs( p_bitmap->pitch );
+    }
+    if( p_glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &((FT_OutlineGlyph) p_glyph)->outline;
+        return sizeof( FT_OutlineGlyphRec )
+             + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+             + p_outline->n_contours * sizeof( short );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+/**
+ * Stores copies of the glyphs in the cache
+ */
+static void CacheGlyph( filter_t *p_filter, const glyph_key_t *p_key,
+                        FT_Glyph p_glyph, FT_Glyph p_outline,
+                        const FT_Vector *p_advance )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    cached_glyph_t *p_cached = calloc( 1, sizeof( *p_cached ) );
+    if( !p_cached )
+        return;
+
+    if( FT_Glyph_Copy( p_glyph, &p_cached->p_glyph ) )
+    {
+        free( p_cached );
+        return;
+    }
+    size_t i_size = sizeof( *p_cached ) + GlyphSize( p_glyph );
+
+    if( p_outline )
+    {
+        if( FT_Glyph_Copy( p_outline, &p_cached->p_outline ) )
+        {
+            ReleaseCachedGlyph( p_cached );
+            return;
+        }
+        i_size += GlyphSize( p_outline );
+    }
+    if( p_advance )
+        p_cached->advance = *p_advance;
+
+    TextCache_Put( p_sys->p_glyph_cache, p_key, sizeof( *p_key ),
+                   p_cached, i_size );
+}
+
+/**
+ * Renders an outline glyph, like FT_Glyph_To_Bitmap().
+ *
+ * Rendering at an integer pixel offset only moves the bitmap, so bitmaps are
+ * cached for the subpixel part of the pen position.
+ */
+static FT_Error RenderGlyph( filter_t *p_filter, const glyph_key_t *p_key,
+                             int i_kind, FT_Glyph *pp_glyph,
+                             const FT_Vector *p_pen, bool b_destroy )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    glyph_key_t key;
+    FT_Glyph p_bitmap;
+
+    /* Keys are compared bytewise: zero the padding */
+    memset( &key, 0, sizeof( key ) );
+    key.p_face = p_key->p_face;
+    key.i_glyph_index = p_key->i_glyph_index;
+    key.i_stroke_radius = p_key->i_stroke_radius;
+    key.i_flags = p_key->i_flags;
+    key.i_kind = i_kind;
+    key.i_x_frac = p_pen->x & 63;
+    key.i_y_frac = p_pen->y & 63;
+
+    const cached_glyph_t *p_cached =
+        TextCache_Get( p_sys->p_glyph_cache, &key, sizeof( key ) );
+    if( p_cached )
+    {
+        FT_Error err = FT_Glyph_Copy( p_cached->p_glyph, &p_bitmap );
+        if( err )
+            return err;
+    }
+    else
+    {
+        FT_Vector origin = { .x = key.i_x_frac, .y = key.i_y_frac };
+
+        p_bitmap = *pp_glyph;
+        FT_Error err = FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL,
+                                           &origin, 0 );
+        if( err )
+            return err;
+        CacheGlyph( p_filter, &key, p_bitmap, NULL, NULL );
+    }
+
+    ShiftGlyph( (FT_BitmapGlyph) p_bitmap,
+                FT_FLOOR( p_pen->x ), FT_FLOOR( p_pen->y ) );
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_bitmap;
+    return 0;
+}
+
 static paragraph_t *NewParagraph( filter_t *p_filter,
                                   int i_size,
                                   const uni_char_t *p_code_points,
@@ -739,6 +905,62 @@ static int ItemizeParagraph( filter_t *p_filter, paragraph_t *p_paragraph )
  * Glyph substitutions of base glyphs and diacritics may take place,
  * so the paragraph size may change.
  */
+typedef struct
+{
+    FT_Face        p_face;
+    hb_script_t    script;
+    hb_direction_t direction;
+} shaping_key_t;
+
+/**
+ * Shaping cache key: the font, script and direction, followed by the text
+ */
+static void *NewShapingKey( const paragraph_t *p_paragraph,
+                            const run_desc_t *p_run, size_t *pi_size )
+{
+    const size_t i_length = p_run->i_end_offset - p_run->i_start_offset;
+    const size_t i_size = sizeof( shaping_key_t ) + i_length * sizeof( uni_char_t );
+    uint8_t *p_key = malloc( i_size );
+    if( !p_key )
+        return NULL;
+
+    shaping_key_t header;
+    memset( &header, 0, sizeof( header ) );
+    header.p_face = p_run->p_face;
+    header.script = p_run->script;
+    header.direction = p_run->direction;
+    memcpy( p_key, &header, sizeof( header ) );
+    memcpy( p_key + sizeof( header ),
+            p_paragraph->p_code_points + p_run->i_start_offset,
+            i_length * sizeof( uni_char_t ) );
+
+    *pi_size = i_size;
+    return p_key;
+}
+
+static size_t ShapedRunSize( unsigned int i_glyph_count )
+{
+    return sizeof( shaped_run_t ) + i_glyph_count
+         * ( sizeof( hb_glyph_info_t ) + sizeof( hb_glyph_position_t ) );
+}
+
+static shaped_run_t *NewShapedRun( unsigned int i_glyph_count,
+                                   const hb_glyph_info_t *p_infos,
+                                   const hb_glyph_position_t *p_positions )
+{
+    shaped_run_t *p_shaped = malloc( ShapedRunSize( i_glyph_count ) );
+    if( !p_shaped )
+        return NULL;
+
+    p_shaped->i_glyph_count = i_glyph_count;
+    p_shaped->p_positions = (hb_glyph_position_t *) ( p_shaped + 1 );
+    p_shaped->p_infos = (hb_glyph_info_t *) ( p_shaped->p_positions + i_glyph_count );
+    memcpy( p_shaped->p_infos, p_infos, i_glyph_count * sizeof( *p_infos ) );
+    memcpy( p_shaped->p_positions, p_positions,
+            i_glyph_count * sizeof( *p_positions ) );
+    return p_shaped;
+}
+
 static int ShapeParagraphHarfBuzz( filter_t *p_filter,
                                    paragraph_t **p_old_paragraph )
 {
@@ -747,6 +969,8 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
     filter_sys_t *p_sys = p_filter->p_sys;
     int i_total_glyphs = 0;
     int i_ret = VLC_EGENERIC;
+    void *p_key = NULL;
+    size_t i_key_size;
 
     if( p_paragraph->i_size <= 0 || p_paragraph->i_runs_count <= 0 )
     {
@@ -785,6 +1009,29 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         else
             p_face = p_run->p_face;
 
+        p_key = NewShapingKey( p_paragraph, p_run, &i_key_size );
+        const shaped_run_t *p_cached = p_key ?
+            TextCache_Get( p_sys->p_shaping_cache, p_key, i_key_size ) : NULL;
+        if( p_cached )
+        {
+            p_run->p_shaped = NewShapedRun( p_cached->i_glyph_count,
+                                            p_cached->p_infos,
+                                            p_cached->p_positions );
+            if( !p_run->p_shaped )
+            {
+                i_ret = VLC_ENOMEM;
+                goto error;
+            }
+            p_run->p_glyph_infos = p_run->p_shaped->p_infos;
+            p_run->p_glyph_positions = p_run->p_shaped->p_positions;
+            p_run->i_glyph_count = p_run->p_shaped->i_glyph_count;
+
+            free( p_key );
+            p_key = NULL;
+            i_total_glyphs += p_run->i_glyph_count;
+            continue;
+        }
+
         p_run->p_hb_font = hb_ft_font_create( p_face, 0 );
         if( !p_run->p_hb_font )
         {
@@ -827,6 +1074,18 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
             goto error;
         }
 
+        if( p_key )
+        {
+            shaped_run_t *p_shaped = NewShapedRun( p_run->i_glyph_count,
+                                                   p_run->p_glyph_infos,
+                                                   p_run->p_glyph_positions );
+            if( p_shaped )
+                TextCache_Put( p_sys->p_shaping_cache, p_key, i_key_size,
+                               p_shaped, ShapedRunSize( p_shaped->i_glyph_count ) );
+            free( p_key );
+            p_key = NULL;
+        }
+
         i_total_glyphs += p_run->i_glyph_count;
     }
 
@@ -900,8 +1159,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        if( p_paragraph->p_runs[ i ].p_hb_font )
+            hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
+        if( p_paragraph->p_runs[ i ].p_buffer )
+            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_shaped );
     }
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
@@ -909,12 +1171,14 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
     return VLC_SUCCESS;
 
 error:
+    free( p_key );
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
         if( p_paragraph->p_runs[ i ].p_hb_font )
             hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
         if( p_paragraph->p_runs[ i ].p_buffer )
             hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_shaped );
     }
 
     if( p_new_paragraph )
@@ -1056,6 +1320,9 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        FT_Fixed i_stroke_radius = 0;
+        uint8_t i_flags = 0;
+
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
@@ -1066,8 +1333,17 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
+            i_stroke_radius = i_radius;
+            i_flags |= GLYPH_FLAG_OUTLINE;
         }
 
+        if( ( p_style->i_style_flags & STYLE_BOLD )
+              && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+            i_flags |= GLYPH_FLAG_EMBOLDEN;
+        if( ( p_style->i_style_flags & STYLE_ITALIC )
+              && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+            i_flags |= GLYPH_FLAG_OBLIQUE;
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -1118,39 +1394,64 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            glyph_key_t *p_key = &p_bitmaps->key;
+            memset( p_key, 0, sizeof( *p_key ) );
+            p_key->p_face = p_face;
+            p_key->i_glyph_index = i_glyph_index;
+            p_key->i_stroke_radius = i_stroke_radius;
+            p_key->i_flags = i_flags;
+            p_key->i_kind = GLYPH_KIND_OUTLINES;
+
+            FT_Vector advance;
+            const cached_glyph_t *p_cached =
+                TextCache_Get( p_sys->p_glyph_cache, p_key, sizeof( *p_key ) );
+            if( p_cached )
+            {
+                if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+                if( p_cached->p_outline
+                 && FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+                    p_bitmaps->p_outline = 0;
+                advance = p_cached->advance;
+            }
+            else
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+                if( i_flags & GLYPH_FLAG_EMBOLDEN )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( i_flags & GLYPH_FLAG_OBLIQUE )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-#undef SKIP_GLYPH
+                if( i_flags & GLYPH_FLAG_OUTLINE )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
 
-            if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
+                advance = p_face->glyph->advance;
+                CacheGlyph( p_filter, p_key, p_bitmaps->p_glyph,
+                            p_bitmaps->p_outline, &advance );
             }
 
+#undef SKIP_GLYPH
+
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
 
             unsigned i_x_advance = FT_FLOOR( abs( p_bitmaps->i_x_advance ) );
@@ -1257,8 +1558,10 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            const int i_kind = p_bitmaps->p_shadow == p_bitmaps->p_outline ?
+                               GLYPH_KIND_OUTLINE_BITMAP : GLYPH_KIND_GLYPH_BITMAP;
+            if( RenderGlyph( p_filter, &p_bitmaps->key, i_kind,
+                             &p_bitmaps->p_shadow, &pen_shadow, false ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1266,8 +1569,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_filter, &p_bitmaps->key, GLYPH_KIND_GLYPH_BITMAP,
+                             &p_bitmaps->p_glyph, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1282,8 +1585,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_filter, &p_bitmaps->key, GLYPH_KIND_OUTLINE_BITMAP,
+                             &p_bitmaps->p_outline, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
@@ -1850,3 +2153,60 @@ int LayoutTextBlock( filter_t *p_filter,
     return VLC_SUCCESS;
 }
 
+
+#ifdef HAVE_HARFBUZZ
+static void ReleaseShapedRun( void *p_value )
+{
+    free( p_value );
+}
+#endif
+
+int LayoutCachesInit( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    p_sys->p_glyph_cache = TextCache_New( GLYPH_CACHE_SIZE, ReleaseCachedGlyph );
+    if( !p_sys->p_glyph_cache )
+        return VLC_ENOMEM;
+
+#ifdef HAVE_HARFBUZZ
+    p_sys->p_shaping_cache = TextCache_New( SHAPING_CACHE_SIZE, ReleaseShapedRun );
+    if( !p_sys->p_shaping_cache )
+    {
+        TextCache_Delete( p_sys->p_glyph_cache );
+        p_sys->p_glyph_cache = NULL;
+        return VLC_ENOMEM;
+    }
+#endif
+    return VLC_SUCCESS;
+}
+
+static void DumpCacheStats( filter_t *p_filter, const char *psz_name,
+                            const text_cache_t *p_cache )
+{
+    text_cache_stats_t stats;
+    TextCache_GetStats( p_cache, &stats );
+    msg_Dbg( p_filter, "%s cache: %lu hits, %lu misses, %zu entries, %zu bytes",
+             psz_name, stats.i_hits, stats.i_misses, stats.i_entries,
+             stats.i_size );
+}
+
+void LayoutCachesClean( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_glyph_cache )
+    {
+        DumpCacheStats( p_filter, "glyph", p_sys->p_glyph_cache );
+        TextCache_Delete( p_sys->p_glyph_cache );
+        p_sys->p_glyph_cache = NULL;
+    }
+#ifdef HAVE_HARFBUZZ
+    if( p_sys->p_shaping_cache )
+    {
+        DumpCacheStats( p_filter, "shaping", p_sys->p_shaping_cache );
+        TextCache_Delete( p_sys->p_shaping_cache );
+        p_sys->p_shaping_cache = NULL;
+    }
+#endif
+}
@@ -107,3 +107,12 @@ typedef struct
  */
 int LayoutTextBlock( filter_t *p_filter, const layout_text_block_t *p_textblock,
                      line_desc_t **pp_lines, FT_BBox *p_bbox, int *pi_max_face_height );
+
+/**
+ * Creates the glyph and shaping caches used by LayoutTextBlock().
+ *
+ * Cached glyphs refer to the loaded faces: the caches must be cleaned
+ * before the faces are released.
+ */
+int LayoutCachesInit( filter_t *p_filter );
+void LayoutCachesClean( filter_t *p_filter );
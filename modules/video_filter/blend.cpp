@@ -32,6 +32,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include "filter_picture.h"
+#include "blend_simd.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -141,7 +142,6 @@ public:
         if (has_alpha)
             data[3] += picture->p[3].i_pitch;
     }
-private:
     pixel *getPointer(unsigned plane, unsigned dx) const
     {
         if (plane == 1 || plane == 2)
@@ -149,6 +149,7 @@ private:
 
         return (pixel*)&data[plane][(x + dx) /  1 * sizeof(pixel)];
     }
+private:
     uint8_t *data[4];
 };
 
@@ -187,7 +188,6 @@ public:
         if ((y % 2) == 0)
             data[1] += picture->p[1].i_pitch;
     }
-private:
     uint8_t *getPointer(unsigned plane, unsigned dx) const
     {
         if (plane == 0)
@@ -195,6 +195,7 @@ private:
         else
             return &data[plane][(x + dx) / 2 * 2];
     }
+private:
     uint8_t *data[2];
 };
 
@@ -330,11 +331,17 @@ public:
         y++;
         data += picture->p[0].i_pitch;
     }
-private:
+    void getOffsets(unsigned offsets[3]) const
+    {
+        offsets[0] = offset_r;
+        offsets[1] = offset_g;
+        offsets[2] = offset_b;
+    }
     uint8_t *getPointer(unsigned dx) const
     {
         return &data[(x + dx) * bytes];
     }
+private:
     int offset_r;
     int offset_g;
     int offset_b;
@@ -558,6 +565,92 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+/* The chroma of a line starts at the first horizontally full pixel, if any */
+template <unsigned rx, class TDst>
+static unsigned getChromaCount(const TDst &dst, unsigned width, unsigned *first)
+{
+    static_assert(rx == 1 || rx == 2, "unsupported subsampling");
+
+    if (dst.isFull(0))
+        *first = 0;
+    else if (dst.isFull(1))
+        *first = 1;
+    else
+        return 0;
+    return width > *first ? (width - *first + rx - 1) / rx : 0;
+}
+
+/* The following blend whole lines at once with vectorized kernels, giving
+ * the same results as Blend() for the most common 8 bits formats */
+template <unsigned rx, unsigned ry, bool swap_uv>
+void BlendYUVAToPlanar(const CPicture &dst_data, const CPicture &src_data,
+                       unsigned width, unsigned height, int alpha)
+{
+    const blend_simd_t *simd = blend_simd_Get();
+    CPictureYUVA src(src_data);
+    CPictureYUVPlanar<uint8_t, rx, ry, false, swap_uv> dst(dst_data);
+
+    for (unsigned y = 0; y < height; y++) {
+        simd->plane(dst.getPointer(0, 0), src.getPointer(0, 0),
+                    src.getPointer(3, 0), alpha, width);
+
+        unsigned first;
+        unsigned count = getChromaCount<rx>(dst, width, &first);
+        for (unsigned plane = 1; plane <= 2 && count > 0; plane++) {
+            if (rx == 1)
+                simd->plane(dst.getPointer(plane, first),
+                            src.getPointer(plane, first),
+                            src.getPointer(3, first), alpha, count);
+            else
+                simd->plane_sub(dst.getPointer(plane, first),
+                                src.getPointer(plane, first),
+                                src.getPointer(3, first), alpha, count);
+        }
+        src.nextLine();
+        dst.nextLine();
+    }
+}
+
+template <bool swap_uv>
+void BlendYUVAToSemiPlanar(const CPicture &dst_data, const CPicture &src_data,
+                           unsigned width, unsigned height, int alpha)
+{
+    const blend_simd_t *simd = blend_simd_Get();
+    CPictureYUVA src(src_data);
+    CPictureYUVSemiPlanar<swap_uv> dst(dst_data);
+
+    for (unsigned y = 0; y < height; y++) {
+        simd->plane(dst.getPointer(0, 0), src.getPointer(0, 0),
+                    src.getPointer(3, 0), alpha, width);
+
+        unsigned first;
+        unsigned count = getChromaCount<2>(dst, width, &first);
+        if (count > 0)
+            simd->plane_uv(dst.getPointer(1, first),
+                           src.getPointer(swap_uv ? 2 : 1, first),
+                           src.getPointer(swap_uv ? 1 : 2, first),
+                           src.getPointer(3, first), alpha, count);
+        src.nextLine();
+        dst.nextLine();
+    }
+}
+
+static void BlendRGBAToRGB32(const CPicture &dst_data, const CPicture &src_data,
+                             unsigned width, unsigned height, int alpha)
+{
+    const blend_simd_t *simd = blend_simd_Get();
+    CPictureRGBA src(src_data);
+    CPictureRGB32 dst(dst_data);
+    unsigned offsets[3];
+
+    dst.getOffsets(offsets);
+    for (unsigned y = 0; y < height; y++) {
+        simd->rgbx(dst.getPointer(0), src.getPointer(0), alpha, offsets, width);
+        src.nextLine();
+        dst.nextLine();
+    }
+}
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
@@ -579,6 +672,18 @@ static const struct {
     { csp, VLC_CODEC_RGBA, Blend<picture, CPictureRGBA, compose<cvt, convertRgbToYuv8> > }, \
     { csp, VLC_CODEC_YUVP, Blend<picture, CPictureYUVP, compose<cvt, convertYuvpToYuva8> > }
 
+    /* Must come first to override the generic versions */
+    { VLC_CODEC_I420, VLC_CODEC_YUVA, BlendYUVAToPlanar<2, 2, false> },
+    { VLC_CODEC_J420, VLC_CODEC_YUVA, BlendYUVAToPlanar<2, 2, false> },
+    { VLC_CODEC_YV12, VLC_CODEC_YUVA, BlendYUVAToPlanar<2, 2, true> },
+    { VLC_CODEC_I422, VLC_CODEC_YUVA, BlendYUVAToPlanar<2, 1, false> },
+    { VLC_CODEC_J422, VLC_CODEC_YUVA, BlendYUVAToPlanar<2, 1, false> },
+    { VLC_CODEC_I444, VLC_CODEC_YUVA, BlendYUVAToPlanar<1, 1, false> },
+    { VLC_CODEC_J444, VLC_CODEC_YUVA, BlendYUVAToPlanar<1, 1, false> },
+    { VLC_CODEC_NV12, VLC_CODEC_YUVA, BlendYUVAToSemiPlanar<false> },
+    { VLC_CODEC_NV21, VLC_CODEC_YUVA, BlendYUVAToSemiPlanar<true> },
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendRGBAToRGB32 },
+
     RGB(VLC_CODEC_RGB15,    CPictureRGB16,    convertRgbToRgbSmall),
     RGB(VLC_CODEC_RGB16,    CPictureRGB16,    convertRgbToRgbSmall),
     RGB(VLC_CODEC_RGB24,    CPictureRGB24,    convertNone),
@@ -688,8 +793,10 @@ static int Open(vlc_object_t *object)
 
     filter_sys_t *sys = new filter_sys_t();
     for (size_t i = 0; i < sizeof(blends) / sizeof(*blends); i++) {
-        if (blends[i].src == src && blends[i].dst == dst)
+        if (blends[i].src == src && blends[i].dst == dst) {
             sys->blend = blends[i].blend;
+            break;
+        }
     }
 
     if (!sys->blend) {
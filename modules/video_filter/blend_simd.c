@@ -0,0 +1,591 @@
+/*****************************************************************************
+ * blend_simd.c: vectorized alpha blending kernels
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef BLEND_TEST
+# undef NDEBUG
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <assert.h>
+
+#include "blend_simd.h"
+
+#if defined(HAVE_SSE2_INTRINSICS) || defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define HAVE_NEON_INTRINSICS 1
+#endif
+
+/* All intermediate values fit in 16 bits: the largest one is
+ * 255 * 255 + 255 * 255 / 256 + 1 */
+static inline unsigned div255(unsigned v)
+{
+    return ((v >> 8) + v + 1) >> 8;
+}
+
+static inline uint8_t merge(unsigned dst, unsigned src, unsigned a)
+{
+    return div255((255 - a) * dst + src * a);
+}
+
+/*****************************************************************************
+ * Generic code
+ *****************************************************************************/
+static void PlaneC(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                   unsigned alpha, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+        dst[i] = merge(dst[i], src[i], div255(alpha * a[i]));
+}
+
+static void PlaneSubC(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned alpha, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+        dst[i] = merge(dst[i], src[2 * i], div255(alpha * a[2 * i]));
+}
+
+static void PlaneUVC(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                     const uint8_t *a, unsigned alpha, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        unsigned f = div255(alpha * a[2 * i]);
+        dst[2 * i + 0] = merge(dst[2 * i + 0], u[2 * i], f);
+        dst[2 * i + 1] = merge(dst[2 * i + 1], v[2 * i], f);
+    }
+}
+
+static void RGBXC(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                  const unsigned offsets[3], unsigned count)
+{
+    for (unsigned i = 0; i < count; i++, dst += 4, src += 4)
+    {
+        unsigned f = div255(alpha * src[3]);
+        dst[offsets[0]] = merge(dst[offsets[0]], src[0], f);
+        dst[offsets[1]] = merge(dst[offsets[1]], src[1], f);
+        dst[offsets[2]] = merge(dst[offsets[2]], src[2], f);
+    }
+}
+
+static const blend_simd_t blend_c = {
+    "C", PlaneC, PlaneSubC, PlaneUVC, RGBXC,
+};
+
+/*****************************************************************************
+ * SSE4.1
+ *****************************************************************************/
+#ifdef HAVE_SSE2_INTRINSICS
+# define VLC_SSE4_1 __attribute__ ((__target__ ("sse4.1")))
+
+VLC_SSE4_1
+static inline __m128i Div255SSE(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_srli_epi16(v, 8));
+    v = _mm_add_epi16(v, _mm_set1_epi16(1));
+    return _mm_srli_epi16(v, 8);
+}
+
+/* Blends 16-bits lanes, with a the source alpha */
+VLC_SSE4_1
+static inline __m128i MergeSSE(__m128i d, __m128i s, __m128i a, __m128i alpha)
+{
+    a = Div255SSE(_mm_mullo_epi16(a, alpha));
+    d = _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a));
+    return Div255SSE(_mm_add_epi16(d, _mm_mullo_epi16(s, a)));
+}
+
+VLC_SSE4_1
+static void PlaneSSE4(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned alpha, unsigned count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha16 = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i f = _mm_loadu_si128((const __m128i *)&a[i]);
+
+        __m128i lo = MergeSSE(_mm_cvtepu8_epi16(d), _mm_cvtepu8_epi16(s),
+                              _mm_cvtepu8_epi16(f), alpha16);
+        __m128i hi = MergeSSE(_mm_unpackhi_epi8(d, zero),
+                              _mm_unpackhi_epi8(s, zero),
+                              _mm_unpackhi_epi8(f, zero), alpha16);
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+    }
+    PlaneC(&dst[i], &src[i], &a[i], alpha, count - i);
+}
+
+/* Even bytes of 16 bytes, as 16-bits lanes */
+VLC_SSE4_1
+static inline __m128i LoadEvenSSE(const uint8_t *p)
+{
+    return _mm_and_si128(_mm_loadu_si128((const __m128i *)p),
+                         _mm_set1_epi16(0xff));
+}
+
+VLC_SSE4_1
+static void PlaneSubSSE4(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                         unsigned alpha, unsigned count)
+{
+    const __m128i alpha16 = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    /* The last odd source byte may be out of the picture */
+    for (; i + 16 < count; i += 16)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+
+        __m128i lo = MergeSSE(_mm_cvtepu8_epi16(d), LoadEvenSSE(&src[2 * i]),
+                              LoadEvenSSE(&a[2 * i]), alpha16);
+        __m128i hi = MergeSSE(_mm_unpackhi_epi8(d, _mm_setzero_si128()),
+                              LoadEvenSSE(&src[2 * i + 16]),
+                              LoadEvenSSE(&a[2 * i + 16]), alpha16);
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+    }
+    PlaneSubC(&dst[i], &src[2 * i], &a[2 * i], alpha, count - i);
+}
+
+VLC_SSE4_1
+static void PlaneUVSSE4(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                        const uint8_t *a, unsigned alpha, unsigned count)
+{
+    const __m128i alpha16 = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 8 < count; i += 8)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[2 * i]);
+        __m128i f = LoadEvenSSE(&a[2 * i]);
+
+        __m128i du = MergeSSE(_mm_and_si128(d, _mm_set1_epi16(0xff)),
+                              LoadEvenSSE(&u[2 * i]), f, alpha16);
+        __m128i dv = MergeSSE(_mm_srli_epi16(d, 8),
+                              LoadEvenSSE(&v[2 * i]), f, alpha16);
+        _mm_storeu_si128((__m128i *)&dst[2 * i],
+                         _mm_or_si128(du, _mm_slli_epi16(dv, 8)));
+    }
+    PlaneUVC(&dst[2 * i], &u[2 * i], &v[2 * i], &a[2 * i], alpha, count - i);
+}
+
+/* Shuffles to move the source components to their destination offsets, and
+ * to spread the source alpha over them (and zero elsewhere) */
+static void RGBXShuffles(const unsigned offsets[3],
+                         uint8_t rgb[16], uint8_t alpha[16])
+{
+    for (unsigned i = 0; i < 16; i += 4)
+    {
+        for (unsigned j = 0; j < 4; j++)
+        {
+            rgb[i + j] = 0x80;
+            alpha[i + j] = 0x80;
+        }
+        for (unsigned j = 0; j < 3; j++)
+        {
+            rgb[i + offsets[j]] = i + j;
+            alpha[i + offsets[j]] = i + 3;
+        }
+    }
+}
+
+VLC_SSE4_1
+static void RGBXSSE4(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                     const unsigned offsets[3], unsigned count)
+{
+    uint8_t rgb_shuffle[16], alpha_shuffle[16];
+    RGBXShuffles(offsets, rgb_shuffle, alpha_shuffle);
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha16 = _mm_set1_epi16(alpha);
+    const __m128i rgb_mask = _mm_loadu_si128((const __m128i *)rgb_shuffle);
+    const __m128i alpha_mask = _mm_loadu_si128((const __m128i *)alpha_shuffle);
+    unsigned i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * i]);
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[4 * i]);
+        __m128i f = _mm_shuffle_epi8(s, alpha_mask);
+        s = _mm_shuffle_epi8(s, rgb_mask);
+
+        __m128i lo = MergeSSE(_mm_cvtepu8_epi16(d), _mm_cvtepu8_epi16(s),
+                              _mm_cvtepu8_epi16(f), alpha16);
+        __m128i hi = MergeSSE(_mm_unpackhi_epi8(d, zero),
+                              _mm_unpackhi_epi8(s, zero),
+                              _mm_unpackhi_epi8(f, zero), alpha16);
+        _mm_storeu_si128((__m128i *)&dst[4 * i], _mm_packus_epi16(lo, hi));
+    }
+    RGBXC(&dst[4 * i], &src[4 * i], alpha, offsets, count - i);
+}
+
+static const blend_simd_t blend_sse4 = {
+    "SSE4.1", PlaneSSE4, PlaneSubSSE4, PlaneUVSSE4, RGBXSSE4,
+};
+#endif
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#if defined(HAVE_AVX2_INTRINSICS) && defined(HAVE_SSE2_INTRINSICS)
+# define VLC_AVX2 __attribute__ ((__target__ ("avx2")))
+
+VLC_AVX2
+static inline __m256i Div255AVX2(__m256i v)
+{
+    v = _mm256_add_epi16(v, _mm256_srli_epi16(v, 8));
+    v = _mm256_add_epi16(v, _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(v, 8);
+}
+
+VLC_AVX2
+static inline __m256i MergeAVX2(__m256i d, __m256i s, __m256i a,
+                                __m256i alpha)
+{
+    a = Div255AVX2(_mm256_mullo_epi16(a, alpha));
+    d = _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a));
+    return Div255AVX2(_mm256_add_epi16(d, _mm256_mullo_epi16(s, a)));
+}
+
+/* Packs 16-bits lanes back to bytes, in order */
+VLC_AVX2
+static inline __m256i PackAVX2(__m256i lo, __m256i hi)
+{
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+}
+
+VLC_AVX2
+static inline __m256i LoadAVX2(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+VLC_AVX2
+static inline __m256i LoadEvenAVX2(const uint8_t *p)
+{
+    return _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p),
+                            _mm256_set1_epi16(0xff));
+}
+
+VLC_AVX2
+static void PlaneAVX2(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned alpha, unsigned count)
+{
+    const __m256i alpha16 = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i lo = MergeAVX2(LoadAVX2(&dst[i]), LoadAVX2(&src[i]),
+                               LoadAVX2(&a[i]), alpha16);
+        __m256i hi = MergeAVX2(LoadAVX2(&dst[i + 16]), LoadAVX2(&src[i + 16]),
+                               LoadAVX2(&a[i + 16]), alpha16);
+        _mm256_storeu_si256((__m256i *)&dst[i], PackAVX2(lo, hi));
+    }
+    PlaneSSE4(&dst[i], &src[i], &a[i], alpha, count - i);
+}
+
+VLC_AVX2
+static void PlaneSubAVX2(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                         unsigned alpha, unsigned count)
+{
+    const __m256i alpha16 = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    /* The last odd source byte may be out of the picture */
+    for (; i + 32 < count; i += 32)
+    {
+        __m256i lo = MergeAVX2(LoadAVX2(&dst[i]), LoadEvenAVX2(&src[2 * i]),
+                               LoadEvenAVX2(&a[2 * i]), alpha16);
+        __m256i hi = MergeAVX2(LoadAVX2(&dst[i + 16]),
+                               LoadEvenAVX2(&src[2 * i + 32]),
+                               LoadEvenAVX2(&a[2 * i + 32]), alpha16);
+        _mm256_storeu_si256((__m256i *)&dst[i], PackAVX2(lo, hi));
+    }
+    PlaneSubSSE4(&dst[i], &src[2 * i], &a[2 * i], alpha, count - i);
+}
+
+VLC_AVX2
+static void PlaneUVAVX2(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                        const uint8_t *a, unsigned alpha, unsigned count)
+{
+    const __m256i alpha16 = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < count; i += 16)
+    {
+        __m256i d = _mm256_loadu_si256((const __m256i *)&dst[2 * i]);
+        __m256i f = LoadEvenAVX2(&a[2 * i]);
+
+        __m256i du = MergeAVX2(_mm256_and_si256(d, _mm256_set1_epi16(0xff)),
+                               LoadEvenAVX2(&u[2 * i]), f, alpha16);
+        __m256i dv = MergeAVX2(_mm256_srli_epi16(d, 8),
+                               LoadEvenAVX2(&v[2 * i]), f, alpha16);
+        _mm256_storeu_si256((__m256i *)&dst[2 * i],
+                            _mm256_or_si256(du, _mm256_slli_epi16(dv, 8)));
+    }
+    PlaneUVSSE4(&dst[2 * i], &u[2 * i], &v[2 * i], &a[2 * i], alpha, count - i);
+}
+
+VLC_AVX2
+static void RGBXAVX2(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                     const unsigned offsets[3], unsigned count)
+{
+    uint8_t rgb_shuffle[16], alpha_shuffle[16];
+    RGBXShuffles(offsets, rgb_shuffle, alpha_shuffle);
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha16 = _mm256_set1_epi16(alpha);
+    const __m256i rgb_mask = _mm256_broadcastsi128_si256(
+                        _mm_loadu_si128((const __m128i *)rgb_shuffle));
+    const __m256i alpha_mask = _mm256_broadcastsi128_si256(
+                        _mm_loadu_si128((const __m128i *)alpha_shuffle));
+    unsigned i = 0;
+
+    /* Unpacking and packing work within 128-bits lanes, preserving order */
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i d = _mm256_loadu_si256((const __m256i *)&dst[4 * i]);
+        __m256i s = _mm256_loadu_si256((const __m256i *)&src[4 * i]);
+        __m256i f = _mm256_shuffle_epi8(s, alpha_mask);
+        s = _mm256_shuffle_epi8(s, rgb_mask);
+
+        __m256i lo = MergeAVX2(_mm256_unpacklo_epi8(d, zero),
+                               _mm256_unpacklo_epi8(s, zero),
+                               _mm256_unpacklo_epi8(f, zero), alpha16);
+        __m256i hi = MergeAVX2(_mm256_unpackhi_epi8(d, zero),
+                               _mm256_unpackhi_epi8(s, zero),
+                               _mm256_unpackhi_epi8(f, zero), alpha16);
+        _mm256_storeu_si256((__m256i *)&dst[4 * i],
+                            _mm256_packus_epi16(lo, hi));
+    }
+    RGBXSSE4(&dst[4 * i], &src[4 * i], alpha, offsets, count - i);
+}
+
+static const blend_simd_t blend_avx2 = {
+    "AVX2", PlaneAVX2, PlaneSubAVX2, PlaneUVAVX2, RGBXAVX2,
+};
+#endif
+
+/*****************************************************************************
+ * NEON
+ *****************************************************************************/
+#ifdef HAVE_NEON_INTRINSICS
+static inline uint16x8_t Div255NEON(uint16x8_t v)
+{
+    v = vaddq_u16(v, vshrq_n_u16(v, 8));
+    return vshrq_n_u16(vaddq_u16(v, vdupq_n_u16(1)), 8);
+}
+
+static inline uint8x8_t MergeNEON(uint8x8_t d, uint8x8_t s, uint8x8_t a,
+                                  uint16x8_t alpha)
+{
+    uint16x8_t f = Div255NEON(vmulq_u16(vmovl_u8(a), alpha));
+    uint16x8_t v = vmulq_u16(vmovl_u8(d), vsubq_u16(vdupq_n_u16(255), f));
+    v = vmlaq_u16(v, vmovl_u8(s), f);
+    return vmovn_u16(Div255NEON(v));
+}
+
+static inline uint8x16_t MergeNEONq(uint8x16_t d, uint8x16_t s, uint8x16_t a,
+                                    uint16x8_t alpha)
+{
+    return vcombine_u8(MergeNEON(vget_low_u8(d), vget_low_u8(s),
+                                 vget_low_u8(a), alpha),
+                       MergeNEON(vget_high_u8(d), vget_high_u8(s),
+                                 vget_high_u8(a), alpha));
+}
+
+static void PlaneNEON(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned alpha, unsigned count)
+{
+    const uint16x8_t alpha16 = vdupq_n_u16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(&dst[i], MergeNEONq(vld1q_u8(&dst[i]), vld1q_u8(&src[i]),
+                                     vld1q_u8(&a[i]), alpha16));
+    PlaneC(&dst[i], &src[i], &a[i], alpha, count - i);
+}
+
+static void PlaneSubNEON(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                         unsigned alpha, unsigned count)
+{
+    const uint16x8_t alpha16 = vdupq_n_u16(alpha);
+    unsigned i = 0;
+
+    /* The last odd source byte may be out of the picture */
+    for (; i + 16 < count; i += 16)
+    {
+        uint8x16x2_t s = vld2q_u8(&src[2 * i]);
+        uint8x16x2_t f = vld2q_u8(&a[2 * i]);
+        vst1q_u8(&dst[i], MergeNEONq(vld1q_u8(&dst[i]), s.val[0], f.val[0],
+                                     alpha16));
+    }
+    PlaneSubC(&dst[i], &src[2 * i], &a[2 * i], alpha, count - i);
+}
+
+static void PlaneUVNEON(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                        const uint8_t *a, unsigned alpha, unsigned count)
+{
+    const uint16x8_t alpha16 = vdupq_n_u16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < count; i += 16)
+    {
+        uint8x16x2_t d = vld2q_u8(&dst[2 * i]);
+        uint8x16x2_t su = vld2q_u8(&u[2 * i]);
+        uint8x16x2_t sv = vld2q_u8(&v[2 * i]);
+        uint8x16x2_t f = vld2q_u8(&a[2 * i]);
+        d.val[0] = MergeNEONq(d.val[0], su.val[0], f.val[0], alpha16);
+        d.val[1] = MergeNEONq(d.val[1], sv.val[0], f.val[0], alpha16);
+        vst2q_u8(&dst[2 * i], d);
+    }
+    PlaneUVC(&dst[2 * i], &u[2 * i], &v[2 * i], &a[2 * i], alpha, count - i);
+}
+
+static void RGBXNEON(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                     const unsigned offsets[3], unsigned count)
+{
+    const uint16x8_t alpha16 = vdupq_n_u16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t d = vld4q_u8(&dst[4 * i]);
+        uint8x16x4_t s = vld4q_u8(&src[4 * i]);
+        for (unsigned j = 0; j < 3; j++)
+            d.val[offsets[j]] = MergeNEONq(d.val[offsets[j]], s.val[j],
+                                           s.val[3], alpha16);
+        vst4q_u8(&dst[4 * i], d);
+    }
+    RGBXC(&dst[4 * i], &src[4 * i], alpha, offsets, count - i);
+}
+
+static const blend_simd_t blend_neon = {
+    "NEON", PlaneNEON, PlaneSubNEON, PlaneUVNEON, RGBXNEON,
+};
+#endif
+
+const blend_simd_t *blend_simd_Get(void)
+{
+#if defined(HAVE_AVX2_INTRINSICS) && defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        return &blend_avx2;
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE4_1())
+        return &blend_sse4;
+#endif
+#ifdef HAVE_NEON_INTRINSICS
+    if (vlc_CPU_ARM_NEON())
+        return &blend_neon;
+#endif
+    return &blend_c;
+}
+
+#ifdef BLEND_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIZE 1000
+
+static void fill(uint8_t *p, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        p[i] = rand();
+    /* Make sure the extreme values are covered */
+    p[0] = 0;
+    p[1] = 255;
+}
+
+/* Compares kernels with the generic code, over unaligned ranges of all
+ * sizes, checking that nothing is written out of range */
+static void check(const blend_simd_t *simd)
+{
+    static const unsigned offsets[][3] = {
+        { 0, 1, 2 }, { 2, 1, 0 }, { 1, 2, 3 }, { 3, 2, 1 },
+    };
+    uint8_t src[4 * SIZE], u[2 * SIZE], v[2 * SIZE], a[4 * SIZE];
+    uint8_t ref[4 * SIZE + 64], dst[4 * SIZE + 64];
+
+    for (unsigned count = 1; count < 100; count++)
+    {
+        const unsigned start = rand() % 32;
+        const unsigned alpha = (count % 3) ? (unsigned)rand() % 256 : 255;
+        const unsigned *offs = offsets[count % ARRAY_SIZE(offsets)];
+
+        fill(src, sizeof (src));
+        fill(u, sizeof (u));
+        fill(v, sizeof (v));
+        fill(a, sizeof (a));
+        fill(ref, sizeof (ref));
+        memcpy(dst, ref, sizeof (dst));
+
+        PlaneC(&ref[start], src, a, alpha, count);
+        simd->plane(&dst[start], src, a, alpha, count);
+        assert(!memcmp(ref, dst, sizeof (dst)));
+
+        /* Only read 2 * count - 1 source bytes */
+        PlaneSubC(&ref[start], &src[sizeof (src) - 2 * count + 1],
+                  &a[sizeof (a) - 2 * count + 1], alpha, count);
+        simd->plane_sub(&dst[start], &src[sizeof (src) - 2 * count + 1],
+                        &a[sizeof (a) - 2 * count + 1], alpha, count);
+        assert(!memcmp(ref, dst, sizeof (dst)));
+
+        PlaneUVC(&ref[start], &u[sizeof (u) - 2 * count + 1],
+                 &v[sizeof (v) - 2 * count + 1], &a[start], alpha, count);
+        simd->plane_uv(&dst[start], &u[sizeof (u) - 2 * count + 1],
+                       &v[sizeof (v) - 2 * count + 1], &a[start], alpha,
+                       count);
+        assert(!memcmp(ref, dst, sizeof (dst)));
+
+        RGBXC(&ref[start], &src[start], alpha, offs, count);
+        simd->rgbx(&dst[start], &src[start], alpha, offs, count);
+        assert(!memcmp(ref, dst, sizeof (dst)));
+    }
+}
+
+int main(void)
+{
+    const blend_simd_t *simd = blend_simd_Get();
+
+    srand(0);
+    fprintf(stderr, "checking %s kernels\n", simd->name);
+    check(simd);
+#ifdef HAVE_SSE2_INTRINSICS
+    if (simd != &blend_sse4 && vlc_CPU_SSE4_1())
+    {
+        fprintf(stderr, "checking %s kernels\n", blend_sse4.name);
+        check(&blend_sse4);
+    }
+#endif
+    return 0;
+}
+#endif
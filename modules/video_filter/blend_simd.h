@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * blend_simd.h: vectorized alpha blending kernels
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_BLEND_SIMD_H
+#define VLC_BLEND_SIMD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Blending kernels for one line of 8-bits samples.
+ *
+ * Each sample is blended as dst = (dst * (255 - a) + src * a) / 255, with
+ * a = alpha * src_alpha / 255, using the same rounding as the generic code.
+ */
+typedef struct
+{
+    const char *name;
+
+    /** dst[i] with src[i] and a[i], for i < count */
+    void (*plane)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                  unsigned alpha, unsigned count);
+    /** dst[i] with src[2i] and a[2i]: horizontally subsampled chroma */
+    void (*plane_sub)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned alpha, unsigned count);
+    /** dst[2i] with u[2i] and dst[2i+1] with v[2i], using a[2i]:
+     * horizontally subsampled and interleaved chroma */
+    void (*plane_uv)(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                     const uint8_t *a, unsigned alpha, unsigned count);
+    /** 32-bits RGB pixels with red, green and blue at the given byte
+     * offsets, from RGBA pixels; the fourth byte is left untouched */
+    void (*rgbx)(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                 const unsigned offsets[3], unsigned count);
+} blend_simd_t;
+
+/**
+ * Returns the fastest kernels for the running CPU.
+ */
+const blend_simd_t *blend_simd_Get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -59,14 +59,22 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
 #define BASE_CHROMA_TEXT N_("Chroma for the base image")
-#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
+#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded " \
+                                "in. A comma separated list benchmarks each " \
+                                "chroma in turn.")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
 #define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
 
 #define BLEND_CHROMA_TEXT N_("Chroma for the blend image")
 #define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
-                                 " in")
+                                 " in. A comma separated list benchmarks each" \
+                                 " chroma in turn.")
+
+#define WIDTH_TEXT N_("Width of the generated images")
+#define HEIGHT_TEXT N_("Height of the generated images")
+#define SIZE_LONGTEXT N_("Without image files, reproducible images of this " \
+                         "size are generated.")
 
 #define CFG_PREFIX "blendbench-"
 
@@ -82,6 +90,10 @@ vlc_module_begin ()
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "width", 1920, 1, 16384, WIDTH_TEXT,
+              SIZE_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "height", 1080, 1, 16384, HEIGHT_TEXT,
+              SIZE_LONGTEXT, false )
 
     set_section( N_("Base image"), NULL )
     add_loadfile(CFG_PREFIX "base-image", NULL,
@@ -99,8 +111,8 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "width", "height", "base-image", "base-chroma",
+    "blend-image", "blend-chroma", NULL
 };
 
 /*****************************************************************************
@@ -110,38 +122,108 @@ typedef struct
 {
     bool b_done;
     int i_loops, i_alpha;
+    unsigned i_width, i_height;
 
-    picture_t *p_base_image;
-    picture_t *p_blend_image;
+    char *psz_base_image;
+    char *psz_blend_image;
 
-    vlc_fourcc_t i_base_chroma;
-    vlc_fourcc_t i_blend_chroma;
+    char *psz_base_chromas;
+    char *psz_blend_chromas;
 } filter_sys_t;
 
-static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
-                                 vlc_fourcc_t i_chroma, char *psz_file, const char *psz_name )
+static picture_t *blendbench_LoadImage( vlc_object_t *p_this,
+                                        vlc_fourcc_t i_chroma,
+                                        const char *psz_file,
+                                        const char *psz_name )
 {
     image_handler_t *p_image;
     video_format_t fmt_out;
+    picture_t *p_pic;
 
     video_format_Init( &fmt_out, i_chroma );
 
     p_image = image_HandlerCreate( p_this );
-    *pp_pic = image_ReadUrl( p_image, psz_file, &fmt_out );
+    if( p_image == NULL )
+        return NULL;
+    p_pic = image_ReadUrl( p_image, psz_file, &fmt_out );
     video_format_Clean( &fmt_out );
     image_HandlerDelete( p_image );
 
-    if( *pp_pic == NULL )
+    if( p_pic == NULL )
     {
         msg_Err( p_this, "Unable to load %s image", psz_name );
-        return VLC_EGENERIC;
+        return NULL;
     }
 
     msg_Dbg( p_this, "%s image has dim %d x %d (Y plane)", psz_name,
-             (*pp_pic)->p[Y_PLANE].i_visible_pitch,
-             (*pp_pic)->p[Y_PLANE].i_visible_lines );
+             p_pic->p[Y_PLANE].i_visible_pitch,
+             p_pic->p[Y_PLANE].i_visible_lines );
 
-    return VLC_SUCCESS;
+    return p_pic;
+}
+
+static uint8_t blendbench_Random( uint32_t *pi_seed )
+{
+    *pi_seed = *pi_seed * 1103515245 + 12345;
+    return *pi_seed >> 16;
+}
+
+/**
+ * Generates a picture with the same content on every run, so that results
+ * can be compared between builds and machines.
+ */
+static picture_t *blendbench_GenerateImage( filter_t *p_filter,
+                                            vlc_fourcc_t i_chroma,
+                                            uint32_t i_seed )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    video_format_t fmt;
+    picture_t *p_pic;
+
+    video_format_Init( &fmt, i_chroma );
+    video_format_Setup( &fmt, i_chroma, p_sys->i_width, p_sys->i_height,
+                        p_sys->i_width, p_sys->i_height, 1, 1 );
+    if( i_chroma == VLC_CODEC_YUVP )
+    {
+        fmt.p_palette = malloc( sizeof( *fmt.p_palette ) );
+        if( fmt.p_palette == NULL )
+            return NULL;
+        fmt.p_palette->i_entries = 256;
+        for( int i = 0; i < 256; i++ )
+            for( int j = 0; j < 4; j++ )
+                fmt.p_palette->palette[i][j] = blendbench_Random( &i_seed );
+    }
+
+    p_pic = picture_NewFromFormat( &fmt );
+    video_format_Clean( &fmt );
+    if( p_pic == NULL )
+        return NULL;
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        const plane_t *p = &p_pic->p[i];
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+                p->p_pixels[y * p->i_pitch + x] = blendbench_Random( &i_seed );
+    }
+    return p_pic;
+}
+
+static picture_t *blendbench_GetImage( filter_t *p_filter,
+                                       vlc_fourcc_t i_chroma,
+                                       const char *psz_file,
+                                       const char *psz_name, uint32_t i_seed )
+{
+    if( psz_file != NULL && *psz_file != '\0' )
+        return blendbench_LoadImage( VLC_OBJECT(p_filter), i_chroma,
+                                     psz_file, psz_name );
+    return blendbench_GenerateImage( p_filter, i_chroma, i_seed );
+}
+
+static vlc_fourcc_t blendbench_ParseChroma( const char *psz )
+{
+    return strlen( psz ) != 4 ? 0 :
+        VLC_FOURCC( psz[0], psz[1], psz[2], psz[3] );
 }
 
 /*****************************************************************************
@@ -151,8 +233,6 @@ static int Create( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys;
-    char *psz_temp, *psz_cmd;
-    int i_ret;
 
     /* Allocate structure */
     p_filter->p_sys = malloc( sizeof( filter_sys_t ) );
@@ -173,38 +253,24 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "loops" );
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
-
-    psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
-    p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
-        VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
-    free( psz_temp );
-    free( psz_cmd );
-    if( i_ret != VLC_SUCCESS )
+    p_sys->i_width = var_CreateGetIntegerCommand( p_filter,
+                                                  CFG_PREFIX "width" );
+    p_sys->i_height = var_CreateGetIntegerCommand( p_filter,
+                                                   CFG_PREFIX "height" );
+
+    p_sys->psz_base_image =
+        var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
+    p_sys->psz_base_chromas =
+        var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
+    p_sys->psz_blend_image =
+        var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
+    p_sys->psz_blend_chromas =
+        var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-chroma" );
+
+    if( p_sys->psz_base_chromas == NULL || p_sys->psz_blend_chromas == NULL )
     {
-        free( p_sys );
-        return i_ret;
-    }
-
-    psz_temp = var_CreateGetStringCommand( p_filter,
-                                           CFG_PREFIX "blend-chroma" );
-    p_sys->i_blend_chroma = !psz_temp || strlen( psz_temp ) != 4
-        ? 0 : VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                                  psz_cmd, "Blend" );
-
-    free( psz_temp );
-    free( psz_cmd );
-
-    if( i_ret != VLC_SUCCESS )
-    {
-        picture_Release( p_sys->p_base_image );
-        free( p_sys );
-
-        return VLC_EGENERIC;
+        Destroy( p_this );
+        return VLC_ENOMEM;
     }
 
     return VLC_SUCCESS;
@@ -218,58 +284,121 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
-    picture_Release( p_sys->p_blend_image );
+    free( p_sys->psz_base_image );
+    free( p_sys->psz_blend_image );
+    free( p_sys->psz_base_chromas );
+    free( p_sys->psz_blend_chromas );
+    free( p_sys );
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
+ * Bench: blends one chroma onto another
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void Bench( filter_t *p_filter, vlc_fourcc_t i_base_chroma,
+                   vlc_fourcc_t i_blend_chroma )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_base_image, *p_blend_image;
     filter_t *p_blend;
 
-    if( p_sys->b_done )
-        return p_pic;
+    p_base_image = blendbench_GetImage( p_filter, i_base_chroma,
+                                        p_sys->psz_base_image, "Base", 1 );
+    if( p_base_image == NULL )
+        return;
+    p_blend_image = blendbench_GetImage( p_filter, i_blend_chroma,
+                                         p_sys->psz_blend_image, "Blend", 2 );
+    if( p_blend_image == NULL )
+        goto error;
 
     p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
     if( !p_blend )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
+        goto error;
+    p_blend->fmt_out.video = p_base_image->format;
+    p_blend->fmt_in.video = p_blend_image->format;
     p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
     if( !p_blend->p_module )
     {
-        picture_Release( p_pic );
+        msg_Warn( p_filter, "%4.4s -> %4.4s: no blending module",
+                  (const char *)&i_blend_chroma, (const char *)&i_base_chroma );
         vlc_object_delete(p_blend);
-        return NULL;
+        goto error;
     }
 
     vlc_tick_t time = vlc_tick_now();
     for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
     {
         p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
+                                 p_base_image, p_blend_image,
                                  0, 0, p_sys->i_alpha );
     }
     time = vlc_tick_now() - time;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              secf_from_vlc_tick(time) );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * CLOCK_FREQ,
-              (float) p_sys->i_loops / time * CLOCK_FREQ *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+    /* The blended area is clipped to the base image */
+    const uint64_t i_pixels =
+        (uint64_t)__MIN( p_base_image->format.i_visible_width,
+                         p_blend_image->format.i_visible_width ) *
+        __MIN( p_base_image->format.i_visible_height,
+               p_blend_image->format.i_visible_height );
+
+    msg_Info( p_filter, "%4.4s -> %4.4s: blended %d images in %f sec",
+              (const char *)&i_blend_chroma, (const char *)&i_base_chroma,
+              p_sys->i_loops, secf_from_vlc_tick(time) );
+    msg_Info( p_filter, "%4.4s -> %4.4s: %.1f images/second, "
+              "%.1f Mpixels/second",
+              (const char *)&i_blend_chroma, (const char *)&i_base_chroma,
+              (double) p_sys->i_loops / time * CLOCK_FREQ,
+              (double) p_sys->i_loops / time * CLOCK_FREQ * i_pixels / 1e6 );
 
     module_unneed( p_blend, p_blend->p_module );
 
     vlc_object_delete(p_blend);
 
+error:
+    if( p_blend_image != NULL )
+        picture_Release( p_blend_image );
+    picture_Release( p_base_image );
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_done )
+        return p_pic;
+
+    /* Every blend chroma onto every base chroma */
+    char *psz_base_list = strdup( p_sys->psz_base_chromas );
+    char *psz_blend_list = strdup( p_sys->psz_blend_chromas );
+    if( psz_base_list == NULL || psz_blend_list == NULL )
+        goto out;
+
+    char *psz_base_save, *psz_blend_save;
+    for( char *psz_base = strtok_r( psz_base_list, ",", &psz_base_save );
+         psz_base != NULL;
+         psz_base = strtok_r( NULL, ",", &psz_base_save ) )
+    {
+        strcpy( psz_blend_list, p_sys->psz_blend_chromas );
+        for( char *psz_blend = strtok_r( psz_blend_list, ",", &psz_blend_save );
+             psz_blend != NULL;
+             psz_blend = strtok_r( NULL, ",", &psz_blend_save ) )
+        {
+            vlc_fourcc_t i_base_chroma = blendbench_ParseChroma( psz_base );
+            vlc_fourcc_t i_blend_chroma = blendbench_ParseChroma( psz_blend );
+
+            if( i_base_chroma == 0 || i_blend_chroma == 0 )
+                msg_Err( p_filter, "invalid chroma %s -> %s",
+                         psz_blend, psz_base );
+            else
+                Bench( p_filter, i_base_chroma, i_blend_chroma );
+        }
+    }
+
+out:
+    free( psz_base_list );
+    free( psz_blend_list );
     p_sys->b_done = true;
     return p_pic;
 }
@@ -1363,6 +1363,21 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
         if( p_block->i_buffer <= 0 )
             goto error;
 
+        /* Demuxers may send views of a shared payload, while packetizers
+         * and decoders are free to modify their input in place */
+        if( block_IsShared( p_block ) )
+        {
+            p_block = block_MakeWritable( p_block );
+            if( p_block == NULL )
+                return;
+        }
+
+        /* The thumbnail was output already: skip decoding until the next
+         * seek flushes the decoder */
+        if( !p_owner->b_first && p_dec->fmt_in.i_cat == VIDEO_ES &&
+            p_owner->p_input && input_priv( p_owner->p_input )->b_thumbnailing )
+            goto error;
+
         vlc_mutex_lock( &p_owner->lock );
         DecoderUpdatePreroll( &p_owner->i_preroll_end, p_block );
         vlc_mutex_unlock( &p_owner->lock );
@@ -1476,6 +1491,9 @@ static void DecoderProcessFlush( decoder_t *p_dec )
     {
         if( p_owner->p_vout )
             vout_FlushAll( p_owner->p_vout );
+        /* Output a new thumbnail after each seek */
+        if( p_owner->p_input && input_priv( p_owner->p_input )->b_thumbnailing )
+            p_owner->b_first = true;
     }
     else if( p_dec->fmt_out.i_cat == SPU_ES )
     {
@@ -138,6 +138,112 @@ static const char* DemuxNameFromExtension( char const* ext,
     return result ? result->name : NULL;
 }
 
+typedef const struct
+{
+    char const name[8];
+    unsigned short offset;
+    unsigned char size;
+    char const magic[12];
+    char const mask[12]; /* compare all bytes if empty */
+    unsigned short period; /* repeat interval of the magic, if any */
+    unsigned char count;
+
+} demux_signature;
+
+/* NOTE: Add only unambiguous signatures here:
+ *  - no ID3 prefixed ES nor playlists (adaptive streaming would be skipped)
+ *  - no RIFF WAVE, for the same reason as the extensions below
+ */
+static demux_signature signatures[] =
+{
+#define RIFF_MASK "\xff\xff\xff\xff\0\0\0\0\xff\xff\xff\xff"
+    { "mp4",  4, 4, "ftyp", "", 0, 1 },
+    { "mp4",  4, 4, "moov", "", 0, 1 },
+    { "mp4",  4, 4, "moof", "", 0, 1 },
+    { "mp4",  4, 4, "mdat", "", 0, 1 },
+    { "mp4",  4, 4, "free", "", 0, 1 },
+    { "mp4",  4, 4, "skip", "", 0, 1 },
+    { "mp4",  4, 4, "wide", "", 0, 1 },
+    { "mp4",  4, 4, "pnot", "", 0, 1 },
+    { "avi",  0, 12, "RIFF\0\0\0\0AVI ", RIFF_MASK, 0, 1 },
+    { "asf",  0, 8, "\x30\x26\xb2\x75\x8e\x66\xcf\x11", "", 0, 1 },
+    { "mkv",  0, 4, "\x1a\x45\xdf\xa3", "", 0, 1 },
+    { "ogg",  0, 4, "OggS", "", 0, 1 },
+    { "flac", 0, 4, "fLaC", "", 0, 1 },
+    { "au",   0, 4, ".snd", "", 0, 1 },
+    { "aiff", 0, 12, "FORM\0\0\0\0AIFF", RIFF_MASK, 0, 1 },
+    { "caf",  0, 4, "caff", "", 0, 1 },
+    { "voc",  0, 12, "Creative Voi", "", 0, 1 },
+    { "smf",  0, 4, "MThd", "", 0, 1 },
+    { "smf",  0, 12, "RIFF\0\0\0\0RMID", RIFF_MASK, 0, 1 },
+    { "nsv",  0, 4, "NSVf", "", 0, 1 },
+    { "nsv",  0, 4, "NSVs", "", 0, 1 },
+    { "ps",   0, 4, "\x00\x00\x01\xba", "", 0, 1 },
+    { "ts",   0, 1, "\x47", "", 188, 3 },
+    { "ts",   4, 1, "\x47", "", 192, 3 },
+#undef RIFF_MASK
+};
+
+static size_t demux_signature_end( demux_signature *sig )
+{
+    return sig->offset + (sig->count - 1) * sig->period + sig->size;
+}
+
+static bool demux_signature_match( demux_signature *sig,
+                                   const uint8_t *peek, size_t size )
+{
+    if( size < demux_signature_end( sig ) )
+        return false;
+
+    peek += sig->offset;
+    for( unsigned i = 0; i < sig->count; i++, peek += sig->period )
+        for( unsigned j = 0; j < sig->size; j++ )
+        {
+            uint8_t mask = sig->mask[0] ? (uint8_t)sig->mask[j] : 0xff;
+            if( (peek[j] ^ (uint8_t)sig->magic[j]) & mask )
+                return false;
+        }
+    return true;
+}
+
+/**
+ * Lists the demuxers whose signature matches the start of the stream.
+ *
+ * The stream is peeked only once, for all signatures, so that the matching
+ * modules can be probed before the others.
+ *
+ * \param buf buffer for the comma-separated module names
+ * \return the number of matching modules
+ */
+static unsigned DemuxNamesFromSignature( stream_t *s, char *buf )
+{
+    size_t need = 0;
+    for( size_t i = 0; i < ARRAY_SIZE( signatures ); i++ )
+        need = __MAX( need, demux_signature_end( &signatures[i] ) );
+
+    const uint8_t *peek;
+    ssize_t size = vlc_stream_Peek( s, &peek, need );
+    const char *last = NULL;
+    unsigned count = 0;
+
+    *buf = '\0';
+    for( size_t i = 0; size > 0 && i < ARRAY_SIZE( signatures ); i++ )
+    {
+        demux_signature *sig = &signatures[i];
+
+        /* Signatures of the same module are adjacent */
+        if( ( last != NULL && !strcmp( last, sig->name ) )
+         || !demux_signature_match( sig, peek, size ) )
+            continue;
+
+        if( count++ > 0 )
+            strcat( buf, "," );
+        strcat( buf, sig->name );
+        last = sig->name;
+    }
+    return count;
+}
+
 demux_t *demux_New( vlc_object_t *p_obj, const char *psz_name,
                     stream_t *s, es_out_t *out )
 {
@@ -242,6 +348,22 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_input,
             psz_module = DemuxNameFromExtension( psz_ext + 1, b_preparsing );
     }
 
+    /* Probe the modules matching the stream signature first, then the one
+     * matching the extension, then all others. */
+    char names[ARRAY_SIZE( signatures ) * (sizeof( signatures[0].name ) + 1)
+               + 1];
+
+    if( !strcmp( p_demux->psz_name, "any" )
+     && DemuxNamesFromSignature( s, names ) > 0 )
+    {
+        if( psz_module != NULL )
+        {
+            strcat( names, "," );
+            strcat( names, psz_module );
+        }
+        psz_module = names;
+    }
+
     if( psz_module == NULL )
         psz_module = p_demux->psz_name;
 
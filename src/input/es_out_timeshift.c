@@ -36,6 +36,9 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -83,7 +86,7 @@ typedef struct attribute_packed
 {
     es_out_id_t *p_es;
     block_t *p_block;
-    int     i_offset;  /* We do not use file > INT_MAX */
+    int     i_offset;  /* We do not use file > INT_MAX, -1 if kept in memory */
 } ts_cmd_send_t;
 
 typedef struct attribute_packed
@@ -165,7 +168,8 @@ struct ts_storage_t
 {
     ts_storage_t *p_next;
 
-    /* */
+    /* The file is only created once the memory budget is exceeded */
+    const char *psz_tmp_path;
 #ifdef _WIN32
     char    *psz_file;  /* Filename */
 #endif
@@ -173,6 +177,7 @@ struct ts_storage_t
     int64_t i_file_size;/* Current size in bytes */
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
+    uint8_t *p_map;     /* Read-only mapping, once the file is complete */
 
     /* */
     int      i_cmd_r;
@@ -188,11 +193,19 @@ typedef struct
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
     const char     *psz_tmp_path;
+    size_t         i_ram_max;
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
     vlc_cond_t     wait;
 
+    /* Bytes of data blocks held in memory */
+    size_t         i_ram_size;
+    /* Temporary files could not be created, data is kept in memory */
+    bool           b_tmp_failed;
+    /* Data was dropped to stay within the memory budget */
+    bool           b_ram_dropped;
+
     /* */
     bool           b_paused;
     vlc_tick_t     i_pause_date;
@@ -227,6 +240,7 @@ typedef struct
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
+    size_t         i_ram_max;         /* Maximal memory usage in byte */
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -255,6 +269,7 @@ static void         TsAutoStop( es_out_t * );
 
 static void         TsStop( ts_thread_t * );
 static void         TsPushCmd( ts_thread_t *, ts_cmd_t * );
+static bool         TsDropRamLocked( ts_thread_t *, size_t i_size );
 static int          TsPopCmdLocked( ts_thread_t *, ts_cmd_t *, bool b_flush );
 static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
@@ -265,10 +280,11 @@ static void         *TsRun( void * );
 
 static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
 static void         TsStorageDelete( ts_storage_t * );
+static int          TsStorageOpenFile( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
-static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
+static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_ram );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
+static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush, bool b_ram );
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
 
 static void CmdClean( ts_cmd_t * );
@@ -330,6 +346,11 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    const int64_t i_ram_max = var_InheritInteger( p_input, "input-timeshift-memory" );
+    p_sys->i_ram_max = i_ram_max > 0 ? __MIN( (uint64_t)i_ram_max, SIZE_MAX ) : 0;
+    msg_Dbg( p_input, "using up to %zu MiB of memory for timeshift",
+             p_sys->i_ram_max/(1024*1024) );
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
     if( p_sys->psz_tmp_path == NULL )
@@ -798,6 +819,10 @@ static int TsStart( es_out_t *p_out )
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
+    p_ts->i_ram_max = p_sys->i_ram_max;
+    p_ts->i_ram_size = 0;
+    p_ts->b_tmp_failed = false;
+    p_ts->b_ram_dropped = false;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
     vlc_mutex_init( &p_ts->lock );
@@ -864,7 +889,16 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
-    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+    /* Keep data in memory as long as it fits in the budget */
+    bool b_ram = false;
+    if( p_cmd->i_type == C_SEND )
+    {
+        const size_t i_size = p_cmd->u.send.p_block->i_buffer;
+
+        b_ram = i_size <= p_ts->i_ram_max - __MIN( p_ts->i_ram_size, p_ts->i_ram_max );
+    }
+
+    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd, b_ram ) )
     {
         ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
 
@@ -888,13 +922,71 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
         }
     }
 
+    /* The temporary file is only created once data spills out of memory,
+     * keep the data there if that is not possible */
+    if( !b_ram && p_cmd->i_type == C_SEND && p_ts->p_storage_w->p_filew == NULL &&
+        ( p_ts->b_tmp_failed || TsStorageOpenFile( p_ts->p_storage_w ) ) )
+    {
+        if( !p_ts->b_tmp_failed )
+            msg_Err( p_ts->p_input, "cannot create timeshift temporary file, "
+                     "keeping data in memory" );
+        p_ts->b_tmp_failed = true;
+
+        /* Stay within the memory budget: the oldest data goes first */
+        const size_t i_size = p_cmd->u.send.p_block->i_buffer;
+        if( !TsDropRamLocked( p_ts, i_size ) )
+        {
+            CmdClean( p_cmd );
+            vlc_mutex_unlock( &p_ts->lock );
+            return;
+        }
+        b_ram = true;
+    }
+
+    if( b_ram )
+        p_ts->i_ram_size += p_cmd->u.send.p_block->i_buffer;
+
     /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w, b_ram );
 
     vlc_cond_signal( &p_ts->wait );
 
     vlc_mutex_unlock( &p_ts->lock );
 }
+static bool TsDropRamLocked( ts_thread_t *p_ts, size_t i_size )
+{
+    vlc_mutex_assert( &p_ts->lock );
+
+    if( i_size > p_ts->i_ram_max )
+        return false;
+
+    for( ts_storage_t *p_storage = p_ts->p_storage_r;
+         p_storage != NULL && p_ts->i_ram_size > p_ts->i_ram_max - i_size;
+         p_storage = p_storage->p_next )
+    {
+        for( int i = p_storage->i_cmd_r;
+             i < p_storage->i_cmd_w && p_ts->i_ram_size > p_ts->i_ram_max - i_size;
+             i++ )
+        {
+            ts_cmd_t *p_cmd = &p_storage->p_cmd[i];
+
+            if( p_cmd->i_type != C_SEND || p_cmd->u.send.i_offset >= 0 ||
+                p_cmd->u.send.p_block == NULL )
+                continue;
+
+            if( !p_ts->b_ram_dropped )
+                msg_Warn( p_ts->p_input, "timeshift memory full, "
+                          "dropping the oldest data" );
+            p_ts->b_ram_dropped = true;
+
+            /* Keep the command itself, it is skipped when executed */
+            p_ts->i_ram_size -= p_cmd->u.send.p_block->i_buffer;
+            block_Release( p_cmd->u.send.p_block );
+            p_cmd->u.send.p_block = NULL;
+        }
+    }
+    return p_ts->i_ram_size <= p_ts->i_ram_max - i_size;
+}
 static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 {
     vlc_mutex_assert( &p_ts->lock );
@@ -904,6 +996,13 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 
     TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
 
+    if( p_cmd->i_type == C_SEND && p_cmd->u.send.i_offset < 0 &&
+        p_cmd->u.send.p_block != NULL )
+    {
+        assert( p_ts->i_ram_size >= p_cmd->u.send.p_block->i_buffer );
+        p_ts->i_ram_size -= p_cmd->u.send.p_block->i_buffer;
+    }
+
     while( TsStorageIsEmpty( p_ts->p_storage_r ) )
     {
         ts_storage_t *p_next = p_ts->p_storage_r->p_next;
@@ -1116,13 +1215,37 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     if( unlikely(p_storage == NULL) )
         return NULL;
 
-    char *psz_file;
-    int fd = GetTmpFile( &psz_file, psz_tmp_path );
-    if( fd == -1 )
+    p_storage->p_next = NULL;
+
+    /* */
+    p_storage->psz_tmp_path = psz_tmp_path;
+    p_storage->i_file_max = i_tmp_size_max;
+    p_storage->i_file_size = 0;
+    p_storage->p_filew = NULL;
+    p_storage->p_filer = NULL;
+    p_storage->p_map = NULL;
+
+    /* */
+    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_r = 0;
+    p_storage->i_cmd_max = 30000;
+    p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
+    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
+
+    if( !p_storage->p_cmd )
     {
         free( p_storage );
         return NULL;
     }
+    return p_storage;
+}
+
+static int TsStorageOpenFile( ts_storage_t *p_storage )
+{
+    char *psz_file;
+    int fd = GetTmpFile( &psz_file, p_storage->psz_tmp_path );
+    if( fd == -1 )
+        return VLC_EGENERIC;
 
     p_storage->p_filew = fdopen( fd, "w+b" );
     if( p_storage->p_filew == NULL )
@@ -1136,6 +1259,7 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     if( p_storage->p_filer == NULL )
     {
         fclose( p_storage->p_filew );
+        p_storage->p_filew = NULL;
         vlc_unlink( psz_file );
         goto error;
     }
@@ -1146,29 +1270,10 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
 #else
     p_storage->psz_file = psz_file;
 #endif
-    p_storage->p_next = NULL;
-
-    /* */
-    p_storage->i_file_max = i_tmp_size_max;
-    p_storage->i_file_size = 0;
-
-    /* */
-    p_storage->i_cmd_w = 0;
-    p_storage->i_cmd_r = 0;
-    p_storage->i_cmd_max = 30000;
-    p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
-
-    if( !p_storage->p_cmd )
-    {
-        TsStorageDelete( p_storage );
-        return NULL;
-    }
-    return p_storage;
+    return VLC_SUCCESS;
 error:
     free( psz_file );
-    free( p_storage );
-    return NULL;
+    return VLC_EGENERIC;
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
@@ -1183,17 +1288,37 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
+#ifdef HAVE_MMAP
+    if( p_storage->p_map != NULL )
+        munmap( p_storage->p_map, p_storage->i_file_size );
+#endif
+    if( p_storage->p_filew != NULL )
+    {
+        fclose( p_storage->p_filer );
+        fclose( p_storage->p_filew );
 #ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
-    free( p_storage->psz_file );
+        vlc_unlink( p_storage->psz_file );
+        free( p_storage->psz_file );
 #endif
+    }
     free( p_storage );
 }
 
 static void TsStoragePack( ts_storage_t *p_storage )
 {
+    /* Nothing will be written anymore: map the file so that replaying does
+     * not need to seek and read through the stdio buffers */
+#ifdef HAVE_MMAP
+    if( p_storage->p_filew != NULL && p_storage->i_file_size > 0 &&
+        fflush( p_storage->p_filew ) == 0 )
+    {
+        void *p_map = mmap( NULL, p_storage->i_file_size, PROT_READ,
+                            MAP_SHARED, fileno( p_storage->p_filer ), 0 );
+        if( p_map != MAP_FAILED )
+            p_storage->p_map = p_map;
+    }
+#endif
+
     /* Try to release a bit of memory */
     if( p_storage->i_cmd_w >= p_storage->i_cmd_max )
         return;
@@ -1204,9 +1329,9 @@ static void TsStoragePack( ts_storage_t *p_storage )
     if( p_new )
         p_storage->p_cmd = p_new;
 }
-static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
+static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_ram )
 {
-    if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
+    if( p_cmd && p_cmd->i_type == C_SEND && !b_ram && p_storage->i_cmd_w > 0 )
     {
         size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
 
@@ -1219,16 +1344,21 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
     return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush, bool b_ram )
 {
     ts_cmd_t cmd = *p_cmd;
 
-    assert( !TsStorageIsFull( p_storage, p_cmd ) );
+    assert( !TsStorageIsFull( p_storage, p_cmd, b_ram ) );
 
-    if( cmd.i_type == C_SEND )
+    if( cmd.i_type == C_SEND && b_ram )
+    {
+        cmd.u.send.i_offset = -1;
+    }
+    else if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
 
+        assert( p_storage->p_filew != NULL );
         cmd.u.send.p_block = NULL;
         cmd.u.send.i_offset = ftell( p_storage->p_filew );
 
@@ -1254,36 +1384,60 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
     }
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
 }
+static block_t *TsStorageReadBlock( ts_storage_t *p_storage, int i_offset )
+{
+    block_t block;
+    block_t *p_block;
+
+    if( p_storage->p_map != NULL )
+    {
+        /* The index gives the record position: no sequential read needed */
+        assert( i_offset + sizeof(block) <= (uint64_t)p_storage->i_file_size );
+        memcpy( &block, &p_storage->p_map[i_offset], sizeof(block) );
+
+        p_block = block_Alloc( block.i_buffer );
+        if( p_block )
+            memcpy( p_block->p_buffer, &p_storage->p_map[i_offset + sizeof(block)],
+                    block.i_buffer );
+    }
+    else
+    {
+        if( fseek( p_storage->p_filer, i_offset, SEEK_SET ) ||
+            fread( &block, sizeof(block), 1, p_storage->p_filer ) != 1 )
+            return NULL;
+
+        p_block = block_Alloc( block.i_buffer );
+        if( p_block )
+            p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+    }
+
+    if( p_block )
+    {
+        p_block->i_dts      = block.i_dts;
+        p_block->i_pts      = block.i_pts;
+        p_block->i_flags    = block.i_flags;
+        p_block->i_length   = block.i_length;
+        p_block->i_nb_samples = block.i_nb_samples;
+    }
+    return p_block;
+}
 static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
-    if( p_cmd->i_type == C_SEND )
+    if( p_cmd->i_type == C_SEND && p_cmd->u.send.i_offset >= 0 )
     {
-        block_t block;
+        block_t *p_block = NULL;
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
-        {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
-            {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
-            }
-            p_cmd->u.send.p_block = p_block;
-        }
-        else
+        if( !b_flush )
+            p_block = TsStorageReadBlock( p_storage, p_cmd->u.send.i_offset );
+        if( p_block == NULL )
         {
             //perror( "TsStoragePopCmd" );
-            p_cmd->u.send.p_block = block_Alloc( 1 );
+            p_block = block_Alloc( 1 );
         }
+        p_cmd->u.send.p_block = p_block;
     }
 }
 
@@ -40,11 +40,17 @@ typedef struct vlc_thumbnailer_params_t
     {
         vlc_tick_t time;
         float pos;
+        struct
+        {
+            vlc_tick_t *times;
+            size_t count;
+        } batch;
     };
     enum
     {
         VLC_THUMBNAILER_SEEK_TIME,
         VLC_THUMBNAILER_SEEK_POS,
+        VLC_THUMBNAILER_SEEK_BATCH,
     } type;
     bool fast_seek;
     input_item_t* input_item;
@@ -54,6 +60,7 @@ typedef struct vlc_thumbnailer_params_t
      */
     vlc_tick_t timeout;
     vlc_thumbnailer_cb cb;
+    vlc_thumbnailer_batch_cb batch_cb;
     void* user_data;
 } vlc_thumbnailer_params_t;
 
@@ -66,8 +73,64 @@ struct vlc_thumbnailer_request_t
 
     vlc_mutex_t lock;
     bool done;
+    /* Index of the next batch thumbnail */
+    size_t batch_index;
 };
 
+/* Must be called with the request lock held */
+static void thumbnailer_batch_Abort( vlc_thumbnailer_request_t *request )
+{
+    if ( request->params.batch_cb != NULL )
+    {
+        for ( size_t i = request->batch_index;
+              i < request->params.batch.count; ++i )
+            request->params.batch_cb( request->params.user_data, i, NULL );
+        request->params.batch_cb = NULL;
+    }
+    request->batch_index = request->params.batch.count;
+    request->done = true;
+}
+
+static void
+on_thumbnailer_batch_event( vlc_thumbnailer_request_t *request,
+                            const struct vlc_input_event *event )
+{
+    const vlc_thumbnailer_params_t *params = &request->params;
+
+    vlc_mutex_lock( &request->lock );
+    if ( request->done )
+    {
+        vlc_mutex_unlock( &request->lock );
+        return;
+    }
+    if ( event->type == INPUT_EVENT_THUMBNAIL_READY )
+    {
+        size_t index = request->batch_index++;
+        /*
+         * Seek before invoking the callback, so that the input reaches the
+         * next thumbnail while this one is being processed.
+         */
+        if ( request->batch_index < params->batch.count )
+            input_SetTime( request->input_thread,
+                           params->batch.times[request->batch_index],
+                           params->fast_seek );
+        else
+        {
+            input_Stop( request->input_thread );
+            request->done = true;
+        }
+        if ( params->batch_cb )
+            params->batch_cb( params->user_data, index, event->thumbnail );
+    }
+    else
+        thumbnailer_batch_Abort( request );
+
+    bool done = request->done;
+    vlc_mutex_unlock( &request->lock );
+    if ( done )
+        background_worker_RequestProbe( request->thumbnailer->worker );
+}
+
 static void
 on_thumbnailer_input_event( input_thread_t *input,
                             const struct vlc_input_event *event, void *userdata )
@@ -81,6 +144,12 @@ on_thumbnailer_input_event( input_thread_t *input,
     vlc_thumbnailer_request_t* request = userdata;
     picture_t *pic = NULL;
 
+    if ( request->params.type == VLC_THUMBNAILER_SEEK_BATCH )
+    {
+        on_thumbnailer_batch_event( request, event );
+        return;
+    }
+
     if ( event->type == INPUT_EVENT_THUMBNAIL_READY )
     {
         /*
@@ -117,6 +186,8 @@ static void thumbnailer_request_Release( void* data )
         input_Close( request->input_thread );
 
     input_item_Release( request->params.input_item );
+    if ( request->params.type == VLC_THUMBNAILER_SEEK_BATCH )
+        free( request->params.batch.times );
     vlc_mutex_destroy( &request->lock );
     free( request );
 }
@@ -130,15 +201,23 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
                                      on_thumbnailer_input_event, request,
                                      request->params.input_item );
     if ( unlikely( input == NULL ) )
+        goto error;
+    if ( request->params.fast_seek )
     {
-        request->params.cb( request->params.user_data, NULL );
-        return VLC_EGENERIC;
+        /* Fast seeks land on key frames: let the decoder skip the others */
+        var_Create( input, "avcodec-skip-frame", VLC_VAR_INTEGER );
+        var_SetInteger( input, "avcodec-skip-frame", 3 /* non-key */ );
     }
     if ( request->params.type == VLC_THUMBNAILER_SEEK_TIME )
     {
         input_SetTime( input, request->params.time,
                        request->params.fast_seek );
     }
+    else if ( request->params.type == VLC_THUMBNAILER_SEEK_BATCH )
+    {
+        input_SetTime( input, request->params.batch.times[0],
+                       request->params.fast_seek );
+    }
     else
     {
         assert( request->params.type == VLC_THUMBNAILER_SEEK_POS );
@@ -146,12 +225,20 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
                        request->params.fast_seek );
     }
     if ( input_Start( input ) != VLC_SUCCESS )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        return VLC_EGENERIC;
-    }
+        goto error;
     *out = request;
     return VLC_SUCCESS;
+
+error:
+    if ( request->params.type == VLC_THUMBNAILER_SEEK_BATCH )
+    {
+        vlc_mutex_lock( &request->lock );
+        thumbnailer_batch_Abort( request );
+        vlc_mutex_unlock( &request->lock );
+    }
+    else
+        request->params.cb( request->params.user_data, NULL );
+    return VLC_EGENERIC;
 }
 
 static void thumbnailer_request_Stop( void* owner, void* handle )
@@ -164,7 +251,9 @@ static void thumbnailer_request_Stop( void* owner, void* handle )
      * If the callback hasn't been invoked yet, we assume a timeout and
      * signal it back to the user
      */
-    if ( request->params.cb != NULL )
+    if ( request->params.type == VLC_THUMBNAILER_SEEK_BATCH )
+        thumbnailer_batch_Abort( request );
+    else if ( request->params.cb != NULL )
     {
         request->params.cb( request->params.user_data, NULL );
         request->params.cb = NULL;
@@ -190,11 +279,16 @@ thumbnailer_RequestCommon( vlc_thumbnailer_t* thumbnailer,
 {
     vlc_thumbnailer_request_t *request = malloc( sizeof( *request ) );
     if ( unlikely( request == NULL ) )
+    {
+        if ( params->type == VLC_THUMBNAILER_SEEK_BATCH )
+            free( params->batch.times );
         return NULL;
+    }
     request->thumbnailer = thumbnailer;
     request->input_thread = NULL;
     request->params = *(vlc_thumbnailer_params_t*)params;
     request->done = false;
+    request->batch_index = 0;
     input_item_Hold( request->params.input_item );
     vlc_mutex_init( &request->lock );
 
@@ -246,12 +340,39 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
         });
 }
 
+vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data )
+{
+    assert( count > 0 );
+    vlc_tick_t *copy = vlc_alloc( count, sizeof( *copy ) );
+    if ( unlikely( copy == NULL ) )
+        return NULL;
+    memcpy( copy, times, count * sizeof( *copy ) );
+
+    /* Released with the request, or on failure */
+    return thumbnailer_RequestCommon( thumbnailer,
+            &(const vlc_thumbnailer_params_t){
+                .batch = { .times = copy, .count = count },
+                .type = VLC_THUMBNAILER_SEEK_BATCH,
+                .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
+                .input_item = input_item,
+                .timeout = timeout,
+                .batch_cb = cb,
+                .user_data = user_data,
+        });
+}
+
 void vlc_thumbnailer_Cancel( vlc_thumbnailer_t* thumbnailer,
                              vlc_thumbnailer_request_t* req )
 {
     vlc_mutex_lock( &req->lock );
     /* Ensure we won't invoke the callback if the input was running. */
     req->params.cb = NULL;
+    req->params.batch_cb = NULL;
     vlc_mutex_unlock( &req->lock );
     background_worker_Cancel( thumbnailer->worker, req );
 }
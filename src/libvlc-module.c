@@ -88,6 +88,13 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Messages are formatted and written out by a background thread, " \
+    "rather than by the threads emitting them. This reduces the cost of " \
+    "debug logging, but messages are lost if they are emitted faster " \
+    "than they can be written out.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -714,6 +721,12 @@ static const char *const ppsz_prefres[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_MEMORY_TEXT N_("Timeshift memory")
+#define INPUT_TIMESHIFT_MEMORY_LONGTEXT N_( \
+    "This is the maximum size in bytes of the timeshifted streams " \
+    "that will be kept in memory. Temporary files are only used " \
+    "beyond this size." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -871,6 +884,12 @@ static const char *const ppsz_prefres[] = {
     "However allocation of port numbers below 1025 is usually restricted " \
     "by the operating system." )
 
+#define HTTP_THREADS_TEXT N_( "HTTP server threads" )
+#define HTTP_THREADS_LONGTEXT N_( \
+    "Number of threads serving the clients of each HTTP, HTTPS or RTSP " \
+    "server. Connections are spread between the threads as they are " \
+    "accepted." )
+
 #define HTTP_CERT_TEXT N_("HTTP/TLS server certificate")
 #define CERT_LONGTEXT N_( \
    "This X.509 certicate file (PEM format) is used for server-side TLS. " \
@@ -1076,6 +1095,13 @@ static const char *const ppsz_prefres[] = {
     "priorities. You can use it to tune VLC priority against other " \
     "programs, or against other VLC instances.")
 
+#define BLOCK_POOL_TEXT N_("Recycle data blocks")
+#define BLOCK_POOL_LONGTEXT N_( \
+    "Keep released data blocks in per-thread and global pools, sorted by " \
+    "size, instead of returning them to the system allocator. This reduces " \
+    "allocator contention when running many inputs in a single process, " \
+    "at the cost of some memory." )
+
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
      "reading a stream")
@@ -1856,6 +1882,9 @@ vlc_module_begin ()
     add_string( "rtsp-host", NULL, RTSP_HOST_TEXT, RTSP_HOST_LONGTEXT, true )
     add_integer( "rtsp-port", 554, RTSP_PORT_TEXT, RTSP_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
+    add_integer( "http-threads", 1, HTTP_THREADS_TEXT, HTTP_THREADS_LONGTEXT,
+                 true )
+        change_integer_range( 1, 64 )
     add_loadfile("http-cert", NULL, HTTP_CERT_TEXT, CERT_LONGTEXT)
     add_obsolete_string( "sout-http-cert" ) /* since 2.0.0 */
     add_loadfile("http-key", NULL, HTTP_KEY_TEXT, KEY_LONGTEXT)
@@ -1982,6 +2011,10 @@ vlc_module_begin ()
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-memory", 100*1024*1024,
+                 INPUT_TIMESHIFT_MEMORY_TEXT,
+                 INPUT_TIMESHIFT_MEMORY_LONGTEXT, true )
+        change_integer_range( 0, INT64_MAX )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -2105,6 +2138,9 @@ vlc_module_begin ()
                  RT_OFFSET_LONGTEXT, true )
 #endif
 
+    add_bool( "block-pool", false, BLOCK_POOL_TEXT,
+              BLOCK_POOL_LONGTEXT, true )
+
 #if defined(HAVE_DBUS)
     add_obsolete_bool( "inhibit" ) /* since 3.0.0 */
 #endif
@@ -2202,6 +2238,7 @@ vlc_module_begin ()
                  false )
         change_short('v')
         change_volatile ()
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT, true )
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
 #if !defined(_WIN32) && !defined(__OS2__)
     add_bool( "daemon", 0, DAEMON_TEXT, DAEMON_LONGTEXT, true )
@@ -166,6 +166,7 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
         goto error;
 
     vlc_LogInit(p_libvlc);
+    vlc_block_pool_setup(p_libvlc);
 
     /*
      * Support for gettext
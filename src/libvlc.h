@@ -80,6 +80,11 @@ typedef struct vlc_logger vlc_logger_t;
 int vlc_LogPreinit(libvlc_int_t *) VLC_USED;
 void vlc_LogInit(libvlc_int_t *);
 
+/*
+ * Data blocks
+ */
+void vlc_block_pool_setup(libvlc_int_t *);
+
 /*
  * LibVLC exit event handling
  */
@@ -31,6 +31,7 @@
 #include <vlc_input_item.h>
 #include <vlc_threads.h>
 #include "libvlc.h"
+#include "../misc/hashmap.h"
 
 struct vlc_media_tree_listener_id
 {
@@ -46,6 +47,8 @@ typedef struct
     struct vlc_list listeners; /**< list of vlc_media_tree_listener_id.node */
     vlc_mutex_t lock;
     vlc_atomic_rc_t rc;
+    struct vlc_hashmap nodes; /**< media -> nodes, in insertion order */
+    struct vlc_hashmap parents; /**< node -> parent node */
 } media_tree_private_t;
 
 #define mt_priv(mt) container_of(mt, media_tree_private_t, public_data)
@@ -60,6 +63,8 @@ vlc_media_tree_New(void)
     vlc_mutex_init(&priv->lock);
     vlc_atomic_rc_init(&priv->rc);
     vlc_list_init(&priv->listeners);
+    vlc_hashmap_Init(&priv->nodes);
+    vlc_hashmap_Init(&priv->parents);
 
     vlc_media_tree_t *tree = &priv->public_data;
     input_item_node_t *root = &tree->root;
@@ -94,51 +99,83 @@ do { \
 } while (0)
 
 static bool
-vlc_media_tree_FindNodeByMedia(input_item_node_t *parent,
+vlc_media_tree_FindNodeByMedia(vlc_media_tree_t *tree,
                                const input_item_t *media,
                                input_item_node_t **result,
                                input_item_node_t **result_parent)
 {
-    for (int i = 0; i < parent->i_children; ++i)
+    media_tree_private_t *priv = mt_priv(tree);
+    input_item_node_t *node =
+        vlc_hashmap_Get(&priv->nodes, vlc_hashmap_PtrKey(media));
+    if (!node)
+        return false;
+
+    *result = node;
+    if (result_parent)
+        *result_parent = vlc_hashmap_Get(&priv->parents,
+                                         vlc_hashmap_PtrKey(node));
+    return true;
+}
+
+static int
+vlc_media_tree_IndexNode(vlc_media_tree_t *tree, input_item_node_t *parent,
+                         input_item_node_t *node)
+{
+    media_tree_private_t *priv = mt_priv(tree);
+
+    if (vlc_hashmap_Add(&priv->nodes, vlc_hashmap_PtrKey(node->p_item), node))
+        return VLC_ENOMEM;
+    if (vlc_hashmap_Add(&priv->parents, vlc_hashmap_PtrKey(node), parent))
     {
-        input_item_node_t *child = parent->pp_children[i];
-        if (child->p_item == media)
-        {
-            *result = child;
-            if (result_parent)
-                *result_parent = parent;
-            return true;
-        }
-
-        if (vlc_media_tree_FindNodeByMedia(child, media, result, result_parent))
-            return true;
+        vlc_hashmap_Remove(&priv->nodes, vlc_hashmap_PtrKey(node->p_item),
+                           node);
+        return VLC_ENOMEM;
     }
+    return VLC_SUCCESS;
+}
+
+/* remove a node and all its descendants from the indexes */
+static void
+vlc_media_tree_UnindexNode(vlc_media_tree_t *tree, input_item_node_t *parent,
+                           input_item_node_t *node)
+{
+    media_tree_private_t *priv = mt_priv(tree);
 
-    return false;
+    for (int i = 0; i < node->i_children; ++i)
+        vlc_media_tree_UnindexNode(tree, node, node->pp_children[i]);
+
+    vlc_hashmap_Remove(&priv->nodes, vlc_hashmap_PtrKey(node->p_item), node);
+    vlc_hashmap_Remove(&priv->parents, vlc_hashmap_PtrKey(node), parent);
 }
 
 static input_item_node_t *
-vlc_media_tree_AddChild(input_item_node_t *parent, input_item_t *media);
+vlc_media_tree_AddChild(vlc_media_tree_t *tree, input_item_node_t *parent,
+                        input_item_t *media);
 
 static void
-vlc_media_tree_AddSubtree(input_item_node_t *to, input_item_node_t *from)
+vlc_media_tree_AddSubtree(vlc_media_tree_t *tree, input_item_node_t *to,
+                          input_item_node_t *from)
 {
     for (int i = 0; i < from->i_children; ++i)
     {
         input_item_node_t *child = from->pp_children[i];
-        input_item_node_t *node = vlc_media_tree_AddChild(to, child->p_item);
+        input_item_node_t *node = vlc_media_tree_AddChild(tree, to,
+                                                          child->p_item);
         if (unlikely(!node))
             break; /* what could we do? */
 
-        vlc_media_tree_AddSubtree(node, child);
+        vlc_media_tree_AddSubtree(tree, node, child);
     }
 }
 
 static void
-vlc_media_tree_ClearChildren(input_item_node_t *root)
+vlc_media_tree_ClearChildren(vlc_media_tree_t *tree, input_item_node_t *root)
 {
     for (int i = 0; i < root->i_children; ++i)
+    {
+        vlc_media_tree_UnindexNode(tree, root, root->pp_children[i]);
         input_item_node_Delete(root->pp_children[i]);
+    }
 
     free(root->pp_children);
     root->pp_children = NULL;
@@ -153,17 +190,16 @@ media_subtree_changed(input_item_t *media, input_item_node_t *node,
 
     vlc_media_tree_Lock(tree);
     input_item_node_t *subtree_root;
-    /* TODO retrieve the node without traversing the tree */
-    bool found = vlc_media_tree_FindNodeByMedia(&tree->root, media,
-                                                &subtree_root, NULL);
+    bool found = vlc_media_tree_FindNodeByMedia(tree, media, &subtree_root,
+                                                NULL);
     if (!found) {
         /* the node probably failed to be allocated */
         vlc_media_tree_Unlock(tree);
         return;
     }
 
-    vlc_media_tree_ClearChildren(subtree_root);
-    vlc_media_tree_AddSubtree(subtree_root, node);
+    vlc_media_tree_ClearChildren(tree, subtree_root);
+    vlc_media_tree_AddSubtree(tree, subtree_root, node);
     vlc_media_tree_Notify(tree, on_children_reset, subtree_root);
     vlc_media_tree_Unlock(tree);
 }
@@ -171,7 +207,7 @@ media_subtree_changed(input_item_t *media, input_item_node_t *node,
 static inline void
 vlc_media_tree_DestroyRootNode(vlc_media_tree_t *tree)
 {
-    vlc_media_tree_ClearChildren(&tree->root);
+    vlc_media_tree_ClearChildren(tree, &tree->root);
 }
 
 static void
@@ -183,6 +219,8 @@ vlc_media_tree_Delete(vlc_media_tree_t *tree)
         free(listener);
     vlc_list_init(&priv->listeners); /* reset */
     vlc_media_tree_DestroyRootNode(tree);
+    vlc_hashmap_Clean(&priv->nodes);
+    vlc_hashmap_Clean(&priv->parents);
     vlc_mutex_destroy(&priv->lock);
     free(tree);
 }
@@ -217,12 +255,19 @@ vlc_media_tree_Unlock(vlc_media_tree_t *tree)
 }
 
 static input_item_node_t *
-vlc_media_tree_AddChild(input_item_node_t *parent, input_item_t *media)
+vlc_media_tree_AddChild(vlc_media_tree_t *tree, input_item_node_t *parent,
+                        input_item_t *media)
 {
     input_item_node_t *node = input_item_node_Create(media);
     if (unlikely(!node))
         return NULL;
 
+    if (vlc_media_tree_IndexNode(tree, parent, node))
+    {
+        input_item_node_Delete(node);
+        return NULL;
+    }
+
     input_item_node_AppendNode(parent, node);
 
     return node;
@@ -276,7 +321,7 @@ vlc_media_tree_Add(vlc_media_tree_t *tree, input_item_node_t *parent,
 {
     vlc_media_tree_AssertLocked(tree);
 
-    input_item_node_t *node = vlc_media_tree_AddChild(parent, media);
+    input_item_node_t *node = vlc_media_tree_AddChild(tree, parent, media);
     if (unlikely(!node))
         return NULL;
 
@@ -292,10 +337,7 @@ vlc_media_tree_Find(vlc_media_tree_t *tree, const input_item_t *media,
 {
     vlc_media_tree_AssertLocked(tree);
 
-    /* quick & dirty depth-first O(n) implementation, with n the number of nodes
-     * in the tree */
-    return vlc_media_tree_FindNodeByMedia(&tree->root, media, result,
-                                          result_parent);
+    return vlc_media_tree_FindNodeByMedia(tree, media, result, result_parent);
 }
 
 bool
@@ -305,9 +347,10 @@ vlc_media_tree_Remove(vlc_media_tree_t *tree, input_item_t *media)
 
     input_item_node_t *node;
     input_item_node_t *parent;
-    if (!vlc_media_tree_FindNodeByMedia(&tree->root, media, &node, &parent))
+    if (!vlc_media_tree_FindNodeByMedia(tree, media, &node, &parent))
         return false;
 
+    vlc_media_tree_UnindexNode(tree, parent, node);
     input_item_node_RemoveNode(parent, node);
     vlc_media_tree_Notify(tree, on_children_removed, parent, &node, 1);
     input_item_node_Delete(node);
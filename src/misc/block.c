@@ -27,6 +27,7 @@
 
 #include <sys/stat.h>
 #include <assert.h>
+#include <stdatomic.h>
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -34,6 +35,7 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include "../libvlc.h"
 
 #ifndef NDEBUG
 static void block_Check (block_t *block)
@@ -105,6 +107,194 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/*
+ * Optional pool of blocks (see the block-pool option). Allocations are rounded
+ * up to power-of-two size classes, from 256 bytes to 64 KiB. Each thread keeps
+ * a few released blocks of each class, and exchanges them in batches with a
+ * global pool. Larger blocks are not pooled.
+ */
+#define BLOCK_POOL_MIN_SHIFT 8
+#define BLOCK_POOL_CLASSES   9
+#define BLOCK_POOL_CACHE     16  /* blocks per thread and size class */
+#define BLOCK_POOL_GLOBAL    256 /* blocks per size class */
+
+struct block_pool_cache
+{
+    block_t *blocks[BLOCK_POOL_CLASSES]; /* linked with p_next */
+    unsigned count[BLOCK_POOL_CLASSES];
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    atomic_bool enabled;
+    vlc_threadvar_t cache;
+    block_t *blocks[BLOCK_POOL_CLASSES];
+    unsigned count[BLOCK_POOL_CLASSES];
+
+    atomic_uintmax_t hits;
+    atomic_uintmax_t misses;
+    atomic_uintmax_t bytes;
+} block_pool = { .lock = VLC_STATIC_MUTEX };
+
+static unsigned block_pool_Class(size_t alloc)
+{
+    unsigned c = 0;
+
+    while (((size_t)1 << (c + BLOCK_POOL_MIN_SHIFT)) < alloc)
+        if (++c == BLOCK_POOL_CLASSES)
+            break;
+    return c;
+}
+
+static size_t block_pool_ClassSize(unsigned c)
+{
+    return (size_t)1 << (c + BLOCK_POOL_MIN_SHIFT);
+}
+
+/* Moves up to n cached blocks of a class to the global pool */
+static void block_pool_Flush(struct block_pool_cache *cache, unsigned c,
+                             unsigned n)
+{
+    vlc_mutex_lock(&block_pool.lock);
+    while (n-- > 0 && cache->count[c] > 0)
+    {
+        block_t *b = cache->blocks[c];
+
+        cache->blocks[c] = b->p_next;
+        cache->count[c]--;
+
+        if (block_pool.count[c] < BLOCK_POOL_GLOBAL)
+        {
+            b->p_next = block_pool.blocks[c];
+            block_pool.blocks[c] = b;
+            block_pool.count[c]++;
+        }
+        else
+            free(b);
+    }
+    vlc_mutex_unlock(&block_pool.lock);
+}
+
+/* Moves up to n blocks of a class from the global pool to the cache */
+static void block_pool_Refill(struct block_pool_cache *cache, unsigned c,
+                              unsigned n)
+{
+    vlc_mutex_lock(&block_pool.lock);
+    while (n-- > 0 && block_pool.count[c] > 0)
+    {
+        block_t *b = block_pool.blocks[c];
+
+        block_pool.blocks[c] = b->p_next;
+        block_pool.count[c]--;
+        b->p_next = cache->blocks[c];
+        cache->blocks[c] = b;
+        cache->count[c]++;
+    }
+    vlc_mutex_unlock(&block_pool.lock);
+}
+
+static void block_pool_DestroyCache(void *data)
+{
+    struct block_pool_cache *cache = data;
+
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+        block_pool_Flush(cache, c, cache->count[c]);
+    free(cache);
+}
+
+static struct block_pool_cache *block_pool_GetCache(void)
+{
+    struct block_pool_cache *cache = vlc_threadvar_get(block_pool.cache);
+
+    if (unlikely(cache == NULL))
+    {
+        cache = calloc(1, sizeof (*cache));
+        if (cache != NULL && vlc_threadvar_set(block_pool.cache, cache))
+        {
+            free(cache);
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+static block_t *block_pool_Alloc(unsigned c)
+{
+    struct block_pool_cache *cache = block_pool_GetCache();
+    block_t *b;
+
+    if (cache != NULL && cache->count[c] == 0)
+        block_pool_Refill(cache, c, BLOCK_POOL_CACHE / 2);
+
+    if (cache != NULL && cache->count[c] > 0)
+    {
+        b = cache->blocks[c];
+        cache->blocks[c] = b->p_next;
+        cache->count[c]--;
+        atomic_fetch_add_explicit(&block_pool.hits, 1, memory_order_relaxed);
+    }
+    else
+    {
+        b = malloc(block_pool_ClassSize(c));
+        if (unlikely(b == NULL))
+            return NULL;
+        atomic_fetch_add_explicit(&block_pool.misses, 1,
+                                  memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&block_pool.bytes, block_pool_ClassSize(c),
+                              memory_order_relaxed);
+    return b;
+}
+
+static void block_pool_Release(block_t *block)
+{
+    const size_t alloc = sizeof (*block) + block->i_size;
+    unsigned c = block_pool_Class(alloc);
+
+    assert(block->p_start == (unsigned char *)(block + 1));
+    assert(c < BLOCK_POOL_CLASSES && alloc == block_pool_ClassSize(c));
+    atomic_fetch_sub_explicit(&block_pool.bytes, alloc, memory_order_relaxed);
+
+    struct block_pool_cache *cache = block_pool_GetCache();
+    if (unlikely(cache == NULL))
+    {
+        free(block);
+        return;
+    }
+
+    if (cache->count[c] >= BLOCK_POOL_CACHE)
+        block_pool_Flush(cache, c, BLOCK_POOL_CACHE / 2);
+
+    block->p_next = cache->blocks[c];
+    cache->blocks[c] = block;
+    cache->count[c]++;
+}
+
+static const struct vlc_block_callbacks block_pool_cbs =
+{
+    block_pool_Release,
+};
+
+void vlc_block_pool_setup(libvlc_int_t *libvlc)
+{
+    vlc_mutex_lock(&block_pool.lock);
+    /* Once enabled, the pool remains for the lifetime of the process */
+    if (!atomic_load_explicit(&block_pool.enabled, memory_order_relaxed)
+     && var_InheritBool(libvlc, "block-pool")
+     && vlc_threadvar_create(&block_pool.cache, block_pool_DestroyCache) == 0)
+        atomic_store_explicit(&block_pool.enabled, true, memory_order_release);
+    vlc_mutex_unlock(&block_pool.lock);
+}
+
+void block_PoolStats(uintmax_t *hits, uintmax_t *misses, uintmax_t *bytes)
+{
+    *hits = atomic_load_explicit(&block_pool.hits, memory_order_relaxed);
+    *misses = atomic_load_explicit(&block_pool.misses, memory_order_relaxed);
+    *bytes = atomic_load_explicit(&block_pool.bytes, memory_order_relaxed);
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -119,11 +309,27 @@ block_t *block_Alloc (size_t size)
     if (unlikely(alloc <= size))
         return NULL;
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
-        return NULL;
+    block_t *b;
+    unsigned c;
 
-    block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+    if (atomic_load_explicit(&block_pool.enabled, memory_order_acquire)
+     && (c = block_pool_Class(alloc)) < BLOCK_POOL_CLASSES)
+    {
+        b = block_pool_Alloc(c);
+        if (unlikely(b == NULL))
+            return NULL;
+
+        block_Init(b, &block_pool_cbs, b + 1,
+                   block_pool_ClassSize(c) - sizeof (*b));
+    }
+    else
+    {
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
+
+        block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+    }
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
@@ -141,6 +347,180 @@ void block_Release(block_t *block)
     block->cbs->free(block);
 }
 
+/*
+ * Shared blocks. Several block headers may reference the same payload. Their
+ * callbacks all point to a common block_shared structure, which counts the
+ * references and keeps the callbacks of the block that was shared first (the
+ * owner). The owner header is only released with the last reference, as its
+ * storage may be tied to the payload.
+ *
+ * While shared, the payload is read-only. The spare room before and after it
+ * may still be used by one of the headers at a time, so that the first
+ * muxer to prepend a header does not need to copy the payload.
+ */
+#define BLOCK_SHARED_RETIRED ((uintptr_t)1)
+
+struct block_shared
+{
+    struct vlc_block_callbacks cbs;
+    const struct vlc_block_callbacks *owner_cbs;
+    block_t *owner;
+    atomic_uint refs;
+
+    const uint8_t *payload_start; /* shared payload */
+    const uint8_t *payload_end;
+    atomic_uintptr_t front; /* header allowed to grow before the payload */
+    atomic_uintptr_t back; /* header allowed to grow after the payload */
+
+    block_t view; /* first additional header, saves an allocation */
+};
+
+static void block_shared_Release(block_t *block);
+
+static struct block_shared *block_shared_Get(const block_t *block)
+{
+    if (block->cbs->free != block_shared_Release)
+        return NULL;
+    return container_of(block->cbs, struct block_shared, cbs);
+}
+
+static void block_shared_Unclaim(atomic_uintptr_t *claim, const block_t *block,
+                                 uintptr_t value)
+{
+    uintptr_t self = (uintptr_t)block;
+
+    atomic_compare_exchange_strong_explicit(claim, &self, value,
+                                            memory_order_relaxed,
+                                            memory_order_relaxed);
+}
+
+static void block_shared_Release(block_t *block)
+{
+    struct block_shared *sh = block_shared_Get(block);
+
+    /* Whatever this header wrote in the spare room is not referenced anymore */
+    block_shared_Unclaim(&sh->front, block, 0);
+    block_shared_Unclaim(&sh->back, block, 0);
+
+    if (atomic_fetch_sub_explicit(&sh->refs, 1, memory_order_acq_rel) > 1)
+    {
+        if (block != sh->owner && block != &sh->view)
+            free(block);
+        return;
+    }
+
+    block_t *owner = sh->owner;
+
+    if (block != owner && block != &sh->view)
+        free(block);
+    owner->cbs = sh->owner_cbs;
+    free(sh);
+    owner->cbs->free(owner);
+}
+
+block_t *block_Share(block_t *block)
+{
+    struct block_shared *sh = block_shared_Get(block);
+    block_t *view;
+
+    block_Check(block);
+
+    if (sh == NULL)
+    {
+        sh = malloc(sizeof (*sh));
+        if (unlikely(sh == NULL))
+            return NULL;
+
+        sh->cbs.free = block_shared_Release;
+        sh->owner_cbs = block->cbs;
+        sh->owner = block;
+        atomic_init(&sh->refs, 1);
+        sh->payload_start = block->p_buffer;
+        sh->payload_end = block->p_buffer + block->i_buffer;
+        atomic_init(&sh->front, 0);
+        atomic_init(&sh->back, 0);
+        block->cbs = &sh->cbs;
+        view = &sh->view;
+    }
+    else
+    {
+        view = malloc(sizeof (*view));
+        if (unlikely(view == NULL))
+            return NULL;
+
+        if (atomic_load_explicit(&sh->refs, memory_order_acquire) == 1)
+        {   /* No other references: the whole buffer was writable */
+            sh->payload_start = block->p_buffer;
+            sh->payload_end = block->p_buffer + block->i_buffer;
+            atomic_store_explicit(&sh->front, 0, memory_order_relaxed);
+            atomic_store_explicit(&sh->back, 0, memory_order_relaxed);
+        }
+        else
+        {   /* What this header wrote in the spare room becomes shared */
+            block_shared_Unclaim(&sh->front, block, BLOCK_SHARED_RETIRED);
+            block_shared_Unclaim(&sh->back, block, BLOCK_SHARED_RETIRED);
+        }
+    }
+
+    *view = *block;
+    view->p_next = NULL;
+    atomic_fetch_add_explicit(&sh->refs, 1, memory_order_relaxed);
+    return view;
+}
+
+bool block_IsShared(const block_t *block)
+{
+    const struct block_shared *sh = block_shared_Get(block);
+
+    return sh != NULL
+        && atomic_load_explicit(&sh->refs, memory_order_acquire) > 1;
+}
+
+block_t *block_MakeWritable(block_t *block)
+{
+    if (!block_IsShared(block))
+        return block;
+
+    block_t *dup = block_Alloc(block->i_buffer);
+    if (likely(dup != NULL))
+    {
+        BlockMetaCopy(dup, block);
+        memcpy(dup->p_buffer, block->p_buffer, block->i_buffer);
+    }
+    block_Release(block);
+    return dup;
+}
+
+static bool block_shared_Claim(atomic_uintptr_t *claim, const block_t *block)
+{
+    uintptr_t self = (uintptr_t)block;
+    uintptr_t owner = 0;
+
+    return atomic_compare_exchange_strong_explicit(claim, &owner, self,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed)
+        || owner == self;
+}
+
+/* Checks if a shared block can grow in place, without touching the payload
+ * shared with the other references. */
+static bool block_shared_CanGrow(const block_t *block, size_t pre, size_t body)
+{
+    struct block_shared *sh = block_shared_Get(block);
+
+    if (pre > 0
+     && (block->p_buffer > sh->payload_start
+      || !block_shared_Claim(&sh->front, block)))
+        return false;
+
+    if (body > block->i_buffer
+     && (block->p_buffer + block->i_buffer < sh->payload_end
+      || !block_shared_Claim(&sh->back, block)))
+        return false;
+
+    return true;
+}
+
 block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 {
     block_Check( p_block );
@@ -177,7 +557,7 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 
     if( p_block->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && !block_IsShared( p_block ) )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -202,7 +582,9 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
     /* Second, reallocate the buffer if we lack space. */
     assert( i_prebody >= 0 );
     if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
-     || (size_t)(p_end - p_block->p_buffer) < i_body )
+     || (size_t)(p_end - p_block->p_buffer) < i_body
+     || ( block_IsShared( p_block )
+       && !block_shared_CanGrow( p_block, i_prebody, i_body ) ) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea == NULL )
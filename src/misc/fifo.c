@@ -26,6 +26,7 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -235,3 +236,163 @@ size_t block_FifoCount (block_fifo_t *fifo)
     vlc_mutex_unlock (&fifo->lock);
     return depth;
 }
+
+/**
+ * Internal state for single producer, single consumer block queues
+ *
+ * The blocks are kept in a ring of pointers. The producer only writes the
+ * tail index and the consumer only writes the head index. A thread that
+ * needs to sleep flags itself as waiting, then sleeps on the sequence
+ * number that the other thread increments after each operation.
+ */
+struct vlc_spsc_fifo
+{
+    size_t              mask;      /**< capacity - 1 */
+    atomic_size_t       size;      /**< total bytes */
+
+    /* Producer side */
+    atomic_size_t       tail;
+    atomic_uint         put_seq;
+    atomic_bool         producer_waiting;
+    char                pad1[64]; /* keep both sides in separate cache lines */
+
+    /* Consumer side */
+    atomic_size_t       head;
+    atomic_uint         get_seq;
+    atomic_bool         consumer_waiting;
+    char                pad2[64];
+
+    block_t            *ring[];
+};
+
+vlc_spsc_fifo_t *vlc_spsc_fifo_New(size_t capacity)
+{
+    size_t count = 1;
+
+    while (count < capacity)
+    {
+        count <<= 1;
+        if (unlikely(count == 0))
+            return NULL;
+    }
+
+    vlc_spsc_fifo_t *fifo = malloc(sizeof (*fifo)
+                                   + count * sizeof (fifo->ring[0]));
+    if (unlikely(fifo == NULL))
+        return NULL;
+
+    fifo->mask = count - 1;
+    atomic_init(&fifo->size, 0);
+    atomic_init(&fifo->tail, 0);
+    atomic_init(&fifo->put_seq, 0);
+    atomic_init(&fifo->producer_waiting, false);
+    atomic_init(&fifo->head, 0);
+    atomic_init(&fifo->get_seq, 0);
+    atomic_init(&fifo->consumer_waiting, false);
+    return fifo;
+}
+
+void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *fifo)
+{
+    block_t *block;
+
+    while ((block = vlc_spsc_fifo_TryDequeue(fifo)) != NULL)
+        block_Release(block);
+    free(fifo);
+}
+
+bool vlc_spsc_fifo_TryQueue(vlc_spsc_fifo_t *fifo, block_t *block)
+{
+    size_t tail = atomic_load_explicit(&fifo->tail, memory_order_relaxed);
+
+    assert(block->p_next == NULL);
+    if (tail - atomic_load(&fifo->head) > fifo->mask)
+        return false; /* full */
+
+    fifo->ring[tail & fifo->mask] = block;
+    atomic_fetch_add_explicit(&fifo->size, block->i_buffer,
+                              memory_order_relaxed);
+    atomic_store(&fifo->tail, tail + 1);
+    atomic_fetch_add(&fifo->put_seq, 1);
+
+    if (atomic_load(&fifo->consumer_waiting))
+        vlc_addr_signal(&fifo->put_seq);
+    return true;
+}
+
+void vlc_spsc_fifo_Queue(vlc_spsc_fifo_t *fifo, block_t *block)
+{
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = NULL;
+        while (!vlc_spsc_fifo_TryQueue(fifo, block))
+        {
+            unsigned seq = atomic_load(&fifo->get_seq);
+
+            atomic_store(&fifo->producer_waiting, true);
+            /* Check again, so that a dequeue cannot be missed */
+            if (atomic_load(&fifo->tail) - atomic_load(&fifo->head)
+                                                                > fifo->mask)
+                vlc_addr_wait(&fifo->get_seq, seq);
+            atomic_store(&fifo->producer_waiting, false);
+        }
+        block = next;
+    }
+}
+
+block_t *vlc_spsc_fifo_TryDequeue(vlc_spsc_fifo_t *fifo)
+{
+    size_t head = atomic_load_explicit(&fifo->head, memory_order_relaxed);
+
+    if (head == atomic_load(&fifo->tail))
+        return NULL; /* empty */
+
+    block_t *block = fifo->ring[head & fifo->mask];
+
+    assert(atomic_load_explicit(&fifo->size, memory_order_relaxed)
+           >= block->i_buffer);
+    atomic_fetch_sub_explicit(&fifo->size, block->i_buffer,
+                              memory_order_relaxed);
+    atomic_store(&fifo->head, head + 1);
+    atomic_fetch_add(&fifo->get_seq, 1);
+
+    if (atomic_load(&fifo->producer_waiting))
+        vlc_addr_signal(&fifo->get_seq);
+    return block;
+}
+
+block_t *vlc_spsc_fifo_Dequeue(vlc_spsc_fifo_t *fifo)
+{
+    block_t *block;
+
+    vlc_testcancel();
+
+    while ((block = vlc_spsc_fifo_TryDequeue(fifo)) == NULL)
+    {
+        unsigned seq = atomic_load(&fifo->put_seq);
+
+        atomic_store(&fifo->consumer_waiting, true);
+        /* Check again, so that a queue cannot be missed */
+        if (atomic_load(&fifo->head) == atomic_load(&fifo->tail))
+            vlc_addr_wait(&fifo->put_seq, seq);
+        atomic_store(&fifo->consumer_waiting, false);
+    }
+    return block;
+}
+
+size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *fifo)
+{
+    vlc_spsc_fifo_t *f = (vlc_spsc_fifo_t *)fifo;
+    size_t head = atomic_load(&f->head); /* before the tail, never after */
+
+    return atomic_load(&f->tail) - head;
+}
+
+size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *fifo)
+{
+    vlc_spsc_fifo_t *f = (vlc_spsc_fifo_t *)fifo;
+
+    return atomic_load_explicit(&f->size, memory_order_relaxed);
+}
@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * hashmap.c: hash multimap with integer keys
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "hashmap.h"
+
+#define HASHMAP_MIN_BITS 4
+
+void vlc_hashmap_Init(struct vlc_hashmap *map)
+{
+    map->buckets = NULL;
+    map->bits = 0;
+    map->count = 0;
+}
+
+void vlc_hashmap_Clean(struct vlc_hashmap *map)
+{
+    if (map->bits > 0)
+        for (size_t i = 0; i < ((size_t)1 << map->bits); i++)
+            for (struct vlc_hashmap_entry *e = map->buckets[i], *next;
+                 e != NULL; e = next)
+            {
+                next = e->next;
+                free(e);
+            }
+
+    free(map->buckets);
+    vlc_hashmap_Init(map);
+}
+
+/* Fibonacci hashing: the high bits of the product are well mixed, even for
+ * aligned pointers and consecutive identifiers. */
+static size_t vlc_hashmap_Bucket(unsigned bits, uint64_t key)
+{
+    return (key * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - bits);
+}
+
+static struct vlc_hashmap_entry **
+vlc_hashmap_Tail(struct vlc_hashmap_entry **buckets, unsigned bits,
+                 uint64_t key)
+{
+    struct vlc_hashmap_entry **pp = &buckets[vlc_hashmap_Bucket(bits, key)];
+
+    while (*pp != NULL)
+        pp = &(*pp)->next;
+    return pp;
+}
+
+static int vlc_hashmap_Grow(struct vlc_hashmap *map)
+{
+    unsigned bits = (map->bits > 0) ? map->bits + 1 : HASHMAP_MIN_BITS;
+    struct vlc_hashmap_entry **buckets = calloc((size_t)1 << bits,
+                                                sizeof (*buckets));
+    if (unlikely(buckets == NULL))
+        return VLC_ENOMEM;
+
+    /* Moving the chains in order preserves the order of equal keys */
+    if (map->bits > 0)
+        for (size_t i = 0; i < ((size_t)1 << map->bits); i++)
+            for (struct vlc_hashmap_entry *e = map->buckets[i], *next;
+                 e != NULL; e = next)
+            {
+                next = e->next;
+                e->next = NULL;
+                *vlc_hashmap_Tail(buckets, bits, e->key) = e;
+            }
+
+    free(map->buckets);
+    map->buckets = buckets;
+    map->bits = bits;
+    return VLC_SUCCESS;
+}
+
+int vlc_hashmap_Add(struct vlc_hashmap *map, uint64_t key, void *value)
+{
+    if (map->count >= ((size_t)1 << map->bits) / 4 * 3
+     && vlc_hashmap_Grow(map) != VLC_SUCCESS && map->bits == 0)
+        return VLC_ENOMEM;
+
+    struct vlc_hashmap_entry *entry = malloc(sizeof (*entry));
+    if (unlikely(entry == NULL))
+        return VLC_ENOMEM;
+
+    entry->next = NULL;
+    entry->key = key;
+    entry->value = value;
+    *vlc_hashmap_Tail(map->buckets, map->bits, key) = entry;
+    map->count++;
+    return VLC_SUCCESS;
+}
+
+bool vlc_hashmap_Remove(struct vlc_hashmap *map, uint64_t key,
+                        const void *value)
+{
+    if (map->bits == 0)
+        return false;
+
+    for (struct vlc_hashmap_entry **pp =
+             &map->buckets[vlc_hashmap_Bucket(map->bits, key)];
+         *pp != NULL; pp = &(*pp)->next)
+    {
+        struct vlc_hashmap_entry *entry = *pp;
+
+        if (entry->key == key && entry->value == value)
+        {
+            *pp = entry->next;
+            free(entry);
+            map->count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+const struct vlc_hashmap_entry *
+vlc_hashmap_Find(const struct vlc_hashmap *map, uint64_t key)
+{
+    if (map->bits == 0)
+        return NULL;
+
+    const struct vlc_hashmap_entry *entry =
+        map->buckets[vlc_hashmap_Bucket(map->bits, key)];
+
+    while (entry != NULL && entry->key != key)
+        entry = entry->next;
+    return entry;
+}
+
+const struct vlc_hashmap_entry *
+vlc_hashmap_FindNext(const struct vlc_hashmap_entry *entry)
+{
+    uint64_t key = entry->key;
+
+    do
+        entry = entry->next;
+    while (entry != NULL && entry->key != key);
+    return entry;
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * hashmap.h: hash multimap with integer keys
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_HASHMAP_H
+#define VLC_HASHMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Hash multimap from integer keys (identifiers or pointers) to pointers.
+ *
+ * Several values may be stored with the same key; they are then iterated in
+ * insertion order. The table grows with the number of entries.
+ */
+struct vlc_hashmap_entry
+{
+    struct vlc_hashmap_entry *next;
+    uint64_t key;
+    void *value;
+};
+
+struct vlc_hashmap
+{
+    struct vlc_hashmap_entry **buckets;
+    unsigned bits; /**< log2 of the bucket count, 0 if none */
+    size_t count;
+};
+
+#define vlc_hashmap_PtrKey(ptr) ((uint64_t)(uintptr_t)(ptr))
+
+void vlc_hashmap_Init(struct vlc_hashmap *map);
+
+/**
+ * Removes all the entries, and frees the table.
+ */
+void vlc_hashmap_Clean(struct vlc_hashmap *map);
+
+/**
+ * Adds an entry, after the entries with the same key.
+ *
+ * \return VLC_SUCCESS or VLC_ENOMEM
+ */
+int vlc_hashmap_Add(struct vlc_hashmap *map, uint64_t key, void *value);
+
+/**
+ * Removes an entry.
+ *
+ * \return true if the entry was found
+ */
+bool vlc_hashmap_Remove(struct vlc_hashmap *map, uint64_t key,
+                        const void *value);
+
+/**
+ * Returns the first entry with the given key, or NULL.
+ */
+const struct vlc_hashmap_entry *
+vlc_hashmap_Find(const struct vlc_hashmap *map, uint64_t key);
+
+/**
+ * Returns the next entry with the same key, or NULL.
+ */
+const struct vlc_hashmap_entry *
+vlc_hashmap_FindNext(const struct vlc_hashmap_entry *entry);
+
+/**
+ * Returns the first value stored with the given key, or NULL.
+ */
+static inline void *vlc_hashmap_Get(const struct vlc_hashmap *map,
+                                    uint64_t key)
+{
+    const struct vlc_hashmap_entry *entry = vlc_hashmap_Find(map, key);
+    return (entry != NULL) ? entry->value : NULL;
+}
+
+#endif
@@ -35,11 +35,14 @@
 #include <stdarg.h>                                       /* va_list for BSD */
 #include <unistd.h>
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
+#include <vlc_memstream.h>
+#include <vlc_list.h>
 #include "../libvlc.h"
 
 static void vlc_LogSpam(vlc_object_t *obj)
@@ -440,6 +443,656 @@ static struct vlc_logger *vlc_LogModuleCreate(vlc_object_t *parent)
     return &module->frontend;
 }
 
+/**
+ * Asynchronous message log.
+ *
+ * The emitting threads do not format their messages: they copy the format
+ * arguments into a per-thread ring buffer, without locking. A background
+ * thread formats the messages and passes them to the sink log, in emission
+ * order. If a ring buffer is full, the message is dropped and counted.
+ */
+#define LOG_RING_SIZE  (64 * 1024) /* bytes per thread, power of 2 */
+#define LOG_RECORD_MAX (LOG_RING_SIZE / 4)
+#define LOG_SPEC_MAX   32
+
+struct vlc_log_ring {
+    struct vlc_list node;
+    atomic_size_t head; /* read offset, only written by the logging thread */
+    atomic_size_t tail; /* write offset, only written by the emitting thread */
+    atomic_bool orphan; /* the emitting thread has exited */
+    atomic_ulong dropped;
+    unsigned char data[LOG_RING_SIZE];
+};
+
+/* Header of a message in a ring, followed by the module name, the optional
+ * header string, then the format string and the format arguments, or only
+ * the formatted text if format_len is 0. */
+struct vlc_log_record {
+    size_t size; /* including this header */
+    vlc_tick_t date;
+    int type;
+    vlc_log_t meta; /* psz_module and psz_header are in the record */
+    size_t header_len; /* including the nul, or 0 if no header */
+    size_t format_len; /* including the nul, or 0 if formatted */
+};
+
+struct vlc_logger_async {
+    struct vlc_logger frontend;
+    struct vlc_logger *sink;
+    vlc_threadvar_t ring;
+    vlc_mutex_t lock; /* protects the rings list */
+    struct vlc_list rings;
+    vlc_sem_t wakeup;
+    atomic_bool sleeping;
+    atomic_bool stop;
+    vlc_thread_t thread;
+    unsigned char record[LOG_RECORD_MAX];
+};
+
+enum vlc_log_arg {
+    LOG_ARG_NONE,
+    LOG_ARG_INT,
+    LOG_ARG_LONG,
+    LOG_ARG_LLONG,
+    LOG_ARG_INTMAX,
+    LOG_ARG_SIZE,
+    LOG_ARG_PTRDIFF,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LDOUBLE,
+    LOG_ARG_PTR,
+    LOG_ARG_STR,
+};
+
+struct vlc_log_spec {
+    size_t len; /* from the percent sign to the conversion included */
+    bool star_width;
+    bool star_precision;
+    int precision; /* -1 if none */
+    enum vlc_log_arg arg;
+};
+
+/* Parses a printf() conversion specification. Returns false if it cannot be
+ * deferred, e.g. %n, %m or wide characters. */
+static bool vlc_log_ParseSpec(const char *p, struct vlc_log_spec *spec)
+{
+    const char *start = p++;
+
+    spec->star_width = spec->star_precision = false;
+    spec->precision = -1;
+
+    while (*p != '\0' && strchr("-+ #0'", *p) != NULL)
+        p++;
+
+    if (*p == '*') {
+        spec->star_width = true;
+        p++;
+    } else
+        while (*p >= '0' && *p <= '9')
+            p++;
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->star_precision = true;
+            p++;
+        } else {
+            spec->precision = 0;
+            while (*p >= '0' && *p <= '9')
+                spec->precision = spec->precision * 10 + (*(p++) - '0');
+        }
+    }
+
+    char length = '\0';
+    switch (*p) {
+        case 'h':
+            length = 'h';
+            if (*(++p) == 'h')
+                p++;
+            break;
+        case 'l':
+            length = 'l';
+            if (*(++p) == 'l') {
+                length = 'q';
+                p++;
+            }
+            break;
+        case 'j': case 'z': case 't': case 'L':
+            length = *(p++);
+            break;
+    }
+
+    switch (*p) {
+        case '%':
+            spec->arg = LOG_ARG_NONE;
+            break;
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+            switch (length) {
+                case '\0':
+                case 'h': spec->arg = LOG_ARG_INT; break;
+                case 'l': spec->arg = LOG_ARG_LONG; break;
+                case 'q': spec->arg = LOG_ARG_LLONG; break;
+                case 'j': spec->arg = LOG_ARG_INTMAX; break;
+                case 'z': spec->arg = LOG_ARG_SIZE; break;
+                case 't': spec->arg = LOG_ARG_PTRDIFF; break;
+                default: return false;
+            }
+            if (*p == 'c' && length != '\0')
+                return false;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+        case 'a': case 'A':
+            if (length == 'L')
+                spec->arg = LOG_ARG_LDOUBLE;
+            else if (length == '\0' || length == 'l')
+                spec->arg = LOG_ARG_DOUBLE;
+            else
+                return false;
+            break;
+        case 'p':
+        case 's':
+            if (length != '\0')
+                return false;
+            spec->arg = (*p == 's') ? LOG_ARG_STR : LOG_ARG_PTR;
+            break;
+        default:
+            return false;
+    }
+
+    spec->len = p + 1 - start;
+    return spec->len < LOG_SPEC_MAX;
+}
+
+static void vlc_log_RingCopyIn(struct vlc_log_ring *ring, size_t offset,
+                               const void *data, size_t len)
+{
+    size_t pos = offset & (LOG_RING_SIZE - 1);
+    size_t first = __MIN(len, LOG_RING_SIZE - pos);
+
+    memcpy(ring->data + pos, data, first);
+    memcpy(ring->data, (const unsigned char *)data + first, len - first);
+}
+
+static void vlc_log_RingCopyOut(const struct vlc_log_ring *ring,
+                                size_t offset, void *data, size_t len)
+{
+    size_t pos = offset & (LOG_RING_SIZE - 1);
+    size_t first = __MIN(len, LOG_RING_SIZE - pos);
+
+    memcpy(data, ring->data + pos, first);
+    memcpy((unsigned char *)data + first, ring->data, len - first);
+}
+
+struct vlc_log_writer {
+    struct vlc_log_ring *ring;
+    size_t offset; /* of the record in the ring */
+    size_t size; /* written so far */
+    size_t avail;
+};
+
+static bool vlc_log_Write(struct vlc_log_writer *w, const void *data,
+                          size_t len)
+{
+    if (len > w->avail - w->size)
+        return false;
+
+    vlc_log_RingCopyIn(w->ring, w->offset + w->size, data, len);
+    w->size += len;
+    return true;
+}
+
+#define LOG_WRITE_ARG(arg, type) \
+    case arg: { \
+        type val = va_arg(ap, type); \
+        if (!vlc_log_Write(w, &val, sizeof (val))) \
+            return false; \
+        break; \
+    }
+
+static bool vlc_log_WriteArgs(struct vlc_log_writer *w, const char *format,
+                              va_list ap)
+{
+    for (const char *p = strchr(format, '%'); p != NULL; p = strchr(p, '%')) {
+        struct vlc_log_spec spec;
+
+        if (!vlc_log_ParseSpec(p, &spec))
+            return false;
+        p += spec.len;
+
+        if (spec.star_width) {
+            int width = va_arg(ap, int);
+            if (!vlc_log_Write(w, &width, sizeof (width)))
+                return false;
+        }
+        if (spec.star_precision) {
+            spec.precision = va_arg(ap, int);
+            if (!vlc_log_Write(w, &spec.precision, sizeof (spec.precision)))
+                return false;
+        }
+
+        switch (spec.arg) {
+            case LOG_ARG_NONE:
+                break;
+            LOG_WRITE_ARG(LOG_ARG_INT, int)
+            LOG_WRITE_ARG(LOG_ARG_LONG, long)
+            LOG_WRITE_ARG(LOG_ARG_LLONG, long long)
+            LOG_WRITE_ARG(LOG_ARG_INTMAX, intmax_t)
+            LOG_WRITE_ARG(LOG_ARG_SIZE, size_t)
+            LOG_WRITE_ARG(LOG_ARG_PTRDIFF, ptrdiff_t)
+            LOG_WRITE_ARG(LOG_ARG_DOUBLE, double)
+            LOG_WRITE_ARG(LOG_ARG_LDOUBLE, long double)
+            LOG_WRITE_ARG(LOG_ARG_PTR, void *)
+            case LOG_ARG_STR: {
+                /* The string may not outlive the call, copy it */
+                const char *str = va_arg(ap, const char *);
+                if (str == NULL)
+                    str = "(null)";
+
+                size_t len = (spec.precision >= 0)
+                           ? strnlen(str, spec.precision) : strlen(str);
+                if (!vlc_log_Write(w, str, len) || !vlc_log_Write(w, "", 1))
+                    return false;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/* Formats on the emitting thread, for what cannot be deferred */
+static bool vlc_log_WriteText(struct vlc_log_writer *w, const char *format,
+                              va_list ap)
+{
+    char *text;
+    int len = vasprintf(&text, format, ap);
+    if (len < 0)
+        return false;
+
+    size_t room = w->avail - w->size;
+    bool ok = room > 0 && ((size_t)len < room || w->avail == LOG_RECORD_MAX);
+    if (ok) { /* A lone message too large for a record is truncated */
+        if ((size_t)len >= room)
+            len = room - 1;
+        ok = vlc_log_Write(w, text, len) && vlc_log_Write(w, "", 1);
+    }
+    free(text);
+    return ok;
+}
+
+static void vlc_log_RingDestroy(void *data)
+{
+    struct vlc_log_ring *ring = data;
+
+    /* Freed by the logging thread once drained */
+    atomic_store_explicit(&ring->orphan, true, memory_order_release);
+}
+
+static struct vlc_log_ring *vlc_log_GetRing(struct vlc_logger_async *async)
+{
+    struct vlc_log_ring *ring = vlc_threadvar_get(async->ring);
+
+    if (likely(ring != NULL))
+        return ring;
+
+    ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->orphan, false);
+    atomic_init(&ring->dropped, 0);
+
+    if (vlc_threadvar_set(async->ring, ring)) {
+        free(ring);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&async->lock);
+    vlc_list_append(&ring->node, &async->rings);
+    vlc_mutex_unlock(&async->lock);
+    return ring;
+}
+
+static void vlc_vaLogAsync(void *d, int type, const vlc_log_t *item,
+                           const char *format, va_list ap)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, frontend);
+    struct vlc_log_ring *ring = vlc_log_GetRing(async);
+
+    if (unlikely(ring == NULL))
+        return;
+
+    struct vlc_log_record rec = {
+        .date = vlc_tick_now(),
+        .type = type,
+        .meta = *item,
+        .header_len = (item->psz_header != NULL)
+                    ? strlen(item->psz_header) + 1 : 0,
+        .format_len = strlen(format) + 1,
+    };
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    struct vlc_log_writer w = {
+        .ring = ring,
+        .offset = tail,
+        .size = sizeof (rec),
+        .avail = __MIN(LOG_RING_SIZE - (tail - head), LOG_RECORD_MAX),
+    };
+
+    if (w.size > w.avail
+     || !vlc_log_Write(&w, item->psz_module, strlen(item->psz_module) + 1)
+     || !vlc_log_Write(&w, item->psz_header, rec.header_len))
+        goto drop;
+
+    /* The format string may not outlive the call either, e.g. if it was
+     * built at run time: it is copied like the arguments. */
+    size_t text = w.size;
+    va_list aq;
+    bool ok;
+
+    va_copy(aq, ap);
+    ok = vlc_log_Write(&w, format, rec.format_len)
+      && vlc_log_WriteArgs(&w, format, aq);
+    va_end(aq);
+
+    if (!ok) {
+        w.size = text;
+        rec.format_len = 0;
+        if (!vlc_log_WriteText(&w, format, ap))
+            goto drop;
+    }
+
+    rec.size = w.size;
+    vlc_log_RingCopyIn(ring, tail, &rec, sizeof (rec));
+    atomic_store(&ring->tail, tail + w.size);
+
+    /* Both the tail store above and this load must be sequentially
+     * consistent, as must be their counterparts in vlc_LogAsyncThread():
+     * either this thread sees the logging thread sleeping, or the logging
+     * thread sees the new tail. */
+    if (atomic_load(&async->sleeping)
+     && atomic_exchange(&async->sleeping, false))
+        vlc_sem_post(&async->wakeup);
+    return;
+
+drop:
+    atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+}
+
+static const unsigned char *vlc_log_Read(const unsigned char *args,
+                                         void *data, size_t len)
+{
+    memcpy(data, args, len);
+    return args + len;
+}
+
+#define LOG_FORMAT_ARG(arg, type) \
+    case arg: { \
+        type val; \
+        args = vlc_log_Read(args, &val, sizeof (val)); \
+        vlc_memstream_printf(&ms, spec, val); \
+        break; \
+    }
+
+/* Formats deferred arguments, as written by vlc_log_WriteArgs() */
+static char *vlc_log_Format(const char *format, const unsigned char *args)
+{
+    struct vlc_memstream ms;
+
+    if (vlc_memstream_open(&ms))
+        return NULL;
+
+    for (;;) {
+        const char *p = strchr(format, '%');
+        if (p == NULL) {
+            vlc_memstream_puts(&ms, format);
+            break;
+        }
+        vlc_memstream_write(&ms, format, p - format);
+
+        struct vlc_log_spec parsed;
+        bool ok = vlc_log_ParseSpec(p, &parsed);
+        assert(ok); (void) ok;
+        format = p + parsed.len;
+
+        /* Substitute the deferred width and precision */
+        char spec[LOG_SPEC_MAX + 24];
+        size_t len = 0;
+
+        for (size_t i = 0; i < parsed.len; i++) {
+            if (p[i] != '*') {
+                spec[len++] = p[i];
+                continue;
+            }
+
+            int val;
+            args = vlc_log_Read(args, &val, sizeof (val));
+            if (p[i - 1] != '.')
+                len += sprintf(spec + len, "%d", val);
+            else if (val >= 0)
+                len += sprintf(spec + len, "%d", val);
+            else /* Negative precision is as if omitted */
+                len--;
+        }
+        spec[len] = '\0';
+
+        switch (parsed.arg) {
+            case LOG_ARG_NONE:
+                vlc_memstream_putc(&ms, '%');
+                break;
+            LOG_FORMAT_ARG(LOG_ARG_INT, int)
+            LOG_FORMAT_ARG(LOG_ARG_LONG, long)
+            LOG_FORMAT_ARG(LOG_ARG_LLONG, long long)
+            LOG_FORMAT_ARG(LOG_ARG_INTMAX, intmax_t)
+            LOG_FORMAT_ARG(LOG_ARG_SIZE, size_t)
+            LOG_FORMAT_ARG(LOG_ARG_PTRDIFF, ptrdiff_t)
+            LOG_FORMAT_ARG(LOG_ARG_DOUBLE, double)
+            LOG_FORMAT_ARG(LOG_ARG_LDOUBLE, long double)
+            LOG_FORMAT_ARG(LOG_ARG_PTR, void *)
+            case LOG_ARG_STR: {
+                const char *str = (const char *)args;
+
+                args += strlen(str) + 1;
+                vlc_memstream_printf(&ms, spec, str);
+                break;
+            }
+        }
+    }
+
+    return vlc_memstream_close(&ms) ? NULL : ms.ptr;
+}
+
+/* Returns the ring holding the oldest pending message, if any.
+ * Must be called with the lock held. */
+static struct vlc_log_ring *vlc_LogAsyncNext(struct vlc_logger_async *async,
+                                             struct vlc_log_record *restrict rec)
+{
+    struct vlc_log_ring *ring, *next = NULL;
+
+    vlc_list_foreach(ring, &async->rings, node) {
+        size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        struct vlc_log_record cur;
+
+        if (head == atomic_load(&ring->tail))
+            continue;
+
+        vlc_log_RingCopyOut(ring, head, &cur, sizeof (cur));
+        if (next == NULL || cur.date < rec->date) {
+            *rec = cur;
+            next = ring;
+        }
+    }
+    return next;
+}
+
+/* Passes all pending messages to the sink. Must be called with the lock
+ * held. */
+static void vlc_LogAsyncDrain(struct vlc_logger_async *async)
+{
+    struct vlc_log_ring *ring;
+    struct vlc_log_record rec;
+    unsigned long dropped = 0;
+
+    while ((ring = vlc_LogAsyncNext(async, &rec)) != NULL) {
+        size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        unsigned char *record = async->record;
+
+        assert(rec.size <= LOG_RECORD_MAX);
+        vlc_log_RingCopyOut(ring, head, record, rec.size);
+        atomic_store_explicit(&ring->head, head + rec.size,
+                              memory_order_release);
+
+        const char *module = (const char *)record + sizeof (rec);
+        const unsigned char *args = record + sizeof (rec) + strlen(module) + 1;
+
+        rec.meta.psz_module = module;
+        rec.meta.psz_header = NULL;
+        if (rec.header_len > 0) {
+            rec.meta.psz_header = (const char *)args;
+            args += rec.header_len;
+        }
+
+        if (rec.format_len > 0) {
+            const char *format = (const char *)args;
+            char *text = vlc_log_Format(format, args + rec.format_len);
+
+            vlc_LogCallback(async->sink, rec.type, &rec.meta, "%s",
+                            (text != NULL) ? text : "message lost");
+            free(text);
+        } else
+            vlc_LogCallback(async->sink, rec.type, &rec.meta, "%s",
+                            (const char *)args);
+    }
+
+    vlc_list_foreach(ring, &async->rings, node) {
+        dropped += atomic_exchange_explicit(&ring->dropped, 0,
+                                            memory_order_relaxed);
+
+        /* The emitting thread is gone: its ring was drained above */
+        if (atomic_load_explicit(&ring->orphan, memory_order_acquire)
+         && atomic_load(&ring->tail)
+                == atomic_load_explicit(&ring->head, memory_order_relaxed)) {
+            dropped += atomic_load_explicit(&ring->dropped,
+                                            memory_order_relaxed);
+            vlc_list_remove(&ring->node);
+            free(ring);
+        }
+    }
+
+    if (dropped > 0) {
+        vlc_log_t meta = {
+            .psz_object_type = "logger",
+            .psz_module = "logger",
+            .file = __FILE__,
+            .line = __LINE__,
+            .func = __func__,
+            .tid = vlc_thread_id(),
+        };
+
+        vlc_LogCallback(async->sink, VLC_MSG_WARN, &meta,
+                        "%lu log message(s) dropped", dropped);
+    }
+}
+
+static bool vlc_LogAsyncPending(struct vlc_logger_async *async)
+{
+    struct vlc_log_ring *ring;
+    bool pending = false;
+
+    vlc_mutex_lock(&async->lock);
+    vlc_list_foreach(ring, &async->rings, node)
+        if (atomic_load(&ring->tail)
+                != atomic_load_explicit(&ring->head, memory_order_relaxed)) {
+            pending = true;
+            break;
+        }
+    vlc_mutex_unlock(&async->lock);
+    return pending;
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    struct vlc_logger_async *async = data;
+
+    for (;;) {
+        bool stop = atomic_load(&async->stop);
+
+        vlc_mutex_lock(&async->lock);
+        vlc_LogAsyncDrain(async);
+        vlc_mutex_unlock(&async->lock);
+
+        if (stop)
+            break;
+
+        /* Emitters only wake this thread up if it says it is sleeping */
+        atomic_store(&async->sleeping, true);
+        if ((vlc_LogAsyncPending(async) || atomic_load(&async->stop))
+         && atomic_exchange(&async->sleeping, false))
+            continue;
+
+        vlc_sem_wait(&async->wakeup);
+    }
+    return NULL;
+}
+
+static void vlc_LogAsyncClose(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, frontend);
+    struct vlc_log_ring *ring;
+
+    atomic_store(&async->stop, true);
+    vlc_sem_post(&async->wakeup);
+    vlc_join(async->thread, NULL);
+
+    vlc_list_foreach(ring, &async->rings, node)
+        free(ring);
+    vlc_threadvar_delete(&async->ring);
+    vlc_sem_destroy(&async->wakeup);
+    vlc_mutex_destroy(&async->lock);
+
+    async->sink->ops->destroy(async->sink);
+    free(async);
+}
+
+static const struct vlc_logger_operations async_ops = {
+    vlc_vaLogAsync,
+    vlc_LogAsyncClose,
+};
+
+static struct vlc_logger *vlc_LogAsyncCreate(struct vlc_logger *sink)
+{
+    struct vlc_logger_async *async = malloc(sizeof (*async));
+    if (unlikely(async == NULL))
+        return NULL;
+
+    if (vlc_threadvar_create(&async->ring, vlc_log_RingDestroy)) {
+        free(async);
+        return NULL;
+    }
+
+    async->frontend.ops = &async_ops;
+    async->sink = sink;
+    vlc_mutex_init(&async->lock);
+    vlc_list_init(&async->rings);
+    vlc_sem_init(&async->wakeup, 0);
+    atomic_init(&async->sleeping, false);
+    atomic_init(&async->stop, false);
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async,
+                  VLC_THREAD_PRIORITY_LOW)) {
+        vlc_sem_destroy(&async->wakeup);
+        vlc_mutex_destroy(&async->lock);
+        vlc_threadvar_delete(&async->ring);
+        free(async);
+        return NULL;
+    }
+    return &async->frontend;
+}
+
 /**
  * Initializes the messages logging subsystem and drain the early messages to
  * the configured log.
@@ -449,6 +1102,11 @@ void vlc_LogInit(libvlc_int_t *vlc)
     struct vlc_logger *logger = vlc_LogModuleCreate(VLC_OBJECT(vlc));
     if (logger == NULL)
         logger = &discard_log;
+    else if (var_InheritBool(vlc, "log-async")) {
+        struct vlc_logger *async = vlc_LogAsyncCreate(logger);
+        if (async != NULL)
+            logger = async;
+    }
 
     vlc_LogSwitch(vlc->obj.logger, logger);
 }
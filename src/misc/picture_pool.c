@@ -41,11 +41,14 @@ static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
 struct picture_pool_t {
     int       (*pic_lock)(picture_t *);
     void      (*pic_unlock)(picture_t *);
+    /* The mutex and condition variable are only used to sleep in
+     * picture_pool_Wait(): pictures are taken and returned lock-free. */
     vlc_mutex_t lock;
     vlc_cond_t  wait;
+    atomic_uint waiters;
 
-    bool               canceled;
-    unsigned long long available;
+    atomic_bool        canceled;
+    atomic_ullong      available;
     atomic_ushort      refs;
     unsigned short     picture_count;
     picture_t  *picture[];
@@ -69,6 +72,40 @@ void picture_pool_Release(picture_pool_t *pool)
     picture_pool_Destroy(pool);
 }
 
+/* Takes an available picture not in the exclude mask,
+ * returns its offset or -1 if none */
+static int picture_pool_Take(picture_pool_t *pool, unsigned long long exclude)
+{
+    unsigned long long available = atomic_load(&pool->available);
+
+    while ((available & ~exclude) != 0)
+    {
+        int i = ctz(available & ~exclude);
+
+        if (atomic_compare_exchange_weak(&pool->available, &available,
+                                         available & ~(1ULL << i)))
+            return i;
+    }
+    return -1;
+}
+
+/* Makes a picture available again */
+static void picture_pool_Put(picture_pool_t *pool, unsigned offset)
+{
+    unsigned long long available;
+
+    available = atomic_fetch_or(&pool->available, 1ULL << offset);
+    assert(!(available & (1ULL << offset)));
+    (void) available;
+
+    /* Either a waiter sees the picture, or it is already waiting */
+    if (atomic_load(&pool->waiters) > 0) {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
@@ -81,12 +118,7 @@ static void picture_pool_ReleasePicture(picture_t *clone)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
-
+    picture_pool_Put(pool, offset);
     picture_pool_Destroy(pool);
 }
 
@@ -131,15 +163,16 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     pool->pic_unlock = cfg->unlock;
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
+    atomic_init(&pool->waiters, 0);
     if (cfg->picture_count == POOL_MAX)
-        pool->available = ~0ULL;
+        atomic_init(&pool->available, ~0ULL);
     else
-        pool->available = (1ULL << cfg->picture_count) - 1;
+        atomic_init(&pool->available, (1ULL << cfg->picture_count) - 1);
     atomic_init(&pool->refs,  1);
     pool->picture_count = cfg->picture_count;
     memcpy(pool->picture, cfg->picture,
            cfg->picture_count * sizeof (picture_t *));
-    pool->canceled = false;
+    atomic_init(&pool->canceled, false);
     return pool;
 }
 
@@ -202,28 +235,26 @@ error:
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    unsigned long long available;
+    unsigned long long locked = 0; /* pictures that failed to lock */
 
-    vlc_mutex_lock(&pool->lock);
     assert(pool->refs > 0);
-    available = pool->available;
 
-    while (available != 0)
+    for (;;)
     {
-        int i = ctz(available);
-
-        if (unlikely(pool->canceled))
+        if (unlikely(atomic_load_explicit(&pool->canceled,
+                                          memory_order_relaxed)))
             break;
 
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
+        int i = picture_pool_Take(pool, locked);
+        if (i < 0)
+            break;
 
         picture_t *picture = pool->picture[i];
 
         if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-            vlc_mutex_lock(&pool->lock);
-            pool->available |= 1ULL << i;
+            picture_pool_Put(pool, i);
+            /* Do not try the same picture over and over again */
+            locked |= 1ULL << i;
             continue;
         }
 
@@ -235,36 +266,37 @@ picture_t *picture_pool_Get(picture_pool_t *pool)
         return clone;
     }
 
-    vlc_mutex_unlock(&pool->lock);
     return NULL;
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
+    int i;
+
     assert(pool->refs > 0);
 
-    while (pool->available == 0)
-    {
-        if (pool->canceled)
+    i = picture_pool_Take(pool, 0);
+    if (i < 0) {
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+
+        while ((i = picture_pool_Take(pool, 0)) < 0)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            if (atomic_load(&pool->canceled))
+                break;
+            vlc_cond_wait(&pool->wait, &pool->lock);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
 
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
-    vlc_mutex_unlock(&pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
+        if (i < 0)
+            return NULL;
+    }
 
     picture_t *picture = pool->picture[i];
 
     if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-        vlc_mutex_lock(&pool->lock);
-        pool->available |= 1ULL << i;
-        vlc_cond_signal(&pool->wait);
-        vlc_mutex_unlock(&pool->lock);
+        picture_pool_Put(pool, i);
         return NULL;
     }
 
@@ -281,7 +313,7 @@ void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
     vlc_mutex_lock(&pool->lock);
     assert(pool->refs > 0);
 
-    pool->canceled = canceled;
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
@@ -36,9 +36,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -51,94 +48,101 @@
 
 typedef struct vlc_modcap
 {
-    char *name;
+    const char *name;
     module_t **modv;
     size_t modc;
 } vlc_modcap_t;
 
 static int vlc_modcap_cmp(const void *a, const void *b)
 {
-    const vlc_modcap_t *capa = a, *capb = b;
-    return strcmp(capa->name, capb->name);
-}
-
-static void vlc_modcap_free(void *data)
-{
-    vlc_modcap_t *cap = data;
-
-    free(cap->modv);
-    free(cap->name);
-    free(cap);
+    const char *const *name = a;
+    const vlc_modcap_t *cap = b;
+    return strcmp(*name, cap->name);
 }
 
 static int vlc_module_cmp (const void *a, const void *b)
 {
     const module_t *const *ma = a, *const *mb = b;
+    int ret = strcmp(module_get_capability(*ma), module_get_capability(*mb));
+    if (ret != 0)
+        return ret;
     /* Note that qsort() uses _ascending_ order,
      * so the smallest module is the one with the biggest score. */
     return (*mb)->i_score - (*ma)->i_score;
 }
 
-static void vlc_modcap_sort(const void *node, const VISIT which,
-                            const int depth)
-{
-    vlc_modcap_t *const *cp = node, *cap = *cp;
-
-    if (which != postorder && which != leaf)
-        return;
-
-    qsort(cap->modv, cap->modc, sizeof (*cap->modv), vlc_module_cmp);
-    (void) depth;
-}
-
 static struct
 {
     vlc_mutex_t lock;
     block_t *caches;
-    void *caps_tree;
+    module_t **modv; /**< All modules, by capability then by score */
+    vlc_modcap_t *capv; /**< Capabilities, by name */
+    size_t capc;
     unsigned usage;
-} modules = { VLC_STATIC_MUTEX, NULL, NULL, 0 };
+} modules = { VLC_STATIC_MUTEX, NULL, NULL, NULL, 0, 0 };
 
 vlc_plugin_t *vlc_plugins = NULL;
 
 /**
- * Adds a module to the bank
+ * (Re)builds the table of modules by capability.
+ *
+ * All modules are sorted once in a single table, so that each capability is
+ * a contiguous range of it. Capability names are not copied: they belong to
+ * the modules (or to the plugins cache) for the whole lifetime of the bank.
+ *
+ * On error, the previous table is dropped rather than left stale, and
+ * capabilities are then looked up by scanning all modules.
  */
-static int vlc_module_store(module_t *mod)
+static int vlc_modcap_index(void)
 {
-    const char *name = module_get_capability(mod);
-    vlc_modcap_t *cap = malloc(sizeof (*cap));
-    if (unlikely(cap == NULL))
-        return -1;
-
-    cap->name = strdup(name);
-    cap->modv = NULL;
-    cap->modc = 0;
+    vlc_mutex_assert(&modules.lock);
 
-    if (unlikely(cap->name == NULL))
-        goto error;
+    size_t modc = 0, capc = 0;
 
-    vlc_modcap_t **cp = tsearch(cap, &modules.caps_tree, vlc_modcap_cmp);
-    if (unlikely(cp == NULL))
-        goto error;
+    for (vlc_plugin_t *lib = vlc_plugins; lib != NULL; lib = lib->next)
+        modc += lib->modules_count;
 
-    if (*cp != cap)
+    module_t **modv = vlc_alloc(modc, sizeof (*modv));
+    vlc_modcap_t *capv = vlc_alloc(modc, sizeof (*capv));
+    if (unlikely(modv == NULL || capv == NULL))
     {
-        vlc_modcap_free(cap);
-        cap = *cp;
+        free(capv);
+        free(modv);
+        free(modules.capv);
+        free(modules.modv);
+        modules.modv = NULL;
+        modules.capv = NULL;
+        modules.capc = 0;
+        return -1;
     }
 
-    module_t **modv = realloc(cap->modv, sizeof (*modv) * (cap->modc + 1));
-    if (unlikely(modv == NULL))
-        return -1;
+    modc = 0;
+    for (vlc_plugin_t *lib = vlc_plugins; lib != NULL; lib = lib->next)
+        for (module_t *m = lib->module; m != NULL; m = m->next)
+            modv[modc++] = m;
+
+    qsort(modv, modc, sizeof (*modv), vlc_module_cmp);
+
+    for (size_t i = 0; i < modc; i++)
+    {
+        const char *name = module_get_capability(modv[i]);
 
-    cap->modv = modv;
-    cap->modv[cap->modc] = mod;
-    cap->modc++;
+        if (capc == 0 || strcmp(capv[capc - 1].name, name))
+        {
+            capv[capc].name = name;
+            capv[capc].modv = modv + i;
+            capv[capc].modc = 0;
+            capc++;
+        }
+        capv[capc - 1].modc++;
+    }
+
+    free(modules.capv);
+    free(modules.modv);
+    modules.modv = modv;
+    modules.capv = capv;
+    modules.capc = capc;
     return 0;
-error:
-    vlc_modcap_free(cap);
-    return -1;
 }
 
 /**
@@ -150,9 +154,6 @@ static void vlc_plugin_store(vlc_plugin_t *lib)
 
     lib->next = vlc_plugins;
     vlc_plugins = lib;
-
-    for (module_t *m = lib->module; m != NULL; m = m->next)
-        vlc_module_store(m);
 }
 
 /**
@@ -596,6 +597,8 @@ void module_InitBank (void)
         vlc_plugin_t *plugin = module_InitStatic(vlc_entry__core);
         if (likely(plugin != NULL))
             vlc_plugin_store(plugin);
+        if (vlc_modcap_index ())
+            fprintf (stderr, "LibVLC: cannot index modules by capability\n");
         config_SortConfig ();
     }
     modules.usage++;
@@ -618,7 +621,8 @@ void module_EndBank (bool b_plugins)
 {
     vlc_plugin_t *libs = NULL;
     block_t *caches = NULL;
-    void *caps_tree = NULL;
+    module_t **modv = NULL;
+    vlc_modcap_t *capv = NULL;
 
     /* If plugins were _not_ loaded, then the caller still has the bank lock
      * from module_InitBank(). */
@@ -633,14 +637,18 @@ void module_EndBank (bool b_plugins)
         config_UnsortConfig ();
         libs = vlc_plugins;
         caches = modules.caches;
-        caps_tree = modules.caps_tree;
+        modv = modules.modv;
+        capv = modules.capv;
         vlc_plugins = NULL;
         modules.caches = NULL;
-        modules.caps_tree = NULL;
+        modules.modv = NULL;
+        modules.capv = NULL;
+        modules.capc = 0;
     }
     vlc_mutex_unlock (&modules.lock);
 
-    tdestroy(caps_tree, vlc_modcap_free);
+    free(capv);
+    free(modv);
 
     while (libs != NULL)
     {
@@ -675,7 +683,8 @@ void module_LoadPlugins(vlc_object_t *obj)
         config_UnsortConfig ();
         config_SortConfig ();
 
-        twalk(modules.caps_tree, vlc_modcap_sort);
+        if (vlc_modcap_index ())
+            msg_Warn (obj, "cannot index modules by capability");
     }
     vlc_mutex_unlock (&modules.lock);
 
@@ -727,6 +736,36 @@ module_t **module_list_get (size_t *n)
     return tab;
 }
 
+/**
+ * Builds the list of modules with a given capability without the index.
+ */
+static ssize_t vlc_modcap_scan(module_t ***restrict list, const char *name)
+{
+    size_t total, n = 0;
+    module_t **tab = module_list_get(&total);
+
+    if (tab == NULL)
+    {
+        *list = NULL;
+        return (vlc_plugins != NULL) ? -1 : 0;
+    }
+
+    for (size_t i = 0; i < total; i++)
+        if (!strcmp(module_get_capability(tab[i]), name))
+            tab[n++] = tab[i];
+
+    if (n == 0)
+    {
+        free(tab);
+        tab = NULL;
+    }
+    else
+        qsort(tab, n, sizeof (*tab), vlc_module_cmp);
+
+    *list = tab;
+    return n;
+}
+
 /**
  * Builds a sorted list of all VLC modules with a given capability.
  * The list is sorted from the highest module score to the lowest.
@@ -737,14 +776,17 @@ module_t **module_list_get (size_t *n)
  */
 ssize_t module_list_cap (module_t ***restrict list, const char *name)
 {
-    const vlc_modcap_t **cp = tfind(&name, &modules.caps_tree, vlc_modcap_cmp);
-    if (cp == NULL)
+    if (unlikely(modules.capv == NULL))
+        return vlc_modcap_scan(list, name);
+
+    const vlc_modcap_t *cap = bsearch(&name, modules.capv, modules.capc,
+                                      sizeof (*cap), vlc_modcap_cmp);
+    if (cap == NULL)
     {
         *list = NULL;
         return 0;
     }
 
-    const vlc_modcap_t *cap = *cp;
     size_t n = cap->modc;
     module_t **tab = vlc_alloc (n, sizeof (*tab));
     *list = tab;
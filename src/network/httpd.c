@@ -68,10 +68,26 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* Maximum number of stream chunks written with a single writev() */
+#define HTTPD_STREAM_IOV 64
+
+typedef struct httpd_stream_chunk httpd_stream_chunk_t;
+
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+static void httpd_StreamChunkRelease(httpd_stream_chunk_t *chunk);
+
+/* each worker runs in its own thread and serves its own clients */
+typedef struct
+{
+    httpd_host_t *host;
+    vlc_thread_t thread;
+    vlc_mutex_t  lock;
 
-/* each host run in his own thread */
+    size_t client_count;
+    struct vlc_list clients;
+} httpd_worker_t;
+
+/* each host runs in one or more worker threads */
 struct httpd_host_t
 {
     struct vlc_object_t obj;
@@ -85,9 +101,13 @@ struct httpd_host_t
     unsigned     nfd;
     unsigned     port;
 
-    vlc_thread_t thread;
+    /* workers, all accepting connections from the same sockets */
+    httpd_worker_t *workers;
+    unsigned        worker_count;
+
     vlc_mutex_t lock;
     vlc_cond_t  wait;
+    vlc_mutex_t cb_lock; /* serializes the callbacks of non-concurrent urls */
 
     /* all registered url (becarefull that 2 httpd_url_t could point at the same url)
      * This will slow down the url research but make my live easier
@@ -95,9 +115,6 @@ struct httpd_host_t
      * */
     struct vlc_list urls;
 
-    size_t client_count;
-    struct vlc_list clients;
-
     /* TLS data */
     vlc_tls_server_t *p_tls;
 };
@@ -108,6 +125,8 @@ struct httpd_url_t
     httpd_host_t *host;
     struct vlc_list node;
     vlc_mutex_t lock;
+    unsigned refs; /* callbacks in progress, protected by the host lock */
+    bool b_concurrent; /* callbacks can run from several workers at once */
 
     char      *psz_url;
     char      *psz_user;
@@ -162,6 +181,11 @@ struct httpd_client_t
      */
     int64_t i_keyframe_wait_to_pass;
 
+    /* Stream mode: chunk being sent (referenced) and offset within it */
+    httpd_stream_t       *p_stream;
+    httpd_stream_chunk_t *p_chunk;
+    size_t               i_chunk_offset;
+
     /* */
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
@@ -566,6 +590,7 @@ httpd_redirect_t *httpd_RedirectNew(httpd_host_t *host, const char *psz_url_dst,
         return NULL;
     }
     memcpy(rdir->dst, psz_url_dst, dstlen + 1);
+    httpd_UrlSetConcurrent(rdir->url); /* stateless */
 
     /* Redirect apply for all HTTP request and RTSP DESCRIBE resquest */
     httpd_UrlCatch(rdir->url, HTTPD_MSG_HEAD, httpd_RedirectCallBack,
@@ -607,9 +632,15 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* Data is kept as a list of chunks, one per block, shared between all
+     * the clients. Each chunk holds a reference to the next one, so a client
+     * only needs to reference the chunk it is sending. The stream references
+     * the oldest chunk and drops chunks once more than i_buffer_size bytes
+     * follow them. */
+    httpd_stream_chunk_t *p_first;  /* oldest chunk, referenced */
+    httpd_stream_chunk_t *p_last;   /* newest chunk */
+    httpd_stream_chunk_t *p_keyframe; /* chunk of the last keyframe or NULL */
+    int64_t     i_buffer_size;      /* amount of data kept for new clients */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
@@ -618,6 +649,61 @@ struct httpd_stream_t
     httpd_header * p_http_headers;
 };
 
+struct httpd_stream_chunk
+{
+    atomic_uint refs;
+    httpd_stream_chunk_t *next; /* referenced, written once under stream lock */
+    int64_t i_pos;              /* absolute position of p_data[0] */
+    size_t  i_size;
+    const uint8_t *p_data;
+    block_t *p_block;           /* shared with the sender, see block_Share() */
+};
+
+static void httpd_StreamChunkRelease(httpd_stream_chunk_t *chunk)
+{
+    /* Iterate rather than recurse: releasing a chunk may release a long
+     * list of chunks nobody else is referencing. */
+    while (chunk != NULL
+        && atomic_fetch_sub_explicit(&chunk->refs, 1,
+                                     memory_order_acq_rel) == 1) {
+        httpd_stream_chunk_t *next = chunk->next;
+
+        block_Release(chunk->p_block);
+        free(chunk);
+        chunk = next;
+    }
+}
+
+static httpd_stream_chunk_t *httpd_StreamChunkHold(httpd_stream_chunk_t *chunk)
+{
+    atomic_fetch_add_explicit(&chunk->refs, 1, memory_order_relaxed);
+    return chunk;
+}
+
+/* Attach a client to the chunk holding the given position.
+ * Must be called with the stream lock held. */
+static void httpd_StreamAttach(httpd_stream_t *stream, httpd_client_t *cl,
+                               int64_t i_pos)
+{
+    httpd_stream_chunk_t *chunk = stream->p_first;
+
+    if (i_pos < chunk->i_pos) {
+        /* this client isn't fast enough */
+        i_pos = stream->i_buffer_last_pos;
+        chunk = stream->p_last;
+    } else if (stream->p_keyframe != NULL
+            && i_pos >= stream->p_keyframe->i_pos)
+        chunk = stream->p_keyframe;
+
+    while (i_pos >= chunk->i_pos + (int64_t)chunk->i_size
+        && chunk->next != NULL)
+        chunk = chunk->next;
+
+    cl->p_stream = stream;
+    cl->p_chunk = httpd_StreamChunkHold(chunk);
+    cl->i_chunk_offset = __MIN((size_t)(i_pos - chunk->i_pos), chunk->i_size);
+}
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -628,45 +714,47 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
+        int64_t i_pos = answer->i_body_offset;
 
-        if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
+        vlc_mutex_lock(&stream->lock);
+        if (cl->p_chunk == NULL) {
+            if (cl->i_keyframe_wait_to_pass >= 0) {
+                if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass) {
+                    /* still waiting for the next keyframe */
+                    vlc_mutex_unlock(&stream->lock);
+                    return VLC_EGENERIC;
+                }
 
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
+                /* seek to the new keyframe */
+                i_pos = stream->i_last_keyframe_seen_pos;
+                cl->i_keyframe_wait_to_pass = -1;
+            }
 
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
+            if (i_pos >= stream->i_buffer_pos) {
+                vlc_mutex_unlock(&stream->lock);
+                return VLC_EGENERIC;    /* wait, no data available */
+            }
+            httpd_StreamAttach(stream, cl, i_pos);
+        } else if (cl->p_chunk->i_pos < stream->p_first->i_pos) {
+            /* this client isn't fast enough */
+            httpd_StreamChunkRelease(cl->p_chunk);
+            httpd_StreamAttach(stream, cl, stream->i_buffer_last_pos);
         }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
-
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
+        i_pos = cl->p_chunk->i_pos + cl->i_chunk_offset;
+        bool b_data = i_pos < stream->i_buffer_pos;
+        vlc_mutex_unlock(&stream->lock);
 
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
+        if (!b_data)
             return VLC_EGENERIC;    /* wait, no data available */
 
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
-
-        /* using HTTPD_MSG_ANSWER -> data available */
+        /* using HTTPD_MSG_ANSWER -> data available. The data itself is not
+         * copied: httpd_ClientSend() writes it out of the stream chunks. */
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
         answer->i_type   = HTTPD_MSG_ANSWER;
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
-
-        answer->i_body_offset += i_write;
+        answer->i_body_offset = i_pos;
 
         return VLC_SUCCESS;
     } else {
@@ -765,7 +853,9 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_header = 0;
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-    stream->p_buffer = xmalloc(stream->i_buffer_size);
+    stream->p_first = NULL;
+    stream->p_last = NULL;
+    stream->p_keyframe = NULL;
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -774,6 +864,7 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_last_keyframe_seen_pos = 0;
     stream->i_http_headers = 0;
     stream->p_http_headers = NULL;
+    httpd_UrlSetConcurrent(stream->url); /* the stream lock protects it */
 
     httpd_UrlCatch(stream->url, HTTPD_MSG_HEAD, httpd_StreamCallBack,
                     (httpd_callback_sys_t*)stream);
@@ -801,40 +892,56 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
+int httpd_StreamSend(httpd_stream_t *stream, block_t *p_block)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
+    if (!p_block || !p_block->p_buffer || p_block->i_buffer == 0)
+        return VLC_SUCCESS;
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
+    /* No copy of the data: clients send straight out of the shared block */
+    httpd_stream_chunk_t *chunk = malloc(sizeof(*chunk));
+    if (unlikely(chunk == NULL))
+        return VLC_ENOMEM;
 
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+    chunk->p_block = block_Share(p_block);
+    if (unlikely(chunk->p_block == NULL)) {
+        free(chunk);
+        return VLC_ENOMEM;
     }
-
-    stream->i_buffer_pos += i_data;
-}
-
-int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
-{
-    if (!p_block || !p_block->p_buffer)
-        return VLC_SUCCESS;
+    atomic_init(&chunk->refs, 1); /* owned by the previous chunk */
+    chunk->next = NULL;
+    chunk->i_size = p_block->i_buffer;
+    chunk->p_data = chunk->p_block->p_buffer;
 
     vlc_mutex_lock(&stream->lock);
 
     /* save this pointer (to be used by new connection) */
     stream->i_buffer_last_pos = stream->i_buffer_pos;
+    chunk->i_pos = stream->i_buffer_pos;
 
     if (p_block->i_flags & BLOCK_FLAG_TYPE_I) {
         stream->b_has_keyframes = true;
         stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
+        stream->p_keyframe = chunk;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+    if (stream->p_last != NULL)
+        stream->p_last->next = chunk;
+    else
+        stream->p_first = chunk;
+    stream->p_last = chunk;
+    stream->i_buffer_pos += chunk->i_size;
+
+    /* Drop the oldest chunks; clients still sending them keep them alive */
+    while (stream->p_first->next != NULL
+        && stream->i_buffer_pos - stream->p_first->next->i_pos
+                                                    >= stream->i_buffer_size) {
+        httpd_stream_chunk_t *old = stream->p_first;
+
+        stream->p_first = httpd_StreamChunkHold(old->next);
+        if (stream->p_keyframe == old)
+            stream->p_keyframe = NULL;
+        httpd_StreamChunkRelease(old);
+    }
 
     vlc_mutex_unlock(&stream->lock);
     return VLC_SUCCESS;
@@ -851,7 +958,7 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     vlc_mutex_destroy(&stream->lock);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    httpd_StreamChunkRelease(stream->p_first);
     free(stream);
 }
 
@@ -937,7 +1044,9 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
 
     vlc_mutex_init(&host->lock);
     vlc_cond_init(&host->wait);
+    vlc_mutex_init(&host->cb_lock);
     atomic_init(&host->ref, 1);
+    host->workers = NULL;
 
     char *hostname = var_InheritString(p_this, hostvar);
 
@@ -952,13 +1061,32 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
 
     host->port     = port;
     vlc_list_init(&host->urls);
-    host->client_count = 0;
-    vlc_list_init(&host->clients);
     host->p_tls    = p_tls;
 
-    /* create the thread */
-    if (vlc_clone(&host->thread, httpd_HostThread, host,
-                   VLC_THREAD_PRIORITY_LOW)) {
+    /* create the threads */
+    unsigned count = var_InheritInteger(p_this, "http-threads");
+
+    host->workers = vlc_alloc(count, sizeof (*host->workers));
+    if (unlikely(host->workers == NULL))
+        goto error;
+
+    for (host->worker_count = 0; host->worker_count < count;
+         host->worker_count++) {
+        httpd_worker_t *worker = &host->workers[host->worker_count];
+
+        worker->host = host;
+        vlc_mutex_init(&worker->lock);
+        worker->client_count = 0;
+        vlc_list_init(&worker->clients);
+
+        if (vlc_clone(&worker->thread, httpd_HostThread, worker,
+                       VLC_THREAD_PRIORITY_LOW)) {
+            vlc_mutex_destroy(&worker->lock);
+            break;
+        }
+    }
+
+    if (host->worker_count == 0) {
         msg_Err(p_this, "cannot spawn http host thread");
         goto error;
     }
@@ -973,8 +1101,10 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+        free(host->workers);
         net_ListenClose(host->fds);
         vlc_cond_destroy(&host->wait);
+        vlc_mutex_destroy(&host->cb_lock);
         vlc_mutex_destroy(&host->lock);
         vlc_object_delete(host);
     }
@@ -998,20 +1128,29 @@ void httpd_HostDelete(httpd_host_t *host)
     }
 
     vlc_list_remove(&host->node);
-    vlc_cancel(host->thread);
-    vlc_join(host->thread, NULL);
+    for (unsigned i = 0; i < host->worker_count; i++)
+        vlc_cancel(host->workers[i].thread);
+    for (unsigned i = 0; i < host->worker_count; i++)
+        vlc_join(host->workers[i].thread, NULL);
 
     msg_Dbg(host, "HTTP host removed");
 
-    vlc_list_foreach(client, &host->clients, node) {
-        msg_Warn(host, "client still connected");
-        httpd_ClientDestroy(client);
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        httpd_worker_t *worker = &host->workers[i];
+
+        vlc_list_foreach(client, &worker->clients, node) {
+            msg_Warn(host, "client still connected");
+            httpd_ClientDestroy(client);
+        }
+        vlc_mutex_destroy(&worker->lock);
     }
+    free(host->workers);
 
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
     net_ListenClose(host->fds);
     vlc_cond_destroy(&host->wait);
+    vlc_mutex_destroy(&host->cb_lock);
     vlc_mutex_destroy(&host->lock);
     vlc_object_delete(host);
     vlc_mutex_unlock(&httpd.mutex);
@@ -1042,6 +1181,8 @@ httpd_url_t *httpd_UrlNew(httpd_host_t *host, const char *psz_url,
     url->host = host;
 
     vlc_mutex_init(&url->lock);
+    url->refs = 0;
+    url->b_concurrent = false;
     url->psz_url = xstrdup(psz_url);
     url->psz_user = xstrdup(psz_user ? psz_user : "");
     url->psz_password = xstrdup(psz_password ? psz_password : "");
@@ -1051,12 +1192,45 @@ httpd_url_t *httpd_UrlNew(httpd_host_t *host, const char *psz_url,
     }
 
     vlc_list_append(&url->node, &host->urls);
-    vlc_cond_signal(&host->wait);
+    vlc_cond_broadcast(&host->wait); /* wake all the workers up */
     vlc_mutex_unlock(&host->lock);
 
     return url;
 }
 
+/* mark a url whose callbacks can run from several workers at once */
+void httpd_UrlSetConcurrent(httpd_url_t *url)
+{
+    vlc_mutex_lock(&url->lock);
+    url->b_concurrent = true;
+    vlc_mutex_unlock(&url->lock);
+}
+
+/* call back a url, one callback at a time per host unless the url is
+ * known to support concurrent calls */
+static int httpd_UrlCallback(httpd_url_t *url, int i_msg, httpd_client_t *cl,
+                             httpd_message_t *answer,
+                             const httpd_message_t *query)
+{
+    vlc_mutex_lock(&url->lock);
+    httpd_callback_t cb = url->catch[i_msg].cb;
+    httpd_callback_sys_t *cb_sys = url->catch[i_msg].p_sys;
+    bool b_concurrent = url->b_concurrent;
+    vlc_mutex_unlock(&url->lock);
+
+    if (cb == NULL)
+        return VLC_EGENERIC;
+    if (b_concurrent)
+        return cb(cb_sys, cl, answer, query);
+
+    httpd_host_t *host = url->host;
+
+    vlc_mutex_lock(&host->cb_lock);
+    int val = cb(cb_sys, cl, answer, query);
+    vlc_mutex_unlock(&host->cb_lock);
+    return val;
+}
+
 /* register callback on a url */
 int httpd_UrlCatch(httpd_url_t *url, int i_msg, httpd_callback_t cb,
                     httpd_callback_sys_t *p_sys)
@@ -1076,24 +1250,34 @@ void httpd_UrlDelete(httpd_url_t *url)
     httpd_client_t *client;
 
     vlc_mutex_lock(&host->lock);
+    /* Wait for the callbacks in progress, the url stays listed meanwhile */
+    while (url->refs > 0)
+        vlc_cond_wait(&host->wait, &host->lock);
     vlc_list_remove(&url->node);
+    vlc_mutex_unlock(&host->lock);
+
+    /* No client can pick the url anymore, close those using it */
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        httpd_worker_t *worker = &host->workers[i];
+
+        vlc_mutex_lock(&worker->lock);
+        vlc_list_foreach(client, &worker->clients, node) {
+            if (client->url != url)
+                continue;
+
+            /* TODO complete it */
+            msg_Warn(host, "force closing connections");
+            worker->client_count--;
+            httpd_ClientDestroy(client);
+        }
+        vlc_mutex_unlock(&worker->lock);
+    }
 
     vlc_mutex_destroy(&url->lock);
     free(url->psz_url);
     free(url->psz_user);
     free(url->psz_password);
-
-    vlc_list_foreach(client, &host->clients, node) {
-        if (client->url != url)
-            continue;
-
-        /* TODO complete it */
-        msg_Warn(host, "force closing connections");
-        host->client_count--;
-        httpd_ClientDestroy(client);
-    }
     free(url);
-    vlc_mutex_unlock(&host->lock);
 }
 
 static void httpd_MsgInit(httpd_message_t *msg)
@@ -1197,6 +1381,7 @@ static void httpd_ClientDestroy(httpd_client_t *cl)
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
 
+    httpd_StreamChunkRelease(cl->p_chunk);
     free(cl->p_buffer);
     free(cl);
 }
@@ -1209,6 +1394,9 @@ static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock, vlc_tick_t now)
 
     cl->sock    = sock;
     cl->url     = NULL;
+    cl->p_stream = NULL;
+    cl->p_chunk = NULL;
+    cl->i_chunk_offset = 0;
 
     httpd_ClientInit(cl, now);
     return cl;
@@ -1537,10 +1725,86 @@ static void httpd_ClientRecv(httpd_client_t *cl)
         cl->i_activity_timeout = 0;
 }
 
+static void httpd_ClientSendStream(httpd_client_t *cl)
+{
+    httpd_stream_t *stream = cl->p_stream;
+    httpd_stream_chunk_t *chunks[HTTPD_STREAM_IOV];
+    struct iovec iov[HTTPD_STREAM_IOV];
+    httpd_stream_chunk_t *chunk;
+    size_t offset, total = 0;
+    unsigned count = 0;
+    bool b_more;
+
+    /* Gather as many chunks as possible. Those following cl->p_chunk stay
+     * alive without the lock, since every chunk references the next one. */
+    vlc_mutex_lock(&stream->lock);
+    if (cl->p_chunk->i_pos < stream->p_first->i_pos) {
+        /* this client isn't fast enough */
+        httpd_StreamChunkRelease(cl->p_chunk);
+        httpd_StreamAttach(stream, cl, stream->i_buffer_last_pos);
+    }
+    chunk = cl->p_chunk;
+    offset = cl->i_chunk_offset;
+    while (chunk != NULL && count < HTTPD_STREAM_IOV) {
+        chunks[count] = chunk;
+        iov[count].iov_base = (uint8_t *)chunk->p_data + offset;
+        iov[count].iov_len = chunk->i_size - offset;
+        total += iov[count].iov_len;
+        count++;
+        chunk = chunk->next;
+        offset = 0;
+    }
+    b_more = chunk != NULL;
+    vlc_mutex_unlock(&stream->lock);
+
+    if (total == 0) {
+        cl->i_state = HTTPD_CLIENT_SEND_DONE; /* wait for more data */
+        return;
+    }
+
+    ssize_t i_len = cl->sock->ops->writev(cl->sock, iov, count);
+    if (i_len <= 0) {
+#if defined(_WIN32)
+        if (i_len == 0 || WSAGetLastError() != WSAEWOULDBLOCK)
+#else
+        if (i_len == 0 || errno != EAGAIN)
+#endif
+            cl->i_state = HTTPD_CLIENT_DEAD;
+        return;
+    }
+
+    /* Move past what was written */
+    unsigned i = 0;
+    size_t len = i_len;
+
+    while (i < count - 1 && len >= iov[i].iov_len)
+        len -= iov[i++].iov_len;
+
+    if (chunks[i] != cl->p_chunk) {
+        httpd_stream_chunk_t *done = cl->p_chunk;
+
+        cl->p_chunk = httpd_StreamChunkHold(chunks[i]);
+        cl->i_chunk_offset = 0;
+        httpd_StreamChunkRelease(done);
+    }
+    cl->i_chunk_offset += len;
+    cl->answer.i_body_offset = cl->p_chunk->i_pos + cl->i_chunk_offset;
+
+    if (cl->i_chunk_offset >= cl->p_chunk->i_size && !b_more
+     && i == count - 1)
+        cl->i_state = HTTPD_CLIENT_SEND_DONE; /* wait for more data */
+}
+
 static void httpd_ClientSend(httpd_client_t *cl)
 {
     int i_len;
 
+    if (cl->p_chunk != NULL && cl->i_buffer >= cl->i_buffer_size) {
+        /* stream data, shared with the other clients */
+        httpd_ClientSendStream(cl);
+        return;
+    }
+
     if (cl->i_buffer < 0) {
         /* We need to create the header */
         int i_size = 0;
@@ -1586,8 +1850,7 @@ static void httpd_ClientSend(httpd_client_t *cl)
                 httpd_MsgClean(&cl->answer);
                 cl->answer.i_body_offset = i_offset;
 
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                                          &cl->answer, &cl->query);
+                httpd_UrlCallback(cl->url, i_msg, cl, &cl->answer, &cl->query);
             }
 
             if (cl->answer.i_body > 0) {
@@ -1666,9 +1929,10 @@ auth_failed:
     return false;
 }
 
-static void httpdLoop(httpd_host_t *host)
+static void httpdLoop(httpd_worker_t *worker)
 {
-    struct pollfd ufd[host->nfd + host->client_count];
+    httpd_host_t *host = worker->host;
+    struct pollfd ufd[host->nfd + worker->client_count];
     unsigned nfd;
     for (nfd = 0; nfd < host->nfd; nfd++) {
         ufd[nfd].fd = host->fds[nfd];
@@ -1677,25 +1941,27 @@ static void httpdLoop(httpd_host_t *host)
     }
 
     vlc_mutex_lock(&host->lock);
-    /* add all socket that should be read/write and close dead connection */
     while (vlc_list_is_empty(&host->urls)) {
         mutex_cleanup_push(&host->lock);
         vlc_cond_wait(&host->wait, &host->lock);
         vlc_cleanup_pop();
     }
+    vlc_mutex_unlock(&host->lock);
 
     vlc_tick_t now = vlc_tick_now();
     bool b_low_delay = false;
     httpd_client_t *cl;
 
     int canc = vlc_savecancel();
-    vlc_list_foreach(cl, &host->clients, node) {
+    vlc_mutex_lock(&worker->lock);
+    /* add all socket that should be read/write and close dead connection */
+    vlc_list_foreach(cl, &worker->clients, node) {
         int64_t i_offset;
 
         if (cl->i_state == HTTPD_CLIENT_DEAD
          || (cl->i_activity_timeout > 0
           && cl->i_activity_date + cl->i_activity_timeout < now)) {
-            host->client_count--;
+            worker->client_count--;
             httpd_ClientDestroy(cl);
             continue;
         }
@@ -1802,10 +2068,17 @@ static void httpdLoop(httpd_host_t *host)
                         bool b_auth_failed = false;
 
                         /* Search the url and trigger callbacks */
-                        vlc_list_foreach(url, &host->urls, node) {
+                        vlc_mutex_lock(&host->lock);
+                        for (struct vlc_list *node = host->urls.next;
+                             node != &host->urls; node = node->next) {
+                            url = container_of(node, httpd_url_t, node);
                             if (strcmp(url->psz_url, query->psz_url))
                                 continue;
-                            if (!url->catch[i_msg].cb)
+
+                            vlc_mutex_lock(&url->lock);
+                            bool b_catch = url->catch[i_msg].cb != NULL;
+                            vlc_mutex_unlock(&url->lock);
+                            if (!b_catch)
                                 continue;
 
                             if (answer) {
@@ -1816,7 +2089,19 @@ static void httpdLoop(httpd_host_t *host)
                                    break;
                             }
 
-                            if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
+                            /* Run the callback without the host lock, so
+                             * that the other workers can serve their clients
+                             * meanwhile. The reference keeps the url (and its
+                             * node) listed until it returns. */
+                            url->refs++;
+                            vlc_mutex_unlock(&host->lock);
+                            int val = httpd_UrlCallback(url, i_msg, cl,
+                                                        answer, query);
+                            vlc_mutex_lock(&host->lock);
+                            if (--url->refs == 0)
+                                vlc_cond_broadcast(&host->wait);
+
+                            if (val)
                                 continue;
 
                             if (answer->i_proto == HTTPD_PROTO_NONE)
@@ -1829,6 +2114,7 @@ static void httpdLoop(httpd_host_t *host)
                             if (!cl->url)
                                 cl->url = url;
                         }
+                        vlc_mutex_unlock(&host->lock);
 
                         if (answer) {
                             answer->i_proto  = query->i_proto;
@@ -1911,8 +2197,7 @@ static void httpdLoop(httpd_host_t *host)
                 httpd_MsgInit(&cl->answer);
                 cl->answer.i_body_offset = i_offset;
 
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                        &cl->answer, &cl->query);
+                httpd_UrlCallback(cl->url, i_msg, cl, &cl->answer, &cl->query);
                 if (cl->answer.i_type != HTTPD_MSG_NONE) {
                     /* we have new data, so re-enter send mode */
                     cl->i_buffer      = 0;
@@ -1931,7 +2216,7 @@ static void httpdLoop(httpd_host_t *host)
         else
             b_low_delay = true;
     }
-    vlc_mutex_unlock(&host->lock);
+    vlc_mutex_unlock(&worker->lock);
     vlc_restorecancel(canc);
 
     /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
@@ -1942,13 +2227,13 @@ static void httpdLoop(httpd_host_t *host)
     }
 
     canc = vlc_savecancel();
-    vlc_mutex_lock(&host->lock);
+    vlc_mutex_lock(&worker->lock);
 
     /* Handle client sockets */
     now = vlc_tick_now();
     nfd = host->nfd;
 
-    vlc_list_foreach(cl, &host->clients, node) {
+    vlc_list_foreach(cl, &worker->clients, node) {
         const struct pollfd *pufd = &ufd[nfd];
 
         assert(pufd < &ufd[sizeof(ufd) / sizeof(ufd[0])]);
@@ -2013,20 +2298,20 @@ static void httpdLoop(httpd_host_t *host)
         if (host->p_tls != NULL)
             cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
 
-        host->client_count++;
-        vlc_list_append(&cl->node, &host->clients);
+        worker->client_count++;
+        vlc_list_append(&cl->node, &worker->clients);
     }
 
-    vlc_mutex_unlock(&host->lock);
+    vlc_mutex_unlock(&worker->lock);
     vlc_restorecancel(canc);
 }
 
 static void* httpd_HostThread(void *data)
 {
-    httpd_host_t *host = data;
+    httpd_worker_t *worker = data;
 
-    while (atomic_load_explicit(&host->ref, memory_order_relaxed) > 0)
-        httpdLoop(host);
+    while (atomic_load_explicit(&worker->host->ref, memory_order_relaxed) > 0)
+        httpdLoop(worker);
     return NULL;
 }
 
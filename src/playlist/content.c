@@ -37,6 +37,76 @@ vlc_playlist_ClearItems(vlc_playlist_t *playlist)
     vlc_vector_foreach(item, &playlist->items)
         vlc_playlist_item_Release(item);
     vlc_vector_clear(&playlist->items);
+    vlc_hashmap_Clean(&playlist->media_index);
+    vlc_hashmap_Clean(&playlist->id_index);
+    playlist->moved = 0;
+}
+
+static void
+vlc_playlist_UnindexItems(vlc_playlist_t *playlist,
+                          vlc_playlist_item_t *const items[], size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        vlc_playlist_item_t *item = items[i];
+        bool found = vlc_hashmap_Remove(&playlist->media_index,
+                                        vlc_hashmap_PtrKey(item->media), item);
+        found = vlc_hashmap_Remove(&playlist->id_index, item->id, item)
+             && found;
+        assert(found); VLC_UNUSED(found);
+    }
+}
+
+static int
+vlc_playlist_IndexItems(vlc_playlist_t *playlist,
+                        vlc_playlist_item_t *const items[], size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        vlc_playlist_item_t *item = items[i];
+        if (vlc_hashmap_Add(&playlist->media_index,
+                            vlc_hashmap_PtrKey(item->media), item))
+        {
+            vlc_playlist_UnindexItems(playlist, items, i);
+            return VLC_ENOMEM;
+        }
+        if (vlc_hashmap_Add(&playlist->id_index, item->id, item))
+        {
+            vlc_hashmap_Remove(&playlist->media_index,
+                               vlc_hashmap_PtrKey(item->media), item);
+            vlc_playlist_UnindexItems(playlist, items, i);
+            return VLC_ENOMEM;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+/* the positions of the items from index may have changed */
+static void
+vlc_playlist_ItemsShifted(vlc_playlist_t *playlist, size_t index)
+{
+    if (playlist->moved > index)
+        playlist->moved = index;
+}
+
+/* return the position of an item, or -1 if it is not in the playlist */
+static ssize_t
+vlc_playlist_FindIndex(vlc_playlist_t *playlist,
+                       const vlc_playlist_item_t *item)
+{
+    playlist_item_vector_t *items = &playlist->items;
+
+    if (item->index < items->size && items->data[item->index] == item)
+        return item->index;
+
+    /* the item has moved, update the positions of the moved items at once */
+    for (size_t i = playlist->moved; i < items->size; ++i)
+        items->data[i]->index = i;
+    playlist->moved = items->size;
+
+    if (item->index < items->size && items->data[item->index] == item)
+        return item->index;
+    return -1;
 }
 
 static void
@@ -197,9 +267,7 @@ vlc_playlist_IndexOf(vlc_playlist_t *playlist, const vlc_playlist_item_t *item)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    ssize_t index;
-    vlc_vector_index_of(&playlist->items, item, &index);
-    return index;
+    return vlc_playlist_FindIndex(playlist, item);
 }
 
 ssize_t
@@ -207,11 +275,19 @@ vlc_playlist_IndexOfMedia(vlc_playlist_t *playlist, const input_item_t *media)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->media == media)
-            return i;
-    return -1;
+    /* the same media may be present several times: return the first one */
+    ssize_t index = -1;
+    for (const struct vlc_hashmap_entry *entry =
+             vlc_hashmap_Find(&playlist->media_index,
+                              vlc_hashmap_PtrKey(media));
+         entry != NULL; entry = vlc_hashmap_FindNext(entry))
+    {
+        ssize_t i = vlc_playlist_FindIndex(playlist, entry->value);
+        assert(i != -1);
+        if (index == -1 || i < index)
+            index = i;
+    }
+    return index;
 }
 
 ssize_t
@@ -219,11 +295,8 @@ vlc_playlist_IndexOfId(vlc_playlist_t *playlist, uint64_t id)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->id == id)
-            return i;
-    return -1;
+    vlc_playlist_item_t *item = vlc_hashmap_Get(&playlist->id_index, id);
+    return item != NULL ? vlc_playlist_FindIndex(playlist, item) : -1;
 }
 
 void
@@ -251,7 +324,7 @@ vlc_playlist_MediaToItems(vlc_playlist_t *playlist, input_item_t *const media[],
         if (unlikely(!items[i]))
             break;
     }
-    if (i < count)
+    if (i < count || vlc_playlist_IndexItems(playlist, items, count))
     {
         /* allocation failure, release partial items */
         while (i)
@@ -281,6 +354,7 @@ vlc_playlist_Insert(vlc_playlist_t *playlist, size_t index,
         vlc_vector_remove_slice(&playlist->items, index, count);
         return ret;
     }
+    vlc_playlist_ItemsShifted(playlist, index);
 
     vlc_playlist_ItemsInserted(playlist, index, count);
     vlc_player_InvalidateNextMedia(playlist->player);
@@ -297,6 +371,7 @@ vlc_playlist_Move(vlc_playlist_t *playlist, size_t index, size_t count,
     assert(target + count <= playlist->items.size);
 
     vlc_vector_move_slice(&playlist->items, index, count, target);
+    vlc_playlist_ItemsShifted(playlist, index < target ? index : target);
 
     vlc_playlist_ItemsMoved(playlist, index, count, target);
     vlc_player_InvalidateNextMedia(playlist->player);
@@ -309,11 +384,13 @@ vlc_playlist_Remove(vlc_playlist_t *playlist, size_t index, size_t count)
     assert(index < playlist->items.size);
 
     vlc_playlist_ItemsRemoving(playlist, index, count);
+    vlc_playlist_UnindexItems(playlist, &playlist->items.data[index], count);
 
     for (size_t i = 0; i < count; ++i)
         vlc_playlist_item_Release(playlist->items.data[index + i]);
 
     vlc_vector_remove_slice(&playlist->items, index, count);
+    vlc_playlist_ItemsShifted(playlist, index);
 
     bool current_media_changed = vlc_playlist_ItemsRemoved(playlist, index,
                                                            count);
@@ -335,6 +412,12 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
     if (!item)
         return VLC_ENOMEM;
 
+    if (vlc_playlist_IndexItems(playlist, &item, 1))
+    {
+        vlc_playlist_item_Release(item);
+        return VLC_ENOMEM;
+    }
+
     if (playlist->order == VLC_PLAYLIST_PLAYBACK_ORDER_RANDOM)
     {
         randomizer_Remove(&playlist->randomizer,
@@ -342,8 +425,10 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
         randomizer_Add(&playlist->randomizer, &item, 1);
     }
 
+    vlc_playlist_UnindexItems(playlist, &playlist->items.data[index], 1);
     vlc_playlist_item_Release(playlist->items.data[index]);
     playlist->items.data[index] = item;
+    item->index = index;
 
     vlc_playlist_ItemReplaced(playlist, index);
     return VLC_SUCCESS;
@@ -379,6 +464,7 @@ vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
                 vlc_vector_remove_slice(&playlist->items, index + 1, count - 1);
                 return ret;
             }
+            vlc_playlist_ItemsShifted(playlist, index + 1);
             vlc_playlist_ItemsInserted(playlist, index + 1, count - 1);
         }
 
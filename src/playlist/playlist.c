@@ -45,6 +45,9 @@ vlc_playlist_New(vlc_object_t *parent)
     }
 
     vlc_vector_init(&playlist->items);
+    vlc_hashmap_Init(&playlist->media_index);
+    vlc_hashmap_Init(&playlist->id_index);
+    playlist->moved = 0;
     randomizer_Init(&playlist->randomizer);
     playlist->current = -1;
     playlist->has_prev = false;
@@ -1065,6 +1065,68 @@ test_index_of(void)
     vlc_playlist_Delete(playlist);
 }
 
+static void
+test_index_of_after_changes(void)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL);
+    assert(playlist);
+
+    input_item_t *media[10];
+    CreateDummyMediaArray(media, 10);
+
+    int ret = vlc_playlist_Append(playlist, media, 8);
+    assert(ret == VLC_SUCCESS);
+
+    /* the same media twice */
+    ret = vlc_playlist_Append(playlist, &media[2], 1);
+    assert(ret == VLC_SUCCESS);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[2]) == 2);
+
+    vlc_playlist_item_t *item = vlc_playlist_Get(playlist, 5);
+    uint64_t id = vlc_playlist_item_GetId(item);
+    assert(vlc_playlist_IndexOfId(playlist, id) == 5);
+
+    /* [0 1 2 3 4 5 6 7 2] -> [0 1 2 9 3 4 5 6 7 2] */
+    ret = vlc_playlist_Insert(playlist, 3, &media[9], 1);
+    assert(ret == VLC_SUCCESS);
+    assert(vlc_playlist_IndexOf(playlist, item) == 6);
+    assert(vlc_playlist_IndexOfId(playlist, id) == 6);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[9]) == 3);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[7]) == 8);
+
+    /* -> [5 6 0 1 2 9 3 4 7 2] */
+    vlc_playlist_Move(playlist, 6, 2, 0);
+    assert(vlc_playlist_IndexOfId(playlist, id) == 0);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[3]) == 6);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[2]) == 4);
+
+    /* -> [5 6 0 1 9 3 4 7 2] */
+    vlc_playlist_RemoveOne(playlist, 4);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[2]) == 8);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[9]) == 4);
+
+    vlc_playlist_Remove(playlist, 0, 1);
+    assert(vlc_playlist_IndexOfId(playlist, id) == -1);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[5]) == -1);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[7]) == 6);
+
+    vlc_playlist_Shuffle(playlist);
+    for (size_t i = 0; i < vlc_playlist_Count(playlist); ++i)
+    {
+        item = vlc_playlist_Get(playlist, i);
+        assert(vlc_playlist_IndexOf(playlist, item) == (ssize_t) i);
+        assert(vlc_playlist_IndexOfId(playlist,
+                                      vlc_playlist_item_GetId(item)) ==
+               (ssize_t) i);
+    }
+
+    vlc_playlist_Clear(playlist);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[0]) == -1);
+
+    DestroyMediaArray(media, 10);
+    vlc_playlist_Delete(playlist);
+}
+
 static void
 test_prev(void)
 {
@@ -2264,6 +2326,7 @@ int main(void)
     test_playback_order_changed_callbacks();
     test_callbacks_on_add_listener();
     test_index_of();
+    test_index_of_after_changes();
     test_prev();
     test_next();
     test_goto();
@@ -29,6 +29,8 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_threads.h>
+#include "../../lib/libvlc_internal.h"
 
 static const char text[] =
     "This is a test!\n"
@@ -86,11 +88,204 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+#define THREADS 4
+#define LOOPS 20000
+
+static const size_t sizes[] = { 0, 1, 100, 188, 1316, 4000, 16384, 60000,
+                                100000 };
+
+static void check_block(const block_t *block, size_t size, uint8_t val)
+{
+    assert(block->i_buffer == size);
+    for (size_t i = 0; i < size; i++)
+        assert(block->p_buffer[i] == val);
+}
+
+/* Allocates blocks, and releases them on another thread through a FIFO */
+static void *producer(void *data)
+{
+    block_fifo_t *fifo = data;
+
+    for (unsigned i = 0; i < LOOPS; i++)
+    {
+        size_t size = sizes[i % ARRAY_SIZE(sizes)];
+        block_t *block = block_Alloc(size);
+
+        assert(block != NULL);
+        memset(block->p_buffer, i & 0xff, size);
+
+        if (i & 1)
+        {   /* Grow the block, possibly into another size class */
+            block = block_Realloc(block, 16, size + 1000);
+            assert(block != NULL);
+            memset(block->p_buffer, i & 0xff, block->i_buffer);
+        }
+        block->i_dts = i + 1;
+        block_FifoPut(fifo, block);
+    }
+    block_FifoPut(fifo, block_Alloc(0)); /* end marker */
+    return NULL;
+}
+
+static void *consumer(void *data)
+{
+    block_fifo_t *fifo = data;
+
+    for (;;)
+    {
+        block_t *block = block_FifoGet(fifo);
+        if (block->i_dts == VLC_TICK_INVALID)
+        {
+            block_Release(block);
+            break;
+        }
+
+        unsigned i = block->i_dts - 1;
+        size_t size = sizes[i % ARRAY_SIZE(sizes)];
+
+        check_block(block, (i & 1) ? 16 + size + 1000 : size, i & 0xff);
+        block_Release(block);
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    block_fifo_t *fifos[THREADS];
+    vlc_thread_t th[2 * THREADS];
+
+    for (unsigned i = 0; i < THREADS; i++)
+    {
+        fifos[i] = block_FifoNew();
+        assert(fifos[i] != NULL);
+        assert(!vlc_clone(&th[2 * i], producer, fifos[i],
+                          VLC_THREAD_PRIORITY_LOW));
+        assert(!vlc_clone(&th[2 * i + 1], consumer, fifos[i],
+                          VLC_THREAD_PRIORITY_LOW));
+    }
+
+    for (unsigned i = 0; i < 2 * THREADS; i++)
+        vlc_join(th[i], NULL);
+    for (unsigned i = 0; i < THREADS; i++)
+        block_FifoRelease(fifos[i]);
+}
+
+static void test_reuse(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        block_t *block = block_Alloc(sizes[i]);
+        assert(block != NULL);
+        assert(((uintptr_t)block->p_buffer % 32) == 0);
+        memset(block->p_buffer, 0x47, sizes[i]);
+        check_block(block, sizes[i], 0x47);
+
+        block_t *dup = block_Duplicate(block);
+        assert(dup != NULL);
+        check_block(dup, sizes[i], 0x47);
+        block_Release(block);
+
+        /* The recycled block must be fully reset */
+        block = block_Alloc(sizes[i]);
+        assert(block != NULL);
+        assert(block->p_next == NULL && block->i_flags == 0);
+        assert(block->i_pts == VLC_TICK_INVALID);
+        block_Release(block);
+        block_Release(dup);
+    }
+}
+
+static void test_share(void)
+{
+    block_t *block = block_Alloc(1000);
+    assert(block != NULL);
+    memset(block->p_buffer, 0x47, block->i_buffer);
+    block->i_dts = 42;
+    assert(!block_IsShared(block));
+
+    block_t *a = block_Share(block);
+    block_t *b = block_Share(a);
+    assert(a != NULL && b != NULL);
+    assert(a->p_buffer == block->p_buffer && b->p_buffer == block->p_buffer);
+    assert(a->i_dts == 42 && b->i_dts == 42);
+    assert(block_IsShared(block) && block_IsShared(a) && block_IsShared(b));
+
+    /* The first header to prepend uses the spare room in place */
+    const uint8_t *payload = block->p_buffer;
+    a = block_Realloc(a, 4, a->i_buffer);
+    assert(a != NULL);
+    assert(a->p_buffer + 4 == payload);
+    memset(a->p_buffer, 0x12, 4);
+
+    /* The spare room is taken: the next ones copy */
+    b = block_Realloc(b, 8, b->i_buffer);
+    assert(b != NULL);
+    assert(b->p_buffer + 8 != payload);
+    memset(b->p_buffer, 0x34, 8);
+    check_block(block, 1000, 0x47);
+
+    /* Shrinking is fine, but must not allow growing into the payload */
+    block = block_Realloc(block, -10, block->i_buffer);
+    assert(block != NULL);
+    assert(block->p_buffer == payload + 10);
+    block = block_Realloc(block, 10, block->i_buffer);
+    assert(block != NULL);
+    assert(block->p_buffer != payload);
+    memset(block->p_buffer, 0x56, 10);
+    for (size_t i = 10; i < block->i_buffer; i++)
+        assert(block->p_buffer[i] == 0x47);
+
+    for (size_t i = 0; i < 4; i++)
+        assert(a->p_buffer[i] == 0x12);
+    for (size_t i = 4; i < a->i_buffer; i++)
+        assert(a->p_buffer[i] == 0x47);
+    block_Release(b);
+    block_Release(block);
+
+    /* Only a shared payload is copied to be written */
+    block_t *c = block_Share(a);
+    assert(c != NULL);
+    c = block_MakeWritable(c);
+    assert(c != NULL && !block_IsShared(c) && c->i_dts == 42);
+    assert(c->i_buffer == 1004 && c->p_buffer[0] == 0x12);
+    assert(!block_IsShared(a));
+    assert(block_MakeWritable(a) == a);
+    block_Release(c);
+    block_Release(a);
+}
+
+static void test_pool(void)
+{
+    static const char *argv[] = { "libvlc", "--block-pool" };
+    uintmax_t hits, misses, bytes;
+
+    libvlc_int_t *vlc = libvlc_InternalCreate();
+    assert(vlc != NULL);
+    assert(libvlc_InternalInit(vlc, ARRAY_SIZE(argv), argv) == VLC_SUCCESS);
+
+    test_reuse();
+    test_share();
+    test_threads();
+    test_reuse();
+
+    block_PoolStats(&hits, &misses, &bytes);
+    assert(hits > 0 && misses > 0);
+
+    libvlc_InternalCleanup(vlc);
+    libvlc_InternalDestroy(vlc);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+
+    /* Without, then with the pool */
+    test_reuse();
+    test_share();
+    test_threads();
+    test_pool();
     return 0;
 }
 
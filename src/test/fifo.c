@@ -0,0 +1,200 @@
+/*****************************************************************************
+ * fifo.c: Test and benchmark for block FIFOs
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#define BLOCKS 64
+#define COUNT 1000000
+
+/* The same few blocks go round between the producer and the consumer, so
+ * that the allocator does not get in the way of the measurement. */
+static block_t blocks[BLOCKS];
+static const struct vlc_block_callbacks cbs = { NULL };
+
+static void init_blocks(void)
+{
+    for (unsigned i = 0; i < BLOCKS; i++)
+        block_Init(&blocks[i], &cbs, NULL, i);
+}
+
+struct bench
+{
+    void *fifo;
+    vlc_sem_t free; /* blocks the producer may send */
+};
+
+static void *consume_mutex(void *data)
+{
+    struct bench *b = data;
+
+    for (unsigned i = 0; i < COUNT; i++)
+    {
+        block_t *block = block_FifoGet(b->fifo);
+
+        assert(block == &blocks[i % BLOCKS]);
+        vlc_sem_post(&b->free);
+    }
+    return NULL;
+}
+
+static void *consume_spsc(void *data)
+{
+    struct bench *b = data;
+
+    for (unsigned i = 0; i < COUNT; i++)
+    {
+        block_t *block = vlc_spsc_fifo_Dequeue(b->fifo);
+
+        assert(block == &blocks[i % BLOCKS]);
+        vlc_sem_post(&b->free);
+    }
+    return NULL;
+}
+
+static void report(const char *name, vlc_tick_t start)
+{
+    vlc_tick_t duration = vlc_tick_now() - start;
+
+    printf("%-10s: %6.2f Mblocks/s\n", name,
+           COUNT * (double)CLOCK_FREQ / duration / 1e6);
+}
+
+static void bench_mutex(void)
+{
+    struct bench b;
+    vlc_thread_t th;
+
+    b.fifo = block_FifoNew();
+    assert(b.fifo != NULL);
+    vlc_sem_init(&b.free, BLOCKS);
+
+    vlc_tick_t start = vlc_tick_now();
+    assert(!vlc_clone(&th, consume_mutex, &b, VLC_THREAD_PRIORITY_LOW));
+    for (unsigned i = 0; i < COUNT; i++)
+    {
+        vlc_sem_wait(&b.free);
+        block_FifoPut(b.fifo, &blocks[i % BLOCKS]);
+    }
+    vlc_join(th, NULL);
+    report("mutex", start);
+
+    assert(block_FifoCount(b.fifo) == 0);
+    vlc_sem_destroy(&b.free);
+    block_FifoRelease(b.fifo);
+}
+
+static void bench_spsc(void)
+{
+    struct bench b;
+    vlc_thread_t th;
+
+    b.fifo = vlc_spsc_fifo_New(BLOCKS);
+    assert(b.fifo != NULL);
+    vlc_sem_init(&b.free, BLOCKS);
+
+    vlc_tick_t start = vlc_tick_now();
+    assert(!vlc_clone(&th, consume_spsc, &b, VLC_THREAD_PRIORITY_LOW));
+    for (unsigned i = 0; i < COUNT; i++)
+    {
+        vlc_sem_wait(&b.free);
+        assert(vlc_spsc_fifo_TryQueue(b.fifo, &blocks[i % BLOCKS]));
+    }
+    vlc_join(th, NULL);
+    report("lock-free", start);
+
+    assert(vlc_spsc_fifo_GetCount(b.fifo) == 0);
+    vlc_sem_destroy(&b.free);
+    vlc_spsc_fifo_Delete(b.fifo);
+}
+
+static void *consume_full(void *data)
+{
+    vlc_spsc_fifo_t *fifo = data;
+
+    for (unsigned i = 0; i < COUNT; i++)
+    {
+        block_t *block = vlc_spsc_fifo_Dequeue(fifo);
+        assert(block == &blocks[i % BLOCKS]);
+    }
+    return NULL;
+}
+
+/* Small capacity: both threads keep sleeping on each other */
+static void test_spsc_full(void)
+{
+    vlc_spsc_fifo_t *fifo = vlc_spsc_fifo_New(3);
+    vlc_thread_t th;
+
+    assert(fifo != NULL);
+    assert(!vlc_clone(&th, consume_full, fifo, VLC_THREAD_PRIORITY_LOW));
+    for (unsigned i = 0; i < COUNT; i++)
+        vlc_spsc_fifo_Queue(fifo, &blocks[i % BLOCKS]);
+    vlc_join(th, NULL);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 0);
+    vlc_spsc_fifo_Delete(fifo);
+}
+
+static void test_spsc_accounting(void)
+{
+    vlc_spsc_fifo_t *fifo = vlc_spsc_fifo_New(5);
+    size_t bytes = 0;
+
+    assert(fifo != NULL);
+    assert(vlc_spsc_fifo_TryDequeue(fifo) == NULL);
+
+    /* Capacity is rounded up to 8 */
+    for (unsigned i = 0; i < 8; i++)
+    {
+        assert(vlc_spsc_fifo_TryQueue(fifo, &blocks[i]));
+        bytes += blocks[i].i_buffer;
+        assert(vlc_spsc_fifo_GetCount(fifo) == i + 1);
+        assert(vlc_spsc_fifo_GetBytes(fifo) == bytes);
+    }
+    assert(!vlc_spsc_fifo_TryQueue(fifo, &blocks[8]));
+
+    for (unsigned i = 0; i < 8; i++)
+    {
+        assert(vlc_spsc_fifo_TryDequeue(fifo) == &blocks[i]);
+        bytes -= blocks[i].i_buffer;
+        assert(vlc_spsc_fifo_GetBytes(fifo) == bytes);
+    }
+    assert(vlc_spsc_fifo_GetCount(fifo) == 0);
+    assert(vlc_spsc_fifo_TryDequeue(fifo) == NULL);
+    vlc_spsc_fifo_Delete(fifo);
+}
+
+int main(void)
+{
+    init_blocks();
+    test_spsc_accounting();
+    test_spsc_full();
+    bench_mutex();
+    bench_spsc();
+    return 0;
+}
@@ -31,6 +31,8 @@
 #include <vlc_picture_pool.h>
 
 #define PICTURES 10
+#define THREADS 6
+#define LOOPS 20000
 
 static video_format_t fmt;
 static picture_pool_t *pool, *reserve;
@@ -106,6 +108,111 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+static void *stress_thread(void *data)
+{
+    bool wait = (uintptr_t)data & 1;
+    unsigned got = 0;
+
+    for (unsigned i = 0; i < LOOPS; i++) {
+        picture_t *pic = wait ? picture_pool_Wait(pool)
+                              : picture_pool_Get(pool);
+        if (pic == NULL) {
+            assert(!wait);
+            continue;
+        }
+
+        /* Nobody else may be using this picture now */
+        uint8_t *pixels = pic->p[0].p_pixels;
+        assert(pixels[0] == 0);
+        pixels[0] = 1;
+        pixels[0] = 0;
+        got++;
+        picture_Release(pic);
+    }
+    return (void *)(uintptr_t)got;
+}
+
+static void test_threads(void)
+{
+    vlc_thread_t th[THREADS];
+
+    picture_t *pics[PICTURES / 2];
+
+    pool = picture_pool_NewFromFormat(&fmt, PICTURES / 2);
+    assert(pool != NULL);
+
+    for (unsigned i = 0; i < PICTURES / 2; i++) {
+        pics[i] = picture_pool_Get(pool);
+        pics[i]->p[0].p_pixels[0] = 0;
+    }
+    for (unsigned i = 0; i < PICTURES / 2; i++)
+        picture_Release(pics[i]);
+
+    for (uintptr_t i = 0; i < THREADS; i++)
+        assert(!vlc_clone(&th[i], stress_thread, (void *)i,
+                          VLC_THREAD_PRIORITY_LOW));
+
+    for (unsigned i = 0; i < THREADS; i++) {
+        void *got;
+
+        vlc_join(th[i], &got);
+        if (i & 1) /* picture_pool_Wait() always succeeds */
+            assert((uintptr_t)got == LOOPS);
+    }
+
+    /* All pictures must have been returned */
+    for (unsigned i = 0; i < PICTURES / 2; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+    for (unsigned i = 0; i < PICTURES / 2; i++)
+        picture_Release(pics[i]);
+
+    picture_pool_Release(pool);
+}
+
+static void *wait_thread(void *data)
+{
+    return picture_pool_Wait(data);
+}
+
+static void test_cancel(void)
+{
+    picture_t *pics[PICTURES];
+    vlc_thread_t th;
+    void *pic;
+
+    pool = picture_pool_NewFromFormat(&fmt, PICTURES);
+    assert(pool != NULL);
+    for (unsigned i = 0; i < PICTURES; i++)
+        pics[i] = picture_pool_Get(pool);
+
+    /* A waiter is woken up by a released picture... */
+    assert(!vlc_clone(&th, wait_thread, pool, VLC_THREAD_PRIORITY_LOW));
+    picture_Release(pics[0]);
+    vlc_join(th, &pic);
+    assert(pic != NULL);
+    pics[0] = pic;
+
+    /* ...or by cancellation */
+    assert(!vlc_clone(&th, wait_thread, pool, VLC_THREAD_PRIORITY_LOW));
+    picture_pool_Cancel(pool, true);
+    vlc_join(th, &pic);
+    assert(pic == NULL);
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_Release(pics[0]);
+    assert(picture_pool_Get(pool) == NULL);
+    picture_pool_Cancel(pool, false);
+    pics[0] = picture_pool_Get(pool);
+    assert(pics[0] != NULL);
+
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -122,6 +229,8 @@ int main(void)
 
     test(false);
     test(true);
+    test_threads();
+    test_cancel();
 
     return 0;
 }
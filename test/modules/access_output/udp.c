@@ -0,0 +1,168 @@
+/*****************************************************************************
+ * udp.c: UDP stream output loopback test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_sout.h>
+#include <vlc_network.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc/vlc.h>
+
+#define MTU 1400 /* keep in sync with main() */
+#define BLOCK_COUNT 60 /* so that everything fits in the receive buffer */
+
+/* Contents of the byte at the given offset in the output stream */
+static uint8_t stream_byte(size_t offset)
+{
+    return offset % 251;
+}
+
+/* Sizes of the written blocks: whole TS packets, some larger than the MTU,
+ * and a final MTU-sized block, so that nothing is left in the aggregation
+ * buffer of the output when it is closed. */
+static size_t block_size(unsigned i)
+{
+    if (i == BLOCK_COUNT - 1)
+        return MTU;
+    if (i % 10 == 9)
+        return 3000;
+    return 188 * (1 + i % 7);
+}
+
+struct receiver
+{
+    int fd;
+    size_t expected;
+    size_t received;
+    unsigned datagrams;
+};
+
+static void *receive_thread(void *data)
+{
+    struct receiver *rx = data;
+    uint8_t buf[MTU + 1];
+
+    while (rx->received < rx->expected)
+    {
+        struct pollfd ufd = { .fd = rx->fd, .events = POLLIN };
+
+        if (poll(&ufd, 1, 5000) <= 0)
+            break; /* time-out */
+
+        ssize_t val = recv(rx->fd, buf, sizeof (buf), 0);
+        if (val < 0)
+            continue;
+
+        /* Datagrams fit in the MTU, and carry the stream in order */
+        assert(val > 0 && val <= MTU);
+        for (ssize_t i = 0; i < val; i++)
+            assert(buf[i] == stream_byte(rx->received + i));
+        rx->received += val;
+        rx->datagrams++;
+    }
+    return NULL;
+}
+
+static void test_output(vlc_object_t *obj, const char *access)
+{
+    struct receiver rx;
+    char dst[32];
+    int port;
+
+    rx.fd = net_OpenDgram(obj, "127.0.0.1", 0, NULL, 0, IPPROTO_UDP);
+    assert(rx.fd != -1);
+    setsockopt(rx.fd, SOL_SOCKET, SO_RCVBUF, &(int){ 1 << 20 }, sizeof (int));
+    assert(net_GetSockAddress(rx.fd, dst, &port) == 0);
+    snprintf(dst, sizeof (dst), "127.0.0.1:%d", port);
+
+    rx.expected = 0;
+    for (unsigned i = 0; i < BLOCK_COUNT; i++)
+        rx.expected += block_size(i);
+    rx.received = 0;
+    rx.datagrams = 0;
+
+    vlc_thread_t th;
+    int val = vlc_clone(&th, receive_thread, &rx, VLC_THREAD_PRIORITY_LOW);
+    assert(val == 0);
+
+    sout_access_out_t *out = sout_AccessOutNew(obj, access, dst);
+    assert(out != NULL);
+
+    size_t offset = 0;
+    for (unsigned i = 0; i < BLOCK_COUNT; i++)
+    {
+        size_t size = block_size(i);
+        block_t *block = block_Alloc(size);
+        assert(block != NULL);
+
+        for (size_t j = 0; j < size; j++)
+            block->p_buffer[j] = stream_byte(offset + j);
+        offset += size;
+
+        /* Already due: packets are sent as fast as they are queued */
+        block->i_dts = vlc_tick_now();
+        if (i % 5 == 0)
+            block->i_flags |= BLOCK_FLAG_CLOCK;
+        assert(sout_AccessOutWrite(out, block) == (ssize_t)size);
+    }
+
+    vlc_join(th, NULL);
+    sout_AccessOutDelete(out);
+    net_Close(rx.fd);
+
+    printf("%s: received %zu/%zu bytes in %u datagrams\n", access,
+           rx.received, rx.expected, rx.datagrams);
+    assert(rx.received == rx.expected);
+    /* Small blocks are aggregated, large ones are split */
+    assert(rx.datagrams >= (rx.expected + MTU - 1) / MTU);
+    assert(rx.datagrams < BLOCK_COUNT * 2);
+}
+
+int main(void)
+{
+    static const char *const argv[] = {
+        "--mtu=1400", "--sout-udp-caching=0",
+    };
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    test_output(obj, "udp");
+    test_output(obj, "udp{group=4}");
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*****************************************************************************
+ * udp_bench.c: UDP stream output loopback benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_sout.h>
+#include <vlc_network.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc/vlc.h>
+
+#define PACKET_SIZE (7 * 188)
+#define PACKET_COUNT 20000
+#define CACHING_MS 50 /* keep in sync with main() */
+
+struct receiver
+{
+    int fd;
+    unsigned count;
+    vlc_tick_t *dates;
+};
+
+static void *receive_thread(void *data)
+{
+    struct receiver *rx = data;
+    char buf[PACKET_SIZE];
+
+    while (rx->count < PACKET_COUNT)
+    {
+        struct pollfd ufd = { .fd = rx->fd, .events = POLLIN };
+
+        if (poll(&ufd, 1, 2000) <= 0)
+            break; /* time-out */
+
+        ssize_t val = recv(rx->fd, buf, sizeof (buf), 0);
+        if (val < 0)
+            continue;
+        assert(val == PACKET_SIZE);
+        rx->dates[rx->count++] = vlc_tick_now();
+    }
+    return NULL;
+}
+
+/**
+ * Sends PACKET_COUNT packets, in bursts of burst packets sharing the same
+ * date, at the given rate, and reports the measured rate and jitter.
+ */
+static void bench(vlc_object_t *obj, unsigned rate, unsigned burst)
+{
+    struct receiver rx;
+    vlc_tick_t *deadlines = malloc(PACKET_COUNT * sizeof (*deadlines));
+    char dst[32];
+    int port;
+
+    rx.dates = malloc(PACKET_COUNT * sizeof (*rx.dates));
+    assert(deadlines != NULL && rx.dates != NULL);
+    rx.count = 0;
+    rx.fd = net_OpenDgram(obj, "127.0.0.1", 0, NULL, 0, IPPROTO_UDP);
+    assert(rx.fd != -1);
+    setsockopt(rx.fd, SOL_SOCKET, SO_RCVBUF, &(int){ 4 << 20 }, sizeof (int));
+    assert(net_GetSockAddress(rx.fd, dst, &port) == 0);
+    snprintf(dst, sizeof (dst), "127.0.0.1:%d", port);
+
+    vlc_thread_t th;
+    int val = vlc_clone(&th, receive_thread, &rx, VLC_THREAD_PRIORITY_LOW);
+    assert(val == 0);
+
+    sout_access_out_t *out = sout_AccessOutNew(obj, "udp", dst);
+    assert(out != NULL);
+
+    const vlc_tick_t start = vlc_tick_now() + VLC_TICK_FROM_MS(100);
+    for (unsigned i = 0; i < PACKET_COUNT; i++)
+    {
+        block_t *block = block_Alloc(PACKET_SIZE);
+        assert(block != NULL);
+        memset(block->p_buffer, 0x47, PACKET_SIZE);
+        block->i_dts = start + (i / burst) * burst * CLOCK_FREQ / rate;
+        deadlines[i] = block->i_dts + VLC_TICK_FROM_MS(CACHING_MS);
+
+        /* Do not run ahead of the output too much */
+        vlc_tick_wait(block->i_dts - VLC_TICK_FROM_MS(CACHING_MS / 2));
+        sout_AccessOutWrite(out, block);
+    }
+
+    vlc_join(th, NULL);
+    sout_AccessOutDelete(out);
+    net_Close(rx.fd);
+
+    /* Loopback should not lose much, if anything. Note that the UDP output
+     * keeps the last packet in its aggregation buffer until it is closed. */
+    assert(rx.count >= PACKET_COUNT * 9 / 10);
+
+    vlc_tick_t jitter_max = 0;
+    double jitter_sum = 0.;
+    for (unsigned i = 0; i < rx.count; i++)
+    {
+        vlc_tick_t d = rx.dates[i] - deadlines[i];
+        if (d < 0)
+            d = -d;
+        if (d > jitter_max)
+            jitter_max = d;
+        jitter_sum += d;
+    }
+
+    double duration = (double)(rx.dates[rx.count - 1] - rx.dates[0])
+                      / CLOCK_FREQ;
+    printf("rate %6u pkt/s, burst %3u: received %u/%u, %.0f pkt/s, "
+           "jitter mean %.0f us, max %"PRId64" us\n", rate, burst,
+           rx.count, PACKET_COUNT, (rx.count - 1) / duration,
+           jitter_sum / rx.count, US_FROM_VLC_TICK(jitter_max));
+
+    free(rx.dates);
+    free(deadlines);
+}
+
+int main(void)
+{
+    static const char *const argv[] = {
+        "--sout-udp-caching=50",
+    };
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    bench(obj, 10000, 1);
+    bench(obj, 10000, 7);
+    bench(obj, 50000, 7);
+    bench(obj, 50000, 50);
+
+    libvlc_release(vlc);
+    return 0;
+}
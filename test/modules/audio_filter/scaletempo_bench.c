@@ -0,0 +1,136 @@
+/*****************************************************************************
+ * scaletempo_bench.c: benchmark for the scaletempo audio filter
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc/vlc.h>
+
+#define RATE 48000
+#define FRAMES 1024 /* per input block */
+#define SECONDS 20 /* of output audio */
+
+/**
+ * Plays SECONDS of output through scaletempo at the given speed, and reports
+ * the CPU time spent per second of audio.
+ */
+static void bench(vlc_object_t *obj, unsigned channels, float speed)
+{
+    filter_t *filter = vlc_object_create(obj, sizeof (*filter));
+    assert(filter != NULL);
+
+    audio_format_t fmt = {
+        .i_format = VLC_CODEC_FL32,
+        .i_rate = RATE,
+        .i_physical_channels = channels == 2 ? AOUT_CHANS_STEREO
+                                             : AOUT_CHANS_5_1,
+        .i_chan_mode = 0,
+    };
+    aout_FormatPrepare(&fmt);
+    assert(fmt.i_channels == channels);
+
+    filter->fmt_in.audio = fmt;
+    filter->fmt_in.i_codec = fmt.i_format;
+    filter->fmt_out.audio = fmt;
+    filter->fmt_out.i_codec = fmt.i_format;
+    filter->p_module = module_need(filter, "audio filter", "scaletempo", true);
+    assert(filter->p_module != NULL);
+
+    /* The audio output changes the input rate to change the speed */
+    filter->fmt_in.audio.i_rate = lroundf(RATE * speed);
+
+    size_t in_frames = 0, out_frames = 0;
+    clock_t cpu = 0;
+
+    while (out_frames < (size_t)SECONDS * RATE)
+    {
+        block_t *in = block_Alloc(FRAMES * channels * sizeof (float));
+        assert(in != NULL);
+
+        /* A few partials, slightly different on each channel */
+        float *p = (float *)in->p_buffer;
+        for (unsigned i = 0; i < FRAMES; i++, in_frames++)
+            for (unsigned c = 0; c < channels; c++)
+            {
+                double t = (double)in_frames / RATE;
+                *p++ = .5f * sin(2 * M_PI * (220 + c) * t)
+                     + .3f * sin(2 * M_PI * 330 * t + c)
+                     + .2f * sin(2 * M_PI * 1210 * t);
+            }
+        in->i_nb_samples = FRAMES;
+        in->i_pts = in->i_dts = VLC_TICK_0;
+
+        clock_t start = clock();
+        block_t *out = filter->pf_audio_filter(filter, in);
+        cpu += clock() - start;
+
+        if (out != NULL)
+        {
+            assert(out->i_buffer == out->i_nb_samples * channels * sizeof (float));
+            out_frames += out->i_nb_samples;
+            block_Release(out);
+        }
+    }
+
+    /* The output must be played at the requested speed */
+    double ratio = (double)in_frames / out_frames;
+    assert(fabs(ratio - speed) < .05 * speed);
+
+    printf("%u channels, speed %.2f: %6.2f ms of CPU per second of audio\n",
+           channels, speed, 1000. * cpu / CLOCKS_PER_SEC / SECONDS);
+
+    module_unneed(filter, filter->p_module);
+    vlc_object_delete(filter);
+}
+
+int main(void)
+{
+    static const float speeds[] = { .5f, 1.f, 1.5f, 2.f, 3.f, 4.f };
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    for (size_t i = 0; i < ARRAY_SIZE(speeds); i++)
+        bench(obj, 2, speeds[i]);
+    bench(obj, 6, 1.5f);
+    bench(obj, 6, 2.f);
+
+    libvlc_release(vlc);
+    return 0;
+}
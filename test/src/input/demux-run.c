@@ -363,6 +363,80 @@ int vlc_demux_process_path(const struct vlc_run_args *args, const char *path)
     return ret;
 }
 
+int vlc_demux_probe_paths(const struct vlc_run_args *args,
+                          const char *const *paths, size_t count)
+{
+    const char *name = args->name;
+    if (name == NULL)
+        name = "any";
+
+    libvlc_instance_t *vlc = libvlc_create(args);
+    if (vlc == NULL)
+        return -1;
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+    vlc_tick_t total = 0, max = 0;
+    size_t matched = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        char *url = vlc_path2uri(paths[i], NULL);
+        if (url == NULL)
+        {
+            fprintf(stderr, "Error: cannot convert path to URL: %s\n",
+                    paths[i]);
+            continue;
+        }
+
+        stream_t *s = vlc_access_NewMRL(obj, url);
+        free(url);
+        if (s == NULL)
+        {
+            fprintf(stderr, "Error: cannot create input stream: %s\n",
+                    paths[i]);
+            continue;
+        }
+
+        es_out_t *out = test_es_out_create(VLC_OBJECT(s));
+        if (out == NULL)
+        {
+            vlc_stream_Delete(s);
+            continue;
+        }
+
+        /* Time to the first matching module, including failed probes */
+        vlc_tick_t start = vlc_tick_now();
+        demux_t *demux = demux_New(VLC_OBJECT(s), name, s, out);
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+
+        printf("%8.3f ms %s %s\n", MS_FROM_VLC_TICK((double)elapsed),
+               (demux != NULL) ? "ok  " : "fail", paths[i]);
+
+        total += elapsed;
+        if (elapsed > max)
+            max = elapsed;
+
+        if (demux != NULL)
+        {
+            matched++;
+            demux_Delete(demux);
+        }
+        else
+            vlc_stream_Delete(s);
+        es_out_Delete(out);
+    }
+
+    if (count > 0)
+        printf("%zu file(s), %zu matched: total %.3f ms, "
+               "mean %.3f ms, max %.3f ms\n", count, matched,
+               MS_FROM_VLC_TICK((double)total),
+               MS_FROM_VLC_TICK((double)total) / count,
+               MS_FROM_VLC_TICK((double)max));
+
+    libvlc_release(vlc);
+    return (matched == count) ? 0 : -1;
+}
+
 int libvlc_demux_process_memory(libvlc_instance_t *vlc,
                                 const struct vlc_run_args *args,
                                 const unsigned char *buf, size_t length)
@@ -28,6 +28,8 @@
 
 int vlc_demux_process_url(const struct vlc_run_args *, const char *url);
 int vlc_demux_process_path(const struct vlc_run_args *, const char *path);
+int vlc_demux_probe_paths(const struct vlc_run_args *,
+                          const char *const *paths, size_t count);
 int vlc_demux_process_memory(const struct vlc_run_args *,
                              const unsigned char *buf, size_t length);
 int libvlc_demux_process_memory(libvlc_instance_t *vlc,
@@ -28,6 +28,7 @@
 
 #include <inttypes.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -360,6 +361,213 @@ fill_rand( int i_fd, size_t i_size )
     }
     assert( i_written == i_size );
 }
+
+/* Source of known data counting its accesses, below the byte range cache */
+#define CACHE_SIZE (128 * 1024) /* smallest cache: 4 chunks of 32 KiB */
+#define SOURCE_SIZE (4 * 1024 * 1024)
+
+struct source_sys
+{
+    uint64_t i_pos;
+    bool b_can_seek;
+    /* Also updated by the tail prefetch thread */
+    atomic_uint i_seeks;
+    atomic_uint_fast64_t i_read_bytes;
+};
+
+static uint8_t
+source_byte( uint64_t i_pos )
+{
+    return i_pos % 251;
+}
+
+static ssize_t
+source_read( stream_t *s, void *p_buf, size_t i_len )
+{
+    struct source_sys *p_sys = s->p_sys;
+    uint8_t *p = p_buf;
+
+    i_len = __MIN( i_len, SOURCE_SIZE - p_sys->i_pos );
+    for( size_t i = 0; i < i_len; i++ )
+        p[i] = source_byte( p_sys->i_pos + i );
+    p_sys->i_pos += i_len;
+    p_sys->i_read_bytes += i_len;
+    return i_len;
+}
+
+static int
+source_seek( stream_t *s, uint64_t i_pos )
+{
+    struct source_sys *p_sys = s->p_sys;
+
+    assert( p_sys->b_can_seek );
+    p_sys->i_pos = i_pos;
+    p_sys->i_seeks++;
+    return VLC_SUCCESS;
+}
+
+static int
+source_control( stream_t *s, int i_query, va_list args )
+{
+    struct source_sys *p_sys = s->p_sys;
+
+    switch( i_query )
+    {
+        case STREAM_CAN_SEEK:
+            *va_arg( args, bool * ) = p_sys->b_can_seek;
+            return VLC_SUCCESS;
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg( args, bool * ) = false;
+            return VLC_SUCCESS;
+        case STREAM_GET_SIZE:
+            *va_arg( args, uint64_t * ) = SOURCE_SIZE;
+            return VLC_SUCCESS;
+        case STREAM_GET_PTS_DELAY:
+            *va_arg( args, vlc_tick_t * ) = 0;
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void
+source_destroy( stream_t *s )
+{
+    (void) s;
+}
+
+static stream_t *
+cache_open( libvlc_instance_t *p_vlc, struct source_sys *p_sys,
+            bool b_can_seek )
+{
+    stream_t *p_source = vlc_stream_CommonNew( VLC_OBJECT(p_vlc->p_libvlc_int),
+                                               source_destroy );
+    assert( p_source );
+
+    p_sys->i_pos = 0;
+    p_sys->b_can_seek = b_can_seek;
+    p_sys->i_seeks = 0;
+    p_sys->i_read_bytes = 0;
+    p_source->p_sys = p_sys;
+    p_source->pf_read = source_read;
+    p_source->pf_seek = b_can_seek ? source_seek : NULL;
+    p_source->pf_control = source_control;
+
+    stream_t *s = vlc_stream_FilterNew( p_source, "cache" );
+    assert( s );
+    return s;
+}
+
+/* Reads at i_pos, and returns how many bytes were read from the source */
+static uint64_t
+cache_read_at( stream_t *s, struct source_sys *p_sys, uint64_t i_pos,
+               size_t i_len )
+{
+    uint8_t p_buf[4096];
+    uint64_t i_read_bytes = p_sys->i_read_bytes;
+
+    assert( i_len <= sizeof (p_buf) );
+    assert( vlc_stream_Seek( s, i_pos ) == VLC_SUCCESS );
+    assert( vlc_stream_Read( s, p_buf, i_len ) == (ssize_t) i_len );
+    for( size_t i = 0; i < i_len; i++ )
+        assert( p_buf[i] == source_byte( i_pos + i ) );
+    return p_sys->i_read_bytes - i_read_bytes;
+}
+
+static void
+test_cache( void )
+{
+    const char * argv[] = {
+        "-v",
+        "--ignore-config",
+        "--cache-read-size=128",
+        "--cache-read-tail=0",
+    };
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( p_vlc != NULL );
+
+    struct source_sys sys;
+    stream_t *s;
+
+    test_log( "Testing the byte range cache...\n" );
+
+    /* Small forward gaps are read through rather than seeked over, and the
+     * data read through is cached */
+    s = cache_open( p_vlc, &sys, true );
+    cache_read_at( s, &sys, 0, 4096 );
+    assert( cache_read_at( s, &sys, 40000, 4096 ) > 0 );
+    assert( sys.i_seeks == 0 );
+    assert( cache_read_at( s, &sys, 20000, 4096 ) == 0 );
+    assert( cache_read_at( s, &sys, 0, 4096 ) == 0 );
+
+    /* Larger gaps are seeked over */
+    assert( cache_read_at( s, &sys, SOURCE_SIZE / 2, 4096 ) > 0 );
+    assert( sys.i_seeks == 1 );
+
+    /* The least recently used ranges are evicted once the cache is full */
+    for( uint64_t i_pos = SOURCE_SIZE / 2; i_pos < SOURCE_SIZE / 2 + CACHE_SIZE;
+         i_pos += 4096 )
+        cache_read_at( s, &sys, i_pos, 4096 );
+    assert( cache_read_at( s, &sys, SOURCE_SIZE / 2 + CACHE_SIZE - 4096,
+                           4096 ) == 0 );
+    unsigned i_seeks = sys.i_seeks;
+    assert( cache_read_at( s, &sys, 0, 4096 ) > 0 );
+    assert( sys.i_seeks == i_seeks + 1 );
+    vlc_stream_Delete( s );
+
+    /* Without a seekable source, only cached data and forward positions can
+     * be seeked to */
+    s = cache_open( p_vlc, &sys, false );
+    cache_read_at( s, &sys, 0, 4096 );
+    assert( cache_read_at( s, &sys, 0, 4096 ) == 0 );
+    assert( cache_read_at( s, &sys, 2 * CACHE_SIZE, 4096 ) > 0 );
+    assert( cache_read_at( s, &sys, 2 * CACHE_SIZE - 4096, 4096 ) == 0 );
+    assert( vlc_stream_Seek( s, 0 ) != VLC_SUCCESS );
+    assert( sys.i_seeks == 0 );
+    vlc_stream_Delete( s );
+
+    libvlc_release( p_vlc );
+}
+
+#define TAIL_SIZE (64 * 1024) /* at most half of the cache */
+
+static void
+test_cache_tail( void )
+{
+    const char * argv[] = {
+        "-v",
+        "--ignore-config",
+        "--cache-read-size=128",
+        "--cache-read-tail=64",
+    };
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( p_vlc != NULL );
+
+    struct source_sys sys;
+    stream_t *s;
+
+    test_log( "Testing the byte range cache tail prefetch...\n" );
+
+    /* Wait for the tail, fetched in the background after the head */
+    s = cache_open( p_vlc, &sys, true );
+    while( sys.i_read_bytes < TAIL_SIZE )
+        vlc_tick_sleep( VLC_TICK_FROM_MS(10) );
+
+    /* The whole tail was fetched after a single seek */
+    assert( cache_read_at( s, &sys, SOURCE_SIZE - TAIL_SIZE, 4096 ) == 0 );
+    assert( cache_read_at( s, &sys, SOURCE_SIZE - 4096, 4096 ) == 0 );
+    assert( sys.i_seeks == 1 );
+
+    /* Going back to the head costs one seek, the tail stays cached */
+    assert( cache_read_at( s, &sys, 65536, 4096 ) > 0 );
+    assert( cache_read_at( s, &sys, SOURCE_SIZE - 4096, 4096 ) == 0 );
+    assert( sys.i_seeks == 2 );
+    vlc_stream_Delete( s );
+
+    libvlc_release( p_vlc );
+}
 #endif
 
 int
@@ -390,6 +598,9 @@ main( void )
     free( psz_url );
 
     close( i_tmp_fd );
+
+    test_cache();
+    test_cache_tail();
 #else
 
     test_log( "Testing http url with stream...\n" );
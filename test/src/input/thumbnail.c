@@ -207,6 +207,90 @@ static void test_cancel_thumbnail( libvlc_instance_t* p_vlc )
     vlc_thumbnailer_Release( p_thumbnailer );
 }
 
+static const vlc_tick_t batch_times[] = {
+    VLC_TICK_FROM_SEC( 10 ), VLC_TICK_FROM_SEC( 60 ), VLC_TICK_FROM_SEC( 61 ),
+    VLC_TICK_FROM_SEC( 30 ), VLC_TICK_FROM_SEC( 200 ),
+};
+
+struct test_batch_ctx
+{
+    vlc_cond_t cond;
+    vlc_mutex_t lock;
+    size_t count;
+    bool b_expected_success;
+};
+
+static void thumbnailer_batch_callback( void* data, size_t index,
+                                        picture_t* thumbnail )
+{
+    struct test_batch_ctx* p_ctx = data;
+    vlc_mutex_lock( &p_ctx->lock );
+
+    assert( index == p_ctx->count && "Unexpected thumbnail order" );
+    if ( p_ctx->b_expected_success )
+    {
+        assert( thumbnail != NULL && "Expected a thumbnail but got a failure" );
+        assert( thumbnail->format.i_chroma == VLC_CODEC_ARGB );
+        assert( thumbnail->date == batch_times[index] && "Unexpected picture date" );
+    }
+    else
+        assert( thumbnail == NULL && "Expected failure but got a thumbnail" );
+
+    p_ctx->count++;
+    vlc_cond_signal( &p_ctx->cond );
+    vlc_mutex_unlock( &p_ctx->lock );
+}
+
+static void test_batch_thumbnails( libvlc_instance_t* p_vlc )
+{
+    vlc_thumbnailer_t* p_thumbnailer = vlc_thumbnailer_Create(
+                VLC_OBJECT( p_vlc->p_libvlc_int ) );
+    assert( p_thumbnailer != NULL );
+
+    struct test_batch_ctx ctx;
+    vlc_cond_init( &ctx.cond );
+    vlc_mutex_init( &ctx.lock );
+
+    /* With a video track, then without, which should timeout */
+    for ( unsigned i_nb_video_tracks = 1; ; --i_nb_video_tracks )
+    {
+        char* psz_mrl;
+
+        ctx.count = 0;
+        ctx.b_expected_success = i_nb_video_tracks > 0;
+
+        if ( asprintf( &psz_mrl, "mock://video_track_count=%u;audio_track_count=1"
+                       ";length=%" PRId64 ";video_chroma=ARGB",
+                       i_nb_video_tracks, MOCK_DURATION ) < 0 )
+            assert( !"Failed to allocate mock mrl" );
+        input_item_t* p_item = input_item_New( psz_mrl, "mock item" );
+        assert( p_item != NULL );
+
+        vlc_mutex_lock( &ctx.lock );
+        vlc_thumbnailer_request_t* p_req = vlc_thumbnailer_RequestBatch(
+            p_thumbnailer, batch_times, ARRAY_SIZE(batch_times),
+            VLC_THUMBNAILER_SEEK_FAST, p_item,
+            ctx.b_expected_success ? VLC_TICK_FROM_SEC( 5 ) : VLC_TICK_FROM_MS( 100 ),
+            thumbnailer_batch_callback, &ctx );
+        assert( p_req != NULL );
+
+        while ( ctx.count < ARRAY_SIZE(batch_times) )
+        {
+            vlc_tick_t timeout = vlc_tick_now() + VLC_TICK_FROM_SEC( 5 );
+            int res = vlc_cond_timedwait( &ctx.cond, &ctx.lock, timeout );
+            assert( res != ETIMEDOUT );
+        }
+        vlc_mutex_unlock( &ctx.lock );
+
+        input_item_Release( p_item );
+        free( psz_mrl );
+
+        if ( i_nb_video_tracks == 0 )
+            break;
+    }
+    vlc_thumbnailer_Release( p_thumbnailer );
+}
+
 int main()
 {
     test_init();
@@ -220,6 +304,7 @@ int main()
 
     test_thumbnails( vlc );
     test_cancel_thumbnail( vlc );
+    test_batch_thumbnails( vlc );
 
     libvlc_release( vlc );
 }
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * messages.c: test the asynchronous message log
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+const char vlc_module_name[] = "test_messages";
+
+/* Messages are formatted by the logging thread, after the calls returned */
+static void test_log_messages(vlc_object_t *obj)
+{
+    msg_Info(obj, "width [%*d] [%-*d]", 5, 42, 4, 7);
+    msg_Info(obj, "precision [%.*s] [%.*s] [%.2s]", 3, "abcdef", -1, "xyz",
+             "uvw");
+    msg_Info(obj, "percent [100%%] [%d%%]", 50);
+    msg_Info(obj, "mixed [%s] [%zu] [%.1f] [%c]", "str", (size_t)1234, 2.5,
+             'c');
+
+    /* A format string built at run time does not outlive the call */
+    char *format = strdup("dynamic [%s] [%*u]");
+    assert(format != NULL);
+    msg_Info(obj, format, "arg", 3, 9u);
+    memset(format, 'x', strlen(format));
+    free(format);
+
+    /* Wide strings cannot be deferred: formatted by the calling thread */
+    msg_Info(obj, "fallback [%ls] [%.*s]", L"wide", 2, "abc");
+}
+
+static const char *const expected[] = {
+    "width [   42] [7   ]",
+    "precision [abc] [xyz] [uv]",
+    "percent [100%] [50%]",
+    "mixed [str] [1234] [2.5] [c]",
+    "dynamic [arg] [  9]",
+    "fallback [wide] [ab]",
+};
+
+int main(void)
+{
+    char path[] = "/tmp/vlc-test-messages-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+
+    char *logfile;
+    assert(asprintf(&logfile, "--logfile=%s", path) != -1);
+
+    const char *args[] = {
+        "--file-logging", "--log-async", "--log-verbose=0", logfile,
+    };
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+    test_log_messages(VLC_OBJECT(vlc->p_libvlc_int));
+    libvlc_release(vlc); /* drains the pending messages */
+    free(logfile);
+
+    FILE *stream = vlc_fopen(path, "rt");
+    assert(stream != NULL);
+
+    char line[256];
+    size_t found = 0;
+
+    while (found < ARRAY_SIZE(expected)
+        && fgets(line, sizeof (line), stream) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+
+        const char *text = strstr(line, ": ");
+        if (text != NULL && strcmp(text + 2, expected[found]) == 0)
+            found++;
+    }
+    fclose(stream);
+    unlink(path);
+
+    if (found < ARRAY_SIZE(expected)) {
+        fprintf(stderr, "missing message: %s\n", expected[found]);
+        return 1;
+    }
+    return 0;
+}
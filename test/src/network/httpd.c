@@ -0,0 +1,273 @@
+/*****************************************************************************
+ * httpd.c: HTTP server worker threads test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+
+#include <vlc_common.h>
+#include <vlc_httpd.h>
+#include <vlc_network.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc/vlc.h>
+
+#define TIMEOUT VLC_TICK_FROM_SEC(5)
+
+struct httpd_callback_sys_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    unsigned active; /* callbacks in progress */
+    unsigned max_active;
+};
+
+/* Holds each request until another one runs concurrently */
+static int overlap_cb(httpd_callback_sys_t *sys, httpd_client_t *cl,
+                      httpd_message_t *answer, const httpd_message_t *query)
+{
+    if (answer == NULL || query == NULL)
+        return VLC_SUCCESS;
+
+    vlc_tick_t deadline = vlc_tick_now() + TIMEOUT;
+
+    vlc_mutex_lock(&sys->lock);
+    if (++sys->active > sys->max_active)
+    {
+        sys->max_active = sys->active;
+        vlc_cond_broadcast(&sys->wait);
+    }
+    while (sys->max_active < 2)
+        if (vlc_cond_timedwait(&sys->wait, &sys->lock, deadline))
+            break;
+    sys->active--;
+    vlc_mutex_unlock(&sys->lock);
+
+    answer->i_proto = HTTPD_PROTO_HTTP;
+    answer->i_version = 1;
+    answer->i_type = HTTPD_MSG_ANSWER;
+    answer->i_status = 200;
+    answer->p_body = (uint8_t *)strdup("ok");
+    assert(answer->p_body != NULL);
+    answer->i_body = 2;
+    httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+    (void) cl;
+    return VLC_SUCCESS;
+}
+
+struct httpd_file_sys_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    bool blocked;
+    bool released;
+};
+
+/* Blocks until the test releases it */
+static int blocking_fill(httpd_file_sys_t *sys, httpd_file_t *file,
+                         uint8_t *request, uint8_t **data, int *len)
+{
+    vlc_mutex_lock(&sys->lock);
+    sys->blocked = true;
+    vlc_cond_broadcast(&sys->wait);
+    while (!sys->released)
+        vlc_cond_wait(&sys->wait, &sys->lock);
+    vlc_mutex_unlock(&sys->lock);
+
+    *data = (uint8_t *)strdup("done");
+    assert(*data != NULL);
+    *len = 4;
+    (void) file; (void) request;
+    return VLC_SUCCESS;
+}
+
+struct client
+{
+    vlc_object_t *obj;
+    int port;
+    const char *path;
+    size_t received;
+};
+
+/* Sends one request and reads the answer until the server closes */
+static size_t request(vlc_object_t *obj, int port, const char *path)
+{
+    char buf[1024];
+    size_t total = 0;
+
+    int len = snprintf(buf, sizeof (buf), "GET %s HTTP/1.0\r\n\r\n", path);
+    int fd = net_ConnectTCP(obj, "127.0.0.1", port);
+    if (fd == -1)
+        return 0;
+
+    if (send(fd, buf, len, 0) != len)
+    {
+        net_Close(fd);
+        return 0;
+    }
+
+    for (;;)
+    {
+        struct pollfd ufd = { .fd = fd, .events = POLLIN };
+
+        if (poll(&ufd, 1, 5000) <= 0)
+            break; /* time-out */
+
+        ssize_t val = recv(fd, buf, sizeof (buf), 0);
+        if (val <= 0)
+            break;
+        total += val;
+    }
+    net_Close(fd);
+    return total;
+}
+
+static void *client_thread(void *data)
+{
+    struct client *c = data;
+
+    c->received = request(c->obj, c->port, c->path);
+    return NULL;
+}
+
+static void start_client(vlc_thread_t *th, struct client *c,
+                         vlc_object_t *obj, int port, const char *path)
+{
+    c->obj = obj;
+    c->port = port;
+    c->path = path;
+    c->received = 0;
+    assert(vlc_clone(th, client_thread, c, VLC_THREAD_PRIORITY_LOW) == 0);
+}
+
+/* Callbacks of a concurrent url run on several host threads at once */
+static void test_concurrent(vlc_object_t *obj, int port)
+{
+    httpd_callback_sys_t sys = { .active = 0, .max_active = 0 };
+    struct client clients[2];
+    vlc_thread_t th[2];
+
+    vlc_mutex_init(&sys.lock);
+    vlc_cond_init(&sys.wait);
+
+    httpd_host_t *host = vlc_http_HostNew(obj);
+    assert(host != NULL);
+    httpd_url_t *url = httpd_UrlNew(host, "/overlap", NULL, NULL);
+    assert(url != NULL);
+    httpd_UrlSetConcurrent(url);
+    httpd_UrlCatch(url, HTTPD_MSG_GET, overlap_cb, &sys);
+
+    for (unsigned i = 0; i < 2; i++)
+        start_client(&th[i], &clients[i], obj, port, "/overlap");
+    for (unsigned i = 0; i < 2; i++)
+    {
+        vlc_join(th[i], NULL);
+        assert(clients[i].received > 0);
+    }
+
+    httpd_UrlDelete(url);
+    httpd_HostDelete(host);
+
+    assert(sys.active == 0);
+    assert(sys.max_active == 2);
+    vlc_cond_destroy(&sys.wait);
+    vlc_mutex_destroy(&sys.lock);
+}
+
+/* A blocked callback does not stop the other threads from serving */
+static void test_blocked(vlc_object_t *obj, int port)
+{
+    httpd_file_sys_t sys = { .blocked = false, .released = false };
+    struct client client;
+    vlc_thread_t th;
+
+    vlc_mutex_init(&sys.lock);
+    vlc_cond_init(&sys.wait);
+
+    httpd_host_t *host = vlc_http_HostNew(obj);
+    assert(host != NULL);
+    httpd_file_t *file = httpd_FileNew(host, "/block", "text/plain",
+                                       NULL, NULL, blocking_fill, &sys);
+    assert(file != NULL);
+    httpd_redirect_t *redir = httpd_RedirectNew(host, "/block", "/redirect");
+    assert(redir != NULL);
+
+    start_client(&th, &client, obj, port, "/block");
+
+    vlc_mutex_lock(&sys.lock);
+    while (!sys.blocked)
+        vlc_cond_wait(&sys.wait, &sys.lock);
+    vlc_mutex_unlock(&sys.lock);
+
+    /* served by the other thread */
+    assert(request(obj, port, "/redirect") > 0);
+
+    vlc_mutex_lock(&sys.lock);
+    sys.released = true;
+    vlc_cond_broadcast(&sys.wait);
+    vlc_mutex_unlock(&sys.lock);
+
+    vlc_join(th, NULL);
+    assert(client.received > 0);
+
+    httpd_RedirectDelete(redir);
+    httpd_FileDelete(file);
+    httpd_HostDelete(host);
+    vlc_cond_destroy(&sys.wait);
+    vlc_mutex_destroy(&sys.lock);
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    /* Find a free port for the server */
+    int *fds = net_ListenTCP(obj, "127.0.0.1", 0);
+    int port;
+    assert(fds != NULL);
+    assert(net_GetSockAddress(fds[0], (char[NI_MAXNUMERICHOST]){ 0 },
+                              &port) == 0);
+    net_ListenClose(fds);
+
+    var_Create(obj, "http-host", VLC_VAR_STRING);
+    var_SetString(obj, "http-host", "127.0.0.1");
+    var_Create(obj, "http-port", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "http-port", port);
+    var_Create(obj, "http-threads", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "http-threads", 2);
+
+    test_concurrent(obj, port);
+    test_blocked(obj, port);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*****************************************************************************
+ * httpd_bench.c: HTTP server load benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+
+#include <vlc_common.h>
+#include <vlc_httpd.h>
+#include <vlc_network.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc/vlc.h>
+
+#define CLIENTS 16
+#define REQUESTS 100 /* per client */
+#define WORK_US 500 /* server time spent on each request */
+#define BODY_SIZE 4096
+
+struct httpd_callback_sys_t
+{
+    vlc_mutex_t lock;
+    unsigned active; /* callbacks in progress */
+    unsigned max_active;
+};
+
+static int answer_cb(httpd_callback_sys_t *sys, httpd_client_t *cl,
+                     httpd_message_t *answer, const httpd_message_t *query)
+{
+    if (answer == NULL || query == NULL)
+        return VLC_SUCCESS;
+
+    vlc_mutex_lock(&sys->lock);
+    if (++sys->active > sys->max_active)
+        sys->max_active = sys->active;
+    vlc_mutex_unlock(&sys->lock);
+
+    /* Pretend to compute the answer */
+    vlc_tick_t deadline = vlc_tick_now() + VLC_TICK_FROM_US(WORK_US);
+    while (vlc_tick_now() < deadline);
+
+    vlc_mutex_lock(&sys->lock);
+    sys->active--;
+    vlc_mutex_unlock(&sys->lock);
+
+    answer->i_proto = HTTPD_PROTO_HTTP;
+    answer->i_version = 1;
+    answer->i_type = HTTPD_MSG_ANSWER;
+    answer->i_status = 200;
+    answer->p_body = malloc(BODY_SIZE);
+    assert(answer->p_body != NULL);
+    memset(answer->p_body, 'x', BODY_SIZE);
+    answer->i_body = BODY_SIZE;
+    httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+    (void) cl;
+    return VLC_SUCCESS;
+}
+
+struct client
+{
+    vlc_object_t *obj;
+    int port;
+    unsigned ok;
+    vlc_tick_t latency[REQUESTS];
+};
+
+/* Sends one request and reads the answer until the server closes */
+static bool request(struct client *c)
+{
+    static const char req[] = "GET /bench HTTP/1.0\r\n\r\n";
+    char buf[BODY_SIZE];
+    size_t total = 0;
+
+    int fd = net_ConnectTCP(c->obj, "127.0.0.1", c->port);
+    if (fd == -1)
+        return false;
+
+    if (send(fd, req, sizeof (req) - 1, 0) != sizeof (req) - 1)
+    {
+        net_Close(fd);
+        return false;
+    }
+
+    for (;;)
+    {
+        struct pollfd ufd = { .fd = fd, .events = POLLIN };
+
+        if (poll(&ufd, 1, 5000) <= 0)
+            break; /* time-out */
+
+        ssize_t val = recv(fd, buf, sizeof (buf), 0);
+        if (val <= 0)
+            break;
+        total += val;
+    }
+    net_Close(fd);
+    return total > BODY_SIZE;
+}
+
+static void *client_thread(void *data)
+{
+    struct client *c = data;
+
+    for (unsigned i = 0; i < REQUESTS; i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+
+        if (request(c))
+            c->latency[c->ok++] = vlc_tick_now() - start;
+    }
+    return NULL;
+}
+
+static int cmp_tick(const void *a, const void *b)
+{
+    vlc_tick_t x = *(const vlc_tick_t *)a, y = *(const vlc_tick_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Runs CLIENTS concurrent clients against a host with the given number of
+ * threads, and reports the request rate and latency percentiles.
+ */
+static void bench(vlc_object_t *obj, int port, unsigned threads)
+{
+    struct client *clients = malloc(CLIENTS * sizeof (*clients));
+    vlc_thread_t th[CLIENTS];
+    assert(clients != NULL);
+
+    var_SetInteger(obj, "http-threads", threads);
+
+    httpd_callback_sys_t sys = {
+        .active = 0,
+        .max_active = 0,
+    };
+    vlc_mutex_init(&sys.lock);
+
+    httpd_host_t *host = vlc_http_HostNew(obj);
+    assert(host != NULL);
+    httpd_url_t *url = httpd_UrlNew(host, "/bench", NULL, NULL);
+    assert(url != NULL);
+    httpd_UrlSetConcurrent(url);
+    httpd_UrlCatch(url, HTTPD_MSG_GET, answer_cb, &sys);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < CLIENTS; i++)
+    {
+        clients[i].obj = obj;
+        clients[i].port = port;
+        clients[i].ok = 0;
+        assert(vlc_clone(&th[i], client_thread, &clients[i],
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+    }
+
+    vlc_tick_t *latency = malloc(CLIENTS * REQUESTS * sizeof (*latency));
+    unsigned count = 0;
+    assert(latency != NULL);
+
+    for (unsigned i = 0; i < CLIENTS; i++)
+    {
+        vlc_join(th[i], NULL);
+        memcpy(latency + count, clients[i].latency,
+               clients[i].ok * sizeof (*latency));
+        count += clients[i].ok;
+    }
+    vlc_tick_t duration = vlc_tick_now() - start;
+
+    httpd_UrlDelete(url);
+    httpd_HostDelete(host);
+
+    assert(count == CLIENTS * REQUESTS);
+    assert(sys.active == 0);
+    assert(sys.max_active <= threads);
+    vlc_mutex_destroy(&sys.lock);
+    qsort(latency, count, sizeof (*latency), cmp_tick);
+    printf("%2u thread(s): %6.0f req/s, latency p50 %5"PRId64" us, "
+           "p99 %6"PRId64" us, max %6"PRId64" us, "
+           "%u concurrent callbacks\n", threads,
+           count * (double)CLOCK_FREQ / duration,
+           US_FROM_VLC_TICK(latency[count / 2]),
+           US_FROM_VLC_TICK(latency[count * 99 / 100]),
+           US_FROM_VLC_TICK(latency[count - 1]), sys.max_active);
+
+    free(latency);
+    free(clients);
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    /* Find a free port for the server */
+    int *fds = net_ListenTCP(obj, "127.0.0.1", 0);
+    int port;
+    assert(fds != NULL);
+    assert(net_GetSockAddress(fds[0], (char[NI_MAXNUMERICHOST]){ 0 },
+                              &port) == 0);
+    net_ListenClose(fds);
+
+    var_Create(obj, "http-host", VLC_VAR_STRING);
+    var_SetString(obj, "http-host", "127.0.0.1");
+    var_Create(obj, "http-port", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "http-port", port);
+    var_Create(obj, "http-threads", VLC_VAR_INTEGER);
+
+    bench(obj, port, 1);
+    bench(obj, port, 2);
+    bench(obj, port, 4);
+
+    libvlc_release(vlc);
+    return 0;
+}